@@ -0,0 +1,20 @@
+#!/bin/sh
+# Linux counterpart of build.bat: ./build.sh [pattern]
+# Listings that include windows.h are Win32 only and are skipped.
+
+cd "$(dirname "$0")"
+mkdir -p build
+
+CXX=${CXX:-c++}
+pattern=${1:-}
+
+for file in *${pattern}*_main.cpp; do
+    if grep -q "#include *<windows.h>" "$file"; then
+        continue
+    fi
+
+    name=${file%.cpp}
+    echo "$file"
+    $CXX -g -Wall -Wno-unused-function "$file" -o "build/${name}_dc" -lpthread -lX11 -lXext
+    $CXX -O2 -g -Wall -Wno-unused-function "$file" -o "build/${name}_rc" -lpthread -lX11 -lXext
+done
@@ -0,0 +1,243 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_dirty_region.cpp"
+
+/*
+    NOTE(Axel): A monitoring view: a full HD screen where each frame only a few short
+      lines move. Two ways to produce the frames:
+        - full: clear the whole back buffer, draw, present the whole buffer
+        - dirty: clear what the previous frame drew, draw while marking the tiles
+          crossed, present the tiles of both frames (shared_dirty_region.cpp)
+      "Present" is a copy into a front buffer, the same memory traffic the X server
+      has on its side of XShmPutImage (with shared_x11.cpp that is one
+      X11PresentRect per dirty_rect).
+
+      Both must give the same front buffer on every frame, the program returns 1
+      otherwise. Then the repetition tester times a cycle of frames of each.
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define CYCLE_FRAME_COUNT 64
+#define LINES_PER_FRAME 8
+#define MAX_LINE_LENGTH 40
+#define MAX_DIRTY_RECT_COUNT 256
+
+struct line
+{
+    int32_t X0;
+    int32_t Y0;
+    int32_t X1;
+    int32_t Y1;
+};
+
+struct dirty_state
+{
+    dirty_region Previous;
+    dirty_region Current;
+    dirty_rect Rects[MAX_DIRTY_RECT_COUNT];
+
+    uint64_t DirtyTileCount;
+    uint64_t RectCount;
+};
+
+static line GlobalLines[CYCLE_FRAME_COUNT][LINES_PER_FRAME];
+
+static void GenerateLines(void)
+{
+    uint32_t State = 0x600DF00D;
+    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+    {
+        for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+        {
+            line *Line = &GlobalLines[FrameIndex][LineIndex];
+            Line->X0 = (int32_t)(RandomU32(&State) % (SCREEN_WIDTH - MAX_LINE_LENGTH));
+            Line->Y0 = (int32_t)(RandomU32(&State) % (SCREEN_HEIGHT - MAX_LINE_LENGTH));
+            Line->X1 = Line->X0 + (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH);
+            Line->Y1 = Line->Y0 + (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Returns the number of bytes touched (clear + present).
+*/
+static uint64_t FullFrame(screen_buffer *Back, screen_buffer *Front, uint32_t FrameIndex)
+{
+    memset(Back->Memory, 0, Back->MemoryCount);
+    for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+    {
+        line Line = GlobalLines[FrameIndex][LineIndex];
+        DrawLine(Back, Line.X0, Line.Y0, Line.X1, Line.Y1, LineColor);
+    }
+    memcpy(Front->Memory, Back->Memory, Back->MemoryCount);
+
+    uint64_t Result = 2*Back->MemoryCount;
+    return Result;
+}
+
+static uint64_t DirtyFrame(screen_buffer *Back, screen_buffer *Front, dirty_state *State, uint32_t FrameIndex)
+{
+    uint64_t Result = 0;
+
+    uint32_t RectCount = GetDirtyRects(&State->Previous, State->Rects, MAX_DIRTY_RECT_COUNT);
+    for(uint32_t RectIndex = 0; RectIndex < RectCount; ++RectIndex)
+    {
+        ClearRect(Back, State->Rects[RectIndex], 0);
+    }
+    Result += GetDirtyPixelCount(State->Rects, RectCount)*Back->BytesPerPixel;
+
+    ResetDirtyRegion(&State->Current);
+    for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+    {
+        line Line = GlobalLines[FrameIndex][LineIndex];
+        MarkDirtyLine(&State->Current, Line.X0, Line.Y0, Line.X1, Line.Y1);
+        DrawLine(Back, Line.X0, Line.Y0, Line.X1, Line.Y1, LineColor);
+    }
+
+    /* NOTE: What was erased has to be presented too */
+    UnionDirtyRegion(&State->Previous, &State->Current);
+    RectCount = GetDirtyRects(&State->Previous, State->Rects, MAX_DIRTY_RECT_COUNT);
+    for(uint32_t RectIndex = 0; RectIndex < RectCount; ++RectIndex)
+    {
+        CopyRect(Front, Back, State->Rects[RectIndex]);
+    }
+    Result += GetDirtyPixelCount(State->Rects, RectCount)*Back->BytesPerPixel;
+
+    State->DirtyTileCount += CountDirtyTiles(&State->Previous);
+    State->RectCount += RectCount;
+
+    dirty_region Swap = State->Previous;
+    State->Previous = State->Current;
+    State->Current = Swap;
+
+    return Result;
+}
+
+static b32 CompareModes(screen_buffer *Back, screen_buffer *Front,
+                        screen_buffer *ExpectedBack, screen_buffer *ExpectedFront,
+                        dirty_state *State)
+{
+    b32 Result = true;
+
+    memset(Back->Memory, 0, Back->MemoryCount);
+    memset(Front->Memory, 0, Front->MemoryCount);
+    ResetDirtyRegion(&State->Previous);
+
+    /* NOTE: Two cycles, the second one starts with the last frame of the first on screen */
+    for(uint32_t FrameIndex = 0; Result && (FrameIndex < 2*CYCLE_FRAME_COUNT); ++FrameIndex)
+    {
+        FullFrame(ExpectedBack, ExpectedFront, FrameIndex % CYCLE_FRAME_COUNT);
+        DirtyFrame(Back, Front, State, FrameIndex % CYCLE_FRAME_COUNT);
+
+        Result = (memcmp(ExpectedFront->Memory, Front->Memory, Front->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Dirty front buffer differs from the full one on frame %u\n", FrameIndex);
+        }
+    }
+
+    return Result;
+}
+
+int main()
+{
+    int Result = 1;
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Back = {};
+    screen_buffer Front = {};
+    screen_buffer ExpectedBack = {};
+    screen_buffer ExpectedFront = {};
+    dirty_state State = {};
+    if(InitScreenBuffer(&Back, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Front, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&ExpectedBack, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&ExpectedFront, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitDirtyRegion(&State.Previous, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitDirtyRegion(&State.Current, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        GenerateLines();
+
+        printf("======= Dirty front buffer against full frames =======\n");
+        if(CompareModes(&Back, &Front, &ExpectedBack, &ExpectedFront, &State))
+        {
+            printf("%u frames compared, all identical\n", 2*CYCLE_FRAME_COUNT);
+            Result = 0;
+
+            /* NOTE: Only the second cycle is the steady state */
+            State.DirtyTileCount = 0;
+            State.RectCount = 0;
+            uint64_t DirtyByteCount = 0;
+            for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+            {
+                DirtyByteCount += DirtyFrame(&Back, &Front, &State, FrameIndex);
+            }
+
+            uint32_t TileCount = State.Previous.TileCountX*State.Previous.TileCountY;
+            printf("Dirty tiles per frame: %.1f of %u (%.1f%%), rectangles per frame: %.1f\n",
+                   (double)State.DirtyTileCount / CYCLE_FRAME_COUNT, TileCount,
+                   100.0*(double)State.DirtyTileCount / ((double)CYCLE_FRAME_COUNT*TileCount),
+                   (double)State.RectCount / CYCLE_FRAME_COUNT);
+
+            uint64_t FullByteCount = CYCLE_FRAME_COUNT*2*(uint64_t)Back.MemoryCount;
+            printf("Bytes touched per frame: full %llu, dirty %llu (%.1fx less)\n\n",
+                   (unsigned long long)(FullByteCount / CYCLE_FRAME_COUNT),
+                   (unsigned long long)(DirtyByteCount / CYCLE_FRAME_COUNT),
+                   (double)FullByteCount / (double)DirtyByteCount);
+
+            repetition_tester Testers[2] = {};
+            for(uint32_t Pass = 0; Pass < 2; ++Pass)
+            {
+                printf("--- Full frames (%u frames) ---\n", CYCLE_FRAME_COUNT);
+                NewTestWave(&Testers[0], FullByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[0]))
+                {
+                    BeginTime(&Testers[0]);
+                    uint64_t ByteCount = 0;
+                    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+                    {
+                        ByteCount += FullFrame(&Back, &Front, FrameIndex);
+                    }
+                    EndTime(&Testers[0]);
+                    CountBytes(&Testers[0], ByteCount);
+                }
+
+                /* NOTE: The full frames left the last frame of the cycle on screen,
+                   which is what the dirty region of the last frame describes */
+                printf("--- Dirty frames (%u frames) ---\n", CYCLE_FRAME_COUNT);
+                NewTestWave(&Testers[1], DirtyByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[1]))
+                {
+                    BeginTime(&Testers[1]);
+                    uint64_t ByteCount = 0;
+                    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+                    {
+                        ByteCount += DirtyFrame(&Back, &Front, &State, FrameIndex);
+                    }
+                    EndTime(&Testers[1]);
+                    CountBytes(&Testers[1], ByteCount);
+                }
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(Result);
+}
@@ -0,0 +1,204 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+static uint32_t ClearColor = (16 << 16) | (16 << 8) | (24 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_dirty_region.cpp"
+#include "shared_kernels.cpp"
+#include "shared_clear.cpp"
+
+/*
+    NOTE(Axel): Clearing the frame (shared_clear.cpp).
+        1. A full clear of a 1920x1080 buffer, scalar stores against streaming
+           stores (the widest the CPU has, shared_kernels.cpp). The gb/s are the
+           clear color written, the real traffic of the scalar one is twice that
+           (every line is read before being written)
+        2. The lazy clear must give the same frame as a full clear + the lines, the
+           program returns 1 otherwise
+        3. Frames of a few short lines: full streaming clear + lines against lazy
+           clear + lines. The gb/s count a whole screen per frame for both, the
+           lazy one only really clears the tiles touched this frame or the last one
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define CYCLE_FRAME_COUNT 64
+#define LINES_PER_FRAME 16
+#define MAX_LINE_LENGTH 100
+
+struct line
+{
+    int32_t X0;
+    int32_t Y0;
+    int32_t X1;
+    int32_t Y1;
+};
+
+static line GlobalLines[CYCLE_FRAME_COUNT][LINES_PER_FRAME];
+
+static void GenerateLines(void)
+{
+    uint32_t State = 0xC1EA2ED;
+    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+    {
+        for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+        {
+            line *Line = &GlobalLines[FrameIndex][LineIndex];
+            Line->X0 = (int32_t)(RandomU32(&State) % (SCREEN_WIDTH - MAX_LINE_LENGTH));
+            Line->Y0 = (int32_t)(RandomU32(&State) % (SCREEN_HEIGHT - MAX_LINE_LENGTH));
+            Line->X1 = Line->X0 + (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH);
+            Line->Y1 = Line->Y0 + (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH);
+        }
+    }
+}
+
+static void FullClearFrame(screen_buffer *Buffer, uint32_t FrameIndex)
+{
+    ClearBufferStreaming(Buffer, ClearColor);
+    for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+    {
+        line Line = GlobalLines[FrameIndex][LineIndex];
+        DrawLine(Buffer, Line.X0, Line.Y0, Line.X1, Line.Y1, LineColor);
+    }
+}
+
+static uint64_t LazyClearFrame(screen_buffer *Buffer, lazy_clear *Lazy, uint32_t FrameIndex)
+{
+    BeginLazyClearFrame(Lazy);
+    for(uint32_t LineIndex = 0; LineIndex < LINES_PER_FRAME; ++LineIndex)
+    {
+        line Line = GlobalLines[FrameIndex][LineIndex];
+        DrawLineLazyClear(Buffer, Lazy, Line.X0, Line.Y0, Line.X1, Line.Y1, LineColor);
+    }
+    EndLazyClearFrame(Buffer, Lazy);
+
+    return Lazy->ClearedByteCount;
+}
+
+static b32 CompareLazyClear(screen_buffer *Buffer, screen_buffer *Expected, lazy_clear *Lazy)
+{
+    b32 Result = true;
+
+    /* NOTE: Garbage first, the lazy clear has to get rid of it */
+    memset(Buffer->Memory, 0xCD, Buffer->MemoryCount);
+
+    for(uint32_t FrameIndex = 0; Result && (FrameIndex < 2*CYCLE_FRAME_COUNT); ++FrameIndex)
+    {
+        FullClearFrame(Expected, FrameIndex % CYCLE_FRAME_COUNT);
+        LazyClearFrame(Buffer, Lazy, FrameIndex % CYCLE_FRAME_COUNT);
+
+        Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Lazy clear differs from the full clear on frame %u\n", FrameIndex);
+        }
+    }
+
+    return Result;
+}
+
+int main()
+{
+    int Result = 1;
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    isa_level Level = SelectRasterKernels(ISA_Count);
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    lazy_clear Lazy = {};
+    if(InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitLazyClear(&Lazy, &Buffer, ClearColor))
+    {
+        GenerateLines();
+
+        printf("======= Lazy clear against full clear =======\n");
+        if(CompareLazyClear(&Buffer, &Expected, &Lazy))
+        {
+            printf("%u frames compared, all identical\n\n", 2*CYCLE_FRAME_COUNT);
+            Result = 0;
+
+            uint64_t LazyClearedByteCount = 0;
+            for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+            {
+                LazyClearedByteCount += LazyClearFrame(&Buffer, &Lazy, FrameIndex);
+            }
+
+            uint64_t FrameByteCount = Buffer.MemoryCount;
+            uint64_t CycleByteCount = CYCLE_FRAME_COUNT*FrameByteCount;
+            repetition_tester Testers[4] = {};
+            for(uint32_t Pass = 0; Pass < 2; ++Pass)
+            {
+                printf("--- Full clear, scalar ---\n");
+                NewTestWave(&Testers[0], FrameByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[0]))
+                {
+                    BeginTime(&Testers[0]);
+                    ClearBufferScalar(&Buffer, ClearColor);
+                    EndTime(&Testers[0]);
+                    CountBytes(&Testers[0], FrameByteCount);
+                }
+
+                printf("--- Full clear, %s streaming ---\n", ISALevelNames[Level]);
+                NewTestWave(&Testers[1], FrameByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[1]))
+                {
+                    BeginTime(&Testers[1]);
+                    ClearBufferStreaming(&Buffer, ClearColor);
+                    EndTime(&Testers[1]);
+                    CountBytes(&Testers[1], FrameByteCount);
+                }
+
+                printf("--- %u frames, streaming clear + %u lines ---\n", CYCLE_FRAME_COUNT, LINES_PER_FRAME);
+                NewTestWave(&Testers[2], CycleByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[2]))
+                {
+                    BeginTime(&Testers[2]);
+                    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+                    {
+                        FullClearFrame(&Buffer, FrameIndex);
+                    }
+                    EndTime(&Testers[2]);
+                    CountBytes(&Testers[2], CycleByteCount);
+                }
+
+                /* NOTE: The full clears left the last frame of the cycle in the buffer,
+                   which is what the lazy clear thinks is there */
+                printf("--- %u frames, lazy clear + %u lines ---\n", CYCLE_FRAME_COUNT, LINES_PER_FRAME);
+                NewTestWave(&Testers[3], CycleByteCount, CPUTimerFreq, 3);
+                while(IsTesting(&Testers[3]))
+                {
+                    BeginTime(&Testers[3]);
+                    for(uint32_t FrameIndex = 0; FrameIndex < CYCLE_FRAME_COUNT; ++FrameIndex)
+                    {
+                        LazyClearFrame(&Buffer, &Lazy, FrameIndex);
+                    }
+                    EndTime(&Testers[3]);
+                    CountBytes(&Testers[3], CycleByteCount);
+                }
+            }
+
+            printf("\nLazy clear really cleared %llu bytes per frame (%.1f%% of the screen)\n",
+                   (unsigned long long)(LazyClearedByteCount / CYCLE_FRAME_COUNT),
+                   100.0*(double)LazyClearedByteCount / (double)CycleByteCount);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(Result);
+}
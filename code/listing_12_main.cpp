@@ -0,0 +1,275 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static uint32_t ClearColor = 0;
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_dirty_region.cpp"
+#include "shared_scene.cpp"
+
+/*
+    NOTE(Axel): Churn benchmark of the retained scene (shared_scene.cpp). A scene of
+      SCENE_SEGMENT_COUNT segments, every frame CHURN of them move somewhere else:
+        - immediate: clear the screen and draw every segment again
+        - retained: move the segments in the scene, UpdateScene redraws their tiles
+      First the scene must give the same pixels as drawing all its segments at once
+      after random adds, removes and moves (returns 1 otherwise), then both are
+      timed for increasing churn. The table uses the average frame, the minimum of
+      the retained one is a frame where the moves happened off screen.
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define SCENE_SEGMENT_COUNT 20000
+#define MAX_SEGMENT_LENGTH 120
+#define MOVE_POOL_COUNT 4096
+
+struct line
+{
+    int32_t X0;
+    int32_t Y0;
+    int32_t X1;
+    int32_t Y1;
+    int32_t Color;
+};
+
+static line GlobalLines[SCENE_SEGMENT_COUNT];
+static scene_handle GlobalHandles[SCENE_SEGMENT_COUNT];
+static line GlobalMoves[MOVE_POOL_COUNT];
+
+/*
+    NOTE(Axel): Some segments stick out of the screen, the scissored draw doesn't care.
+*/
+static line RandomLine(uint32_t *State)
+{
+    line Result;
+    Result.X0 = (int32_t)(RandomU32(State) % (SCREEN_WIDTH + 100)) - 50;
+    Result.Y0 = (int32_t)(RandomU32(State) % (SCREEN_HEIGHT + 100)) - 50;
+    Result.X1 = Result.X0 + (int32_t)(RandomU32(State) % (2*MAX_SEGMENT_LENGTH)) - MAX_SEGMENT_LENGTH;
+    Result.Y1 = Result.Y0 + (int32_t)(RandomU32(State) % (2*MAX_SEGMENT_LENGTH)) - MAX_SEGMENT_LENGTH;
+    Result.Color = (int32_t)(RandomU32(State) & 0xFFFFFF);
+    return Result;
+}
+
+static void DrawImmediate(screen_buffer *Buffer, line *Lines, uint32_t LineCount)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    ClearRect(Buffer, {0, 0, Buffer->Width, Buffer->Height}, ClearColor);
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        line *Line = Lines + LineIndex;
+        DrawLineScissored(Buffer, Line->X0, Line->Y0, Line->X1, Line->Y1, Line->Color, Screen);
+    }
+}
+
+/*
+    NOTE(Axel): The reference draws the live segments in slot order, the scene order.
+*/
+static b32 CompareScene(line_scene *Scene, screen_buffer *Buffer, screen_buffer *Expected)
+{
+    clip_rect Screen = GetScreenClipRect(Expected);
+    ClearRect(Expected, {0, 0, Expected->Width, Expected->Height}, ClearColor);
+    for(uint32_t SegmentIndex = 0; SegmentIndex < Scene->SegmentCount; ++SegmentIndex)
+    {
+        scene_segment *Segment = Scene->Segments + SegmentIndex;
+        if(Segment->Alive)
+        {
+            DrawLineScissored(Expected, Segment->X0, Segment->Y0, Segment->X1, Segment->Y1,
+                              Segment->Color, Screen);
+        }
+    }
+
+    b32 Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+    return Result;
+}
+
+static b32 RunComparison(screen_buffer *Buffer, screen_buffer *Expected)
+{
+    b32 Result = false;
+
+    line_scene Scene = {};
+    if(InitLineScene(&Scene, SCREEN_WIDTH, SCREEN_HEIGHT, 4096, ClearColor))
+    {
+        Result = true;
+
+        static scene_handle Handles[4096];
+        uint32_t HandleCount = 0;
+        uint32_t State = 0x5CE2E;
+        memset(Buffer->Memory, 0xCD, Buffer->MemoryCount);
+
+        for(uint32_t Round = 0; Result && (Round < 200); ++Round)
+        {
+            for(uint32_t Change = 0; Change < 20; ++Change)
+            {
+                uint32_t Action = RandomU32(&State) % 4;
+                if((Action <= 1) || !HandleCount)
+                {
+                    line Line = RandomLine(&State);
+                    scene_handle Handle = AddSegment(&Scene, Line.X0, Line.Y0, Line.X1, Line.Y1, Line.Color);
+                    if(Handle.Value)
+                    {
+                        Handles[HandleCount++] = Handle;
+                    }
+                }
+                else if(Action == 2)
+                {
+                    uint32_t Which = RandomU32(&State) % HandleCount;
+                    RemoveSegment(&Scene, Handles[Which]);
+                    Handles[Which] = Handles[--HandleCount];
+                }
+                else
+                {
+                    line Line = RandomLine(&State);
+                    uint32_t Which = RandomU32(&State) % HandleCount;
+                    MoveSegment(&Scene, Handles[Which], Line.X0, Line.Y0, Line.X1, Line.Y1);
+                }
+            }
+
+            UpdateScene(&Scene, Buffer);
+            Result = CompareScene(&Scene, Buffer, Expected);
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: Scene differs from drawing all its segments at round %u\n", Round);
+            }
+        }
+
+        /* NOTE: Stale handles must be refused */
+        if(Result && HandleCount)
+        {
+            scene_handle Stale = Handles[0];
+            RemoveSegment(&Scene, Stale);
+            Result = !RemoveSegment(&Scene, Stale) && !MoveSegment(&Scene, Stale, 0, 0, 1, 1);
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: Removed handle still accepted\n");
+            }
+        }
+
+        FreeLineScene(&Scene);
+    }
+
+    return Result;
+}
+
+int main()
+{
+    int Result = 1;
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    line_scene Scene = {};
+    if(InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitLineScene(&Scene, SCREEN_WIDTH, SCREEN_HEIGHT, SCENE_SEGMENT_COUNT, ClearColor))
+    {
+        printf("======= Scene against drawing all its segments =======\n");
+        if(RunComparison(&Buffer, &Expected))
+        {
+            printf("200 rounds of adds/removes/moves, all identical\n\n");
+            Result = 0;
+
+            uint32_t State = 0xC4A2;
+            for(uint32_t LineIndex = 0; LineIndex < SCENE_SEGMENT_COUNT; ++LineIndex)
+            {
+                line *Line = GlobalLines + LineIndex;
+                *Line = RandomLine(&State);
+                GlobalHandles[LineIndex] = AddSegment(&Scene, Line->X0, Line->Y0, Line->X1, Line->Y1, Line->Color);
+            }
+
+            for(uint32_t MoveIndex = 0; MoveIndex < MOVE_POOL_COUNT; ++MoveIndex)
+            {
+                GlobalMoves[MoveIndex] = RandomLine(&State);
+            }
+
+            UpdateScene(&Scene, &Buffer);
+
+            uint32_t Churns[] = {0, 1, 10, 100, 1000, 10000};
+            uint32_t ChurnCount = sizeof(Churns)/sizeof(Churns[0]);
+            uint64_t ImmediateTimes[8] = {};
+            uint64_t RetainedTimes[8] = {};
+            double UpdatedTiles[8] = {};
+
+            uint32_t NextMove = 0;
+            uint32_t NextSegment = 0;
+            for(uint32_t ChurnIndex = 0; ChurnIndex < ChurnCount; ++ChurnIndex)
+            {
+                uint32_t Churn = Churns[ChurnIndex];
+                printf("--- %u of %u segments moving per frame ---\n", Churn, SCENE_SEGMENT_COUNT);
+
+                printf("Immediate:\n");
+                repetition_tester Tester = {};
+                NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                while(IsTesting(&Tester))
+                {
+                    BeginTime(&Tester);
+                    for(uint32_t Move = 0; Move < Churn; ++Move)
+                    {
+                        line *Line = GlobalLines + NextSegment;
+                        line *Target = GlobalMoves + NextMove;
+                        Line->X0 = Target->X0; Line->Y0 = Target->Y0;
+                        Line->X1 = Target->X1; Line->Y1 = Target->Y1;
+                        NextSegment = (NextSegment + 1) % SCENE_SEGMENT_COUNT;
+                        NextMove = (NextMove + 1) % MOVE_POOL_COUNT;
+                    }
+                    DrawImmediate(&Expected, GlobalLines, SCENE_SEGMENT_COUNT);
+                    EndTime(&Tester);
+                }
+                ImmediateTimes[ChurnIndex] = Tester.Results.TotalTime / Tester.Results.TestCount;
+
+                printf("Retained:\n");
+                Tester = {};
+                uint64_t TileSum = 0;
+                uint64_t FrameCount = 0;
+                NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                while(IsTesting(&Tester))
+                {
+                    BeginTime(&Tester);
+                    for(uint32_t Move = 0; Move < Churn; ++Move)
+                    {
+                        line *Target = GlobalMoves + NextMove;
+                        MoveSegment(&Scene, GlobalHandles[NextSegment],
+                                    Target->X0, Target->Y0, Target->X1, Target->Y1);
+                        NextSegment = (NextSegment + 1) % SCENE_SEGMENT_COUNT;
+                        NextMove = (NextMove + 1) % MOVE_POOL_COUNT;
+                    }
+                    UpdateScene(&Scene, &Buffer);
+                    EndTime(&Tester);
+
+                    TileSum += Scene.UpdatedTileCount;
+                    ++FrameCount;
+                }
+                RetainedTimes[ChurnIndex] = Tester.Results.TotalTime / Tester.Results.TestCount;
+                UpdatedTiles[ChurnIndex] = FrameCount ? ((double)TileSum / (double)FrameCount) : 0.0;
+                printf("\n");
+            }
+
+            uint32_t TileCount = Scene.Dirty.TileCountX*Scene.Dirty.TileCountY;
+            printf("======= Frame cost against churn (%u segments, %u tiles) =======\n",
+                   SCENE_SEGMENT_COUNT, TileCount);
+            printf("  Churn  Immediate (avg ms)  Retained (avg ms)  Tiles redrawn\n");
+            for(uint32_t ChurnIndex = 0; ChurnIndex < ChurnCount; ++ChurnIndex)
+            {
+                printf("%7u  %18f  %17f  %13.1f\n", Churns[ChurnIndex],
+                       1000.0*SecondsFromCPUTime((double)ImmediateTimes[ChurnIndex], CPUTimerFreq),
+                       1000.0*SecondsFromCPUTime((double)RetainedTimes[ChurnIndex], CPUTimerFreq),
+                       UpdatedTiles[ChurnIndex]);
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(Result);
+}
@@ -0,0 +1,340 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_spatial_index.cpp"
+
+/*
+    NOTE(Axel): Viewport culling of a big static set of segments (shared_spatial_index.cpp).
+      The segments live in a WORLD_SIZE x WORLD_SIZE world, the screen shows a
+      viewport of it, at a few zoom levels, panned somewhere else every frame:
+        - brute force: every segment is transformed to the screen, clipped, drawn
+        - indexed: the grid gives the segments in the viewport, only those are
+          transformed, clipped, drawn
+      Both must give the same pixels and the query must find exactly the segments
+      whose bounding box overlaps the viewport (returns 1 otherwise). Then the build
+      time and the memory of the grid, and the time of a query alone and of both
+      kinds of frames for every zoom. The segments are sorted by cell once the grid
+      is built, without it the indexed frame of a wide view reads them in random
+      order and ends up slower than the brute force.
+
+      --segments N to change the count (10M by default, about 500MB of memory at the peak).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define WORLD_SIZE 65536
+#define MAX_SEGMENT_LENGTH 64
+#define PAN_VIEW_COUNT 64
+
+static void GenerateSegments(line_segment_batch *Segments, uint32_t Count)
+{
+    uint32_t State = 0x5E6D;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        int32_t X0 = (int32_t)(RandomU32(&State) % WORLD_SIZE);
+        int32_t Y0 = (int32_t)(RandomU32(&State) % WORLD_SIZE);
+        int32_t X1 = X0 + (int32_t)(RandomU32(&State) % (2*MAX_SEGMENT_LENGTH + 1)) - MAX_SEGMENT_LENGTH;
+        int32_t Y1 = Y0 + (int32_t)(RandomU32(&State) % (2*MAX_SEGMENT_LENGTH + 1)) - MAX_SEGMENT_LENGTH;
+        PushSegment(Segments, X0, Y0, X1, Y1);
+    }
+}
+
+/*
+    NOTE(Axel): A viewport of the screen aspect ratio, WORLD_SIZE / ZoomDivisor wide,
+      that can stick out of the world a bit.
+*/
+static clip_rect RandomView(uint32_t *State, uint32_t ZoomDivisor)
+{
+    int32_t Width = WORLD_SIZE / (int32_t)ZoomDivisor;
+    int32_t Height = (int32_t)(((int64_t)Width*SCREEN_HEIGHT) / SCREEN_WIDTH);
+
+    clip_rect Result;
+    Result.MinX = (int32_t)(RandomU32(State) % (WORLD_SIZE - Width + 256)) - 128;
+    Result.MinY = (int32_t)(RandomU32(State) % (WORLD_SIZE - Height + 256)) - 128;
+    Result.MaxX = Result.MinX + Width - 1;
+    Result.MaxY = Result.MinY + Height - 1;
+    return Result;
+}
+
+inline int64_t FloorDiv(int64_t A, int64_t B)
+{
+    /* NOTE: B > 0. Rounding towards 0 would bring points just left of the view
+       onto the first column */
+    int64_t Result = (A >= 0) ? (A / B) : -((B - 1 - A) / B);
+    return Result;
+}
+
+struct view_transform
+{
+    clip_rect View;
+    int64_t ViewWidth;
+    int64_t ViewHeight;
+};
+
+inline view_transform GetViewTransform(clip_rect View)
+{
+    view_transform Result;
+    Result.View = View;
+    Result.ViewWidth = (int64_t)View.MaxX - View.MinX + 1;
+    Result.ViewHeight = (int64_t)View.MaxY - View.MinY + 1;
+    return Result;
+}
+
+/*
+    NOTE(Axel): The view maps onto the screen, what is outside the view lands outside
+      the screen, so a segment outside the view can't leave a pixel.
+*/
+inline void DrawWorldSegment(screen_buffer *Buffer, view_transform *Transform, clip_rect Screen,
+                             int32_t WorldX0, int32_t WorldY0, int32_t WorldX1, int32_t WorldY1)
+{
+    int32_t X0 = (int32_t)FloorDiv(((int64_t)WorldX0 - Transform->View.MinX)*SCREEN_WIDTH, Transform->ViewWidth);
+    int32_t Y0 = (int32_t)FloorDiv(((int64_t)WorldY0 - Transform->View.MinY)*SCREEN_HEIGHT, Transform->ViewHeight);
+    int32_t X1 = (int32_t)FloorDiv(((int64_t)WorldX1 - Transform->View.MinX)*SCREEN_WIDTH, Transform->ViewWidth);
+    int32_t Y1 = (int32_t)FloorDiv(((int64_t)WorldY1 - Transform->View.MinY)*SCREEN_HEIGHT, Transform->ViewHeight);
+
+    if(ClipLine(Screen, &X0, &Y0, &X1, &Y1))
+    {
+        DrawLine(Buffer, X0, Y0, X1, Y1, LineColor);
+    }
+}
+
+static void DrawFrameBruteForce(screen_buffer *Buffer, line_segment_batch *Segments, clip_rect View)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    view_transform Transform = GetViewTransform(View);
+
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+    for(uint32_t Index = 0; Index < Segments->Count; ++Index)
+    {
+        DrawWorldSegment(Buffer, &Transform, Screen, Segments->X0[Index], Segments->Y0[Index],
+                         Segments->X1[Index], Segments->Y1[Index]);
+    }
+}
+
+static uint32_t DrawFrameIndexed(screen_buffer *Buffer, segment_grid *Grid, line_segment_batch *Segments,
+                                 clip_rect View, uint32_t *Visible)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    view_transform Transform = GetViewTransform(View);
+
+    uint32_t VisibleCount = QuerySegmentGrid(Grid, Segments, View, Visible, Segments->Count);
+
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+    for(uint32_t VisibleIndex = 0; VisibleIndex < VisibleCount; ++VisibleIndex)
+    {
+        uint32_t Index = Visible[VisibleIndex];
+        DrawWorldSegment(Buffer, &Transform, Screen, Segments->X0[Index], Segments->Y0[Index],
+                         Segments->X1[Index], Segments->Y1[Index]);
+    }
+
+    return VisibleCount;
+}
+
+static uint32_t CountOverlapping(line_segment_batch *Segments, clip_rect View)
+{
+    uint32_t Result = 0;
+    for(uint32_t Index = 0; Index < Segments->Count; ++Index)
+    {
+        int32_t X0 = Segments->X0[Index];
+        int32_t Y0 = Segments->Y0[Index];
+        int32_t X1 = Segments->X1[Index];
+        int32_t Y1 = Segments->Y1[Index];
+        if((((X0 < X1) ? X1 : X0) >= View.MinX) && (((X0 < X1) ? X0 : X1) <= View.MaxX) &&
+           (((Y0 < Y1) ? Y1 : Y0) >= View.MinY) && (((Y0 < Y1) ? Y0 : Y1) <= View.MaxY))
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+static uint32_t ZoomDivisors[] = {1, 4, 16, 64, 256};
+#define ZOOM_COUNT (sizeof(ZoomDivisors)/sizeof(ZoomDivisors[0]))
+
+static b32 CompareWithBruteForce(screen_buffer *Buffer, screen_buffer *Expected, segment_grid *Grid,
+                                 line_segment_batch *Segments, uint32_t *Visible)
+{
+    b32 Result = true;
+
+    uint32_t State = 0xC0FFEE;
+    for(uint32_t ZoomIndex = 0; Result && (ZoomIndex < ZOOM_COUNT); ++ZoomIndex)
+    {
+        for(uint32_t ViewIndex = 0; Result && (ViewIndex < 3); ++ViewIndex)
+        {
+            clip_rect View = RandomView(&State, ZoomDivisors[ZoomIndex]);
+            uint32_t VisibleCount = DrawFrameIndexed(Buffer, Grid, Segments, View, Visible);
+            DrawFrameBruteForce(Expected, Segments, View);
+
+            uint32_t ExpectedCount = CountOverlapping(Segments, View);
+            if(VisibleCount != ExpectedCount)
+            {
+                fprintf(stderr, "ERROR: Query found %u segments instead of %u (zoom 1/%u)\n",
+                        VisibleCount, ExpectedCount, ZoomDivisors[ZoomIndex]);
+                Result = false;
+            }
+            else if(memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) != 0)
+            {
+                fprintf(stderr, "ERROR: Indexed frame differs from brute force (zoom 1/%u)\n",
+                        ZoomDivisors[ZoomIndex]);
+                Result = false;
+            }
+        }
+    }
+
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t SegmentCount = 10000000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--segments") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            SegmentCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    line_segment_batch Segments = {};
+    uint32_t *Visible = (uint32_t *)malloc((size_t)SegmentCount*sizeof(uint32_t));
+    if(SegmentCount && Visible &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateSegmentBatch(&Segments, SegmentCount))
+    {
+        GenerateSegments(&Segments, SegmentCount);
+
+        segment_grid Grid = {};
+        uint64_t BuildStart = ReadCPUTimer();
+        b32 Built = BuildSegmentGrid(&Grid, &Segments);
+        uint64_t BuildTime = ReadCPUTimer() - BuildStart;
+
+        uint64_t SortStart = ReadCPUTimer();
+        Built = Built && SortSegmentsByGridCell(&Grid, &Segments);
+        uint64_t SortTime = ReadCPUTimer() - SortStart;
+
+        if(Built)
+        {
+            uint64_t GridBytes = GetSegmentGridMemory(&Grid);
+            printf("======= Grid over %u segments =======\n", SegmentCount);
+            printf("Build: %.2fms, sort of the segments by cell: %.2fms\n",
+                   1000.0*SecondsFromCPUTime((double)BuildTime, CPUTimerFreq),
+                   1000.0*SecondsFromCPUTime((double)SortTime, CPUTimerFreq));
+            printf("Cells: %ux%u of %u units, %.2f references per segment\n",
+                   Grid.CellCountX, Grid.CellCountY, 1u << Grid.CellShift,
+                   (double)Grid.ReferenceCount / (double)SegmentCount);
+            printf("Memory: %.2fMB, %.2f bytes per segment (+ %u bytes of segment)\n\n",
+                   (double)GridBytes / (1024.0*1024.0), (double)GridBytes / (double)SegmentCount,
+                   (uint32_t)(4*sizeof(int32_t)));
+
+            printf("======= Indexed frames against brute force =======\n");
+            if(CompareWithBruteForce(&Buffer, &Expected, &Grid, &Segments, Visible))
+            {
+                printf("%u views compared, all identical\n\n", (uint32_t)(3*ZOOM_COUNT));
+                Result = 0;
+
+                uint64_t QueryTimes[ZOOM_COUNT] = {};
+                uint64_t IndexedTimes[ZOOM_COUNT] = {};
+                uint64_t BruteForceTimes[ZOOM_COUNT] = {};
+                double VisibleCounts[ZOOM_COUNT] = {};
+
+                for(uint32_t ZoomIndex = 0; ZoomIndex < ZOOM_COUNT; ++ZoomIndex)
+                {
+                    uint32_t ZoomDivisor = ZoomDivisors[ZoomIndex];
+                    clip_rect Views[PAN_VIEW_COUNT];
+                    uint32_t State = 0xBA7 + ZoomIndex;
+                    for(uint32_t ViewIndex = 0; ViewIndex < PAN_VIEW_COUNT; ++ViewIndex)
+                    {
+                        Views[ViewIndex] = RandomView(&State, ZoomDivisor);
+                    }
+
+                    printf("--- Zoom 1/%u ---\n", ZoomDivisor);
+
+                    printf("Query:\n");
+                    repetition_tester Tester = {};
+                    uint32_t ViewIndex = 0;
+                    uint64_t VisibleSum = 0;
+                    uint64_t QueryCount = 0;
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        uint32_t VisibleCount = QuerySegmentGrid(&Grid, &Segments, Views[ViewIndex], Visible, SegmentCount);
+                        EndTime(&Tester);
+
+                        VisibleSum += VisibleCount;
+                        ++QueryCount;
+                        ViewIndex = (ViewIndex + 1) % PAN_VIEW_COUNT;
+                    }
+                    QueryTimes[ZoomIndex] = Tester.Results.TotalTime / Tester.Results.TestCount;
+                    VisibleCounts[ZoomIndex] = (double)VisibleSum / (double)QueryCount;
+
+                    printf("Indexed frame:\n");
+                    Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        DrawFrameIndexed(&Buffer, &Grid, &Segments, Views[ViewIndex], Visible);
+                        EndTime(&Tester);
+
+                        ViewIndex = (ViewIndex + 1) % PAN_VIEW_COUNT;
+                    }
+                    IndexedTimes[ZoomIndex] = Tester.Results.TotalTime / Tester.Results.TestCount;
+
+                    printf("Brute force frame:\n");
+                    Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        DrawFrameBruteForce(&Buffer, &Segments, Views[ViewIndex]);
+                        EndTime(&Tester);
+
+                        ViewIndex = (ViewIndex + 1) % PAN_VIEW_COUNT;
+                    }
+                    BruteForceTimes[ZoomIndex] = Tester.Results.TotalTime / Tester.Results.TestCount;
+                    printf("\n");
+                }
+
+                printf("======= Frame cost against zoom (%u segments) =======\n", SegmentCount);
+                printf("   Zoom  Visible (avg)  Query (avg ms)  Indexed (avg ms)  Brute force (avg ms)\n");
+                for(uint32_t ZoomIndex = 0; ZoomIndex < ZOOM_COUNT; ++ZoomIndex)
+                {
+                    printf("  1/%-3u  %13.0f  %14f  %16f  %20f\n", ZoomDivisors[ZoomIndex],
+                           VisibleCounts[ZoomIndex],
+                           1000.0*SecondsFromCPUTime((double)QueryTimes[ZoomIndex], CPUTimerFreq),
+                           1000.0*SecondsFromCPUTime((double)IndexedTimes[ZoomIndex], CPUTimerFreq),
+                           1000.0*SecondsFromCPUTime((double)BruteForceTimes[ZoomIndex], CPUTimerFreq));
+                }
+            }
+        }
+
+        FreeSegmentGrid(&Grid);
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u segments \n", SegmentCount);
+    }
+
+    return(Result);
+}
@@ -0,0 +1,193 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (80 << 16) | (200 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_decimation.cpp"
+
+/*
+    NOTE(Axel): Decimating dense polylines before the rasterizer (shared_decimation.cpp).
+        1. A time series, millions of points over the 1920 columns (X only goes
+           forward): every segment drawn against DecimatePolylineColumns + draw
+        2. A dense curve going every way (a spiral of tiny segments): every segment
+           drawn against MergeCollinearPoints + draw
+      The decimated polyline must give exactly the pixels of the original one (the
+      program returns 1 otherwise), then the point counts and the timings, the
+      decimation being counted in the frame.
+
+      --points N to change the point count (10M by default).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+
+/*
+    NOTE(Axel): A random walk around a slow sine, snapped to the pixels.
+*/
+static void GenerateTimeSeries(polyline *Polyline, uint32_t PointCount)
+{
+    uint32_t State = 0x7135E;
+    double Walk = 0.0;
+    for(uint32_t Index = 0; Index < PointCount; ++Index)
+    {
+        Walk += ((double)(RandomU32(&State) & 0xFFFF) / 65535.0 - 0.5)*4.0;
+        Walk *= 0.999;
+
+        double T = (double)Index / (double)PointCount;
+        double Value = 0.5*SCREEN_HEIGHT + 300.0*sin(T*6.0*3.14159265358979) + Walk;
+        int32_t X = (int32_t)(((uint64_t)Index*SCREEN_WIDTH) / PointCount);
+        int32_t Y = (int32_t)Value;
+        Y = (Y < 0) ? 0 : ((Y >= SCREEN_HEIGHT) ? (SCREEN_HEIGHT - 1) : Y);
+        PushPoint(Polyline, X, Y);
+    }
+}
+
+/*
+    NOTE(Axel): A spiral with far more points than pixels on its path, lots of repeated
+      points and straight runs once snapped.
+*/
+static void GenerateSpiral(polyline *Polyline, uint32_t PointCount)
+{
+    double CenterX = 0.5*SCREEN_WIDTH;
+    double CenterY = 0.5*SCREEN_HEIGHT;
+    double Turns = 40.0;
+    for(uint32_t Index = 0; Index < PointCount; ++Index)
+    {
+        double T = (double)Index / (double)PointCount;
+        double Angle = T*Turns*2.0*3.14159265358979;
+        double Radius = 10.0 + T*520.0;
+        int32_t X = (int32_t)floor(CenterX + Radius*cos(Angle));
+        int32_t Y = (int32_t)floor(CenterY + Radius*sin(Angle));
+        PushPoint(Polyline, X, Y);
+    }
+}
+
+typedef void decimate_function(polyline *Source, polyline *Dest);
+
+struct decimation_test
+{
+    char const *Name;
+    void (*Generate)(polyline *Polyline, uint32_t PointCount);
+    decimate_function *Decimate;
+};
+
+static void DrawFrame(screen_buffer *Buffer, polyline *Polyline)
+{
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+    DrawPolyline(Buffer, Polyline, LineColor);
+}
+
+static void DrawFrameDecimated(screen_buffer *Buffer, polyline *Polyline, polyline *Decimated,
+                               decimate_function *Decimate)
+{
+    Decimate(Polyline, Decimated);
+    DrawFrame(Buffer, Decimated);
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t PointCount = 10000000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--points") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            PointCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    polyline Polyline = {};
+    polyline Decimated = {};
+    if(PointCount &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocatePolyline(&Polyline, PointCount) &&
+       AllocatePolyline(&Decimated, PointCount))
+    {
+        decimation_test Tests[] =
+        {
+            {"Time series, min/max per column", GenerateTimeSeries, DecimatePolylineColumns},
+            {"Spiral, collinear merge", GenerateSpiral, MergeCollinearPoints},
+        };
+
+        Result = 0;
+        for(uint32_t TestIndex = 0; (Result == 0) && (TestIndex < sizeof(Tests)/sizeof(Tests[0])); ++TestIndex)
+        {
+            decimation_test *Test = Tests + TestIndex;
+            Polyline.Count = 0;
+            Test->Generate(&Polyline, PointCount);
+
+            printf("======= %s =======\n", Test->Name);
+            DrawFrame(&Expected, &Polyline);
+            DrawFrameDecimated(&Buffer, &Polyline, &Decimated, Test->Decimate);
+            if(memcmp(Expected.Memory, Buffer.Memory, Buffer.MemoryCount) != 0)
+            {
+                fprintf(stderr, "ERROR: Decimated polyline doesn't give the same pixels\n");
+                Result = 1;
+                break;
+            }
+
+            printf("Same pixels, %u points -> %u (%.1f per column)\n\n", Polyline.Count, Decimated.Count,
+                   (double)Decimated.Count / (double)SCREEN_WIDTH);
+
+            printf("Every segment:\n");
+            repetition_tester Tester = {};
+            NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                DrawFrame(&Buffer, &Polyline);
+                EndTime(&Tester);
+            }
+            uint64_t FullTime = Tester.Results.TotalTime / Tester.Results.TestCount;
+
+            printf("Decimation alone:\n");
+            Tester = {};
+            NewTestWave(&Tester, (uint64_t)Polyline.Count*2*sizeof(int32_t), CPUTimerFreq, 1);
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                Test->Decimate(&Polyline, &Decimated);
+                EndTime(&Tester);
+                CountBytes(&Tester, (uint64_t)Polyline.Count*2*sizeof(int32_t));
+            }
+
+            printf("Decimated:\n");
+            Tester = {};
+            NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                DrawFrameDecimated(&Buffer, &Polyline, &Decimated, Test->Decimate);
+                EndTime(&Tester);
+            }
+            uint64_t DecimatedTime = Tester.Results.TotalTime / Tester.Results.TestCount;
+
+            printf("\nFrame: %fms every segment, %fms decimated (x%.1f)\n\n",
+                   1000.0*SecondsFromCPUTime((double)FullTime, CPUTimerFreq),
+                   1000.0*SecondsFromCPUTime((double)DecimatedTime, CPUTimerFreq),
+                   (double)FullTime / (double)DecimatedTime);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u points \n", PointCount);
+    }
+
+    return(Result);
+}
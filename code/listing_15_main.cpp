@@ -0,0 +1,382 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_threads.cpp"
+#include "shared_parallel_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_density.cpp"
+
+/*
+    NOTE(Axel): Density plot of random walk trajectories (shared_density.cpp).
+      Checks first (returns 1 if any fails):
+        - the density kernel hits the pixels DrawLine draws
+        - per thread buffers + reduction give the counts of one buffer with every
+          line, and leave the private buffers zeroed
+        - the AVX2 colorize gives the scalar colors, linear and log
+      Then every phase on its own, on 1..N cores (powers of two + all):
+        - accumulation: every thread draws its share in its own buffer
+        - reduction: every thread sums a band of rows of all the buffers
+        - colorize: every thread maps a band of rows through the LUT
+        - frame: the three in a row, with barriers in between
+
+      --trajectories N to change the count (200000 by default, 16 segments each).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define TRAJECTORY_SEGMENT_COUNT 16
+#define MAX_STEP 24
+
+/*
+    NOTE(Axel): Trajectories leave from a few hot spots, so the density has a real range
+      (the log scale has something to show).
+*/
+static void GenerateTrajectories(line_segment_batch *Segments, uint32_t TrajectoryCount)
+{
+    uint32_t State = 0xDE5171;
+    for(uint32_t Trajectory = 0; Trajectory < TrajectoryCount; ++Trajectory)
+    {
+        uint32_t Spot = RandomU32(&State) % 5;
+        int32_t X = (int32_t)(SCREEN_WIDTH*(Spot + 1) / 6) + (int32_t)(RandomU32(&State) % 64) - 32;
+        int32_t Y = (int32_t)(SCREEN_HEIGHT / 2) + (int32_t)(RandomU32(&State) % 64) - 32;
+        for(uint32_t Step = 0; Step < TRAJECTORY_SEGMENT_COUNT; ++Step)
+        {
+            int32_t NextX = ClampToRange(X + (int32_t)(RandomU32(&State) % (2*MAX_STEP + 1)) - MAX_STEP, SCREEN_WIDTH - 1);
+            int32_t NextY = ClampToRange(Y + (int32_t)(RandomU32(&State) % (2*MAX_STEP + 1)) - MAX_STEP, SCREEN_HEIGHT - 1);
+            PushSegment(Segments, X, Y, NextX, NextY);
+            X = NextX;
+            Y = NextY;
+        }
+    }
+}
+
+struct density_frame
+{
+    line_segment_batch *Segments;
+    density_buffer *Private;
+    density_buffer *Total;
+    screen_buffer *Buffer;
+    density_scale Scale;
+
+    thread_barrier Barrier;
+    uint32_t RowMax[MAX_THREAD_COUNT];
+};
+
+struct range
+{
+    uint32_t First;
+    uint32_t OnePastLast;
+};
+
+static range GetThreadRange(uint32_t Count, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    range Result;
+    Result.First = (uint32_t)(((uint64_t)Count*ThreadIndex) / ThreadCount);
+    Result.OnePastLast = (uint32_t)(((uint64_t)Count*(ThreadIndex + 1)) / ThreadCount);
+    return Result;
+}
+
+static uint64_t AccumulateWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    density_frame *Frame = (density_frame *)UserData;
+    range Segments = GetThreadRange(Frame->Segments->Count, ThreadIndex, ThreadCount);
+    AccumulateSegments(Frame->Private + ThreadIndex, Frame->Segments, Segments.First, Segments.OnePastLast);
+
+    uint64_t Result = (uint64_t)(Segments.OnePastLast - Segments.First)*4*sizeof(int32_t);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Bytes are the private buffers read + the total written.
+*/
+static uint64_t ReduceWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    density_frame *Frame = (density_frame *)UserData;
+    range Rows = GetThreadRange(Frame->Total->Height, ThreadIndex, ThreadCount);
+    Frame->RowMax[ThreadIndex] = ReduceDensityRows(Frame->Total, Frame->Private, ThreadCount,
+                                                   Rows.First, Rows.OnePastLast);
+
+    uint64_t Result = ((uint64_t)(Rows.OnePastLast - Rows.First)*Frame->Total->Pitch*
+                       sizeof(uint32_t)*(ThreadCount + 1));
+    return Result;
+}
+
+static uint64_t ColorizeWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    density_frame *Frame = (density_frame *)UserData;
+    range Rows = GetThreadRange(Frame->Total->Height, ThreadIndex, ThreadCount);
+
+    uint32_t MaxCount = 0;
+    for(uint32_t Thread = 0; Thread < ThreadCount; ++Thread)
+    {
+        MaxCount = (Frame->RowMax[Thread] > MaxCount) ? Frame->RowMax[Thread] : MaxCount;
+    }
+
+    /* NOTE: 2KB, cheaper for every thread to build its own than to share it */
+    density_lut Lut;
+    BuildDensityLUT(&Lut, Frame->Scale, MaxCount);
+    ColorizeDensityRows(Frame->Buffer, Frame->Total, &Lut, Rows.First, Rows.OnePastLast);
+
+    uint64_t Result = (uint64_t)(Rows.OnePastLast - Rows.First)*Frame->Total->Width*2*sizeof(uint32_t);
+    return Result;
+}
+
+static uint64_t FrameWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    density_frame *Frame = (density_frame *)UserData;
+
+    uint64_t Result = AccumulateWork(UserData, ThreadIndex, ThreadCount);
+    WaitOnBarrier(&Frame->Barrier);
+    ReduceWork(UserData, ThreadIndex, ThreadCount);
+    WaitOnBarrier(&Frame->Barrier);
+    ColorizeWork(UserData, ThreadIndex, ThreadCount);
+
+    return Result;
+}
+
+static uint64_t GetTargetByteCount(density_frame *Frame, parallel_test_work *Work, uint32_t ThreadCount)
+{
+    uint64_t Result = 0;
+    if(Work == ReduceWork)
+    {
+        Result = (uint64_t)Frame->Total->Height*Frame->Total->Pitch*sizeof(uint32_t)*(ThreadCount + 1);
+    }
+    else if(Work == ColorizeWork)
+    {
+        Result = (uint64_t)Frame->Total->Height*Frame->Total->Width*2*sizeof(uint32_t);
+    }
+    else
+    {
+        Result = (uint64_t)Frame->Segments->Count*4*sizeof(int32_t);
+    }
+
+    return Result;
+}
+
+static b32 RunChecks(density_frame *Frame, uint32_t ThreadCount, density_buffer *Reference,
+                     screen_buffer *Expected)
+{
+    b32 Result = true;
+    line_segment_batch *Segments = Frame->Segments;
+    density_buffer *Total = Frame->Total;
+    size_t CountBytes = (size_t)Total->Pitch*Total->Height*sizeof(uint32_t);
+
+    ClearDensityBuffer(Reference);
+    AccumulateSegments(Reference, Segments, 0, Segments->Count);
+
+    memset(Expected->Memory, 0, Expected->MemoryCount);
+    DrawLineBatch(Expected, Segments, 1);
+    for(uint32_t Y = 0; Result && (Y < Total->Height); ++Y)
+    {
+        uint32_t *Pixel = (uint32_t *)(Expected->Memory + (size_t)Y*Expected->Pitch);
+        uint32_t *Count = Reference->Counts + (size_t)Y*Reference->Pitch;
+        for(uint32_t X = 0; X < Total->Width; ++X)
+        {
+            if((Pixel[X] != 0) != (Count[X] != 0))
+            {
+                fprintf(stderr, "ERROR: Density kernel and DrawLine disagree at (%u, %u)\n", X, Y);
+                Result = false;
+                break;
+            }
+        }
+    }
+
+    if(Result)
+    {
+        /* NOTE: The threads one after the other, same work split */
+        for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            AccumulateWork(Frame, ThreadIndex, ThreadCount);
+        }
+        for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            ReduceWork(Frame, ThreadIndex, ThreadCount);
+        }
+
+        Result = (memcmp(Total->Counts, Reference->Counts, CountBytes) == 0);
+        for(uint32_t ThreadIndex = 0; Result && (ThreadIndex < ThreadCount); ++ThreadIndex)
+        {
+            density_buffer *Private = Frame->Private + ThreadIndex;
+            for(size_t Index = 0; Index < (size_t)Private->Pitch*Private->Height; ++Index)
+            {
+                if(Private->Counts[Index])
+                {
+                    Result = false;
+                    break;
+                }
+            }
+        }
+
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Reduced per thread buffers differ from a single buffer\n");
+        }
+    }
+
+    for(uint32_t ScaleIndex = 0; Result && (ScaleIndex < 2); ++ScaleIndex)
+    {
+        uint32_t MaxCount = 0;
+        for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            MaxCount = (Frame->RowMax[ThreadIndex] > MaxCount) ? Frame->RowMax[ThreadIndex] : MaxCount;
+        }
+
+        density_lut Lut;
+        BuildDensityLUT(&Lut, (density_scale)ScaleIndex, MaxCount);
+        ColorizeDensityRowsScalar(Expected, Total, &Lut, 0, Total->Height);
+        ColorizeDensityRows(Frame->Buffer, Total, &Lut, 0, Total->Height);
+
+        Result = (memcmp(Expected->Memory, Frame->Buffer->Memory, Expected->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: AVX2 colorize differs from the scalar one (%s)\n",
+                    ScaleIndex ? "log" : "linear");
+        }
+    }
+
+    return Result;
+}
+
+struct density_test
+{
+    char const *Label;
+    parallel_test_work *Work;
+};
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    if(DetectISALevel() < ISA_AVX2)
+    {
+        fprintf(stderr, "ERROR: The density kernels need AVX2, this CPU doesn't have it\n");
+        return Result;
+    }
+
+    uint32_t TrajectoryCount = 200000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--trajectories") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            TrajectoryCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    uint32_t CoreCount = GetLogicalCoreCount();
+    CoreCount = (CoreCount > MAX_THREAD_COUNT) ? MAX_THREAD_COUNT : CoreCount;
+
+    static density_buffer Private[MAX_THREAD_COUNT];
+    b32 Allocated = true;
+    for(uint32_t ThreadIndex = 0; ThreadIndex < CoreCount; ++ThreadIndex)
+    {
+        Allocated = Allocated && InitDensityBuffer(Private + ThreadIndex, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    density_buffer Total = {};
+    density_buffer Reference = {};
+    line_segment_batch Segments = {};
+    uint32_t SegmentCount = TrajectoryCount*TRAJECTORY_SEGMENT_COUNT;
+    if(Allocated && SegmentCount &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitDensityBuffer(&Total, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitDensityBuffer(&Reference, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateSegmentBatch(&Segments, SegmentCount))
+    {
+        GenerateTrajectories(&Segments, TrajectoryCount);
+
+        static density_frame Frame;
+        Frame.Segments = &Segments;
+        Frame.Private = Private;
+        Frame.Total = &Total;
+        Frame.Buffer = &Buffer;
+        Frame.Scale = DensityScale_Log;
+
+        printf("%u logical cores, %u segments\n\n", CoreCount, SegmentCount);
+        printf("======= Checks =======\n");
+        if(RunChecks(&Frame, CoreCount, &Reference, &Expected))
+        {
+            uint32_t MaxCount = 0;
+            for(uint32_t ThreadIndex = 0; ThreadIndex < CoreCount; ++ThreadIndex)
+            {
+                MaxCount = (Frame.RowMax[ThreadIndex] > MaxCount) ? Frame.RowMax[ThreadIndex] : MaxCount;
+            }
+            printf("Density kernel, reduction and colorize all match (highest count %u)\n\n", MaxCount);
+            Result = 0;
+
+            density_test Tests[] =
+            {
+                {"Accumulation", AccumulateWork},
+                {"Reduction", ReduceWork},
+                {"Colorize (log)", ColorizeWork},
+                {"Frame", FrameWork},
+            };
+            uint32_t TestCount = sizeof(Tests)/sizeof(Tests[0]);
+
+            uint32_t ThreadCounts[MAX_THREAD_COUNT];
+            uint32_t ThreadCountCount = 0;
+            for(uint32_t ThreadCount = 1; ; )
+            {
+                ThreadCounts[ThreadCountCount++] = ThreadCount;
+                if(ThreadCount == CoreCount)
+                {
+                    break;
+                }
+
+                ThreadCount = ((2*ThreadCount) > CoreCount) ? CoreCount : (2*ThreadCount);
+            }
+
+            static uint64_t MinTimes[4][MAX_THREAD_COUNT];
+            for(uint32_t TestIndex = 0; TestIndex < TestCount; ++TestIndex)
+            {
+                density_test *Test = Tests + TestIndex;
+                for(uint32_t CountIndex = 0; CountIndex < ThreadCountCount; ++CountIndex)
+                {
+                    uint32_t ThreadCount = ThreadCounts[CountIndex];
+                    printf("======= %s: %u threads ======= \n", Test->Label, ThreadCount);
+
+                    InitBarrier(&Frame.Barrier, ThreadCount);
+
+                    static parallel_tester Tester;
+                    RunParallelTest(&Tester, ThreadCount, Test->Work, &Frame,
+                                    GetTargetByteCount(&Frame, Test->Work, ThreadCount), CPUTimerFreq, 2);
+                    PrintParallelResults(&Tester);
+                    printf("\n");
+
+                    MinTimes[TestIndex][CountIndex] = Tester.Results.MinTime;
+                }
+            }
+
+            printf("======= Min time per phase (ms) =======\n");
+            printf("Threads  Accumulation     Reduction      Colorize         Frame\n");
+            for(uint32_t CountIndex = 0; CountIndex < ThreadCountCount; ++CountIndex)
+            {
+                printf("%7u", ThreadCounts[CountIndex]);
+                for(uint32_t TestIndex = 0; TestIndex < TestCount; ++TestIndex)
+                {
+                    printf("  %12f", 1000.0*SecondsFromCPUTime((double)MinTimes[TestIndex][CountIndex], CPUTimerFreq));
+                }
+                printf("\n");
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffers \n");
+    }
+
+    return(Result);
+}
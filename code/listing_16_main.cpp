@@ -0,0 +1,593 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_transform.cpp"
+
+/*
+    NOTE(Axel): Vertex stage (shared_transform.cpp), world floats -> screen integers.
+      Three transforms of the same world segments:
+        - affine: pan, zoom, rotation
+        - projective 3x3: the same map tilted, part of it behind the eye
+        - 4x4: a camera in the middle of a bumpy ground (Z), looking at the horizon,
+          half of the world behind it
+      The AVX2 kernels must give the integers of the scalar ones, pixels and 1/16th
+      of pixel grids, and both must match a real64 reference of the projection and
+      the clip (returns 1 otherwise). The check also runs on a second world of long
+      segments, out to 2^40 units: far off the screen past the guard band, and
+      behind the eye in the projective views. Then scalar against AVX2 for each,
+      and a whole affine frame (transform + clip + draw) to see what is left of it.
+
+      --segments N to change the count (2M by default, 4M end points).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define WORLD_SIZE 4096.0f
+#define MAX_SEGMENT_LENGTH 8.0f
+#define FAR_SEGMENT_COUNT 65536
+
+inline real32 RandomUnilateral(uint32_t *State)
+{
+    real32 Result = (real32)(RandomU32(State) >> 8) / (real32)(1 << 24);
+    return Result;
+}
+
+static void GenerateWorld(world_segment_batch *World, uint32_t SegmentCount)
+{
+    uint32_t State = 0x3D3D3D;
+    for(uint32_t Index = 0; Index < SegmentCount; ++Index)
+    {
+        real32 X0 = RandomUnilateral(&State)*WORLD_SIZE;
+        real32 Y0 = RandomUnilateral(&State)*WORLD_SIZE;
+        real32 X1 = X0 + (RandomUnilateral(&State) - 0.5f)*2.0f*MAX_SEGMENT_LENGTH;
+        real32 Y1 = Y0 + (RandomUnilateral(&State) - 0.5f)*2.0f*MAX_SEGMENT_LENGTH;
+        real32 Z0 = 20.0f*sinf(X0*0.01f)*cosf(Y0*0.013f);
+        real32 Z1 = 20.0f*sinf(X1*0.01f)*cosf(Y1*0.013f);
+        PushWorldSegment(World, X0, Y0, Z0, X1, Y1, Z1);
+    }
+}
+
+/*
+    NOTE(Axel): Segments from 1 to 2^40 units long, in any direction. A quarter of them go
+      out from a point of the world, a quarter come back to it, the other half
+      cross it with both ends far away.
+*/
+static void GenerateFarWorld(world_segment_batch *World, uint32_t SegmentCount)
+{
+    uint32_t State = 0xFA7F00D;
+    for(uint32_t Index = 0; Index < SegmentCount; ++Index)
+    {
+        real32 X = RandomUnilateral(&State)*WORLD_SIZE;
+        real32 Y = RandomUnilateral(&State)*WORLD_SIZE;
+        real32 Angle = RandomUnilateral(&State)*6.2831853f;
+        real32 Length = exp2f(RandomUnilateral(&State)*40.0f);
+        real32 DirX = cosf(Angle);
+        real32 DirY = sinf(Angle);
+
+        real32 X0 = X;
+        real32 Y0 = Y;
+        real32 X1 = X + DirX*Length;
+        real32 Y1 = Y + DirY*Length;
+        switch(Index & 3)
+        {
+            case 1:
+            {
+                X0 = X1; Y0 = Y1;
+                X1 = X; Y1 = Y;
+            } break;
+
+            case 2:
+            case 3:
+            {
+                real32 Back = exp2f(RandomUnilateral(&State)*40.0f);
+                X0 = X - DirX*Back;
+                Y0 = Y - DirY*Back;
+            } break;
+        }
+
+        real32 Z0 = 20.0f*sinf(X0*0.01f)*cosf(Y0*0.013f);
+        real32 Z1 = 20.0f*sinf(X1*0.01f)*cosf(Y1*0.013f);
+        PushWorldSegment(World, X0, Y0, Z0, X1, Y1, Z1);
+    }
+}
+
+/*
+    NOTE(Axel): The flat view tilted away: W is 1 on the bottom row and grows going up,
+      the rows go to the horizon line, the columns to the center. What the flat view
+      has far enough under the bottom of the screen ends up behind the eye.
+        x' = cx + (x - cx)/w
+        y' = horizon + (height - horizon)/w
+        w  = 1 + Tilt*(height - y)
+*/
+static transform_3x3 GetTiltedMapTransform(transform_3x3 View, real32 Tilt)
+{
+    real32 CenterX = 0.5f*SCREEN_WIDTH;
+    real32 Height = (real32)SCREEN_HEIGHT;
+    real32 Horizon = 0.2f*SCREEN_HEIGHT;
+
+    transform_3x3 Projection =
+    {{
+        {1.0f, -CenterX*Tilt, CenterX*Tilt*Height},
+        {0.0f, -Horizon*Tilt, Horizon*Tilt*Height + Height},
+        {0.0f, -Tilt, 1.0f + Tilt*Height},
+    }};
+
+    transform_3x3 Result = Multiply(Projection, View);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Eye at (EyeX, EyeY, Height), looking along +Y, pitched down by Pitch.
+*/
+static transform_4x4 GetCameraTransform(real32 EyeX, real32 EyeY, real32 Height, real32 Pitch)
+{
+    real32 Cos = cosf(Pitch);
+    real32 Sin = sinf(Pitch);
+
+    /* NOTE: Camera space: x right, y down the screen, z forward */
+    transform_4x4 View =
+    {{
+        {1.0f, 0.0f, 0.0f, -EyeX},
+        {0.0f, -Sin, -Cos, Sin*EyeY + Cos*Height},
+        {0.0f, Cos, -Sin, -Cos*EyeY + Sin*Height},
+        {0.0f, 0.0f, 0.0f, 1.0f},
+    }};
+
+    real32 Focal = 0.8f*SCREEN_WIDTH;
+    transform_4x4 Projection =
+    {{
+        {Focal, 0.0f, 0.5f*SCREEN_WIDTH, 0.0f},
+        {0.0f, Focal, 0.5f*SCREEN_HEIGHT, 0.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+    }};
+
+    transform_4x4 Result = Multiply(Projection, View);
+    return Result;
+}
+
+static b32 CompareBatches(line_segment_batch *A, line_segment_batch *B)
+{
+    size_t Size = (size_t)A->Count*sizeof(int32_t);
+    b32 Result = ((A->Count == B->Count) &&
+                  (memcmp(A->X0, B->X0, Size) == 0) && (memcmp(A->Y0, B->Y0, Size) == 0) &&
+                  (memcmp(A->X1, B->X1, Size) == 0) && (memcmp(A->Y1, B->Y1, Size) == 0));
+    return Result;
+}
+
+struct transform_test
+{
+    char const *Name;
+    b32 Is3D;
+    transform_3x3 M3;
+    transform_4x4 M4;
+};
+
+static void RunTransform(transform_test *Test, b32 Scalar, uint32_t SubpixelBits,
+                         world_segment_batch *World, line_segment_batch *Out)
+{
+    if(Test->Is3D)
+    {
+        if(Scalar)
+        {
+            TransformSegmentsScalar(Test->M4, SubpixelBits, World, Out);
+        }
+        else
+        {
+            TransformSegments(Test->M4, SubpixelBits, World, Out);
+        }
+    }
+    else
+    {
+        if(Scalar)
+        {
+            TransformSegmentsScalar(Test->M3, SubpixelBits, World, Out);
+        }
+        else
+        {
+            TransformSegments(Test->M3, SubpixelBits, World, Out);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Reference of the vertex stage, in real64, from the same real32 inputs.
+      The kernels transform in real32, every value the reference finds carries an
+      error bound from it (a few ulps of the sum of the absolute terms), and the
+      check only requires what that bound allows:
+        - a plane distance within the bound of 0, either end: the clip could go
+          both ways, the segment is skipped
+        - nothing left after the clip: (0, 0)-(0, 0)
+        - an end not clipped: exactly the rounded X/W, unless X/W is within the
+          bound of a .5 tie (then that coordinate is skipped)
+        - a clipped end: on the line of the segment (the homogeneous line P0 x P1)
+          within half a pixel of rounding plus the bound carried to that distance,
+          and on the border of the guard band when the guard band clipped it
+*/
+struct reference_stats
+{
+    uint64_t SegmentCount;
+    uint64_t HiddenCount;
+    uint64_t ClippedEndCount;
+    uint64_t SkippedSegmentCount;
+    uint64_t SkippedTieCount;
+};
+
+struct reference_end
+{
+    real64 P[3];
+    real64 Error[3];
+};
+
+#define REFERENCE_EPSILON (1.0 / 16777216.0)
+
+static reference_end TransformReference(real32 *Row[3], uint32_t ColumnCount, real64 *Point)
+{
+    reference_end Result = {};
+    for(uint32_t Coordinate = 0; Coordinate < 3; ++Coordinate)
+    {
+        real64 Value = 0.0;
+        real64 Magnitude = 0.0;
+        for(uint32_t Column = 0; Column < ColumnCount; ++Column)
+        {
+            real64 Term = (real64)Row[Coordinate][Column]*Point[Column];
+            Value += Term;
+            Magnitude += fabs(Term);
+        }
+        Result.P[Coordinate] = Value;
+        Result.Error[Coordinate] = (ColumnCount + 2)*REFERENCE_EPSILON*Magnitude;
+    }
+
+    return Result;
+}
+
+static b32 CheckReferenceEnd(reference_stats *Stats, char const *Name, uint32_t Index, uint32_t EndIndex,
+                             reference_end *End, int32_t *Snapped)
+{
+    b32 Result = true;
+    real64 W = End->P[2];
+    for(uint32_t Coordinate = 0; Coordinate < 2; ++Coordinate)
+    {
+        real64 Value = End->P[Coordinate] / W;
+        real64 Error = 2.0*((End->Error[Coordinate] + fabs(Value)*End->Error[2]) / W +
+                            REFERENCE_EPSILON*fabs(Value));
+        real64 Fraction = Value - floor(Value);
+        if(fabs(Fraction - 0.5) <= Error)
+        {
+            ++Stats->SkippedTieCount;
+        }
+        else if(Snapped[Coordinate] != (int64_t)floor(Value + 0.5))
+        {
+            fprintf(stderr, "ERROR: %s, segment %u end %u: %d instead of %.3f\n",
+                    Name, Index, EndIndex, Snapped[Coordinate], Value);
+            Result = false;
+        }
+    }
+
+    return Result;
+}
+
+static b32 CheckAgainstReference(transform_test *Test, uint32_t SubpixelBits, world_segment_batch *World,
+                                 line_segment_batch *Out, reference_stats *Stats)
+{
+    b32 Result = true;
+
+    transform_3x3 M3 = ScaleToSubpixels(Test->M3, SubpixelBits);
+    transform_4x4 M4 = ScaleToSubpixels(Test->M4, SubpixelBits);
+    real32 *Rows[3] = {M3.E[0], M3.E[1], M3.E[2]};
+    if(Test->Is3D)
+    {
+        Rows[0] = M4.E[0];
+        Rows[1] = M4.E[1];
+        Rows[2] = M4.E[3];
+    }
+
+    real64 Max = TRANSFORM_MAX_COORDINATE;
+    real64 Near = TRANSFORM_NEAR_W;
+    for(uint32_t Index = 0; Result && (Index < Out->Count); ++Index)
+    {
+        real64 Point[2][4] =
+        {
+            {World->X0[Index], World->Y0[Index], 1.0, 1.0},
+            {World->X1[Index], World->Y1[Index], 1.0, 1.0},
+        };
+        if(Test->Is3D)
+        {
+            Point[0][2] = World->Z0[Index];
+            Point[1][2] = World->Z1[Index];
+        }
+
+        reference_end Ends[2];
+        for(uint32_t End = 0; End < 2; ++End)
+        {
+            Ends[End] = TransformReference(Rows, Test->Is3D ? 4 : 3, Point[End]);
+        }
+
+        int32_t Snapped[2][2] =
+        {
+            {Out->X0[Index], Out->Y0[Index]},
+            {Out->X1[Index], Out->Y1[Index]},
+        };
+
+        /* NOTE: Same planes as ProjectSegment: near W, then the guard band */
+        b32 Ambiguous = false;
+        b32 Visible = true;
+        b32 Clipped[2] = {};
+        b32 NearClipped[2] = {};
+        real64 T[2] = {0.0, 1.0};
+        for(uint32_t Plane = 0; Plane < 5; ++Plane)
+        {
+            real64 D[2];
+            for(uint32_t End = 0; End < 2; ++End)
+            {
+                reference_end *E = Ends + End;
+                real64 Sign = (Plane & 1) ? -1.0 : 1.0;
+                uint32_t Axis = (Plane - 1) / 2;
+                real64 Distance = E->P[2] - Near;
+                real64 Error = E->Error[2];
+                if(Plane > 0)
+                {
+                    Distance = Max*E->P[2] + Sign*E->P[Axis];
+                    Error = Max*E->Error[2] + E->Error[Axis];
+                }
+                Ambiguous |= (fabs(Distance) <= 2.0*Error);
+                D[End] = Distance;
+            }
+
+            if((D[0] < 0.0) && (D[1] < 0.0))
+            {
+                Visible = false;
+            }
+            else if(D[0] < 0.0)
+            {
+                real64 Tp = D[0] / (D[0] - D[1]);
+                T[0] = (Tp > T[0]) ? Tp : T[0];
+                Clipped[0] = true;
+                NearClipped[0] |= (Plane == 0);
+            }
+            else if(D[1] < 0.0)
+            {
+                real64 Tp = D[0] / (D[0] - D[1]);
+                T[1] = (Tp < T[1]) ? Tp : T[1];
+                Clipped[1] = true;
+                NearClipped[1] |= (Plane == 0);
+            }
+        }
+        Visible = Visible && (T[0] <= T[1]);
+        Ambiguous |= (Visible && (T[1] - T[0] < 1e-6));
+
+        if(Ambiguous)
+        {
+            ++Stats->SkippedSegmentCount;
+        }
+        else if(!Visible)
+        {
+            ++Stats->HiddenCount;
+            if(Snapped[0][0] || Snapped[0][1] || Snapped[1][0] || Snapped[1][1])
+            {
+                fprintf(stderr, "ERROR: %s, segment %u: nothing is left of it, got (%d, %d)-(%d, %d)\n",
+                        Test->Name, Index, Snapped[0][0], Snapped[0][1], Snapped[1][0], Snapped[1][1]);
+                Result = false;
+            }
+        }
+        else
+        {
+            /* NOTE: The homogeneous line through both ends, and how far its distance can be off */
+            real64 *P0 = Ends[0].P;
+            real64 *P1 = Ends[1].P;
+            real64 Line[3] =
+            {
+                P0[1]*P1[2] - P0[2]*P1[1],
+                P0[2]*P1[0] - P0[0]*P1[2],
+                P0[0]*P1[1] - P0[1]*P1[0],
+            };
+            real64 LineNorm = sqrt(Line[0]*Line[0] + Line[1]*Line[1]);
+            real64 LineError = 2.0*(sqrt(Ends[0].Error[0]*Ends[0].Error[0] + Ends[0].Error[1]*Ends[0].Error[1] +
+                                         Ends[0].Error[2]*Ends[0].Error[2])*sqrt(P1[0]*P1[0] + P1[1]*P1[1] + P1[2]*P1[2]) +
+                                    sqrt(Ends[1].Error[0]*Ends[1].Error[0] + Ends[1].Error[1]*Ends[1].Error[1] +
+                                         Ends[1].Error[2]*Ends[1].Error[2])*sqrt(P0[0]*P0[0] + P0[1]*P0[1] + P0[2]*P0[2]));
+
+            ++Stats->SegmentCount;
+            for(uint32_t End = 0; Result && (End < 2); ++End)
+            {
+                if(!Clipped[End])
+                {
+                    Result = CheckReferenceEnd(Stats, Test->Name, Index, End, Ends + End, Snapped[End]);
+                }
+                else if(LineNorm > 0.0)
+                {
+                    ++Stats->ClippedEndCount;
+                    real64 X = Snapped[End][0];
+                    real64 Y = Snapped[End][1];
+                    real64 Distance = fabs(Line[0]*X + Line[1]*Y + Line[2]) / LineNorm;
+                    real64 Tolerance = 1.0 + LineError*sqrt(X*X + Y*Y + 1.0) / LineNorm;
+
+                    real64 Border = (fabs(X) > fabs(Y)) ? fabs(X) : fabs(Y);
+                    b32 OnBorder = (NearClipped[End] || (Border >= Max - 1.0));
+                    if((Distance > Tolerance) || !OnBorder)
+                    {
+                        fprintf(stderr, "ERROR: %s, segment %u end %u: clipped to (%d, %d), %.3f off the line "
+                                "(%.3f allowed)%s\n", Test->Name, Index, End, Snapped[End][0], Snapped[End][1],
+                                Distance, Tolerance, OnBorder ? "" : ", inside the guard band");
+                        Result = false;
+                    }
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+static void DrawBatchClipped(screen_buffer *Buffer, line_segment_batch *Batch)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        int32_t X0 = Batch->X0[Index];
+        int32_t Y0 = Batch->Y0[Index];
+        int32_t X1 = Batch->X1[Index];
+        int32_t Y1 = Batch->Y1[Index];
+        if(ClipLine(Screen, &X0, &Y0, &X1, &Y1))
+        {
+            DrawLine(Buffer, X0, Y0, X1, Y1, LineColor);
+        }
+    }
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    if(DetectISALevel() < ISA_AVX2)
+    {
+        fprintf(stderr, "ERROR: The transform kernels need AVX2, this CPU doesn't have it\n");
+        return Result;
+    }
+
+    uint32_t SegmentCount = 2000000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--segments") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            SegmentCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffer = {};
+    world_segment_batch World = {};
+    world_segment_batch FarWorld = {};
+    line_segment_batch Expected = {};
+    line_segment_batch Out = {};
+    if(SegmentCount &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateWorldSegmentBatch(&World, SegmentCount) &&
+       AllocateWorldSegmentBatch(&FarWorld, (SegmentCount < FAR_SEGMENT_COUNT) ? SegmentCount : FAR_SEGMENT_COUNT) &&
+       AllocateSegmentBatch(&Expected, SegmentCount) &&
+       AllocateSegmentBatch(&Out, SegmentCount))
+    {
+        GenerateWorld(&World, SegmentCount);
+        GenerateFarWorld(&FarWorld, FarWorld.Capacity);
+
+        transform_3x3 View = GetViewTransform2D(0.5f*WORLD_SIZE, 0.5f*WORLD_SIZE, 0.6f, 0.3f,
+                                                SCREEN_WIDTH, SCREEN_HEIGHT);
+        transform_test Tests[] =
+        {
+            {"Affine 3x3", false, View, {}},
+            {"Projective 3x3", false, GetTiltedMapTransform(View, 4.0f / SCREEN_HEIGHT), {}},
+            {"Camera 4x4", true, {}, GetCameraTransform(0.5f*WORLD_SIZE, 0.5f*WORLD_SIZE, 60.0f, 0.15f)},
+        };
+        uint32_t TestCount = sizeof(Tests)/sizeof(Tests[0]);
+
+        printf("======= AVX2 against scalar against real64 (%u + %u far segments) =======\n",
+               SegmentCount, FarWorld.Count);
+        Result = 0;
+        reference_stats Stats = {};
+        for(uint32_t TestIndex = 0; (Result == 0) && (TestIndex < TestCount); ++TestIndex)
+        {
+            world_segment_batch *Worlds[] = {&World, &FarWorld};
+            uint32_t SubpixelBits[] = {0, 4};
+            for(uint32_t CaseIndex = 0; (Result == 0) && (CaseIndex < 4); ++CaseIndex)
+            {
+                world_segment_batch *CaseWorld = Worlds[CaseIndex / 2];
+                uint32_t Bits = SubpixelBits[CaseIndex % 2];
+                RunTransform(Tests + TestIndex, true, Bits, CaseWorld, &Expected);
+                RunTransform(Tests + TestIndex, false, Bits, CaseWorld, &Out);
+                if(!CompareBatches(&Expected, &Out))
+                {
+                    fprintf(stderr, "ERROR: %s%s, %u subpixel bits: AVX2 differs from scalar\n",
+                            Tests[TestIndex].Name, (CaseWorld == &FarWorld) ? " (far)" : "", Bits);
+                    Result = 1;
+                }
+                else if(!CheckAgainstReference(Tests + TestIndex, Bits, CaseWorld, &Out, &Stats))
+                {
+                    fprintf(stderr, "ERROR: %s%s, %u subpixel bits: differs from the real64 reference\n",
+                            Tests[TestIndex].Name, (CaseWorld == &FarWorld) ? " (far)" : "", Bits);
+                    Result = 1;
+                }
+            }
+        }
+
+        if(Result == 0)
+        {
+            printf("Every transform identical, whole pixels and 4 bits of subpixel\n");
+            printf("Reference: %llu segments drawn (%llu ends clipped), %llu with nothing left, "
+                   "%llu skipped on a plane, %llu coordinates skipped on a tie\n\n",
+                   (unsigned long long)Stats.SegmentCount, (unsigned long long)Stats.ClippedEndCount,
+                   (unsigned long long)Stats.HiddenCount, (unsigned long long)Stats.SkippedSegmentCount,
+                   (unsigned long long)Stats.SkippedTieCount);
+
+            uint64_t Times[3][2] = {};
+            for(uint32_t TestIndex = 0; TestIndex < TestCount; ++TestIndex)
+            {
+                transform_test *Test = Tests + TestIndex;
+                uint64_t InputBytes = (uint64_t)SegmentCount*(Test->Is3D ? 6 : 4)*sizeof(real32);
+                uint64_t ByteCount = InputBytes + (uint64_t)SegmentCount*4*sizeof(int32_t);
+
+                for(uint32_t Scalar = 0; Scalar < 2; ++Scalar)
+                {
+                    printf("--- %s, %s ---\n", Test->Name, Scalar ? "scalar" : "AVX2");
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, ByteCount, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        RunTransform(Test, Scalar, 0, &World, &Out);
+                        EndTime(&Tester);
+                        CountBytes(&Tester, ByteCount);
+                    }
+                    Times[TestIndex][Scalar] = Tester.Results.MinTime;
+                }
+                printf("\n");
+            }
+
+            printf("--- Affine frame: AVX2 transform + clip + draw ---\n");
+            repetition_tester Tester = {};
+            NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                RunTransform(Tests + 0, false, 0, &World, &Out);
+                DrawBatchClipped(&Buffer, &Out);
+                EndTime(&Tester);
+            }
+            uint64_t FrameTime = Tester.Results.MinTime;
+            printf("\n");
+
+            printf("======= Transform of %u end points (min ms) =======\n", 2*SegmentCount);
+            printf("                  Scalar        AVX2   Speed-up  AVX2 ms per million end points\n");
+            for(uint32_t TestIndex = 0; TestIndex < TestCount; ++TestIndex)
+            {
+                double ScalarMs = 1000.0*SecondsFromCPUTime((double)Times[TestIndex][1], CPUTimerFreq);
+                double SimdMs = 1000.0*SecondsFromCPUTime((double)Times[TestIndex][0], CPUTimerFreq);
+                printf("%-14s  %10f  %10f  %8.2fx  %30f\n", Tests[TestIndex].Name, ScalarMs, SimdMs,
+                       ScalarMs / SimdMs, SimdMs / (2.0*SegmentCount / 1000000.0));
+            }
+            printf("Affine frame: %fms, transform is %.1f%% of it\n",
+                   1000.0*SecondsFromCPUTime((double)FrameTime, CPUTimerFreq),
+                   100.0*(double)Times[0][0] / (double)FrameTime);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u segments \n", SegmentCount);
+    }
+
+    return(Result);
+}
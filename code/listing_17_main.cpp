@@ -0,0 +1,574 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_kernels.cpp"
+#include "shared_circle.cpp"
+
+/*
+    NOTE(Axel): Midpoint circles, ellipses and arcs (shared_circle.cpp) against the
+      obvious parametric version: a point every 1/R radian with sinf/cosf, rounded,
+      tested against the screen.
+      Checks first (returns 1 if any fails):
+        - clipped is cropped: shapes crossing the screen edges give the pixels the
+          same shapes drawn whole in a bigger buffer have in that window
+        - an ellipse with two equal radii is the circle
+        - an arc cut in pieces is the arc, a whole turn is the circle
+        - filled rows go exactly from the first to the last outline pixel
+        - ellipses too big for the 64 bits walk (radii up to 200000 crossing the
+          screen) and circles up to a radius of 2^31 - 1: the outline is the edge
+          of the fill and hugs the curve, arcs still tile
+      Then range rings (some crossing the edges), ellipses, quarter arcs and the
+      filled versions with both (the filled ones against rows of sqrtf).
+
+      --rings N to change the count (2000 by default).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define MAX_RADIUS 400
+#define CHECK_MARGIN (MAX_RADIUS + 64)
+#define TAU 6.28318530717958648f
+
+inline int32_t RandomBetween(uint32_t *State, int32_t Min, int32_t Max)
+{
+    int32_t Result = Min + (int32_t)(RandomU32(State) % (uint32_t)(Max - Min + 1));
+    return Result;
+}
+
+inline real32 RandomAngle(uint32_t *State)
+{
+    real32 Result = (real32)(RandomU32(State) % 100000)*(TAU / 100000.0f);
+    return Result;
+}
+
+static void DrawEllipseArcParametric(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY,
+                                     int32_t RadiusX, int32_t RadiusY,
+                                     real32 StartAngle, real32 Sweep, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    int32_t Radius = (RadiusX > RadiusY) ? RadiusX : RadiusY;
+    int32_t StepCount = (int32_t)(Sweep*(real32)Radius) + 1;
+    real32 Step = Sweep / (real32)StepCount;
+    for(int32_t Index = 0; Index <= StepCount; ++Index)
+    {
+        real32 Angle = StartAngle + Step*(real32)Index;
+        int32_t X = CenterX + RoundReal32Toint32_t((real32)RadiusX*cosf(Angle));
+        int32_t Y = CenterY + RoundReal32Toint32_t((real32)RadiusY*sinf(Angle));
+        DrawPixelClipped(Buffer, Screen, X, Y, Color);
+    }
+}
+
+static void FillCircleBySqrt(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY, int32_t Radius, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    for(int32_t Y = -Radius; Y <= Radius; ++Y)
+    {
+        int32_t Half = (int32_t)sqrtf((real32)(Radius*Radius - Y*Y));
+        FillSpan(Buffer, Screen, CenterY + Y, CenterX - Half, CenterX + Half, Color);
+    }
+}
+
+static void FillEllipseBySqrt(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY,
+                              int32_t RadiusX, int32_t RadiusY, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    for(int32_t Y = -RadiusY; Y <= RadiusY; ++Y)
+    {
+        real32 V = (real32)Y / (real32)RadiusY;
+        int32_t Half = (int32_t)((real32)RadiusX*sqrtf(1.0f - V*V));
+        FillSpan(Buffer, Screen, CenterY + Y, CenterX - Half, CenterX + Half, Color);
+    }
+}
+
+struct shape_set
+{
+    circle_batch Circles;
+    int32_t *RadiusY;
+    real32 *StartAngle;
+    real32 *Sweep;
+};
+
+static void GenerateShapes(shape_set *Shapes, uint32_t Count)
+{
+    uint32_t State = 0xC1C1E5;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        PushCircle(&Shapes->Circles,
+                   RandomBetween(&State, -MAX_RADIUS / 2, SCREEN_WIDTH + MAX_RADIUS / 2),
+                   RandomBetween(&State, -MAX_RADIUS / 2, SCREEN_HEIGHT + MAX_RADIUS / 2),
+                   RandomBetween(&State, 4, MAX_RADIUS));
+        Shapes->RadiusY[Index] = RandomBetween(&State, 4, MAX_RADIUS);
+        Shapes->StartAngle[Index] = RandomAngle(&State);
+        Shapes->Sweep[Index] = 0.25f*TAU;
+    }
+}
+
+enum shape_kind
+{
+    Shape_Circle,
+    Shape_Ellipse,
+    Shape_Arc,
+    Shape_FilledCircle,
+    Shape_FilledEllipse,
+
+    Shape_Count,
+};
+
+static char const *ShapeNames[Shape_Count] =
+{
+    "Circle", "Ellipse", "Arc", "Filled circle", "Filled ellipse",
+};
+
+static void DrawShape(screen_buffer *Buffer, shape_kind Kind, int32_t CenterX, int32_t CenterY,
+                      int32_t RadiusX, int32_t RadiusY, real32 StartAngle, real32 EndAngle, int32_t Color)
+{
+    switch(Kind)
+    {
+        case Shape_Circle: DrawCircle(Buffer, CenterX, CenterY, RadiusX, Color); break;
+        case Shape_Ellipse: DrawEllipse(Buffer, CenterX, CenterY, RadiusX, RadiusY, Color); break;
+        case Shape_Arc: DrawArc(Buffer, CenterX, CenterY, RadiusX, StartAngle, EndAngle, Color); break;
+        case Shape_FilledCircle: FillCircle(Buffer, CenterX, CenterY, RadiusX, Color); break;
+        case Shape_FilledEllipse: FillEllipse(Buffer, CenterX, CenterY, RadiusX, RadiusY, Color); break;
+        default: break;
+    }
+}
+
+/*
+    NOTE(Axel): Every shape on the screen and in the big buffer (the screen in its middle,
+      the shapes are never clipped there), the screen must be that window.
+*/
+static b32 CheckClipping(screen_buffer *Screen, screen_buffer *Big)
+{
+    b32 Result = true;
+    uint32_t State = 0xC11BC11B;
+    for(uint32_t Index = 0; Result && (Index < 2000); ++Index)
+    {
+        shape_kind Kind = (shape_kind)(Index % Shape_Count);
+        int32_t CenterX = RandomBetween(&State, -MAX_RADIUS, SCREEN_WIDTH + MAX_RADIUS);
+        int32_t CenterY = RandomBetween(&State, -MAX_RADIUS, SCREEN_HEIGHT + MAX_RADIUS);
+        int32_t RadiusX = RandomBetween(&State, 0, MAX_RADIUS);
+        int32_t RadiusY = RandomBetween(&State, 0, MAX_RADIUS);
+        real32 StartAngle = RandomAngle(&State) - 0.5f*TAU;
+        real32 EndAngle = StartAngle + RandomAngle(&State);
+
+        memset(Screen->Memory, 0, Screen->MemoryCount);
+        memset(Big->Memory, 0, Big->MemoryCount);
+        DrawShape(Screen, Kind, CenterX, CenterY, RadiusX, RadiusY, StartAngle, EndAngle, LineColor);
+        DrawShape(Big, Kind, CenterX + CHECK_MARGIN, CenterY + CHECK_MARGIN, RadiusX, RadiusY,
+                  StartAngle, EndAngle, LineColor);
+
+        for(uint32_t Y = 0; Y < Screen->Height; ++Y)
+        {
+            uint8_t *ScreenRow = Screen->Memory + (size_t)Y*Screen->Pitch;
+            uint8_t *BigRow = Big->Memory + (size_t)(Y + CHECK_MARGIN)*Big->Pitch + CHECK_MARGIN*Big->BytesPerPixel;
+            if(memcmp(ScreenRow, BigRow, Screen->Pitch) != 0)
+            {
+                fprintf(stderr, "ERROR: %s at (%d, %d) radius %d/%d clipped differs from cropped (row %u)\n",
+                        ShapeNames[Kind], CenterX, CenterY, RadiusX, RadiusY, Y);
+                Result = false;
+                break;
+            }
+        }
+    }
+
+    return Result;
+}
+
+static b32 CheckShapes(screen_buffer *A, screen_buffer *B)
+{
+    b32 Result = true;
+    uint32_t State = 0x5EC7;
+    int32_t CenterX = SCREEN_WIDTH / 2;
+    int32_t CenterY = SCREEN_HEIGHT / 2;
+
+    for(int32_t Radius = 0; Result && (Radius < SCREEN_HEIGHT / 2); ++Radius)
+    {
+        memset(A->Memory, 0, A->MemoryCount);
+        memset(B->Memory, 0, B->MemoryCount);
+        DrawCircle(A, CenterX, CenterY, Radius, LineColor);
+        DrawEllipse(B, CenterX, CenterY, Radius, Radius, LineColor);
+        if(memcmp(A->Memory, B->Memory, A->MemoryCount) != 0)
+        {
+            fprintf(stderr, "ERROR: Ellipse of radius %d/%d is not the circle\n", Radius, Radius);
+            Result = false;
+        }
+
+        memset(B->Memory, 0, B->MemoryCount);
+        real32 StartAngle = RandomAngle(&State);
+        DrawArc(B, CenterX, CenterY, Radius, StartAngle, StartAngle + TAU, LineColor);
+        if(Result && (memcmp(A->Memory, B->Memory, A->MemoryCount) != 0))
+        {
+            fprintf(stderr, "ERROR: Whole turn of radius %d is not the circle\n", Radius);
+            Result = false;
+        }
+    }
+
+    for(uint32_t Index = 0; Result && (Index < 2000); ++Index)
+    {
+        int32_t Radius = RandomBetween(&State, 1, SCREEN_HEIGHT / 2 - 1);
+        real32 Start = RandomAngle(&State) - 0.5f*TAU;
+        real32 Middle = Start + 0.5f*RandomAngle(&State);
+        real32 End = Middle + 0.5f*RandomAngle(&State);
+
+        memset(A->Memory, 0, A->MemoryCount);
+        memset(B->Memory, 0, B->MemoryCount);
+        DrawArc(A, CenterX, CenterY, Radius, Start, End, LineColor);
+        DrawArc(B, CenterX, CenterY, Radius, Start, Middle, LineColor);
+        DrawArc(B, CenterX, CenterY, Radius, Middle, End, LineColor);
+        if(memcmp(A->Memory, B->Memory, A->MemoryCount) != 0)
+        {
+            fprintf(stderr, "ERROR: Arc of radius %d from %f to %f differs from its two halves\n",
+                    Radius, Start, End);
+            Result = false;
+        }
+    }
+
+    for(uint32_t Index = 0; Result && (Index < 200); ++Index)
+    {
+        b32 Ellipse = (Index & 1);
+        int32_t RadiusX = RandomBetween(&State, 0, SCREEN_HEIGHT / 2 - 1);
+        int32_t RadiusY = Ellipse ? RandomBetween(&State, 0, SCREEN_HEIGHT / 2 - 1) : RadiusX;
+
+        memset(A->Memory, 0, A->MemoryCount);
+        memset(B->Memory, 0, B->MemoryCount);
+        DrawShape(A, Ellipse ? Shape_Ellipse : Shape_Circle, CenterX, CenterY, RadiusX, RadiusY, 0, 0, LineColor);
+        DrawShape(B, Ellipse ? Shape_FilledEllipse : Shape_FilledCircle, CenterX, CenterY,
+                  RadiusX, RadiusY, 0, 0, LineColor);
+
+        for(uint32_t Y = 0; Result && (Y < A->Height); ++Y)
+        {
+            uint32_t *Outline = (uint32_t *)(A->Memory + (size_t)Y*A->Pitch);
+            uint32_t *Filled = (uint32_t *)(B->Memory + (size_t)Y*B->Pitch);
+
+            int32_t First = A->Width;
+            int32_t Last = -1;
+            for(int32_t X = 0; X < (int32_t)A->Width; ++X)
+            {
+                if(Outline[X])
+                {
+                    First = (X < First) ? X : First;
+                    Last = X;
+                }
+            }
+
+            for(int32_t X = 0; X < (int32_t)A->Width; ++X)
+            {
+                uint32_t Expected = ((X >= First) && (X <= Last)) ? (uint32_t)LineColor : 0;
+                if(Filled[X] != Expected)
+                {
+                    fprintf(stderr, "ERROR: %s of radius %d/%d, row %u isn't filled between its outline\n",
+                            ShapeNames[Ellipse ? Shape_FilledEllipse : Shape_FilledCircle], RadiusX, RadiusY, Y);
+                    Result = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+inline uint32_t ReadPixel(screen_buffer *Buffer, int32_t X, int32_t Y)
+{
+    uint32_t *Pixel = (uint32_t *)(Buffer->Memory + Y*Buffer->Pitch + X*Buffer->BytesPerPixel);
+    return *Pixel;
+}
+
+/*
+    NOTE(Axel): Past MAX_ELLIPSE_WALK_RADIUS there is no walk to compare with, the checks
+      are the definition: an outline pixel is a filled pixel with a neighbor that
+      isn't (neighbors off the screen are unknown, those pixels are skipped), and
+      the curve goes through the 3x3 pixels around it. Divided by the radii that
+      square is a rectangle and the ellipse the unit circle: the curve crosses it
+      when its nearest point is inside the circle and its farthest corner isn't.
+      A has the outline, B the fill.
+*/
+static b32 CheckLargeOutline(screen_buffer *A, screen_buffer *B, char const *Name,
+                             int32_t CenterX, int32_t CenterY, int32_t RadiusX, int32_t RadiusY)
+{
+    b32 Result = true;
+    uint32_t OutlineCount = 0;
+    for(int32_t Y = 0; Result && (Y < (int32_t)A->Height); ++Y)
+    {
+        for(int32_t X = 0; X < (int32_t)A->Width; ++X)
+        {
+            b32 Outline = (ReadPixel(A, X, Y) != 0);
+            b32 Filled = (ReadPixel(B, X, Y) != 0);
+            OutlineCount += Outline;
+
+            b32 Edge = false;
+            b32 Known = ((X > 0) && (Y > 0) && (X < (int32_t)A->Width - 1) && (Y < (int32_t)A->Height - 1));
+            if(Known)
+            {
+                Edge = (Filled && (!ReadPixel(B, X - 1, Y) || !ReadPixel(B, X + 1, Y) ||
+                                   !ReadPixel(B, X, Y - 1) || !ReadPixel(B, X, Y + 1)));
+            }
+
+            int64_t DX = (int64_t)X - CenterX;
+            int64_t DY = (int64_t)Y - CenterY;
+            real64 NearU = (real64)((DX > 1) ? (DX - 1) : ((DX < -1) ? (DX + 1) : 0)) / (real64)RadiusX;
+            real64 NearV = (real64)((DY > 1) ? (DY - 1) : ((DY < -1) ? (DY + 1) : 0)) / (real64)RadiusY;
+            real64 FarU = (real64)((DX < 0) ? (DX - 1) : (DX + 1)) / (real64)RadiusX;
+            real64 FarV = (real64)((DY < 0) ? (DY - 1) : (DY + 1)) / (real64)RadiusY;
+            b32 OnCurve = (((NearU*NearU + NearV*NearV) <= 1.0) && ((FarU*FarU + FarV*FarV) >= 1.0));
+
+            if((Outline && !Filled) || (Known && (Outline != Edge)) || (Outline && !OnCurve))
+            {
+                fprintf(stderr, "ERROR: %s at (%d, %d) radius %d/%d, pixel (%d, %d) %s\n",
+                        Name, CenterX, CenterY, RadiusX, RadiusY, X, Y,
+                        !OnCurve ? "is off the curve" : "isn't the edge of the fill");
+                Result = false;
+                break;
+            }
+        }
+    }
+
+    if(Result && !OutlineCount)
+    {
+        fprintf(stderr, "ERROR: %s at (%d, %d) radius %d/%d missed the screen\n",
+                Name, CenterX, CenterY, RadiusX, RadiusY);
+        Result = false;
+    }
+
+    return Result;
+}
+
+static b32 CheckLargeEllipses(screen_buffer *A, screen_buffer *B)
+{
+    b32 Result = true;
+    int32_t Radii[] = {40000, 60000, 200000};
+    uint32_t RadiusCount = sizeof(Radii)/sizeof(Radii[0]);
+    for(uint32_t RadiusIndex = 0; Result && (RadiusIndex < RadiusCount); ++RadiusIndex)
+    {
+        for(uint32_t Index = 0; Result && (Index < 8); ++Index)
+        {
+            int32_t Radius = Radii[RadiusIndex];
+            int32_t RadiusX = (Index & 2) ? Radius / 3 : Radius;
+            int32_t RadiusY = (Index & 4) ? 7 : Radius;
+
+            /* NOTE: The top of the ellipse or its side goes through the screen */
+            int32_t CenterX = SCREEN_WIDTH / 2;
+            int32_t CenterY = SCREEN_HEIGHT / 2;
+            if(Index & 1)
+            {
+                CenterX += RadiusX - 300;
+            }
+            else
+            {
+                CenterY += RadiusY - 200;
+            }
+
+            memset(A->Memory, 0, A->MemoryCount);
+            memset(B->Memory, 0, B->MemoryCount);
+            DrawEllipse(A, CenterX, CenterY, RadiusX, RadiusY, LineColor);
+            FillEllipse(B, CenterX, CenterY, RadiusX, RadiusY, LineColor);
+            Result = CheckLargeOutline(A, B, "Ellipse", CenterX, CenterY, RadiusX, RadiusY);
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Circles past MAX_CIRCLE_WALK_RADIUS, up to the largest int32 radius (its
+      center barely fits in an int32, the bottom or the right of the circle goes
+      through the screen). Same checks as the ellipses, and a whole turn is the
+      circle, an arc cut in two is the arc.
+*/
+static b32 CheckLargeCircles(screen_buffer *A, screen_buffer *B)
+{
+    b32 Result = true;
+    uint32_t State = 0xB16C;
+    int32_t Radii[] = {40000, 1000000000, 2147483647};
+    uint32_t RadiusCount = sizeof(Radii)/sizeof(Radii[0]);
+    for(uint32_t RadiusIndex = 0; Result && (RadiusIndex < RadiusCount); ++RadiusIndex)
+    {
+        for(uint32_t Index = 0; Result && (Index < 2); ++Index)
+        {
+            int32_t Radius = Radii[RadiusIndex];
+            int32_t CenterX = SCREEN_WIDTH / 2;
+            int32_t CenterY = SCREEN_HEIGHT / 2;
+            if(Index & 1)
+            {
+                CenterX = (int32_t)((int64_t)CenterX - Radius + 300);
+            }
+            else
+            {
+                CenterY = (int32_t)((int64_t)CenterY - Radius + 200);
+            }
+
+            memset(A->Memory, 0, A->MemoryCount);
+            memset(B->Memory, 0, B->MemoryCount);
+            DrawCircle(A, CenterX, CenterY, Radius, LineColor);
+            FillCircle(B, CenterX, CenterY, Radius, LineColor);
+            Result = CheckLargeOutline(A, B, "Circle", CenterX, CenterY, Radius, Radius);
+
+            if(Result)
+            {
+                memset(B->Memory, 0, B->MemoryCount);
+                real32 StartAngle = RandomAngle(&State);
+                DrawArc(B, CenterX, CenterY, Radius, StartAngle, StartAngle + TAU, LineColor);
+                if(memcmp(A->Memory, B->Memory, A->MemoryCount) != 0)
+                {
+                    fprintf(stderr, "ERROR: Whole turn of radius %d is not the circle\n", Radius);
+                    Result = false;
+                }
+            }
+
+            /* NOTE: The visible part is around 0 (right side) or 1/4 turn (bottom) */
+            real32 Visible = (Index & 1) ? 0.0f : 0.25f*TAU;
+            for(uint32_t ArcIndex = 0; Result && (ArcIndex < 16); ++ArcIndex)
+            {
+                real32 Start = Visible - 1e-6f*(real32)RandomBetween(&State, 0, 1000);
+                real32 End = Visible + 1e-6f*(real32)RandomBetween(&State, 0, 1000);
+                real32 Middle = Start + (End - Start)*0.001f*(real32)RandomBetween(&State, 0, 1000);
+
+                memset(A->Memory, 0, A->MemoryCount);
+                memset(B->Memory, 0, B->MemoryCount);
+                DrawArc(A, CenterX, CenterY, Radius, Start, End, LineColor);
+                DrawArc(B, CenterX, CenterY, Radius, Start, Middle, LineColor);
+                DrawArc(B, CenterX, CenterY, Radius, Middle, End, LineColor);
+                if(memcmp(A->Memory, B->Memory, A->MemoryCount) != 0)
+                {
+                    fprintf(stderr, "ERROR: Arc of radius %d from %f to %f differs from its two halves\n",
+                            Radius, Start, End);
+                    Result = false;
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t RingCount = 2000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--rings") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            RingCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    SelectRasterKernels(ISA_Count);
+
+    screen_buffer Buffer = {};
+    screen_buffer Other = {};
+    screen_buffer Big = {};
+    shape_set Shapes = {};
+    buffer ShapeMemory = AllocateBuffer((size_t)RingCount*(sizeof(int32_t) + 2*sizeof(real32)) + 1);
+    if(RingCount && ShapeMemory.Data &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Other, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Big, SCREEN_WIDTH + 2*CHECK_MARGIN, SCREEN_HEIGHT + 2*CHECK_MARGIN) &&
+       AllocateCircleBatch(&Shapes.Circles, RingCount))
+    {
+        Shapes.RadiusY = (int32_t *)ShapeMemory.Data;
+        Shapes.StartAngle = (real32 *)(Shapes.RadiusY + RingCount);
+        Shapes.Sweep = Shapes.StartAngle + RingCount;
+        GenerateShapes(&Shapes, RingCount);
+
+        printf("======= Checks =======\n");
+        if(CheckClipping(&Buffer, &Big) && CheckShapes(&Buffer, &Other) &&
+           CheckLargeEllipses(&Buffer, &Other) && CheckLargeCircles(&Buffer, &Other))
+        {
+            printf("Clipped is cropped, equal radii ellipses are circles, arcs tile, fills follow the outline,\n"
+                   "huge ellipses and circles are the edge of their fill\n\n");
+            Result = 0;
+
+            circle_batch *Circles = &Shapes.Circles;
+            uint64_t MinTimes[Shape_Count][2] = {};
+            for(uint32_t Kind = 0; Kind < Shape_Count; ++Kind)
+            {
+                for(uint32_t Naive = 0; Naive < 2; ++Naive)
+                {
+                    printf("--- %s, %s ---\n", ShapeNames[Kind], Naive ? "parametric" : "midpoint");
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        memset(Buffer.Memory, 0, Buffer.MemoryCount);
+
+                        BeginTime(&Tester);
+                        if((Kind == Shape_Circle) && !Naive)
+                        {
+                            DrawCircleBatch(&Buffer, Circles, LineColor);
+                        }
+                        else if((Kind == Shape_FilledCircle) && !Naive)
+                        {
+                            FillCircleBatch(&Buffer, Circles, LineColor);
+                        }
+                        else
+                        {
+                            for(uint32_t Index = 0; Index < Circles->Count; ++Index)
+                            {
+                                int32_t CenterX = Circles->CenterX[Index];
+                                int32_t CenterY = Circles->CenterY[Index];
+                                int32_t RadiusX = Circles->Radius[Index];
+                                b32 Ellipse = ((Kind == Shape_Ellipse) || (Kind == Shape_FilledEllipse));
+                                int32_t RadiusY = Ellipse ? Shapes.RadiusY[Index] : RadiusX;
+                                real32 StartAngle = Shapes.StartAngle[Index];
+                                real32 Sweep = (Kind == Shape_Arc) ? Shapes.Sweep[Index] : TAU;
+                                if(!Naive)
+                                {
+                                    DrawShape(&Buffer, (shape_kind)Kind, CenterX, CenterY, RadiusX, RadiusY,
+                                              StartAngle, StartAngle + Sweep, LineColor);
+                                }
+                                else if(Kind == Shape_FilledCircle)
+                                {
+                                    FillCircleBySqrt(&Buffer, CenterX, CenterY, RadiusX, LineColor);
+                                }
+                                else if(Kind == Shape_FilledEllipse)
+                                {
+                                    FillEllipseBySqrt(&Buffer, CenterX, CenterY, RadiusX, RadiusY, LineColor);
+                                }
+                                else
+                                {
+                                    DrawEllipseArcParametric(&Buffer, CenterX, CenterY, RadiusX, RadiusY,
+                                                             StartAngle, Sweep, LineColor);
+                                }
+                            }
+                        }
+                        EndTime(&Tester);
+                    }
+                    MinTimes[Kind][Naive] = Tester.Results.MinTime;
+                }
+                printf("\n");
+            }
+
+            printf("======= %u shapes, min ms =======\n", RingCount);
+            printf("                  Midpoint    Parametric  Speed-up\n");
+            for(uint32_t Kind = 0; Kind < Shape_Count; ++Kind)
+            {
+                real64 Midpoint = 1000.0*SecondsFromCPUTime((real64)MinTimes[Kind][0], CPUTimerFreq);
+                real64 Naive = 1000.0*SecondsFromCPUTime((real64)MinTimes[Kind][1], CPUTimerFreq);
+                printf("%-14s  %10f    %10f  %7.2fx\n", ShapeNames[Kind], Midpoint, Naive, Naive / Midpoint);
+            }
+            printf("(no parametric fill, the other column fills rows of sqrtf)\n");
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u shapes \n", RingCount);
+    }
+
+    return(Result);
+}
@@ -0,0 +1,373 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_curve.cpp"
+
+/*
+    NOTE(Axel): Curve flattening (shared_curve.cpp). What we did before: every curve cut
+      in FIXED_SEGMENT_COUNT pieces, each point evaluated on its own. Now: Wang's
+      count for a tolerance, points by AVX2 forward differencing.
+      Checks first (returns 1 if any fails):
+        - the flattened curves stay within the tolerance of the real ones (measured
+          in doubles, between every two points, plus the rounding to pixels)
+        - the polyline and the batch outputs give the same points
+      Then for a few tolerances: segment counts, flattening alone (fixed, adaptive
+      scalar, adaptive AVX2) and flattening + drawing.
+
+      --curves N to change the count (20000 cubics and 20000 quadratics by default).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define FIXED_SEGMENT_COUNT 256
+#define MAX_CURVE_SIZE 600
+
+inline real32 RandomBetween(uint32_t *State, real32 Min, real32 Max)
+{
+    real32 Result = Min + (Max - Min)*((real32)(RandomU32(State) >> 8) / (real32)(1 << 24));
+    return Result;
+}
+
+/*
+    NOTE(Axel): Control points in a box of random size (a few flat curves, many loose
+      ones, some cusps and loops), inside the screen.
+*/
+static void GenerateCurves(cubic_bezier *Cubics, quadratic_bezier *Quadratics, uint32_t Count)
+{
+    uint32_t State = 0xBE21E5;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        real32 Size = RandomBetween(&State, 4.0f, MAX_CURVE_SIZE);
+        real32 MinX = RandomBetween(&State, 0.0f, SCREEN_WIDTH - 1 - Size);
+        real32 MinY = RandomBetween(&State, 0.0f, SCREEN_HEIGHT - 1 - Size);
+        for(uint32_t Point = 0; Point < 4; ++Point)
+        {
+            Cubics[Index].X[Point] = MinX + RandomBetween(&State, 0.0f, Size);
+            Cubics[Index].Y[Point] = MinY + RandomBetween(&State, 0.0f, Size);
+        }
+
+        for(uint32_t Point = 0; Point < 3; ++Point)
+        {
+            Quadratics[Index].X[Point] = MinX + RandomBetween(&State, 0.0f, Size);
+            Quadratics[Index].Y[Point] = MinY + RandomBetween(&State, 0.0f, Size);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Every point evaluated on its own (Horner), SegmentCount equal steps.
+*/
+static void FlattenPolynomialScalar(curve_polynomial *Polynomial, uint32_t SegmentCount,
+                                    real32 EndX, real32 EndY, line_segment_batch *Out)
+{
+    real32 StepT = 1.0f / (real32)SegmentCount;
+    int32_t X0 = (int32_t)lrintf(Polynomial->X[3]);
+    int32_t Y0 = (int32_t)lrintf(Polynomial->Y[3]);
+    for(uint32_t Index = 1; Index <= SegmentCount; ++Index)
+    {
+        real32 T = (real32)Index*StepT;
+        int32_t X1 = (int32_t)lrintf(EvaluatePolynomial(Polynomial->X, T));
+        int32_t Y1 = (int32_t)lrintf(EvaluatePolynomial(Polynomial->Y, T));
+        if(Index == SegmentCount)
+        {
+            X1 = (int32_t)lrintf(EndX);
+            Y1 = (int32_t)lrintf(EndY);
+        }
+
+        PushSegment(Out, X0, Y0, X1, Y1);
+        X0 = X1;
+        Y0 = Y1;
+    }
+}
+
+enum flatten_method
+{
+    Flatten_Fixed,
+    Flatten_AdaptiveScalar,
+    Flatten_Adaptive,
+
+    Flatten_Count,
+};
+
+static char const *FlattenMethodNames[Flatten_Count] =
+{
+    "Fixed", "Adaptive scalar", "Adaptive AVX2",
+};
+
+static void FlattenAll(flatten_method Method, cubic_bezier *Cubics, quadratic_bezier *Quadratics,
+                       uint32_t CurveCount, real32 Tolerance, line_segment_batch *Out)
+{
+    Out->Count = 0;
+    if(Method == Flatten_Adaptive)
+    {
+        FlattenCurves(Cubics, CurveCount, Tolerance, Out);
+        FlattenCurves(Quadratics, CurveCount, Tolerance, Out);
+    }
+    else
+    {
+        for(uint32_t Index = 0; Index < CurveCount; ++Index)
+        {
+            curve_polynomial Polynomial = GetPolynomial(Cubics + Index);
+            uint32_t SegmentCount = ((Method == Flatten_Fixed) ? FIXED_SEGMENT_COUNT :
+                                     GetSegmentCount(Cubics + Index, Tolerance));
+            FlattenPolynomialScalar(&Polynomial, SegmentCount, Cubics[Index].X[3], Cubics[Index].Y[3], Out);
+        }
+
+        for(uint32_t Index = 0; Index < CurveCount; ++Index)
+        {
+            curve_polynomial Polynomial = GetPolynomial(Quadratics + Index);
+            uint32_t SegmentCount = ((Method == Flatten_Fixed) ? FIXED_SEGMENT_COUNT :
+                                     GetSegmentCount(Quadratics + Index, Tolerance));
+            FlattenPolynomialScalar(&Polynomial, SegmentCount, Quadratics[Index].X[2], Quadratics[Index].Y[2], Out);
+        }
+    }
+}
+
+inline real64 EvaluateBezier(real32 *P, uint32_t PointCount, real64 T)
+{
+    real64 S = 1.0 - T;
+    real64 Result = 0.0;
+    if(PointCount == 3)
+    {
+        Result = S*S*P[0] + 2.0*S*T*P[1] + T*T*P[2];
+    }
+    else
+    {
+        Result = S*S*S*P[0] + 3.0*S*S*T*P[1] + 3.0*S*T*T*P[2] + T*T*T*P[3];
+    }
+
+    return Result;
+}
+
+static real64 DistanceToSegment(real64 X, real64 Y, real64 X0, real64 Y0, real64 X1, real64 Y1)
+{
+    real64 DX = X1 - X0;
+    real64 DY = Y1 - Y0;
+    real64 LengthSquared = DX*DX + DY*DY;
+    real64 T = (LengthSquared > 0.0) ? (((X - X0)*DX + (Y - Y0)*DY) / LengthSquared) : 0.0;
+    T = (T < 0.0) ? 0.0 : ((T > 1.0) ? 1.0 : T);
+
+    real64 EX = X0 + T*DX - X;
+    real64 EY = Y0 + T*DY - Y;
+    real64 Result = sqrt(EX*EX + EY*EY);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Between points I and I + 1 (t from I/n to (I + 1)/n) the real curve is
+      sampled and measured against that segment. Returns the worst distance.
+*/
+static real64 MeasureFlatteningError(real32 *X, real32 *Y, uint32_t PointCount, polyline *Points)
+{
+    real64 Result = 0.0;
+    uint32_t SegmentCount = Points->Count - 1;
+    for(uint32_t Index = 0; Index < SegmentCount; ++Index)
+    {
+        for(uint32_t Sample = 0; Sample <= 16; ++Sample)
+        {
+            real64 T = ((real64)Index + (real64)Sample / 16.0) / (real64)SegmentCount;
+            real64 Distance = DistanceToSegment(EvaluateBezier(X, PointCount, T), EvaluateBezier(Y, PointCount, T),
+                                                Points->X[Index], Points->Y[Index],
+                                                Points->X[Index + 1], Points->Y[Index + 1]);
+            Result = (Distance > Result) ? Distance : Result;
+        }
+    }
+
+    return Result;
+}
+
+static b32 CheckFlattening(cubic_bezier *Cubics, quadratic_bezier *Quadratics, uint32_t CurveCount,
+                           polyline *Points, line_segment_batch *Segments)
+{
+    b32 Result = true;
+    real32 Tolerances[] = {0.1f, 0.25f, 1.0f, 4.0f};
+    uint32_t CheckCount = (CurveCount < 2000) ? CurveCount : 2000;
+
+    for(uint32_t ToleranceIndex = 0; Result && (ToleranceIndex < 4); ++ToleranceIndex)
+    {
+        real32 Tolerance = Tolerances[ToleranceIndex];
+
+        /* NOTE: Chords within the tolerance, plus half a diagonal for the rounding */
+        real64 Allowed = Tolerance + 0.7072;
+        real64 WorstError = 0.0;
+        for(uint32_t Index = 0; Result && (Index < 2*CheckCount); ++Index)
+        {
+            b32 Cubic = (Index < CheckCount);
+            uint32_t CurveIndex = Cubic ? Index : (Index - CheckCount);
+            real32 *X = Cubic ? Cubics[CurveIndex].X : Quadratics[CurveIndex].X;
+            real32 *Y = Cubic ? Cubics[CurveIndex].Y : Quadratics[CurveIndex].Y;
+
+            Points->Count = 0;
+            Segments->Count = 0;
+            if(Cubic)
+            {
+                FlattenCurve(Cubics + CurveIndex, Tolerance, Points);
+                FlattenCurves(Cubics + CurveIndex, 1, Tolerance, Segments);
+            }
+            else
+            {
+                FlattenCurve(Quadratics + CurveIndex, Tolerance, Points);
+                FlattenCurves(Quadratics + CurveIndex, 1, Tolerance, Segments);
+            }
+
+            /* NOTE: The polyline drops a start point equal to the last one, it is empty before */
+            b32 Same = (Points->Count == (Segments->Count + 1));
+            for(uint32_t Segment = 0; Same && (Segment < Segments->Count); ++Segment)
+            {
+                Same = ((Segments->X0[Segment] == Points->X[Segment]) && (Segments->Y0[Segment] == Points->Y[Segment]) &&
+                        (Segments->X1[Segment] == Points->X[Segment + 1]) && (Segments->Y1[Segment] == Points->Y[Segment + 1]));
+            }
+
+            if(!Same)
+            {
+                fprintf(stderr, "ERROR: Polyline and batch differ for %s %u\n", Cubic ? "cubic" : "quadratic", CurveIndex);
+                Result = false;
+            }
+
+            real64 Error = MeasureFlatteningError(X, Y, Cubic ? 4 : 3, Points);
+            WorstError = (Error > WorstError) ? Error : WorstError;
+            if(Error > Allowed)
+            {
+                fprintf(stderr, "ERROR: %s %u is %f pixels away from its flattening (tolerance %f)\n",
+                        Cubic ? "Cubic" : "Quadratic", CurveIndex, Error, Tolerance);
+                Result = false;
+            }
+        }
+
+        if(Result)
+        {
+            printf("Tolerance %.2f: worst distance %f (allowed %f)\n", Tolerance, WorstError, Allowed);
+        }
+    }
+
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    if(DetectISALevel() < ISA_AVX2)
+    {
+        fprintf(stderr, "ERROR: The curve kernels need AVX2, this CPU doesn't have it\n");
+        return Result;
+    }
+
+    uint32_t CurveCount = 20000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--curves") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            CurveCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    /* NOTE: The fixed count is the biggest output, the adaptive one at 0.1 pixel comes close */
+    uint32_t SegmentCapacity = 2*CurveCount*FIXED_SEGMENT_COUNT;
+
+    screen_buffer Buffer = {};
+    polyline Points = {};
+    line_segment_batch Segments = {};
+    buffer CurveMemory = AllocateBuffer((size_t)CurveCount*(sizeof(cubic_bezier) + sizeof(quadratic_bezier)) + 1);
+    if(CurveCount && CurveMemory.Data &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocatePolyline(&Points, CURVE_MAX_SEGMENTS + 1) &&
+       AllocateSegmentBatch(&Segments, SegmentCapacity))
+    {
+        cubic_bezier *Cubics = (cubic_bezier *)CurveMemory.Data;
+        quadratic_bezier *Quadratics = (quadratic_bezier *)(Cubics + CurveCount);
+        GenerateCurves(Cubics, Quadratics, CurveCount);
+
+        printf("======= Checks (%u cubics, %u quadratics) =======\n", CurveCount, CurveCount);
+        if(CheckFlattening(Cubics, Quadratics, CurveCount, &Points, &Segments))
+        {
+            printf("\n");
+            Result = 0;
+
+            real32 Tolerances[] = {0.1f, 0.25f, 1.0f};
+            uint32_t ToleranceCount = sizeof(Tolerances)/sizeof(Tolerances[0]);
+            uint64_t FlattenTimes[3][Flatten_Count] = {};
+            uint64_t FrameTimes[3][Flatten_Count] = {};
+            uint32_t SegmentCounts[3][Flatten_Count] = {};
+
+            for(uint32_t ToleranceIndex = 0; ToleranceIndex < ToleranceCount; ++ToleranceIndex)
+            {
+                real32 Tolerance = Tolerances[ToleranceIndex];
+                for(uint32_t Method = 0; Method < Flatten_Count; ++Method)
+                {
+                    if((Method == Flatten_Fixed) && ToleranceIndex)
+                    {
+                        /* NOTE: No tolerance there, same numbers every time */
+                        FlattenTimes[ToleranceIndex][Method] = FlattenTimes[0][Method];
+                        FrameTimes[ToleranceIndex][Method] = FrameTimes[0][Method];
+                        SegmentCounts[ToleranceIndex][Method] = SegmentCounts[0][Method];
+                        continue;
+                    }
+
+                    flatten_method FlattenMethod = (flatten_method)Method;
+                    printf("--- %s, tolerance %.2f: flattening ---\n", FlattenMethodNames[Method], Tolerance);
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        FlattenAll(FlattenMethod, Cubics, Quadratics, CurveCount, Tolerance, &Segments);
+                        EndTime(&Tester);
+                    }
+                    FlattenTimes[ToleranceIndex][Method] = Tester.Results.MinTime;
+                    SegmentCounts[ToleranceIndex][Method] = Segments.Count;
+
+                    printf("--- %s, tolerance %.2f: flattening + drawing ---\n", FlattenMethodNames[Method], Tolerance);
+                    Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                    while(IsTesting(&Tester))
+                    {
+                        memset(Buffer.Memory, 0, Buffer.MemoryCount);
+
+                        BeginTime(&Tester);
+                        FlattenAll(FlattenMethod, Cubics, Quadratics, CurveCount, Tolerance, &Segments);
+                        DrawLineBatch(&Buffer, &Segments, LineColor);
+                        EndTime(&Tester);
+                    }
+                    FrameTimes[ToleranceIndex][Method] = Tester.Results.MinTime;
+                    printf("\n");
+                }
+            }
+
+            printf("======= %u curves, min ms (segments) =======\n", 2*CurveCount);
+            printf("Tolerance  Method                Segments     Flatten  Flatten + draw\n");
+            for(uint32_t ToleranceIndex = 0; ToleranceIndex < ToleranceCount; ++ToleranceIndex)
+            {
+                for(uint32_t Method = 0; Method < Flatten_Count; ++Method)
+                {
+                    printf("%9.2f  %-16s  %12u  %10f  %14f\n", Tolerances[ToleranceIndex], FlattenMethodNames[Method],
+                           SegmentCounts[ToleranceIndex][Method],
+                           1000.0*SecondsFromCPUTime((real64)FlattenTimes[ToleranceIndex][Method], CPUTimerFreq),
+                           1000.0*SecondsFromCPUTime((real64)FrameTimes[ToleranceIndex][Method], CPUTimerFreq));
+                }
+            }
+            printf("(fixed: %u segments per curve whatever the tolerance)\n", FIXED_SEGMENT_COUNT);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u curves \n", CurveCount);
+    }
+
+    return(Result);
+}
@@ -0,0 +1,384 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+static uint32_t ClearColor = (16 << 16) | (16 << 8) | (24 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_dirty_region.cpp"
+#include "shared_kernels.cpp"
+#include "shared_clear.cpp"
+
+/*
+    NOTE(Axel): One binary for every CPU (shared_cpu.cpp, shared_kernels.cpp). The kernels
+      of every level the CPU has are run, the widest is what SelectRasterKernels
+      picks on its own.
+      Checks first, for every level (returns 1 if any differs):
+        - FillRow and BlendRow against the scalar loops, every count up to
+          CHECK_ROW_LENGTH at every start in a cache line, nothing written around
+        - ClearBufferStreaming against ClearBufferScalar
+        - DrawLineBatchRuns against DrawLineBatch
+      Then every kernel at every level, the scalar loop (or DrawLineBatch) as the
+      baseline: clear of the screen, spans filled, spans blended, lines.
+
+      --isa sse2|avx2|avx512 to only run that level (never wider than the CPU),
+      --segments N to change the line count (200000 by default).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define CHECK_ROW_LENGTH 100
+#define CHECK_SEGMENT_COUNT 20000
+#define SPAN_COUNT 100000
+#define MAX_SPAN_LENGTH 512
+#define MAX_LINE_LENGTH 600
+#define BLEND_ALPHA 96
+
+static void FillRowScalar(uint32_t *Pixel, uint32_t Count, uint32_t Color)
+{
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        Pixel[Index] = Color;
+    }
+}
+
+static void BlendRowScalar(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        Pixel[Index] = BlendPixel(Pixel[Index], Color, Alpha);
+    }
+}
+
+struct span
+{
+    uint32_t *Pixel;
+    uint32_t Count;
+};
+
+static void GenerateSpans(screen_buffer *Buffer, span *Spans, uint32_t Count)
+{
+    uint32_t State = 0x5BA45;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        uint32_t Length = 1 + RandomU32(&State) % MAX_SPAN_LENGTH;
+        uint32_t X = RandomU32(&State) % (Buffer->Width - Length + 1);
+        uint32_t Y = RandomU32(&State) % Buffer->Height;
+        Spans[Index].Pixel = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch) + X;
+        Spans[Index].Count = Length;
+    }
+}
+
+/*
+    NOTE(Axel): Every slope, but most of them flat-ish (the minor extent is the major one
+      shifted by 0 to 6): long runs, what the wide stores are for.
+*/
+static void GenerateSegments(line_segment_batch *Batch, uint32_t Count)
+{
+    uint32_t State = 0x11E5;
+    Batch->Count = 0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        int32_t Major = (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH) - MAX_LINE_LENGTH/2;
+        int32_t Minor = (int32_t)(RandomU32(&State) % MAX_LINE_LENGTH) - MAX_LINE_LENGTH/2;
+        Minor /= (1 << (RandomU32(&State) % 7));
+
+        b32 Steep = ((RandomU32(&State) & 7) == 0);
+        int32_t X0 = (int32_t)(RandomU32(&State) % SCREEN_WIDTH);
+        int32_t Y0 = (int32_t)(RandomU32(&State) % SCREEN_HEIGHT);
+        int32_t X1 = ClampToRange(X0 + (Steep ? Minor : Major), SCREEN_WIDTH - 1);
+        int32_t Y1 = ClampToRange(Y0 + (Steep ? Major : Minor), SCREEN_HEIGHT - 1);
+        PushSegment(Batch, X0, Y0, X1, Y1);
+    }
+}
+
+static b32 CheckRows(isa_level Level)
+{
+    b32 Result = true;
+
+    uint32_t State = 0xC0FFEE;
+    uint32_t Expected[CHECK_ROW_LENGTH + 32];
+    uint32_t Actual[CHECK_ROW_LENGTH + 32];
+    for(uint32_t Offset = 0; Result && (Offset < 16); ++Offset)
+    {
+        for(uint32_t Count = 0; Result && (Count <= CHECK_ROW_LENGTH); ++Count)
+        {
+            for(uint32_t Blend = 0; Result && (Blend < 2); ++Blend)
+            {
+                for(uint32_t Index = 0; Index < CHECK_ROW_LENGTH + 32; ++Index)
+                {
+                    Expected[Index] = Actual[Index] = RandomU32(&State);
+                }
+
+                /* NOTE: Both ends of alpha, and anything in between */
+                uint32_t Color = RandomU32(&State);
+                uint32_t Alpha = (Count & 1) ? (RandomU32(&State) & 0xff) : ((Count & 2) ? 255 : 0);
+                if(Blend)
+                {
+                    BlendRowScalar(Expected + Offset, Count, Color, Alpha);
+                    BlendRow(Actual + Offset, Count, Color, Alpha);
+                }
+                else
+                {
+                    FillRowScalar(Expected + Offset, Count, Color);
+                    FillRow(Actual + Offset, Count, Color);
+                }
+
+                Result = (memcmp(Expected, Actual, sizeof(Expected)) == 0);
+                if(!Result)
+                {
+                    fprintf(stderr, "ERROR: %s %s differs from the scalar loop, %u pixels from %u\n",
+                            ISALevelNames[Level], Blend ? "BlendRow" : "FillRow", Count, Offset);
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+static b32 CheckLevel(isa_level Level, screen_buffer *Buffer, screen_buffer *Expected, line_segment_batch *Segments)
+{
+    b32 Result = CheckRows(Level);
+    if(Result)
+    {
+        memset(Buffer->Memory, 0xCD, Buffer->MemoryCount);
+        ClearBufferScalar(Expected, ClearColor);
+        ClearBufferStreaming(Buffer, ClearColor);
+        Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: %s ClearBufferStreaming differs from ClearBufferScalar\n", ISALevelNames[Level]);
+        }
+    }
+
+    if(Result)
+    {
+        DrawLineBatch(Expected, Segments, LineColor);
+        DrawLineBatchRuns(Buffer, Segments, LineColor);
+        Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: %s DrawLineBatchRuns differs from DrawLineBatch\n", ISALevelNames[Level]);
+        }
+    }
+
+    return Result;
+}
+
+enum kernel_test
+{
+    Kernel_Clear,
+    Kernel_Fill,
+    Kernel_Blend,
+    Kernel_Lines,
+
+    Kernel_Count,
+};
+
+static char const *KernelTestNames[Kernel_Count] = {"clear", "fill spans", "blend spans", "lines"};
+
+/*
+    NOTE(Axel): Level ISA_Count is the scalar baseline.
+*/
+static uint64_t TimeKernel(kernel_test Test, uint32_t Level, screen_buffer *Buffer,
+                           span *Spans, uint32_t SpanCount, line_segment_batch *Segments,
+                           uint64_t CPUTimerFreq)
+{
+    b32 Scalar = (Level == ISA_Count);
+    printf("--- %s, %s ---\n", KernelTestNames[Test], Scalar ? "scalar" : ISALevelNames[Level]);
+
+    repetition_tester Tester = {};
+    NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+    while(IsTesting(&Tester))
+    {
+        BeginTime(&Tester);
+        switch(Test)
+        {
+            case Kernel_Clear:
+            {
+                if(Scalar)
+                {
+                    ClearBufferScalar(Buffer, ClearColor);
+                }
+                else
+                {
+                    ClearBufferStreaming(Buffer, ClearColor);
+                }
+            } break;
+
+            case Kernel_Fill:
+            {
+                for(uint32_t Index = 0; Index < SpanCount; ++Index)
+                {
+                    if(Scalar)
+                    {
+                        FillRowScalar(Spans[Index].Pixel, Spans[Index].Count, (uint32_t)LineColor);
+                    }
+                    else
+                    {
+                        FillRow(Spans[Index].Pixel, Spans[Index].Count, (uint32_t)LineColor);
+                    }
+                }
+            } break;
+
+            case Kernel_Blend:
+            {
+                for(uint32_t Index = 0; Index < SpanCount; ++Index)
+                {
+                    if(Scalar)
+                    {
+                        BlendRowScalar(Spans[Index].Pixel, Spans[Index].Count, (uint32_t)LineColor, BLEND_ALPHA);
+                    }
+                    else
+                    {
+                        BlendRow(Spans[Index].Pixel, Spans[Index].Count, (uint32_t)LineColor, BLEND_ALPHA);
+                    }
+                }
+            } break;
+
+            case Kernel_Lines:
+            {
+                if(Scalar)
+                {
+                    DrawLineBatch(Buffer, Segments, LineColor);
+                }
+                else
+                {
+                    DrawLineBatchRuns(Buffer, Segments, LineColor);
+                }
+            } break;
+
+            default: break;
+        }
+        EndTime(&Tester);
+    }
+    printf("\n");
+
+    return Tester.Results.MinTime;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t SegmentCount = 200000;
+    isa_level Forced = ISA_Count;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--segments") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            SegmentCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--isa") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            Forced = GetISALevelFromName(Args[++ArgIndex]);
+            if(Forced == ISA_Count)
+            {
+                fprintf(stderr, "ERROR: Unknown level %s (sse2, avx2 or avx512)\n", Args[ArgIndex]);
+                return Result;
+            }
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    isa_level Supported = DetectISALevel();
+    uint32_t FirstLevel = ISA_SSE2;
+    uint32_t LastLevel = Supported;
+    if(Forced != ISA_Count)
+    {
+        FirstLevel = LastLevel = (Forced < Supported) ? Forced : Supported;
+    }
+
+    printf("CPU: up to %s, running", ISALevelNames[Supported]);
+    for(uint32_t Level = FirstLevel; Level <= LastLevel; ++Level)
+    {
+        printf(" %s", ISALevelNames[Level]);
+    }
+    printf("\n\n");
+
+    uint32_t SegmentCapacity = (SegmentCount > CHECK_SEGMENT_COUNT) ? SegmentCount : CHECK_SEGMENT_COUNT;
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    line_segment_batch Segments = {};
+    buffer SpanMemory = AllocateBuffer(SPAN_COUNT*sizeof(span));
+    if(SpanMemory.Data &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateSegmentBatch(&Segments, SegmentCapacity))
+    {
+        printf("======= Checks =======\n");
+        GenerateSegments(&Segments, CHECK_SEGMENT_COUNT);
+
+        Result = 0;
+        for(uint32_t Level = FirstLevel; (Result == 0) && (Level <= LastLevel); ++Level)
+        {
+            SelectRasterKernels((isa_level)Level);
+            if(!CheckLevel((isa_level)Level, &Buffer, &Expected, &Segments))
+            {
+                Result = 1;
+            }
+        }
+
+        if(Result == 0)
+        {
+            printf("Fill, blend, clear and lines identical to the scalar code at every level\n\n");
+
+            span *Spans = (span *)SpanMemory.Data;
+            GenerateSpans(&Buffer, Spans, SPAN_COUNT);
+            GenerateSegments(&Segments, SegmentCount);
+
+            /* NOTE: ISA_Count for the scalar baseline */
+            uint64_t Times[Kernel_Count][ISA_Count + 1] = {};
+            for(uint32_t Test = 0; Test < Kernel_Count; ++Test)
+            {
+                Times[Test][ISA_Count] = TimeKernel((kernel_test)Test, ISA_Count, &Buffer,
+                                                    Spans, SPAN_COUNT, &Segments, CPUTimerFreq);
+                for(uint32_t Level = FirstLevel; Level <= LastLevel; ++Level)
+                {
+                    SelectRasterKernels((isa_level)Level);
+                    Times[Test][Level] = TimeKernel((kernel_test)Test, Level, &Buffer,
+                                                    Spans, SPAN_COUNT, &Segments, CPUTimerFreq);
+                }
+            }
+
+            printf("======= Min ms (%u spans, %u lines) =======\n", SPAN_COUNT, SegmentCount);
+            printf("%-12s  %10s", "Kernel", "scalar");
+            for(uint32_t Level = FirstLevel; Level <= LastLevel; ++Level)
+            {
+                printf("  %10s", ISALevelNames[Level]);
+            }
+            printf("\n");
+
+            for(uint32_t Test = 0; Test < Kernel_Count; ++Test)
+            {
+                printf("%-12s  %10f", KernelTestNames[Test],
+                       1000.0*SecondsFromCPUTime((real64)Times[Test][ISA_Count], CPUTimerFreq));
+                for(uint32_t Level = FirstLevel; Level <= LastLevel; ++Level)
+                {
+                    printf("  %10f", 1000.0*SecondsFromCPUTime((real64)Times[Test][Level], CPUTimerFreq));
+                }
+                printf("\n");
+            }
+            printf("(scalar lines: DrawLineBatch, the others DrawLineBatchRuns)\n");
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u segments \n", SegmentCapacity);
+    }
+
+    return(Result);
+}
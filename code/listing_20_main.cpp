@@ -0,0 +1,334 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static uint32_t LineColor = (255 << 16) | (160 << 8) | (32 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_kernels.cpp"
+#include "shared_line_kernels.cpp"
+
+/*
+    NOTE(Axel): Line kernels generated per octant, pixel format and write mode
+      (shared_line_kernels.cpp) against one loop that looks at the format and the
+      mode for every pixel (DrawLineGeneric below, what you write first).
+      Checks first (returns 1 if any differs):
+        - BGRX8888 opaque kernels give the pixels of DrawLineBatch
+        - every format and mode gives the bytes of DrawLineGeneric, which blends and
+          adds with its own per channel formulas
+      Then every format and mode, generic loop against the kernel table.
+
+      --segments N to change the count (200000 by default).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define MAX_LINE_LENGTH 400
+#define LINE_ALPHA 96
+
+static void GenerateSegments(line_segment_batch *Batch, uint32_t Count)
+{
+    uint32_t State = 0x0C7A;
+    Batch->Count = 0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        int32_t X0 = (int32_t)(RandomU32(&State) % SCREEN_WIDTH);
+        int32_t Y0 = (int32_t)(RandomU32(&State) % SCREEN_HEIGHT);
+        int32_t X1 = X0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+        int32_t Y1 = Y0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+        PushSegment(Batch, X0, Y0, ClampToRange(X1, SCREEN_WIDTH - 1), ClampToRange(Y1, SCREEN_HEIGHT - 1));
+    }
+}
+
+/*
+    NOTE(Axel): The formulas written out again, nothing from shared_line_kernels.cpp, so
+      the check covers the channel math of the kernels and not only their table. A
+      blend is S*A + D*(255 - A) over 255 rounded to nearest (never a tie, 255 is
+      odd), an add is the sum of the channels capped at their maximum.
+*/
+inline uint32_t BlendReference(uint32_t Source, uint32_t Dest, uint32_t Alpha)
+{
+    uint32_t Result = (Source*Alpha + Dest*(255 - Alpha) + 127) / 255;
+    return Result;
+}
+
+inline uint32_t WriteChannelReference(uint32_t Dest, uint32_t Source, uint32_t Max,
+                                      line_write_mode Mode, uint32_t Alpha)
+{
+    uint32_t Result = Source;
+    if(Mode == LineWrite_Blend)
+    {
+        Result = BlendReference(Source, Dest, Alpha);
+    }
+    else if(Mode == LineWrite_Add)
+    {
+        Result = (Dest + Source > Max) ? Max : (Dest + Source);
+    }
+
+    return Result;
+}
+
+static void WritePixelReference(uint8_t *Pixel, pixel_format Format, line_write_mode Mode, line_paint Paint)
+{
+    switch(Format)
+    {
+        case PixelFormat_BGRX8888:
+        {
+            /* NOTE: Byte I of the pixel is byte I of the color, X included */
+            for(uint32_t Index = 0; Index < 4; ++Index)
+            {
+                uint32_t Source = (Paint.Color >> (8*Index)) & 0xff;
+                Pixel[Index] = (uint8_t)WriteChannelReference(Pixel[Index], Source, 255, Mode, Paint.Alpha);
+            }
+        } break;
+
+        case PixelFormat_RGB565:
+        {
+            uint16_t Dest = *(uint16_t *)Pixel;
+            uint32_t R = WriteChannelReference((Dest >> 11) & 31, (Paint.Color >> 11) & 31, 31, Mode, Paint.Alpha);
+            uint32_t G = WriteChannelReference((Dest >> 5) & 63, (Paint.Color >> 5) & 63, 63, Mode, Paint.Alpha);
+            uint32_t B = WriteChannelReference(Dest & 31, Paint.Color & 31, 31, Mode, Paint.Alpha);
+            *(uint16_t *)Pixel = (uint16_t)((R << 11) | (G << 5) | B);
+        } break;
+
+        default:
+        {
+            *Pixel = (uint8_t)WriteChannelReference(*Pixel, Paint.Color & 0xff, 255, Mode, Paint.Alpha);
+        } break;
+    }
+}
+
+/*
+    NOTE(Axel): Steps at runtime, a switch on the format and one on the mode per pixel.
+*/
+static void DrawLineGeneric(line_target *Target, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1,
+                            line_write_mode Mode, line_paint Paint)
+{
+    intptr_t BytesPerPixel = PixelFormatBytes[Target->Format];
+
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    intptr_t StepX = BytesPerPixel;
+    intptr_t StepY = Target->Pitch;
+    if(dx < 0)
+    {
+        dx = -dx;
+        StepX = -StepX;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        StepY = -StepY;
+    }
+
+    int32_t Major = dx;
+    int32_t Minor = dy;
+    intptr_t MajorStep = StepX;
+    intptr_t MinorStep = StepY;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = StepY;
+        MinorStep = StepX;
+    }
+
+    int32_t decision    = (2 * Minor) - Major;
+    int32_t IncrementNE = (2 * (Minor - Major));
+    int32_t IncrementE  = (2 * Minor);
+
+    uint8_t *Pixel = Target->Memory + (intptr_t)Y0*Target->Pitch + (intptr_t)X0*BytesPerPixel;
+    for(int32_t Count = Major; Count > 0; --Count)
+    {
+        if(decision <= 0)
+        {
+            decision += IncrementE;
+        }
+        else
+        {
+            Pixel += MinorStep;
+            decision += IncrementNE;
+        }
+
+        WritePixelReference(Pixel, Target->Format, Mode, Paint);
+
+        Pixel += MajorStep;
+    }
+}
+
+static void DrawLineBatchGeneric(line_target *Target, line_segment_batch *Batch, line_write_mode Mode, line_paint Paint)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawLineGeneric(Target, Batch->X0[Index], Batch->Y0[Index], Batch->X1[Index], Batch->Y1[Index], Mode, Paint);
+    }
+}
+
+/*
+    NOTE(Axel): Same starting garbage in both, the blend and add read it.
+*/
+static void FillWithNoise(buffer *Memory)
+{
+    uint32_t State = 0x7E57;
+    for(size_t Index = 0; Index < Memory->Count; ++Index)
+    {
+        Memory->Data[Index] = (uint8_t)RandomU32(&State);
+    }
+}
+
+static line_target GetTarget(buffer *Memory, pixel_format Format)
+{
+    line_target Result = {};
+    Result.Memory = Memory->Data;
+    Result.Pitch = SCREEN_WIDTH*PixelFormatBytes[Format];
+    Result.Width = SCREEN_WIDTH;
+    Result.Height = SCREEN_HEIGHT;
+    Result.Format = Format;
+    return Result;
+}
+
+static line_paint GetPaint(pixel_format Format)
+{
+    line_paint Result = {};
+    Result.Color = PackColor(Format, LineColor);
+    Result.Alpha = LINE_ALPHA;
+    return Result;
+}
+
+static b32 CheckKernels(line_segment_batch *Segments, buffer *Expected, buffer *Actual)
+{
+    b32 Result = true;
+
+    screen_buffer Screen = {};
+    if(InitScreenBuffer(&Screen, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        line_target Target = GetLineTarget(&Screen);
+        DrawLineBatch(&Screen, Segments, (int32_t)LineColor);
+        memcpy(Expected->Data, Screen.Memory, Screen.MemoryCount);
+        memset(Screen.Memory, 0, Screen.MemoryCount);
+        DrawLineBatchWith(&Target, Segments, LineWrite_Opaque, GetPaint(PixelFormat_BGRX8888));
+
+        Result = (memcmp(Expected->Data, Screen.Memory, Screen.MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: BGRX8888 opaque kernels differ from DrawLineBatch\n");
+        }
+        FreeScreenBuffer(&Screen);
+    }
+
+    for(uint32_t Format = 0; Result && (Format < PixelFormat_Count); ++Format)
+    {
+        for(uint32_t Mode = 0; Result && (Mode < LineWrite_Count); ++Mode)
+        {
+            line_target ExpectedTarget = GetTarget(Expected, (pixel_format)Format);
+            line_target ActualTarget = GetTarget(Actual, (pixel_format)Format);
+            FillWithNoise(Expected);
+            FillWithNoise(Actual);
+
+            line_paint Paint = GetPaint((pixel_format)Format);
+            DrawLineBatchGeneric(&ExpectedTarget, Segments, (line_write_mode)Mode, Paint);
+            DrawLineBatchWith(&ActualTarget, Segments, (line_write_mode)Mode, Paint);
+
+            Result = (memcmp(Expected->Data, Actual->Data, Expected->Count) == 0);
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: %s %s kernels differ from the generic loop\n",
+                        PixelFormatNames[Format], LineWriteModeNames[Mode]);
+            }
+        }
+    }
+
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t SegmentCount = 200000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--segments") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            SegmentCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    line_segment_batch Segments = {};
+    size_t TargetSize = (size_t)SCREEN_WIDTH*SCREEN_HEIGHT*4;
+    buffer Expected = AllocateBuffer(TargetSize);
+    buffer Actual = AllocateBuffer(TargetSize);
+    if(SegmentCount && Expected.Data && Actual.Data && AllocateSegmentBatch(&Segments, SegmentCount))
+    {
+        GenerateSegments(&Segments, SegmentCount);
+
+        printf("======= Checks (%u kernels, %u segments) =======\n", LINE_KERNEL_COUNT, SegmentCount);
+        if(CheckKernels(&Segments, &Expected, &Actual))
+        {
+            printf("Every format and mode identical to the generic loop\n\n");
+            Result = 0;
+
+            uint64_t Times[PixelFormat_Count][LineWrite_Count][2] = {};
+            for(uint32_t Format = 0; Format < PixelFormat_Count; ++Format)
+            {
+                for(uint32_t Mode = 0; Mode < LineWrite_Count; ++Mode)
+                {
+                    line_target Target = GetTarget(&Actual, (pixel_format)Format);
+                    line_paint Paint = GetPaint((pixel_format)Format);
+                    for(uint32_t Kernels = 0; Kernels < 2; ++Kernels)
+                    {
+                        printf("--- %s %s, %s ---\n", PixelFormatNames[Format], LineWriteModeNames[Mode],
+                               Kernels ? "kernel table" : "generic");
+                        repetition_tester Tester = {};
+                        NewTestWave(&Tester, 0, CPUTimerFreq, 1);
+                        while(IsTesting(&Tester))
+                        {
+                            BeginTime(&Tester);
+                            if(Kernels)
+                            {
+                                DrawLineBatchWith(&Target, &Segments, (line_write_mode)Mode, Paint);
+                            }
+                            else
+                            {
+                                DrawLineBatchGeneric(&Target, &Segments, (line_write_mode)Mode, Paint);
+                            }
+                            EndTime(&Tester);
+                        }
+                        Times[Format][Mode][Kernels] = Tester.Results.MinTime;
+                        printf("\n");
+                    }
+                }
+            }
+
+            printf("======= %u segments, min ms =======\n", SegmentCount);
+            printf("Format    Mode          generic  kernel table\n");
+            for(uint32_t Format = 0; Format < PixelFormat_Count; ++Format)
+            {
+                for(uint32_t Mode = 0; Mode < LineWrite_Count; ++Mode)
+                {
+                    printf("%-8s  %-6s  %12f  %12f\n", PixelFormatNames[Format], LineWriteModeNames[Mode],
+                           1000.0*SecondsFromCPUTime((real64)Times[Format][Mode][0], CPUTimerFreq),
+                           1000.0*SecondsFromCPUTime((real64)Times[Format][Mode][1], CPUTimerFreq));
+                }
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u segments \n", SegmentCount);
+    }
+
+    return(Result);
+}
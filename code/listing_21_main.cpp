@@ -0,0 +1,430 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_packed.cpp"
+
+/*
+    NOTE(Axel): Packed segments and delta polylines (shared_packed.cpp) on scenes much
+      bigger than the cache: short lines in tile order, the frame stays in the
+      cache, the end points come from memory.
+      Checks first (returns 1 if any fails):
+        - AVX2 and scalar encoders agree, decoding gives the int32 batch back, an end
+          point out of the int16 range doesn't encode
+        - the packed batch draws the pixels of the int32 one, also after a trip
+          through a file (written in the temp directory, removed after), and a file
+          whose count doesn't match its size is refused before any allocation
+        - the delta polyline is a valid stream (a broken chunk count or size isn't),
+          decodes to the points, draws the pixels of the int32 polyline (AVX2 and
+          scalar chunk decoders)
+      Then drawing from int32 against drawing from the packed streams, and the
+      encoders/decoders alone.
+
+      --segments N to change the count (4M segments, and 4M polyline points).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define MAX_LINE_LENGTH 8
+#define SEGMENT_TILE_SIZE 40
+#define MAX_WALK_STEP 12
+#define DECODE_CHUNK_SIZE 1024
+#define PACKED_TEST_FILE_NAME "listing_21_segments.bin"
+
+static void GetTestFilePath(char *Path, size_t PathSize)
+{
+#if _WIN32
+    char Directory[MAX_PATH];
+    DWORD Count = GetTempPathA(sizeof(Directory), Directory);
+    if(!Count || (Count >= sizeof(Directory)))
+    {
+        Directory[0] = 0;
+    }
+    snprintf(Path, PathSize, "%s%s", Directory, PACKED_TEST_FILE_NAME);
+#else
+    char const *Directory = getenv("TMPDIR");
+    snprintf(Path, PathSize, "%s/%s", (Directory && Directory[0]) ? Directory : "/tmp", PACKED_TEST_FILE_NAME);
+#endif
+}
+
+/*
+    NOTE(Axel): In tile order, the way the spatial index hands them out: the pixels of a
+      tile stay in the cache, what comes from memory is the stream.
+*/
+static void GenerateSegments(line_segment_batch *Batch, uint32_t Count)
+{
+    uint32_t State = 0x9AC4ED;
+    Batch->Count = 0;
+
+    uint32_t TileCountX = SCREEN_WIDTH / SEGMENT_TILE_SIZE;
+    uint32_t TileCount = TileCountX*(SCREEN_HEIGHT / SEGMENT_TILE_SIZE);
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        uint32_t Tile = (uint32_t)(((uint64_t)Index*TileCount) / Count);
+        int32_t TileX = (int32_t)((Tile % TileCountX)*SEGMENT_TILE_SIZE);
+        int32_t TileY = (int32_t)((Tile / TileCountX)*SEGMENT_TILE_SIZE);
+
+        int32_t X0 = TileX + (int32_t)(RandomU32(&State) % SEGMENT_TILE_SIZE);
+        int32_t Y0 = TileY + (int32_t)(RandomU32(&State) % SEGMENT_TILE_SIZE);
+        int32_t X1 = X0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+        int32_t Y1 = Y0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+        PushSegment(Batch, X0, Y0, ClampToRange(X1, SCREEN_WIDTH - 1), ClampToRange(Y1, SCREEN_HEIGHT - 1));
+    }
+}
+
+/*
+    NOTE(Axel): A random walk that jumps somewhere else now and then (a new chunk, the
+      jump doesn't fit in a delta).
+*/
+static void GenerateWalk(polyline *Polyline, uint32_t Count)
+{
+    uint32_t State = 0x3A1C;
+    Polyline->Count = 0;
+
+    int32_t X = SCREEN_WIDTH/2;
+    int32_t Y = SCREEN_HEIGHT/2;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        if((RandomU32(&State) % 100) == 0)
+        {
+            X = (int32_t)(RandomU32(&State) % SCREEN_WIDTH);
+            Y = (int32_t)(RandomU32(&State) % SCREEN_HEIGHT);
+        }
+        else
+        {
+            X = ClampToRange(X + (int32_t)(RandomU32(&State) % (2*MAX_WALK_STEP + 1)) - MAX_WALK_STEP, SCREEN_WIDTH - 1);
+            Y = ClampToRange(Y + (int32_t)(RandomU32(&State) % (2*MAX_WALK_STEP + 1)) - MAX_WALK_STEP, SCREEN_HEIGHT - 1);
+        }
+        PushPoint(Polyline, X, Y);
+    }
+}
+
+static b32 IsSameBatch(line_segment_batch *A, line_segment_batch *B, uint32_t First)
+{
+    b32 Result = true;
+    for(uint32_t Index = 0; Result && (Index < B->Count); ++Index)
+    {
+        Result = ((A->X0[First + Index] == B->X0[Index]) && (A->Y0[First + Index] == B->Y0[Index]) &&
+                  (A->X1[First + Index] == B->X1[Index]) && (A->Y1[First + Index] == B->Y1[Index]));
+    }
+
+    return Result;
+}
+
+static b32 IsSamePacked(packed_segment_batch *A, packed_segment_batch *B)
+{
+    size_t Size = B->Count*sizeof(int16_t);
+    b32 Result = ((A->Count == B->Count) &&
+                  (memcmp(A->X0, B->X0, Size) == 0) && (memcmp(A->Y0, B->Y0, Size) == 0) &&
+                  (memcmp(A->X1, B->X1, Size) == 0) && (memcmp(A->Y1, B->Y1, Size) == 0));
+    return Result;
+}
+
+static void DrawDecodedSegments(screen_buffer *Buffer, packed_segment_batch *Packed,
+                                line_segment_batch *Scratch, int32_t Color)
+{
+    for(uint32_t First = 0; First < Packed->Count; First += DECODE_CHUNK_SIZE)
+    {
+        uint32_t Count = Packed->Count - First;
+        Count = (Count < DECODE_CHUNK_SIZE) ? Count : DECODE_CHUNK_SIZE;
+        DecodeSegments(Packed, First, Count, Scratch);
+        DrawLineBatch(Buffer, Scratch, Color);
+    }
+}
+
+static b32 CheckSegments(line_segment_batch *Segments, packed_segment_batch *Packed, packed_segment_batch *Other,
+                         line_segment_batch *Scratch, screen_buffer *Expected, screen_buffer *Buffer)
+{
+    b32 Result = (EncodeSegments(Segments, Packed) && EncodeSegmentsScalar(Segments, Other) &&
+                  IsSamePacked(Packed, Other));
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: AVX2 and scalar encoders differ\n");
+    }
+
+    for(uint32_t First = 0; Result && (First < Packed->Count); First += DECODE_CHUNK_SIZE)
+    {
+        uint32_t Count = Packed->Count - First;
+        DecodeSegments(Packed, First, (Count < DECODE_CHUNK_SIZE) ? Count : DECODE_CHUNK_SIZE, Scratch);
+        Result = IsSameBatch(Segments, Scratch, First);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Decoded segments differ from %u\n", First);
+        }
+    }
+
+    if(Result)
+    {
+        /* NOTE: One coordinate out of range, in the vector part then in the tail */
+        uint32_t Spots[2] = {Segments->Count/2, Segments->Count - 1};
+        for(uint32_t Spot = 0; Result && (Spot < 2); ++Spot)
+        {
+            int32_t Saved = Segments->Y1[Spots[Spot]];
+            Segments->Y1[Spots[Spot]] = 40000;
+            Result = (!EncodeSegments(Segments, Other) && !EncodeSegmentsScalar(Segments, Other));
+            Segments->Y1[Spots[Spot]] = Saved;
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: A coordinate out of the int16 range was encoded\n");
+            }
+        }
+    }
+
+    if(Result)
+    {
+        memset(Expected->Memory, 0, Expected->MemoryCount);
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        DrawLineBatch(Expected, Segments, LineColor);
+        DrawPackedSegmentBatch(Buffer, Packed, LineColor);
+        Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        DrawDecodedSegments(Buffer, Packed, Scratch, LineColor);
+        Result = Result && (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Packed segments don't draw the pixels of the int32 ones\n");
+        }
+    }
+
+    if(Result)
+    {
+        char Path[512];
+        GetTestFilePath(Path, sizeof(Path));
+
+        packed_segment_batch FromFile = {};
+        Result = (WritePackedSegmentFile(Path, Packed) &&
+                  ReadPackedSegmentFile(Path, &FromFile) &&
+                  IsSamePacked(Packed, &FromFile));
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Packed segments differ after a trip through %s\n", Path);
+        }
+        FreePackedSegmentBatch(&FromFile);
+
+        /* NOTE: The same file with a count one too big, then the biggest count */
+        uint32_t BadCounts[2] = {Packed->Count + 1, 0xFFFFFFFF};
+        for(uint32_t BadIndex = 0; Result && (BadIndex < 2); ++BadIndex)
+        {
+            FILE *File = fopen(Path, "r+b");
+            uint32_t Header[2] = {PACKED_FILE_MAGIC, BadCounts[BadIndex]};
+            Result = File && (fwrite(Header, sizeof(Header), 1, File) == 1);
+            Result = File && (fclose(File) == 0) && Result;
+            Result = Result && !ReadPackedSegmentFile(Path, &FromFile) && !FromFile.Memory.Data;
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: A segment file claiming %u segments wasn't refused\n", BadCounts[BadIndex]);
+            }
+            FreePackedSegmentBatch(&FromFile);
+        }
+        remove(Path);
+    }
+
+    return Result;
+}
+
+static b32 CheckPolyline(polyline *Walk, packed_polyline *Packed, polyline *Decoded,
+                         screen_buffer *Expected, screen_buffer *Buffer)
+{
+    b32 Result = EncodePolyline(Walk, Packed) && (Packed->PointCount == Walk->Count);
+    if(Result)
+    {
+        DecodePolyline(Packed, Decoded);
+        Result = ((Decoded->Count == Walk->Count) &&
+                  (memcmp(Decoded->X, Walk->X, Walk->Count*sizeof(int32_t)) == 0) &&
+                  (memcmp(Decoded->Y, Walk->Y, Walk->Count*sizeof(int32_t)) == 0));
+    }
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: The delta polyline doesn't decode to its points\n");
+    }
+
+    if(Result)
+    {
+        /* NOTE: A chunk with one delta too many, then a stream cut in the middle of a chunk */
+        b32 Valid = IsPackedPolylineValid(Packed);
+        uint8_t DeltaCount = Packed->Data[4];
+        Packed->Data[4] = PACKED_CHUNK_DELTAS + 1;
+        b32 BadCount = IsPackedPolylineValid(Packed);
+        Packed->Data[4] = DeltaCount;
+        Packed->Size -= 1;
+        b32 BadSize = IsPackedPolylineValid(Packed);
+        Packed->Size += 1;
+        Result = (Valid && !BadCount && !BadSize);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: The delta polyline stream isn't valid, or a broken one is\n");
+        }
+    }
+
+    if(Result)
+    {
+        memset(Expected->Memory, 0, Expected->MemoryCount);
+        DrawPolyline(Expected, Walk, LineColor);
+
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        DrawPackedPolyline(Buffer, Packed, LineColor);
+        Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        DrawPackedPolylineScalar(Buffer, Packed, LineColor);
+        Result = Result && (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: The delta polyline doesn't draw the pixels of the int32 one\n");
+        }
+    }
+
+    return Result;
+}
+
+enum packed_test
+{
+    Packed_SegmentsInt32,
+    Packed_SegmentsInt16,
+    Packed_SegmentsDecoded,
+    Packed_PolylineInt32,
+    Packed_PolylineDelta,
+    Packed_PolylineDeltaScalar,
+    Packed_EncodeSegments,
+    Packed_DecodeSegments,
+    Packed_DecodePolyline,
+
+    Packed_Count,
+};
+
+static char const *PackedTestNames[Packed_Count] =
+{
+    "draw segments, int32",
+    "draw segments, int16",
+    "draw segments, decoded",
+    "draw polyline, int32",
+    "draw polyline, delta",
+    "draw polyline, delta scalar",
+    "encode segments",
+    "decode segments",
+    "decode polyline",
+};
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    if(DetectISALevel() < ISA_AVX2)
+    {
+        fprintf(stderr, "ERROR: The packed kernels need AVX2, this CPU doesn't have it\n");
+        return Result;
+    }
+
+    uint32_t SegmentCount = 4*1024*1024;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--segments") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            SegmentCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    line_segment_batch Segments = {};
+    line_segment_batch Decoded = {};
+    line_segment_batch Scratch = {};
+    packed_segment_batch Packed = {};
+    packed_segment_batch Other = {};
+    polyline Walk = {};
+    polyline DecodedWalk = {};
+    packed_polyline PackedWalk = {};
+    if(SegmentCount &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateSegmentBatch(&Segments, SegmentCount) &&
+       AllocateSegmentBatch(&Decoded, SegmentCount) &&
+       AllocateSegmentBatch(&Scratch, DECODE_CHUNK_SIZE) &&
+       AllocatePackedSegmentBatch(&Packed, SegmentCount) &&
+       AllocatePackedSegmentBatch(&Other, SegmentCount) &&
+       AllocatePolyline(&Walk, SegmentCount) &&
+       AllocatePolyline(&DecodedWalk, SegmentCount + PACKED_CHUNK_DELTAS) &&
+       AllocatePackedPolyline(&PackedWalk, SegmentCount))
+    {
+        GenerateSegments(&Segments, SegmentCount);
+        GenerateWalk(&Walk, SegmentCount);
+
+        printf("======= Checks (%u segments, %u points) =======\n", SegmentCount, SegmentCount);
+        if(CheckSegments(&Segments, &Packed, &Other, &Scratch, &Expected, &Buffer) &&
+           CheckPolyline(&Walk, &PackedWalk, &DecodedWalk, &Expected, &Buffer))
+        {
+            printf("Encoders agree, decoders give the points back, same pixels from every format\n\n");
+            Result = 0;
+
+            uint64_t Bytes[Packed_Count] = {};
+            Bytes[Packed_SegmentsInt32] = 4ull*SegmentCount*sizeof(int32_t);
+            Bytes[Packed_SegmentsInt16] = 4ull*SegmentCount*sizeof(int16_t);
+            Bytes[Packed_SegmentsDecoded] = Bytes[Packed_SegmentsInt16];
+            Bytes[Packed_PolylineInt32] = 2ull*SegmentCount*sizeof(int32_t);
+            Bytes[Packed_PolylineDelta] = PackedWalk.Size;
+            Bytes[Packed_PolylineDeltaScalar] = PackedWalk.Size;
+            Bytes[Packed_EncodeSegments] = Bytes[Packed_SegmentsInt32];
+            Bytes[Packed_DecodeSegments] = Bytes[Packed_SegmentsInt16];
+            Bytes[Packed_DecodePolyline] = PackedWalk.Size;
+
+            uint64_t Times[Packed_Count] = {};
+            for(uint32_t Test = 0; Test < Packed_Count; ++Test)
+            {
+                printf("--- %s ---\n", PackedTestNames[Test]);
+                repetition_tester Tester = {};
+                NewTestWave(&Tester, Bytes[Test], CPUTimerFreq, 2);
+                while(IsTesting(&Tester))
+                {
+                    BeginTime(&Tester);
+                    switch(Test)
+                    {
+                        case Packed_SegmentsInt32: {DrawLineBatch(&Buffer, &Segments, LineColor);} break;
+                        case Packed_SegmentsInt16: {DrawPackedSegmentBatch(&Buffer, &Packed, LineColor);} break;
+                        case Packed_SegmentsDecoded: {DrawDecodedSegments(&Buffer, &Packed, &Scratch, LineColor);} break;
+                        case Packed_PolylineInt32: {DrawPolyline(&Buffer, &Walk, LineColor);} break;
+                        case Packed_PolylineDelta: {DrawPackedPolyline(&Buffer, &PackedWalk, LineColor);} break;
+                        case Packed_PolylineDeltaScalar: {DrawPackedPolylineScalar(&Buffer, &PackedWalk, LineColor);} break;
+                        case Packed_EncodeSegments: {EncodeSegments(&Segments, &Other);} break;
+                        case Packed_DecodeSegments: {DecodeSegments(&Packed, 0, Packed.Count, &Decoded);} break;
+                        case Packed_DecodePolyline: {DecodePolyline(&PackedWalk, &DecodedWalk);} break;
+                        default: break;
+                    }
+                    EndTime(&Tester);
+                    CountBytes(&Tester, Bytes[Test]);
+                }
+                Times[Test] = Tester.Results.MinTime;
+                printf("\n");
+            }
+
+            printf("======= %u segments / points, min ms =======\n", SegmentCount);
+            printf("%-28s  %10s  %10s\n", "Test", "stream MB", "ms");
+            for(uint32_t Test = 0; Test < Packed_Count; ++Test)
+            {
+                printf("%-28s  %10.1f  %10f\n", PackedTestNames[Test], (real64)Bytes[Test] / (1024.0*1024.0),
+                       1000.0*SecondsFromCPUTime((real64)Times[Test], CPUTimerFreq));
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u segments \n", SegmentCount);
+    }
+
+    return(Result);
+}
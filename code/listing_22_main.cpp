@@ -0,0 +1,673 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_threads.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_image.cpp"
+
+/*
+    NOTE(Axel): Writing rendered frames to disk (shared_image.cpp).
+      Checks first (returns 1 if any fails): every format is written to a file in the
+      current directory, read back and decoded here (a QOI decoder, a PNG one that
+      checks every CRC and the Adler32 and inflates stored and fixed blocks, the PPM
+      bytes), the pixels must be the frame's. On the scene and on a small frame
+      whose last band is partial, with runs longer than QOI allows.
+      Then every encoder alone and to a file, in MB/s of frame (4 bytes a pixel),
+      and --frames frames rendered then written one after the other against written
+      while the next one renders.
+
+      --threads N for the encoder threads (one a core by default), --lines N for the
+      lines of the scene. The last files written are left in the current directory.
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define SMALL_WIDTH 37
+#define SMALL_HEIGHT 70
+#define SCENE_COLOR_COUNT 4
+#define MAX_LINE_LENGTH 200
+
+/*
+    NOTE(Axel): What the batch jobs write: a vertical gradient (a new shade every few
+      rows) under lines in a few colors, different every frame.
+*/
+static void RenderScene(screen_buffer *Buffer, line_segment_batch *Segments, uint32_t LineCount, uint32_t Frame)
+{
+    for(uint32_t Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32_t Shade = (Y*255) / Buffer->Height;
+        uint32_t Color = (Shade/4 << 16) | (Shade/3 << 8) | (Shade/2 + 32);
+        uint32_t *Row = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch);
+        for(uint32_t X = 0; X < Buffer->Width; ++X)
+        {
+            Row[X] = Color;
+        }
+    }
+
+    int32_t Colors[SCENE_COLOR_COUNT] = {0xFFFFFF, 0xFF4020, 0x20FF60, 0xFFD000};
+    uint32_t State = 0x51CE + Frame;
+    int32_t MaxX = (int32_t)Buffer->Width - 1;
+    int32_t MaxY = (int32_t)Buffer->Height - 1;
+    for(uint32_t ColorIndex = 0; ColorIndex < SCENE_COLOR_COUNT; ++ColorIndex)
+    {
+        Segments->Count = 0;
+        for(uint32_t Index = 0; Index < LineCount / SCENE_COLOR_COUNT; ++Index)
+        {
+            int32_t X0 = (int32_t)(RandomU32(&State) % Buffer->Width);
+            int32_t Y0 = (int32_t)(RandomU32(&State) % Buffer->Height);
+            int32_t X1 = X0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+            int32_t Y1 = Y0 + (int32_t)(RandomU32(&State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+            PushSegment(Segments, X0, Y0, ClampToRange(X1, MaxX), ClampToRange(Y1, MaxY));
+        }
+        DrawLineBatch(Buffer, Segments, Colors[ColorIndex]);
+    }
+}
+
+/*
+    NOTE(Axel): Flat rows (runs over several bands), a row of noise, and a column
+      pattern that repeats the row above.
+*/
+static void RenderSmall(screen_buffer *Buffer)
+{
+    uint32_t State = 0x77;
+    for(uint32_t Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32_t *Row = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch);
+        for(uint32_t X = 0; X < Buffer->Width; ++X)
+        {
+            uint32_t Color = 0x102030;
+            if(Y == 40)
+            {
+                Color = RandomU32(&State);
+            }
+            else if(Y > 50)
+            {
+                Color = (X & 4) ? 0x808080 : (0x808080 + X);
+            }
+            Row[X] = Color | 0xFF000000;
+        }
+    }
+}
+
+static b32 ReadEntireFile(char const *FileName, buffer *Dest)
+{
+    b32 Result = false;
+
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        long Size = ftell(File);
+        fseek(File, 0, SEEK_SET);
+        if(Size > 0)
+        {
+            *Dest = AllocateBuffer((size_t)Size);
+            Result = (Dest->Data && (fread(Dest->Data, (size_t)Size, 1, File) == 1));
+        }
+        fclose(File);
+    }
+
+    return Result;
+}
+
+inline uint32_t GetU32BigEndian(uint8_t *At)
+{
+    uint32_t Result = ((uint32_t)At[0] << 24) | ((uint32_t)At[1] << 16) | ((uint32_t)At[2] << 8) | At[3];
+    return Result;
+}
+
+/*
+    NOTE(Axel): The reference decoder of the QOI spec, RGB out.
+*/
+static b32 DecodeQOI(buffer File, uint32_t Width, uint32_t Height, uint8_t *Dest)
+{
+    b32 Result = ((File.Count >= 22) && (memcmp(File.Data, "qoif", 4) == 0) &&
+                  (GetU32BigEndian(File.Data + 4) == Width) && (GetU32BigEndian(File.Data + 8) == Height) &&
+                  (File.Data[12] == 3));
+
+    uint8_t Index[64][4] = {};
+    uint8_t Pixel[4] = {0, 0, 0, 255};
+    uint8_t *At = File.Data + 14;
+    uint8_t *End = File.Data + File.Count - 8;
+    uint32_t Run = 0;
+    for(uint64_t PixelIndex = 0; Result && (PixelIndex < (uint64_t)Width*Height); ++PixelIndex)
+    {
+        if(Run)
+        {
+            --Run;
+        }
+        else if(At < End)
+        {
+            uint8_t Op = *At++;
+            if(Op == 0xFE)
+            {
+                Pixel[0] = At[0];
+                Pixel[1] = At[1];
+                Pixel[2] = At[2];
+                At += 3;
+            }
+            else if(Op == 0xFF)
+            {
+                memcpy(Pixel, At, 4);
+                At += 4;
+            }
+            else if((Op & 0xC0) == 0x00)
+            {
+                memcpy(Pixel, Index[Op], 4);
+            }
+            else if((Op & 0xC0) == 0x40)
+            {
+                Pixel[0] += ((Op >> 4) & 3) - 2;
+                Pixel[1] += ((Op >> 2) & 3) - 2;
+                Pixel[2] += (Op & 3) - 2;
+            }
+            else if((Op & 0xC0) == 0x80)
+            {
+                uint8_t Next = *At++;
+                int32_t DG = (Op & 0x3F) - 32;
+                Pixel[0] += DG - 8 + ((Next >> 4) & 0xF);
+                Pixel[1] += DG;
+                Pixel[2] += DG - 8 + (Next & 0xF);
+            }
+            else
+            {
+                Run = (Op & 0x3F);
+            }
+
+            uint32_t Hash = (Pixel[0]*3 + Pixel[1]*5 + Pixel[2]*7 + Pixel[3]*11) % 64;
+            memcpy(Index[Hash], Pixel, 4);
+        }
+        else
+        {
+            Result = false;
+        }
+
+        memcpy(Dest + 3*PixelIndex, Pixel, 3);
+    }
+
+    uint8_t EndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    Result = Result && (At == End) && (memcmp(End, EndMarker, 8) == 0);
+    return Result;
+}
+
+struct bit_reader
+{
+    uint8_t *At;
+    uint8_t *End;
+    uint32_t Bit;
+    b32 Overflow;
+};
+
+inline uint32_t GetBits(bit_reader *Reader, uint32_t Count)
+{
+    uint32_t Result = 0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        if(Reader->At < Reader->End)
+        {
+            Result |= (uint32_t)((*Reader->At >> Reader->Bit) & 1) << Index;
+            if(++Reader->Bit == 8)
+            {
+                Reader->Bit = 0;
+                ++Reader->At;
+            }
+        }
+        else
+        {
+            Reader->Overflow = true;
+        }
+    }
+
+    return Result;
+}
+
+/* NOTE: Huffman codes come highest bit first */
+static uint32_t GetFixedLiteral(bit_reader *Reader)
+{
+    uint32_t Code = 0;
+    for(uint32_t Count = 1; Count <= 7; ++Count)
+    {
+        Code = (Code << 1) | GetBits(Reader, 1);
+    }
+
+    uint32_t Result = 0;
+    if(Code <= 0x17)
+    {
+        Result = 256 + Code;
+    }
+    else
+    {
+        Code = (Code << 1) | GetBits(Reader, 1);
+        if((Code >= 0x30) && (Code <= 0xBF))
+        {
+            Result = Code - 0x30;
+        }
+        else if((Code >= 0xC0) && (Code <= 0xC7))
+        {
+            Result = 280 + (Code - 0xC0);
+        }
+        else
+        {
+            Code = (Code << 1) | GetBits(Reader, 1);
+            Result = 144 + (Code - 0x190);
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Only what shared_image writes: stored blocks and fixed Huffman blocks.
+*/
+static b32 Inflate(uint8_t *Source, size_t SourceSize, uint8_t *Dest, size_t DestSize, size_t *OutSize)
+{
+    bit_reader Reader = {Source, Source + SourceSize, 0, false};
+    size_t Out = 0;
+    b32 Result = true;
+    b32 IsLast = false;
+    while(Result && !IsLast)
+    {
+        IsLast = GetBits(&Reader, 1);
+        uint32_t Type = GetBits(&Reader, 2);
+        if(Type == 0)
+        {
+            if(Reader.Bit)
+            {
+                Reader.Bit = 0;
+                ++Reader.At;
+            }
+
+            uint32_t Length = Reader.At[0] | (Reader.At[1] << 8);
+            uint32_t NotLength = Reader.At[2] | (Reader.At[3] << 8);
+            Reader.At += 4;
+            Result = ((Length ^ 0xFFFF) == NotLength) && (Reader.At + Length <= Reader.End) &&
+                     (Out + Length <= DestSize);
+            if(Result)
+            {
+                memcpy(Dest + Out, Reader.At, Length);
+                Reader.At += Length;
+                Out += Length;
+            }
+        }
+        else if(Type == 1)
+        {
+            for(;;)
+            {
+                uint32_t Symbol = GetFixedLiteral(&Reader);
+                if(Reader.Overflow || (Symbol > 285))
+                {
+                    Result = false;
+                    break;
+                }
+
+                if(Symbol < 256)
+                {
+                    Result = (Out < DestSize);
+                    if(!Result)
+                    {
+                        break;
+                    }
+                    Dest[Out++] = (uint8_t)Symbol;
+                }
+                else if(Symbol == 256)
+                {
+                    break;
+                }
+                else
+                {
+                    uint32_t Code = Symbol - 257;
+                    uint32_t Length = DeflateLengthBase[Code] + GetBits(&Reader, DeflateLengthExtra[Code]);
+                    uint32_t DistanceCode = ReverseBits(GetBits(&Reader, 5), 5);
+                    Result = (DistanceCode < 30);
+                    if(!Result)
+                    {
+                        break;
+                    }
+
+                    uint32_t ExtraCount = (DistanceCode < 4) ? 0 : ((DistanceCode / 2) - 1);
+                    uint32_t Distance = DeflateDistanceBase[DistanceCode] + GetBits(&Reader, ExtraCount);
+                    Result = (Distance <= Out) && (Out + Length <= DestSize);
+                    if(!Result)
+                    {
+                        break;
+                    }
+
+                    for(uint32_t Index = 0; Index < Length; ++Index)
+                    {
+                        Dest[Out] = Dest[Out - Distance];
+                        ++Out;
+                    }
+                }
+            }
+        }
+        else
+        {
+            Result = false;
+        }
+
+        Result = Result && !Reader.Overflow;
+    }
+
+    *OutSize = Out;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Every chunk CRC, IHDR, the IDAT concatenated and inflated, the Adler32,
+      then filter 0 rows to RGB.
+*/
+static b32 DecodePNG(buffer File, uint32_t Width, uint32_t Height, uint8_t *Dest)
+{
+    uint8_t Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    b32 Result = (File.Count >= 8) && (memcmp(File.Data, Signature, 8) == 0);
+
+    size_t RowSize = 1 + 3*(size_t)Width;
+    buffer Compressed = AllocateBuffer(File.Count);
+    buffer Raw = AllocateBuffer(RowSize*Height);
+    Result = Result && Compressed.Data && Raw.Data;
+
+    size_t CompressedSize = 0;
+    b32 HasHeader = false;
+    b32 HasEnd = false;
+    uint8_t *At = File.Data + 8;
+    uint8_t *End = File.Data + File.Count;
+    while(Result && !HasEnd && (At + 12 <= End))
+    {
+        uint32_t Size = GetU32BigEndian(At);
+        Result = (At + 12 + Size <= End) &&
+                 (UpdateCRC32(0, At + 4, Size + 4) == GetU32BigEndian(At + 8 + Size));
+        if(Result)
+        {
+            uint8_t *Data = At + 8;
+            if(memcmp(At + 4, "IHDR", 4) == 0)
+            {
+                HasHeader = ((Size == 13) && (GetU32BigEndian(Data) == Width) &&
+                             (GetU32BigEndian(Data + 4) == Height) && (Data[8] == 8) && (Data[9] == 2));
+            }
+            else if(memcmp(At + 4, "IDAT", 4) == 0)
+            {
+                memcpy(Compressed.Data + CompressedSize, Data, Size);
+                CompressedSize += Size;
+            }
+            else if(memcmp(At + 4, "IEND", 4) == 0)
+            {
+                HasEnd = true;
+            }
+            At += 12 + Size;
+        }
+    }
+
+    size_t RawSize = 0;
+    Result = (Result && HasHeader && HasEnd && (CompressedSize > 6) &&
+              (((Compressed.Data[0] << 8) | Compressed.Data[1]) % 31 == 0) &&
+              Inflate(Compressed.Data + 2, CompressedSize - 6, Raw.Data, Raw.Count, &RawSize) &&
+              (RawSize == Raw.Count));
+
+    if(Result)
+    {
+        uint32_t Adler = 1;
+        for(size_t Index = 0; Index < RawSize; ++Index)
+        {
+            Adler = UpdateAdler32Byte(Adler, Raw.Data[Index]);
+        }
+        Result = (Adler == GetU32BigEndian(Compressed.Data + CompressedSize - 4));
+    }
+
+    for(uint32_t Y = 0; Result && (Y < Height); ++Y)
+    {
+        uint8_t *Row = Raw.Data + Y*RowSize;
+        Result = (Row[0] == 0);
+        memcpy(Dest + Y*(RowSize - 1), Row + 1, RowSize - 1);
+    }
+
+    FreeBuffer(&Compressed);
+    FreeBuffer(&Raw);
+
+    return Result;
+}
+
+static b32 DecodePPM(buffer File, uint32_t Width, uint32_t Height, uint8_t *Dest)
+{
+    char Header[MAX_IMAGE_HEADER_SIZE];
+    int HeaderSize = sprintf(Header, "P6\n%u %u\n255\n", Width, Height);
+    size_t PixelSize = 3*(size_t)Width*Height;
+
+    b32 Result = ((File.Count == HeaderSize + PixelSize) && (memcmp(File.Data, Header, HeaderSize) == 0));
+    if(Result)
+    {
+        memcpy(Dest, File.Data + HeaderSize, PixelSize);
+    }
+
+    return Result;
+}
+
+static void GetExpectedRGB(screen_buffer *Frame, uint8_t *Dest)
+{
+    for(uint32_t Y = 0; Y < Frame->Height; ++Y)
+    {
+        Dest = ConvertRowToRGB(Dest, (uint32_t *)(Frame->Memory + (size_t)Y*Frame->Pitch), Frame->Width);
+    }
+}
+
+static void GetImageFileName(char *Dest, image_format Format)
+{
+    sprintf(Dest, "listing_22_%s.%s", (Format == Image_PNGStored) ? "stored" : "frame",
+            ImageFormatExtensions[Format]);
+}
+
+static b32 CheckImageFormats(image_writer *Writer, screen_buffer *Frame)
+{
+    b32 Result = true;
+
+    size_t PixelSize = 3*(size_t)Frame->Width*Frame->Height;
+    buffer Expected = AllocateBuffer(PixelSize);
+    buffer Decoded = AllocateBuffer(PixelSize);
+    Result = Expected.Data && Decoded.Data;
+    if(Result)
+    {
+        GetExpectedRGB(Frame, Expected.Data);
+    }
+
+    for(uint32_t Format = 0; Result && (Format < Image_Count); ++Format)
+    {
+        char FileName[64];
+        GetImageFileName(FileName, (image_format)Format);
+
+        buffer File = {};
+        Result = (BeginImageWrite(Writer, Frame, (image_format)Format, FileName) &&
+                  WaitImageWrite(Writer) && ReadEntireFile(FileName, &File) &&
+                  (File.Count == Writer->OutputSize));
+        if(Result)
+        {
+            memset(Decoded.Data, 0, PixelSize);
+            switch(Format)
+            {
+                case Image_QOI: {Result = DecodeQOI(File, Frame->Width, Frame->Height, Decoded.Data);} break;
+                case Image_PNGStored:
+                case Image_PNGFast: {Result = DecodePNG(File, Frame->Width, Frame->Height, Decoded.Data);} break;
+                case Image_PPM: {Result = DecodePPM(File, Frame->Width, Frame->Height, Decoded.Data);} break;
+                default: break;
+            }
+            Result = Result && (memcmp(Decoded.Data, Expected.Data, PixelSize) == 0);
+        }
+
+        if(Result)
+        {
+            /* NOTE: Encoding without a file gives the same size */
+            Result = (BeginImageWrite(Writer, Frame, (image_format)Format, 0) && WaitImageWrite(Writer) &&
+                      (Writer->OutputSize == File.Count));
+        }
+
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: %s (%ux%u) doesn't decode to the frame\n",
+                    FileName, Frame->Width, Frame->Height);
+        }
+        FreeBuffer(&File);
+    }
+
+    FreeBuffer(&Expected);
+    FreeBuffer(&Decoded);
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Render then write, FrameCount times. Overlapped: frame N is written
+      while frame N+1 renders in the other buffer, the wait is only for the write of
+      frame N-1 before reusing its buffer.
+*/
+static uint64_t RenderAndWriteFrames(image_writer *Writer, screen_buffer *Buffers, line_segment_batch *Segments,
+                                     uint32_t LineCount, uint32_t FrameCount, image_format Format, b32 Overlapped)
+{
+    char FileName[64];
+    GetImageFileName(FileName, Format);
+
+    b32 Succeeded = true;
+    uint64_t StartTime = ReadCPUTimer();
+    for(uint32_t Frame = 0; Frame < FrameCount; ++Frame)
+    {
+        screen_buffer *Buffer = Buffers + (Overlapped ? (Frame & 1) : 0);
+        RenderScene(Buffer, Segments, LineCount, Frame);
+
+        Succeeded = WaitImageWrite(Writer) && Succeeded;
+        Succeeded = BeginImageWrite(Writer, Buffer, Format, FileName) && Succeeded;
+        if(!Overlapped)
+        {
+            Succeeded = WaitImageWrite(Writer) && Succeeded;
+        }
+    }
+    Succeeded = WaitImageWrite(Writer) && Succeeded;
+    uint64_t Result = ReadCPUTimer() - StartTime;
+
+    if(!Succeeded)
+    {
+        fprintf(stderr, "ERROR: A frame wasn't written\n");
+    }
+
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t ThreadCount = GetLogicalCoreCount();
+    uint32_t LineCount = 2000;
+    uint32_t FrameCount = 30;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--threads") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            ThreadCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--lines") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            LineCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--frames") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            FrameCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    screen_buffer Buffers[2] = {};
+    screen_buffer Small = {};
+    line_segment_batch Segments = {};
+    image_writer Writer = {};
+    if(InitScreenBuffer(&Buffers[0], SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Buffers[1], SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Small, SMALL_WIDTH, SMALL_HEIGHT) &&
+       AllocateSegmentBatch(&Segments, LineCount + 1) &&
+       InitImageWriter(&Writer, ThreadCount, SCREEN_WIDTH, SCREEN_HEIGHT))
+    {
+        RenderScene(&Buffers[0], &Segments, LineCount, 0);
+        RenderSmall(&Small);
+
+        printf("======= Checks (%u encoder threads) =======\n", Writer.ThreadCount);
+        if(CheckImageFormats(&Writer, &Small) && CheckImageFormats(&Writer, &Buffers[0]))
+        {
+            printf("Every format decodes back to the frame\n\n");
+            Result = 0;
+
+            uint64_t FrameBytes = (uint64_t)Buffers[0].Width*Buffers[0].Height*Buffers[0].BytesPerPixel;
+            uint64_t OutputSizes[Image_Count] = {};
+            uint64_t Times[Image_Count][2] = {};
+            for(uint32_t Format = 0; Format < Image_Count; ++Format)
+            {
+                char FileName[64];
+                GetImageFileName(FileName, (image_format)Format);
+                for(uint32_t ToFile = 0; ToFile < 2; ++ToFile)
+                {
+                    printf("--- %s, %s ---\n", ImageFormatNames[Format], ToFile ? FileName : "encode only");
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, FrameBytes, CPUTimerFreq, 2);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        if(BeginImageWrite(&Writer, &Buffers[0], (image_format)Format, ToFile ? FileName : 0) &&
+                           WaitImageWrite(&Writer))
+                        {
+                            CountBytes(&Tester, FrameBytes);
+                        }
+                        else
+                        {
+                            Error(&Tester, "Write failed");
+                        }
+                        EndTime(&Tester);
+                    }
+                    Times[Format][ToFile] = Tester.Results.MinTime;
+                    OutputSizes[Format] = Writer.OutputSize;
+                    printf("\n");
+                }
+            }
+
+            printf("======= %ux%u frame, %u encoder threads, min =======\n",
+                   Buffers[0].Width, Buffers[0].Height, Writer.ThreadCount);
+            printf("%-12s  %8s  %10s  %10s  %10s  %10s\n", "Format", "file MB", "encode ms", "encode MB/s",
+                   "file ms", "file MB/s");
+            for(uint32_t Format = 0; Format < Image_Count; ++Format)
+            {
+                real64 EncodeSeconds = SecondsFromCPUTime((real64)Times[Format][0], CPUTimerFreq);
+                real64 FileSeconds = SecondsFromCPUTime((real64)Times[Format][1], CPUTimerFreq);
+                real64 MB = (real64)FrameBytes / (1024.0*1024.0);
+                printf("%-12s  %8.2f  %10.3f  %10.1f  %10.3f  %10.1f\n", ImageFormatNames[Format],
+                       (real64)OutputSizes[Format] / (1024.0*1024.0), 1000.0*EncodeSeconds, MB / EncodeSeconds,
+                       1000.0*FileSeconds, MB / FileSeconds);
+            }
+
+            printf("\n======= %u frames of %u lines, render then write, ms a frame =======\n",
+                   FrameCount, LineCount);
+            printf("%-12s  %10s  %10s\n", "Format", "serial", "overlapped");
+            for(uint32_t Format = 0; (Format < Image_Count) && FrameCount; ++Format)
+            {
+                uint64_t Serial = RenderAndWriteFrames(&Writer, Buffers, &Segments, LineCount, FrameCount,
+                                                       (image_format)Format, false);
+                uint64_t Overlapped = RenderAndWriteFrames(&Writer, Buffers, &Segments, LineCount, FrameCount,
+                                                           (image_format)Format, true);
+                printf("%-12s  %10.3f  %10.3f\n", ImageFormatNames[Format],
+                       1000.0*SecondsFromCPUTime((real64)Serial, CPUTimerFreq) / FrameCount,
+                       1000.0*SecondsFromCPUTime((real64)Overlapped, CPUTimerFreq) / FrameCount);
+            }
+        }
+
+        FreeImageWriter(&Writer);
+    }
+    else
+    {
+        printf("ERROR: Could not allocate the frames and the image writer\n");
+    }
+
+    return(Result);
+}
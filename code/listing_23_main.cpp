@@ -0,0 +1,549 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor = (255 << 16) | (255 << 8) | (255 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_cpu.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+#include "shared_kernels.cpp"
+#include "shared_dash.cpp"
+
+/*
+    NOTE(Axel): Dashed lines (shared_dash.cpp) against the two ways of doing it without:
+      a DrawLine call per dash (end points of each dash rounded on the line, all the
+      setup again every dash) and DrawLineStepping testing every pixel against the
+      pattern (walks the off runs too).
+      Checks first (returns 1 if any fails):
+        - a pattern without gaps is DrawLineStepping
+        - random patterns and lines in every octant, starting anywhere in the
+          pattern, give the pixels of the per pixel test and end at the phase of
+          start + line length
+        - a random walk polyline has one phase all the way (same check, the
+          offset of the per pixel test runs through the joints)
+        - a stipple pattern gives the pixels of its bits
+      Then a dashed grid over the screen, random lines and a polyline (in a corner
+      that stays in the cache) with each method.
+
+      --lines N to change the count of random lines and polyline points (50000).
+*/
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define MAX_LINE_LENGTH 200
+#define MAX_WALK_STEP 24
+#define GRID_SPACING 16
+#define BENCH_AREA_SIZE 256
+#define MAX_DASH_PERIOD 1024
+
+/*
+    NOTE(Axel): On or off for every pixel of the period, what the per pixel test reads.
+      Built from the runs, or from the bits of a stipple without going through runs.
+*/
+struct dash_mask
+{
+    uint8_t On[MAX_DASH_PERIOD];
+    uint32_t Period;
+};
+
+static void MakeDashMask(dash_mask *Mask, dash_pattern *Pattern)
+{
+    Mask->Period = 0;
+    for(uint32_t Run = 0; Run < Pattern->RunCount; ++Run)
+    {
+        for(uint32_t Index = 0; Index < Pattern->Runs[Run]; ++Index)
+        {
+            Mask->On[Mask->Period++] = ((Run & 1) == 0);
+        }
+    }
+}
+
+static void MakeStippleMask(dash_mask *Mask, uint32_t Bits, uint32_t BitCount, uint32_t Scale)
+{
+    Mask->Period = BitCount*Scale;
+    for(uint32_t Index = 0; Index < Mask->Period; ++Index)
+    {
+        Mask->On[Index] = (uint8_t)((Bits >> (Index / Scale)) & 1);
+    }
+}
+
+/*
+    NOTE(Axel): DrawLineStepping with a test per pixel, Offset is the pixel count since
+      the start of the pattern.
+*/
+static void DrawDashedLinePerPixel(screen_buffer *Buffer,
+                                   int32_t X0, int32_t Y0,
+                                   int32_t X1, int32_t Y1, int32_t Color,
+                                   dash_mask *Mask, uint64_t *Offset)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    intptr_t StepX = 1;
+    intptr_t StepY = PitchInPixels;
+    if(dx < 0)
+    {
+        dx = -dx;
+        StepX = -1;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        StepY = -PitchInPixels;
+    }
+
+    int32_t Major = dx;
+    int32_t Minor = dy;
+    intptr_t MajorStep = StepX;
+    intptr_t MinorStep = StepY;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = StepY;
+        MinorStep = StepX;
+    }
+
+    int32_t decision    = (2 * Minor) - Major;
+    int32_t IncrementNE = (2 * (Minor - Major));
+    int32_t IncrementE  = (2 * Minor);
+
+    uint32_t Phase = (uint32_t)(*Offset % Mask->Period);
+    uint32_t *Pixel = (uint32_t *)Buffer->Memory + Y0*PitchInPixels + X0;
+    for(int32_t Count = Major; Count > 0; --Count)
+    {
+        if(decision <= 0)
+        {
+            decision += IncrementE;
+        }
+        else
+        {
+            Pixel += MinorStep;
+            decision += IncrementNE;
+        }
+
+        if(Mask->On[Phase])
+        {
+            *Pixel = (uint32_t)Color;
+        }
+        Pixel += MajorStep;
+        Phase = (Phase + 1 == Mask->Period) ? 0 : (Phase + 1);
+    }
+
+    *Offset += (uint64_t)Major;
+}
+
+/*
+    NOTE(Axel): What a caller without pattern support does: the end points of each dash
+      rounded on the line, then a DrawLine for it.
+*/
+static void DrawDashedLineByDashes(screen_buffer *Buffer,
+                                   int32_t X0, int32_t Y0,
+                                   int32_t X1, int32_t Y1, int32_t Color,
+                                   dash_pattern *Pattern, dash_phase *Phase)
+{
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    int32_t SignX = (dx < 0) ? -1 : 1;
+    int32_t SignY = (dy < 0) ? -1 : 1;
+    int64_t Major = (dx*SignX > dy*SignY) ? dx*SignX : dy*SignY;
+
+    NextDashRun(Pattern, Phase);
+
+    int64_t Step = 0;
+    while(Step < Major)
+    {
+        int64_t End = Step + (Pattern->Runs[Phase->Run] - Phase->Done);
+        End = (End < Major) ? End : Major;
+
+        if((Phase->Run & 1) == 0)
+        {
+            int32_t StartX = X0 + (int32_t)((2*Step*dx + Major*SignX) / (2*Major));
+            int32_t StartY = Y0 + (int32_t)((2*Step*dy + Major*SignY) / (2*Major));
+            int32_t EndX = X0 + (int32_t)((2*End*dx + Major*SignX) / (2*Major));
+            int32_t EndY = Y0 + (int32_t)((2*End*dy + Major*SignY) / (2*Major));
+            DrawLine(Buffer, StartX, StartY, EndX, EndY, Color);
+        }
+
+        Phase->Done += (uint32_t)(End - Step);
+        Step = End;
+        NextDashRun(Pattern, Phase);
+    }
+}
+
+static void RandomLine(uint32_t *State, int32_t Width, int32_t Height,
+                       int32_t *X0, int32_t *Y0, int32_t *X1, int32_t *Y1)
+{
+    *X0 = (int32_t)(RandomU32(State) % Width);
+    *Y0 = (int32_t)(RandomU32(State) % Height);
+    switch(RandomU32(State) % 8)
+    {
+        /* NOTE: Some axis aligned and diagonal ones, and some that don't move at all */
+        case 0: {*X1 = *X0 + (int32_t)(RandomU32(State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH; *Y1 = *Y0;} break;
+        case 1: {*X1 = *X0; *Y1 = *Y0 + (int32_t)(RandomU32(State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;} break;
+        case 2: {int32_t D = (int32_t)(RandomU32(State) % MAX_LINE_LENGTH); *X1 = *X0 + D; *Y1 = *Y0 - D;} break;
+        case 3: {*X1 = *X0; *Y1 = *Y0;} break;
+        default:
+        {
+            *X1 = *X0 + (int32_t)(RandomU32(State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+            *Y1 = *Y0 + (int32_t)(RandomU32(State) % (2*MAX_LINE_LENGTH + 1)) - MAX_LINE_LENGTH;
+        } break;
+    }
+
+    *X1 = ClampToRange(*X1, Width - 1);
+    *Y1 = ClampToRange(*Y1, Height - 1);
+}
+
+/*
+    NOTE(Axel): In a corner of the screen that stays in the cache, what is timed is the
+      drawing, not the misses.
+*/
+static void GenerateLines(line_segment_batch *Batch, uint32_t Count)
+{
+    uint32_t State = 0xDA54;
+    Batch->Count = 0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        int32_t X0, Y0, X1, Y1;
+        RandomLine(&State, BENCH_AREA_SIZE, BENCH_AREA_SIZE, &X0, &Y0, &X1, &Y1);
+        PushSegment(Batch, X0, Y0, X1, Y1);
+    }
+}
+
+static void GenerateGrid(line_segment_batch *Batch)
+{
+    Batch->Count = 0;
+    for(int32_t Y = GRID_SPACING/2; Y < SCREEN_HEIGHT; Y += GRID_SPACING)
+    {
+        PushSegment(Batch, 0, Y, SCREEN_WIDTH - 1, Y);
+    }
+
+    for(int32_t X = GRID_SPACING/2; X < SCREEN_WIDTH; X += GRID_SPACING)
+    {
+        PushSegment(Batch, X, 0, X, SCREEN_HEIGHT - 1);
+    }
+}
+
+static void GenerateWalk(polyline *Polyline, uint32_t Count)
+{
+    uint32_t State = 0x3A1C;
+    Polyline->Count = 0;
+
+    int32_t X = BENCH_AREA_SIZE/2;
+    int32_t Y = BENCH_AREA_SIZE/2;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        X = ClampToRange(X + (int32_t)(RandomU32(&State) % (2*MAX_WALK_STEP + 1)) - MAX_WALK_STEP, BENCH_AREA_SIZE - 1);
+        Y = ClampToRange(Y + (int32_t)(RandomU32(&State) % (2*MAX_WALK_STEP + 1)) - MAX_WALK_STEP, BENCH_AREA_SIZE - 1);
+        PushPoint(Polyline, X, Y);
+    }
+}
+
+static void RandomPattern(uint32_t *State, dash_pattern *Pattern)
+{
+    uint32_t Lengths[8];
+    uint32_t Count = 1 + RandomU32(State) % 8;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        /* NOTE: Empty runs too */
+        Lengths[Index] = RandomU32(State) % 24;
+    }
+    Lengths[0] += 1;
+    MakeDashPattern(Pattern, Lengths, Count);
+}
+
+inline b32 IsSamePhase(dash_phase A, dash_phase B)
+{
+    b32 Result = (A.Run == B.Run) && (A.Done == B.Done);
+    return Result;
+}
+
+inline int32_t GetMajor(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    int32_t dx = (X1 > X0) ? (X1 - X0) : (X0 - X1);
+    int32_t dy = (Y1 > Y0) ? (Y1 - Y0) : (Y0 - Y1);
+    int32_t Result = (dx > dy) ? dx : dy;
+    return Result;
+}
+
+static b32 CheckDashes(screen_buffer *Expected, screen_buffer *Buffer, polyline *Walk, dash_mask *Mask)
+{
+    uint32_t State = 0x1234;
+    b32 Result = true;
+
+    dash_pattern Solid = {};
+    uint32_t SolidLength = 7;
+    MakeDashPattern(&Solid, &SolidLength, 1);
+    memset(Expected->Memory, 0, Expected->MemoryCount);
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+    for(uint32_t Index = 0; Index < 2000; ++Index)
+    {
+        int32_t X0, Y0, X1, Y1;
+        RandomLine(&State, SCREEN_WIDTH, SCREEN_HEIGHT, &X0, &Y0, &X1, &Y1);
+        dash_phase Phase = GetDashPhase(&Solid, RandomU32(&State));
+        DrawLineStepping(Expected, X0, Y0, X1, Y1, LineColor);
+        DrawDashedLine(Buffer, X0, Y0, X1, Y1, LineColor, &Solid, &Phase);
+    }
+    Result = (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: A pattern without gaps isn't DrawLineStepping\n");
+    }
+
+    for(uint32_t Test = 0; Result && (Test < 200); ++Test)
+    {
+        dash_pattern Pattern;
+        RandomPattern(&State, &Pattern);
+        MakeDashMask(Mask, &Pattern);
+
+        memset(Expected->Memory, 0, Expected->MemoryCount);
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        for(uint32_t Index = 0; Result && (Index < 50); ++Index)
+        {
+            int32_t X0, Y0, X1, Y1;
+            RandomLine(&State, SCREEN_WIDTH, SCREEN_HEIGHT, &X0, &Y0, &X1, &Y1);
+            uint64_t Offset = RandomU32(&State);
+            dash_phase Phase = GetDashPhase(&Pattern, Offset);
+            DrawDashedLinePerPixel(Expected, X0, Y0, X1, Y1, LineColor, Mask, &Offset);
+            DrawDashedLine(Buffer, X0, Y0, X1, Y1, LineColor, &Pattern, &Phase);
+            Result = IsSamePhase(Phase, GetDashPhase(&Pattern, Offset));
+        }
+        Result = Result && (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Dashed lines differ from the per pixel test (pattern %u)\n", Test);
+        }
+    }
+
+    for(uint32_t Test = 0; Result && (Test < 20); ++Test)
+    {
+        dash_pattern Pattern;
+        RandomPattern(&State, &Pattern);
+        MakeDashMask(Mask, &Pattern);
+
+        uint64_t Offset = RandomU32(&State);
+        dash_phase Phase = GetDashPhase(&Pattern, Offset);
+        memset(Expected->Memory, 0, Expected->MemoryCount);
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        for(uint32_t Index = 1; Index < Walk->Count; ++Index)
+        {
+            DrawDashedLinePerPixel(Expected, Walk->X[Index - 1], Walk->Y[Index - 1],
+                                   Walk->X[Index], Walk->Y[Index], LineColor, Mask, &Offset);
+        }
+        DrawDashedPolyline(Buffer, Walk, LineColor, &Pattern, &Phase);
+        Result = (IsSamePhase(Phase, GetDashPhase(&Pattern, Offset)) &&
+                  (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0));
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: The dashed polyline loses the phase (pattern %u)\n", Test);
+        }
+    }
+
+    uint32_t StippleBits[3] = {0xF0F3, 0x0FF2, 0xAAAAAAAA};
+    uint32_t StippleBitCounts[3] = {16, 12, 32};
+    for(uint32_t Test = 0; Result && (Test < 3); ++Test)
+    {
+        dash_pattern Pattern;
+        Result = MakeStipplePattern(&Pattern, StippleBits[Test], StippleBitCounts[Test], 1 + Test);
+        MakeStippleMask(Mask, StippleBits[Test], StippleBitCounts[Test], 1 + Test);
+
+        uint64_t Offset = 0;
+        dash_phase Phase = {};
+        memset(Expected->Memory, 0, Expected->MemoryCount);
+        memset(Buffer->Memory, 0, Buffer->MemoryCount);
+        for(uint32_t Index = 0; Result && (Index < 200); ++Index)
+        {
+            int32_t X0, Y0, X1, Y1;
+            RandomLine(&State, SCREEN_WIDTH, SCREEN_HEIGHT, &X0, &Y0, &X1, &Y1);
+            DrawDashedLinePerPixel(Expected, X0, Y0, X1, Y1, LineColor, Mask, &Offset);
+            DrawDashedLine(Buffer, X0, Y0, X1, Y1, LineColor, &Pattern, &Phase);
+        }
+        Result = Result && (memcmp(Expected->Memory, Buffer->Memory, Buffer->MemoryCount) == 0);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Stipple 0x%X doesn't give the pixels of its bits\n", StippleBits[Test]);
+        }
+    }
+
+    return Result;
+}
+
+enum dash_method
+{
+    Dash_Spans,
+    Dash_PerDashDrawLine,
+    Dash_PerPixelTest,
+
+    Dash_Count,
+};
+
+static char const *DashMethodNames[Dash_Count] =
+{
+    "spans, phase carried",
+    "DrawLine per dash",
+    "per pixel test",
+};
+
+enum dash_scene
+{
+    DashScene_Grid,
+    DashScene_Lines,
+    DashScene_Polyline,
+
+    DashScene_Count,
+};
+
+static char const *DashSceneNames[DashScene_Count] =
+{
+    "grid",
+    "random lines",
+    "polyline",
+};
+
+static void DrawDashScene(screen_buffer *Buffer, dash_scene Scene, dash_method Method,
+                          line_segment_batch *Grid, line_segment_batch *Lines, polyline *Walk,
+                          dash_pattern *Pattern, dash_mask *Mask)
+{
+    line_segment_batch *Batch = (Scene == DashScene_Grid) ? Grid : Lines;
+    if(Scene == DashScene_Polyline)
+    {
+        dash_phase Phase = {};
+        uint64_t Offset = 0;
+        for(uint32_t Index = 1; Index < Walk->Count; ++Index)
+        {
+            int32_t X0 = Walk->X[Index - 1];
+            int32_t Y0 = Walk->Y[Index - 1];
+            int32_t X1 = Walk->X[Index];
+            int32_t Y1 = Walk->Y[Index];
+            switch(Method)
+            {
+                case Dash_Spans: {DrawDashedLine(Buffer, X0, Y0, X1, Y1, LineColor, Pattern, &Phase);} break;
+                case Dash_PerDashDrawLine: {DrawDashedLineByDashes(Buffer, X0, Y0, X1, Y1, LineColor, Pattern, &Phase);} break;
+                case Dash_PerPixelTest: {DrawDashedLinePerPixel(Buffer, X0, Y0, X1, Y1, LineColor, Mask, &Offset);} break;
+                default: break;
+            }
+        }
+    }
+    else
+    {
+        for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+        {
+            int32_t X0 = Batch->X0[Index];
+            int32_t Y0 = Batch->Y0[Index];
+            int32_t X1 = Batch->X1[Index];
+            int32_t Y1 = Batch->Y1[Index];
+            dash_phase Phase = {};
+            uint64_t Offset = 0;
+            switch(Method)
+            {
+                case Dash_Spans: {DrawDashedLine(Buffer, X0, Y0, X1, Y1, LineColor, Pattern, &Phase);} break;
+                case Dash_PerDashDrawLine: {DrawDashedLineByDashes(Buffer, X0, Y0, X1, Y1, LineColor, Pattern, &Phase);} break;
+                case Dash_PerPixelTest: {DrawDashedLinePerPixel(Buffer, X0, Y0, X1, Y1, LineColor, Mask, &Offset);} break;
+                default: break;
+            }
+        }
+    }
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t LineCount = 50000;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--lines") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            LineCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    SelectRasterKernels(ISA_Count);
+
+    screen_buffer Buffer = {};
+    screen_buffer Expected = {};
+    line_segment_batch Grid = {};
+    line_segment_batch Lines = {};
+    polyline Walk = {};
+    dash_mask Mask = {};
+    if(LineCount &&
+       InitScreenBuffer(&Buffer, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       InitScreenBuffer(&Expected, SCREEN_WIDTH, SCREEN_HEIGHT) &&
+       AllocateSegmentBatch(&Grid, SCREEN_WIDTH/GRID_SPACING + SCREEN_HEIGHT/GRID_SPACING + 2) &&
+       AllocateSegmentBatch(&Lines, LineCount) &&
+       AllocatePolyline(&Walk, LineCount))
+    {
+        GenerateGrid(&Grid);
+        GenerateLines(&Lines, LineCount);
+        GenerateWalk(&Walk, LineCount);
+
+        printf("======= Checks (kernels: %s) =======\n", ISALevelNames[GlobalRasterKernels.Level]);
+        if(CheckDashes(&Expected, &Buffer, &Walk, &Mask))
+        {
+            printf("Same pixels and phase as the per pixel test, gaps or not, through joints, stipples\n\n");
+            Result = 0;
+
+            /* NOTE: Dashes and gaps of a few pixels, what a grid or a construction line uses */
+            dash_pattern Pattern;
+            uint32_t Lengths[4] = {12, 6, 3, 6};
+            MakeDashPattern(&Pattern, Lengths, 4);
+            MakeDashMask(&Mask, &Pattern);
+
+            uint64_t Times[DashScene_Count][Dash_Count] = {};
+            for(uint32_t Scene = 0; Scene < DashScene_Count; ++Scene)
+            {
+                for(uint32_t Method = 0; Method < Dash_Count; ++Method)
+                {
+                    printf("--- %s, %s ---\n", DashSceneNames[Scene], DashMethodNames[Method]);
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, 0, CPUTimerFreq, 2);
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        DrawDashScene(&Buffer, (dash_scene)Scene, (dash_method)Method, &Grid, &Lines, &Walk,
+                                      &Pattern, &Mask);
+                        EndTime(&Tester);
+                        CountBytes(&Tester, 0);
+                    }
+                    Times[Scene][Method] = Tester.Results.MinTime;
+                    printf("\n");
+                }
+            }
+
+            printf("======= Dashes 12/6/3/6, %u grid lines, %u random lines, %u points, min ms =======\n",
+                   Grid.Count, Lines.Count, Walk.Count);
+            printf("%-14s", "Scene");
+            for(uint32_t Method = 0; Method < Dash_Count; ++Method)
+            {
+                printf("  %22s", DashMethodNames[Method]);
+            }
+            printf("\n");
+            for(uint32_t Scene = 0; Scene < DashScene_Count; ++Scene)
+            {
+                printf("%-14s", DashSceneNames[Scene]);
+                for(uint32_t Method = 0; Method < Dash_Count; ++Method)
+                {
+                    printf("  %22f", 1000.0*SecondsFromCPUTime((real64)Times[Scene][Method], CPUTimerFreq));
+                }
+                printf("\n");
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for %u lines\n", LineCount);
+    }
+
+    return(Result);
+}
@@ -0,0 +1,271 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_threads.cpp"
+#include "shared_parallel_tester.cpp"
+#include "shared_rasterizer.cpp"
+
+/*
+    NOTE(Axel): Same Bresenham as listing_3, but run on 1..N cores at the same time in
+      order to see how the rasterization scales. Every thread works on its own
+      horizontal band of the screen (Height / ThreadCount rows) unless the test is
+      about sharing the memory on purpose.
+
+      The buffer is 4K (32mb) so the whole frame doesn't fit in most L3 caches,
+      otherwise the bandwidth test would only measure the cache.
+*/
+#define LINE_LENGTH 512
+#define STRONG_LINE_COUNT 8192
+#define WEAK_LINES_PER_THREAD 1024
+#define SHARED_ROW_COUNT 32
+#define SHARED_PASS_COUNT 16
+
+static screen_buffer GlobalBuffer;
+
+struct band
+{
+    uint32_t Y;
+    uint32_t Height;
+};
+
+static band GetBand(screen_buffer *Buffer, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    band Result = {};
+    Result.Height = Buffer->Height / ThreadCount;
+    Result.Y = ThreadIndex*Result.Height;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Every line has the same amount of pixels (LINE_LENGTH, x being the major
+      dimension), only the slope changes so the minor step is taken or not.
+      The decision can push Y by one on the very first pixel, so we keep 2 rows
+      of margin inside the band.
+*/
+static uint64_t DrawLinesInBand(screen_buffer *Buffer, band Band,
+                                uint32_t FirstLine, uint32_t OnePastLastLine)
+{
+    int32_t MaxDy = (int32_t)Band.Height - 2;
+    if(MaxDy < 0)
+    {
+        MaxDy = 0;
+    }
+
+    int32_t MaxX = (int32_t)Buffer->Width - LINE_LENGTH - 1;
+    for(uint32_t LineIndex = FirstLine; LineIndex < OnePastLastLine; ++LineIndex)
+    {
+        int32_t X0 = (int32_t)((LineIndex*37) % MaxX);
+        int32_t Y0 = (int32_t)Band.Y;
+        int32_t Dy = (int32_t)(LineIndex % (MaxDy + 1));
+        DrawLine(Buffer, X0, Y0, X0 + LINE_LENGTH, Y0 + Dy, LineColor, Line_Draw_By_Bresenham);
+    }
+
+    uint64_t Result = (uint64_t)(OnePastLastLine - FirstLine)*LINE_LENGTH*Buffer->BytesPerPixel;
+    return Result;
+}
+
+static uint64_t StrongLineWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    screen_buffer *Buffer = (screen_buffer *)UserData;
+    band Band = GetBand(Buffer, ThreadIndex, ThreadCount);
+
+    uint32_t FirstLine = (STRONG_LINE_COUNT*ThreadIndex) / ThreadCount;
+    uint32_t OnePastLastLine = (STRONG_LINE_COUNT*(ThreadIndex + 1)) / ThreadCount;
+
+    uint64_t Result = DrawLinesInBand(Buffer, Band, FirstLine, OnePastLastLine);
+    return Result;
+}
+
+static uint64_t WeakLineWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    screen_buffer *Buffer = (screen_buffer *)UserData;
+    band Band = GetBand(Buffer, ThreadIndex, ThreadCount);
+
+    uint64_t Result = DrawLinesInBand(Buffer, Band, 0, WEAK_LINES_PER_THREAD);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Full width horizontal lines over every row of the band: the whole
+      frame is written every wave, so once the memory bus is saturated adding
+      threads doesn't help anymore.
+*/
+static uint64_t FillBandWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    screen_buffer *Buffer = (screen_buffer *)UserData;
+    band Band = GetBand(Buffer, ThreadIndex, ThreadCount);
+    if(ThreadIndex == (ThreadCount - 1))
+    {
+        Band.Height = Buffer->Height - Band.Y;
+    }
+
+    for(uint32_t Y = Band.Y; Y < (Band.Y + Band.Height); ++Y)
+    {
+        DrawLine(Buffer, 0, Y, Buffer->Width, Y, LineColor, Line_Draw_By_Bresenham);
+    }
+
+    uint64_t Result = (uint64_t)Band.Height*Buffer->Pitch;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Both tests write the same pixels of the first SHARED_ROW_COUNT rows
+      (small enough to stay in L2), SHARED_PASS_COUNT times:
+        - Interleaved: thread N writes every pixel X where X % ThreadCount == N, so 16
+          pixels of a cache line are owned by up to 16 different cores and the line
+          bounces between them on every write (false sharing).
+        - Contiguous: thread N writes its own run of pixels, no line is shared.
+*/
+static uint64_t SharedInterleavedWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    screen_buffer *Buffer = (screen_buffer *)UserData;
+    uint64_t PixelCount = 0;
+
+    for(uint32_t Pass = 0; Pass < SHARED_PASS_COUNT; ++Pass)
+    {
+        for(uint32_t Y = 0; Y < SHARED_ROW_COUNT; ++Y)
+        {
+            for(uint32_t X = ThreadIndex; X < Buffer->Width; X += ThreadCount)
+            {
+                DrawPixel(Buffer, X, Y, LineColor + Pass);
+                ++PixelCount;
+            }
+        }
+    }
+
+    uint64_t Result = PixelCount*Buffer->BytesPerPixel;
+    return Result;
+}
+
+static uint64_t SharedContiguousWork(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount)
+{
+    screen_buffer *Buffer = (screen_buffer *)UserData;
+    uint64_t PixelCount = 0;
+
+    uint32_t TotalPixelCount = Buffer->Width*SHARED_ROW_COUNT;
+    uint32_t FirstPixel = (uint32_t)(((uint64_t)TotalPixelCount*ThreadIndex) / ThreadCount);
+    uint32_t OnePastLastPixel = (uint32_t)(((uint64_t)TotalPixelCount*(ThreadIndex + 1)) / ThreadCount);
+
+    for(uint32_t Pass = 0; Pass < SHARED_PASS_COUNT; ++Pass)
+    {
+        uint32_t X = FirstPixel % Buffer->Width;
+        uint32_t Y = FirstPixel / Buffer->Width;
+        for(uint32_t PixelIndex = FirstPixel; PixelIndex < OnePastLastPixel; ++PixelIndex)
+        {
+            DrawPixel(Buffer, X, Y, LineColor + Pass);
+            ++PixelCount;
+
+            if(++X == Buffer->Width)
+            {
+                X = 0;
+                ++Y;
+            }
+        }
+    }
+
+    uint64_t Result = PixelCount*Buffer->BytesPerPixel;
+    return Result;
+}
+
+struct scaling_test
+{
+    char const *Label;
+    scaling_mode Mode;
+    parallel_test_work *Work;
+};
+
+static uint64_t GetTargetByteCount(screen_buffer *Buffer, parallel_test_work *Work, uint32_t ThreadCount)
+{
+    uint64_t Result = 0;
+    if(Work == StrongLineWork)
+    {
+        Result = (uint64_t)STRONG_LINE_COUNT*LINE_LENGTH*Buffer->BytesPerPixel;
+    }
+    else if(Work == WeakLineWork)
+    {
+        Result = (uint64_t)ThreadCount*WEAK_LINES_PER_THREAD*LINE_LENGTH*Buffer->BytesPerPixel;
+    }
+    else if(Work == FillBandWork)
+    {
+        Result = Buffer->MemoryCount;
+    }
+    else
+    {
+        Result = (uint64_t)SHARED_PASS_COUNT*SHARED_ROW_COUNT*Buffer->Width*Buffer->BytesPerPixel;
+    }
+
+    return Result;
+}
+
+int main()
+{
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    uint32_t CoreCount = GetLogicalCoreCount();
+
+    scaling_test Tests[] =
+    {
+        {"Bresenham, banded", Scaling_Strong, StrongLineWork},
+        {"Bresenham, banded", Scaling_Weak, WeakLineWork},
+        {"Full frame fill", Scaling_Strong, FillBandWork},
+        {"Shared rows, interleaved pixels", Scaling_Strong, SharedInterleavedWork},
+        {"Shared rows, contiguous pixels", Scaling_Strong, SharedContiguousWork},
+    };
+
+    if(InitScreenBuffer(&GlobalBuffer, 3840, 2160))
+    {
+        printf("%u logical cores\n\n", CoreCount);
+
+        for(uint32_t TestIndex = 0; TestIndex < (sizeof(Tests)/sizeof(Tests[0])); ++TestIndex)
+        {
+            scaling_test *Test = &Tests[TestIndex];
+            scaling_point Points[MAX_THREAD_COUNT] = {};
+            uint32_t PointCount = 0;
+
+            /* NOTE: Powers of two, plus every core at the end */
+            for(uint32_t ThreadCount = 1; ThreadCount <= CoreCount; )
+            {
+                printf("======= %s: %u threads ======= \n", Test->Label, ThreadCount);
+
+                static parallel_tester Tester;
+                uint64_t TargetByteCount = GetTargetByteCount(&GlobalBuffer, Test->Work, ThreadCount);
+                RunParallelTest(&Tester, ThreadCount, Test->Work, &GlobalBuffer,
+                                TargetByteCount, CPUTimerFreq, 2);
+                PrintParallelResults(&Tester);
+                printf("\n");
+
+                scaling_point *Point = &Points[PointCount++];
+                Point->ThreadCount = ThreadCount;
+                Point->MinWaveTime = Tester.Results.MinTime;
+                Point->ByteCount = TargetByteCount;
+
+                if(ThreadCount == CoreCount)
+                {
+                    break;
+                }
+
+                ThreadCount *= 2;
+                if(ThreadCount > CoreCount)
+                {
+                    ThreadCount = CoreCount;
+                }
+            }
+
+            PrintScalingTable(Test->Label, Test->Mode, Points, PointCount, CPUTimerFreq);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(0);
+}
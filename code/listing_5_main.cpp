@@ -0,0 +1,215 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#define PROFILER 1
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_profiler.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+
+/*
+    NOTE(Axel): A whole frame cut in the stages a real line renderer has, so the
+      profiler can tell us where the time goes:
+        - clip: throw away or shorten the lines against the screen
+        - setup: everything Bresenham needs before the loop (deltas, decision, increments)
+        - raster: the loop itself
+        - present: the frame goes somewhere else (here a copy in a front buffer,
+          which is what StretchDIBits does for us in listing_2)
+      Set PROFILER to 0 above and the zones disappear, only the total is printed.
+*/
+#define FRAME_LINE_COUNT 20000
+#define FRAME_COUNT 200
+
+struct line
+{
+    int32_t X0;
+    int32_t Y0;
+    int32_t X1;
+    int32_t Y1;
+};
+
+struct line_setup
+{
+    int32_t X;
+    int32_t Y;
+    int32_t Count;
+    int32_t Decision;
+    int32_t IncrementE;
+    int32_t IncrementNE;
+};
+
+static screen_buffer GlobalBuffer;
+static screen_buffer GlobalFrontBuffer;
+
+static line GlobalLines[FRAME_LINE_COUNT];
+static line GlobalClippedLines[FRAME_LINE_COUNT];
+static line_setup GlobalSetups[FRAME_LINE_COUNT];
+
+/*
+    NOTE(Axel): Only the octant our Bresenham handles (0 <= dy <= dx), about a fourth of
+      them start or end outside of the screen so the clipper has some work.
+*/
+static void GenerateLines(screen_buffer *Buffer, line *Lines, uint32_t LineCount)
+{
+    uint32_t State = 0x12345678;
+    int32_t Width = (int32_t)Buffer->Width;
+    int32_t Height = (int32_t)Buffer->Height;
+
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        line *Line = Lines + LineIndex;
+        int32_t Dx = 1 + (int32_t)(RandomU32(&State) % 600);
+        int32_t Dy = (int32_t)(RandomU32(&State) % (Dx + 1));
+
+        Line->X0 = (int32_t)(RandomU32(&State) % (Width + 400)) - 200 - Dx/2;
+        Line->Y0 = (int32_t)(RandomU32(&State) % (Height + 200)) - 100 - Dy/2;
+        Line->X1 = Line->X0 + Dx;
+        Line->Y1 = Line->Y0 + Dy;
+    }
+}
+
+static uint32_t ClipLines(screen_buffer *Buffer, line *Lines, uint32_t LineCount, line *Dest)
+{
+    TimeBlock("Clip");
+    CountWork(LineCount);
+
+    clip_rect Rect = GetScreenClipRect(Buffer);
+    uint32_t Result = 0;
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        line Line = Lines[LineIndex];
+        if(ClipLine(Rect, &Line.X0, &Line.Y0, &Line.X1, &Line.Y1))
+        {
+            /* NOTE: Integer clipping can round a short line out of the octant */
+            int32_t Dx = Line.X1 - Line.X0;
+            int32_t Dy = Line.Y1 - Line.Y0;
+            if((Dx > 0) && (Dy >= 0) && (Dy <= Dx))
+            {
+                Dest[Result++] = Line;
+            }
+        }
+    }
+
+    return Result;
+}
+
+static uint64_t SetupLines(line *Lines, uint32_t LineCount, line_setup *Dest)
+{
+    TimeBlock("Setup");
+    CountWork(LineCount);
+
+    uint64_t PixelCount = 0;
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        line *Line = Lines + LineIndex;
+        line_setup *Setup = Dest + LineIndex;
+
+        int32_t dx = (Line->X1 - Line->X0);
+        int32_t dy = (Line->Y1 - Line->Y0);
+        Setup->X = Line->X0;
+        Setup->Y = Line->Y0;
+        Setup->Count = dx;
+        Setup->Decision = (2 * dy) - dx;
+        Setup->IncrementNE = (2 * (dy - dx));
+        Setup->IncrementE = (2 * dy);
+
+        PixelCount += dx;
+    }
+
+    return PixelCount;
+}
+
+static void RasterLines(screen_buffer *Buffer, line_setup *Setups, uint32_t LineCount,
+                        uint64_t PixelCount)
+{
+    TimeBandwidth("Raster", PixelCount*Buffer->BytesPerPixel);
+    CountWork(PixelCount);
+
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        line_setup Setup = Setups[LineIndex];
+        int32_t Y = Setup.Y;
+        int32_t decision = Setup.Decision;
+
+        for(int32_t X = Setup.X; X < (Setup.X + Setup.Count); ++X)
+        {
+            if(decision <= 0)
+            {
+                decision += Setup.IncrementE;
+            }
+            else
+            {
+                ++Y;
+                decision += Setup.IncrementNE;
+            }
+
+            DrawPixel(Buffer, X, Y, LineColor);
+        }
+    }
+}
+
+static void Present(screen_buffer *Buffer, screen_buffer *FrontBuffer)
+{
+    TimeBandwidth("Present", Buffer->MemoryCount);
+    memcpy(FrontBuffer->Memory, Buffer->Memory, Buffer->MemoryCount);
+}
+
+static void RenderFrame(screen_buffer *Buffer, screen_buffer *FrontBuffer)
+{
+    TimeBlock("Frame");
+
+    uint32_t LineCount = ClipLines(Buffer, GlobalLines, FRAME_LINE_COUNT, GlobalClippedLines);
+    uint64_t PixelCount = SetupLines(GlobalClippedLines, LineCount, GlobalSetups);
+    RasterLines(Buffer, GlobalSetups, LineCount, PixelCount);
+    Present(Buffer, FrontBuffer);
+}
+
+int main()
+{
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    if(InitScreenBuffer(&GlobalBuffer, 1920, 1080) &&
+       InitScreenBuffer(&GlobalFrontBuffer, 1920, 1080))
+    {
+        GenerateLines(&GlobalBuffer, GlobalLines, FRAME_LINE_COUNT);
+
+        printf("======= %u frames of %u lines ======= \n", FRAME_COUNT, FRAME_LINE_COUNT);
+        BeginProfile();
+        for(uint32_t FrameIndex = 0; FrameIndex < FRAME_COUNT; ++FrameIndex)
+        {
+            /* NOTE: Only the last frame goes in the trace */
+            if(FrameIndex == (FRAME_COUNT - 1))
+            {
+                BeginProfileTrace();
+            }
+
+            RenderFrame(&GlobalBuffer, &GlobalFrontBuffer);
+        }
+        EndProfileTrace();
+        EndAndPrintProfile(CPUTimerFreq);
+
+        char const *TraceFileName = "listing_5_trace.json";
+        if(WriteProfileTrace(TraceFileName, CPUTimerFreq))
+        {
+            printf("Last frame written to %s\n", TraceFileName);
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(0);
+}
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,418 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+
+/*
+    NOTE(Axel): Every line method ends up writing pixels one by one, so whatever we do
+      with the decision variable, a line can't go faster than the pixel write itself.
+      This listing isolates that write:
+        - address math: DrawPixel, Y*Pitch + X*BytesPerPixel and the cast on every pixel
+        - increment:    a pointer on the pixel we step by +1 or +Pitch
+        - streaming:    same stepping with non-temporal stores (they skip the cache,
+                        so they only pay off when the data would not stay in it anyway)
+        - scatter:      the pixel offsets come from a table, like a rasterizer that
+                        computes the offsets first and writes them later
+      on three access patterns:
+        - sequential: along the row, what a horizontal line/span does
+        - strided:    down the columns, one new cache line per pixel like a steep line
+        - random:     the worst case, every pixel can be anywhere in the region
+      and on regions of the screen_buffer sized for L1, L2, L3 and DRAM.
+
+      The region is always the top rows of a 2048 pixels wide buffer (8kb per row), so
+      region sizes are powers of two and the random pattern can be a full period LCG
+      (every pixel is written exactly once per pass, no table needed).
+
+      Sequential stepping is usually vectorized by the compiler, it is the ceiling
+      for a horizontal span rather than for a single pixel step.
+*/
+#define BUFFER_WIDTH 2048
+#define BUFFER_HEIGHT 16384
+#define MIN_PIXELS_PER_TEST (1024*1024)
+
+struct pixel_region
+{
+    screen_buffer *Buffer;
+    uint32_t Height;
+    uint32_t PixelCount;
+    uint32_t WidthShift;
+    uint32_t *Offsets;
+    uint32_t Color;
+};
+
+inline uint32_t NextRandomPixel(uint32_t Index, uint32_t Mask)
+{
+    /* NOTE: a % 4 == 1 and c odd gives a full period modulo any power of two */
+    uint32_t Result = (Index*1664525 + 1013904223) & Mask;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Address math
+*/
+static void WriteAddressMathSequential(pixel_region *Region)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    for(uint32_t Y = 0; Y < Region->Height; ++Y)
+    {
+        for(uint32_t X = 0; X < Buffer->Width; ++X)
+        {
+            DrawPixel(Buffer, X, Y, Region->Color);
+        }
+    }
+}
+
+static void WriteAddressMathStrided(pixel_region *Region)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    for(uint32_t X = 0; X < Buffer->Width; ++X)
+    {
+        for(uint32_t Y = 0; Y < Region->Height; ++Y)
+        {
+            DrawPixel(Buffer, X, Y, Region->Color);
+        }
+    }
+}
+
+static void WriteAddressMathRandom(pixel_region *Region)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    uint32_t Mask = Region->PixelCount - 1;
+    uint32_t XMask = Buffer->Width - 1;
+    uint32_t Index = 0;
+    for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+    {
+        Index = NextRandomPixel(Index, Mask);
+        DrawPixel(Buffer, Index & XMask, Index >> Region->WidthShift, Region->Color);
+    }
+}
+
+/*
+    NOTE(Axel): Pointer increment
+*/
+static void WriteIncrementSequential(pixel_region *Region)
+{
+    uint32_t *Pixel = (uint32_t *)Region->Buffer->Memory;
+    for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+    {
+        *Pixel++ = Region->Color;
+    }
+}
+
+static void WriteIncrementStrided(pixel_region *Region)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    uint32_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    for(uint32_t X = 0; X < Buffer->Width; ++X)
+    {
+        uint32_t *Pixel = (uint32_t *)Buffer->Memory + X;
+        for(uint32_t Y = 0; Y < Region->Height; ++Y)
+        {
+            *Pixel = Region->Color;
+            Pixel += PitchInPixels;
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Non-temporal stores
+*/
+static void WriteStreamingSequential(pixel_region *Region)
+{
+    int *Pixel = (int *)Region->Buffer->Memory;
+    for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+    {
+        _mm_stream_si32(Pixel++, (int)Region->Color);
+    }
+    _mm_sfence();
+}
+
+static void WriteStreamingStrided(pixel_region *Region)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    uint32_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    for(uint32_t X = 0; X < Buffer->Width; ++X)
+    {
+        int *Pixel = (int *)Buffer->Memory + X;
+        for(uint32_t Y = 0; Y < Region->Height; ++Y)
+        {
+            _mm_stream_si32(Pixel, (int)Region->Color);
+            Pixel += PitchInPixels;
+        }
+    }
+    _mm_sfence();
+}
+
+static void WriteStreamingRandom(pixel_region *Region)
+{
+    int *Pixels = (int *)Region->Buffer->Memory;
+    uint32_t Mask = Region->PixelCount - 1;
+    uint32_t Index = 0;
+    for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+    {
+        Index = NextRandomPixel(Index, Mask);
+        _mm_stream_si32(Pixels + Index, (int)Region->Color);
+    }
+    _mm_sfence();
+}
+
+/*
+    NOTE(Axel): Scatter, the table is built for the pattern before the test. Reading it
+      is part of the cost (4 bytes read for 4 bytes written).
+*/
+static void WriteScatter(pixel_region *Region)
+{
+    uint32_t *Pixels = (uint32_t *)Region->Buffer->Memory;
+    uint32_t *Offsets = Region->Offsets;
+    for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+    {
+        Pixels[Offsets[PixelIndex]] = Region->Color;
+    }
+}
+
+enum access_pattern
+{
+    AccessPattern_Sequential,
+    AccessPattern_Strided,
+    AccessPattern_Random,
+
+    AccessPattern_Count,
+};
+
+static char const *AccessPatternNames[AccessPattern_Count] = {"sequential", "strided", "random"};
+
+static void BuildOffsets(pixel_region *Region, access_pattern Pattern)
+{
+    screen_buffer *Buffer = Region->Buffer;
+    uint32_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    uint32_t *Offset = Region->Offsets;
+
+    switch(Pattern)
+    {
+        case AccessPattern_Sequential:
+        {
+            for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+            {
+                *Offset++ = PixelIndex;
+            }
+        } break;
+
+        case AccessPattern_Strided:
+        {
+            for(uint32_t X = 0; X < Buffer->Width; ++X)
+            {
+                for(uint32_t Y = 0; Y < Region->Height; ++Y)
+                {
+                    *Offset++ = Y*PitchInPixels + X;
+                }
+            }
+        } break;
+
+        case AccessPattern_Random:
+        {
+            uint32_t Mask = Region->PixelCount - 1;
+            uint32_t Index = 0;
+            for(uint32_t PixelIndex = 0; PixelIndex < Region->PixelCount; ++PixelIndex)
+            {
+                Index = NextRandomPixel(Index, Mask);
+                *Offset++ = Index;
+            }
+        } break;
+
+        default: break;
+    }
+}
+
+typedef void pixel_write_test(pixel_region *Region);
+
+enum pixel_write_method
+{
+    PixelWrite_AddressMath,
+    PixelWrite_Increment,
+    PixelWrite_Streaming,
+    PixelWrite_Scatter,
+
+    PixelWrite_Count,
+};
+
+static char const *PixelWriteNames[PixelWrite_Count] = {"address math", "increment", "streaming", "scatter"};
+
+/* NOTE: 0 when the method can't follow the pattern (stepping a pointer randomly) */
+static pixel_write_test *PixelWriteTests[PixelWrite_Count][AccessPattern_Count] =
+{
+    {WriteAddressMathSequential, WriteAddressMathStrided, WriteAddressMathRandom},
+    {WriteIncrementSequential, WriteIncrementStrided, 0},
+    {WriteStreamingSequential, WriteStreamingStrided, WriteStreamingRandom},
+    {WriteScatter, WriteScatter, WriteScatter},
+};
+
+struct region_size
+{
+    char const *Label;
+    uint32_t Height;
+};
+
+static region_size RegionSizes[] =
+{
+    {"L1 (16kb)", 2},
+    {"L2 (512kb)", 64},
+    {"L3 (8mb)", 1024},
+    {"DRAM (128mb)", BUFFER_HEIGHT},
+};
+
+#define REGION_SIZE_COUNT (sizeof(RegionSizes)/sizeof(RegionSizes[0]))
+
+static double GlobalTicksPerPixel[REGION_SIZE_COUNT][PixelWrite_Count][AccessPattern_Count];
+static double GlobalBandwidth[REGION_SIZE_COUNT][PixelWrite_Count][AccessPattern_Count];
+
+int main(int ArgCount, char **Args)
+{
+    uint32_t SecondsToTry = 1;
+    if(ArgCount > 1)
+    {
+        SecondsToTry = atoi(Args[1]);
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+    screen_buffer Buffer = {};
+    buffer Offsets = AllocateBuffer((size_t)BUFFER_WIDTH*BUFFER_HEIGHT*sizeof(uint32_t));
+
+    if(InitScreenBuffer(&Buffer, BUFFER_WIDTH, BUFFER_HEIGHT) && Offsets.Data)
+    {
+        /* NOTE: Touch everything once so page faults are not part of the first test */
+        pixel_region WholeBuffer = {};
+        WholeBuffer.Buffer = &Buffer;
+        WholeBuffer.Height = Buffer.Height;
+        WholeBuffer.PixelCount = Buffer.Width*Buffer.Height;
+        WholeBuffer.Offsets = (uint32_t *)Offsets.Data;
+        WriteIncrementSequential(&WholeBuffer);
+        BuildOffsets(&WholeBuffer, AccessPattern_Sequential);
+
+        uint32_t WidthShift = 0;
+        while((1u << WidthShift) < Buffer.Width)
+        {
+            ++WidthShift;
+        }
+
+        for(uint32_t SizeIndex = 0; SizeIndex < REGION_SIZE_COUNT; ++SizeIndex)
+        {
+            for(uint32_t Pattern = 0; Pattern < AccessPattern_Count; ++Pattern)
+            {
+                pixel_region Region = {};
+                Region.Buffer = &Buffer;
+                Region.Height = RegionSizes[SizeIndex].Height;
+                Region.PixelCount = Buffer.Width*Region.Height;
+                Region.WidthShift = WidthShift;
+                Region.Offsets = (uint32_t *)Offsets.Data;
+                Region.Color = LineColor;
+                BuildOffsets(&Region, (access_pattern)Pattern);
+
+                uint32_t PassCount = 1;
+                if(Region.PixelCount < MIN_PIXELS_PER_TEST)
+                {
+                    PassCount = MIN_PIXELS_PER_TEST / Region.PixelCount;
+                }
+                uint64_t ByteCount = (uint64_t)PassCount*Region.PixelCount*Buffer.BytesPerPixel;
+
+                for(uint32_t Method = 0; Method < PixelWrite_Count; ++Method)
+                {
+                    pixel_write_test *Test = PixelWriteTests[Method][Pattern];
+                    if(Test)
+                    {
+                        printf("======= %s, %s, %s ======= \n", RegionSizes[SizeIndex].Label,
+                               PixelWriteNames[Method], AccessPatternNames[Pattern]);
+
+                        repetition_tester Tester = {};
+                        NewTestWave(&Tester, ByteCount, CPUTimerFreq, SecondsToTry);
+                        while(IsTesting(&Tester))
+                        {
+                            BeginTime(&Tester);
+                            for(uint32_t Pass = 0; Pass < PassCount; ++Pass)
+                            {
+                                Region.Color = LineColor + Pass;
+                                Test(&Region);
+                            }
+                            EndTime(&Tester);
+
+                            CountBytes(&Tester, ByteCount);
+                        }
+
+                        double MinTime = (double)Tester.Results.MinTime;
+                        double Seconds = SecondsFromCPUTime(MinTime, CPUTimerFreq);
+                        double Gigabyte = (1024.0f * 1024.0f * 1024.0f);
+                        GlobalTicksPerPixel[SizeIndex][Method][Pattern] =
+                            MinTime / ((double)PassCount*Region.PixelCount);
+                        GlobalBandwidth[SizeIndex][Method][Pattern] =
+                            (Seconds > 0.0) ? (ByteCount / (Gigabyte * Seconds)) : 0.0;
+                    }
+                }
+            }
+        }
+
+        /*
+            NOTE(Axel): Roofline-ish summary. For each region size the best ticks/pixel of
+              a pattern is the ceiling for a line method writing pixels that way:
+              a mostly horizontal line is sequential, a steep one is strided, a batch of
+              lines all over the screen is closer to random.
+              Ticks are the ones of the CPU timer (the TSC, a fixed rate), not core
+              cycles: with the core running above or below that rate the cycles are
+              more or fewer. Compare the rows between them, not with a cycle count.
+        */
+        printf("\n======= CPU timer ticks per pixel (gb/s) =======\n");
+        printf("%-14s %-13s", "Region", "Method");
+        for(uint32_t Pattern = 0; Pattern < AccessPattern_Count; ++Pattern)
+        {
+            printf(" %20s", AccessPatternNames[Pattern]);
+        }
+        printf("\n");
+
+        for(uint32_t SizeIndex = 0; SizeIndex < REGION_SIZE_COUNT; ++SizeIndex)
+        {
+            double Best[AccessPattern_Count] = {};
+            for(uint32_t Method = 0; Method < PixelWrite_Count; ++Method)
+            {
+                printf("%-14s %-13s", RegionSizes[SizeIndex].Label, PixelWriteNames[Method]);
+                for(uint32_t Pattern = 0; Pattern < AccessPattern_Count; ++Pattern)
+                {
+                    if(PixelWriteTests[Method][Pattern])
+                    {
+                        double TicksPerPixel = GlobalTicksPerPixel[SizeIndex][Method][Pattern];
+                        printf(" %8.3f (%9.3f)", TicksPerPixel, GlobalBandwidth[SizeIndex][Method][Pattern]);
+                        if((Best[Pattern] == 0.0) || (TicksPerPixel < Best[Pattern]))
+                        {
+                            Best[Pattern] = TicksPerPixel;
+                        }
+                    }
+                    else
+                    {
+                        printf(" %20s", "-");
+                    }
+                }
+                printf("\n");
+            }
+
+            printf("%-14s %-13s", RegionSizes[SizeIndex].Label, "CEILING");
+            for(uint32_t Pattern = 0; Pattern < AccessPattern_Count; ++Pattern)
+            {
+                printf(" %8.3f %11s", Best[Pattern], "");
+            }
+            printf("\n\n");
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(0);
+}
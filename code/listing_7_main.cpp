@@ -0,0 +1,196 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_random.cpp"
+
+/*
+    NOTE(Axel): Bresenham on all octants with a pixel pointer (DrawLineStepping).
+      First we check it is pixel identical to what we had:
+        - in the first octant against Line_Draw_By_Bresenham directly
+        - in the 7 others against Line_Draw_By_Bresenham drawn in the first octant
+          and mirrored/transposed back, which is the definition of the other octants
+      Then the repetition tester compares both on the octant they share.
+      The program returns 1 as soon as one line differs, so it can run unattended.
+*/
+#define TEST_SIZE 128
+#define TEST_RADIUS 40
+#define RANDOM_LINE_COUNT 20000
+
+static screen_buffer GlobalExpected;
+static screen_buffer GlobalActual;
+static screen_buffer GlobalScratch;
+
+static void ClearScreenBuffer(screen_buffer *Buffer)
+{
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+}
+
+inline uint32_t ReadPixel(screen_buffer *Buffer, int32_t X, int32_t Y)
+{
+    uint32_t *Pixel = (uint32_t *)(Buffer->Memory + Y*Buffer->Pitch + X*Buffer->BytesPerPixel);
+    return *Pixel;
+}
+
+/*
+    NOTE(Axel): Draws the line in the first octant of the scratch buffer with the
+      reference algorithm, then copies every lit pixel back to where the octant
+      transform sends it.
+*/
+static void DrawLineReference(screen_buffer *Dest, screen_buffer *Scratch,
+                              int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, int32_t Color)
+{
+    int32_t dx = X1 - X0;
+    int32_t dy = Y1 - Y0;
+    int32_t SignX = (dx < 0) ? -1 : 1;
+    int32_t SignY = (dy < 0) ? -1 : 1;
+    dx *= SignX;
+    dy *= SignY;
+
+    b32 Transposed = (dy > dx);
+    int32_t Major = Transposed ? dy : dx;
+    int32_t Minor = Transposed ? dx : dy;
+
+    ClearScreenBuffer(Scratch);
+    DrawLine(Scratch, 0, 0, Major, Minor, Color, Line_Draw_By_Bresenham);
+
+    for(int32_t V = 0; V <= Minor; ++V)
+    {
+        for(int32_t U = 0; U < Major; ++U)
+        {
+            if(ReadPixel(Scratch, U, V))
+            {
+                int32_t LocalX = Transposed ? V : U;
+                int32_t LocalY = Transposed ? U : V;
+                DrawPixel(Dest, X0 + SignX*LocalX, Y0 + SignY*LocalY, Color);
+            }
+        }
+    }
+}
+
+static b32 CompareLine(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    ClearScreenBuffer(&GlobalExpected);
+    ClearScreenBuffer(&GlobalActual);
+
+    b32 FirstOctant = ((X1 > X0) && (Y1 >= Y0) && ((Y1 - Y0) <= (X1 - X0)));
+    if(FirstOctant)
+    {
+        DrawLine(&GlobalExpected, X0, Y0, X1, Y1, LineColor, Line_Draw_By_Bresenham);
+    }
+    else
+    {
+        DrawLineReference(&GlobalExpected, &GlobalScratch, X0, Y0, X1, Y1, LineColor);
+    }
+    DrawLine(&GlobalActual, X0, Y0, X1, Y1, LineColor);
+
+    b32 Result = (memcmp(GlobalExpected.Memory, GlobalActual.Memory, GlobalActual.MemoryCount) == 0);
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Pixel mismatch for line (%d, %d) -> (%d, %d)\n", X0, Y0, X1, Y1);
+    }
+
+    return Result;
+}
+
+static b32 RunComparison(void)
+{
+    b32 Result = true;
+    uint32_t LineCount = 0;
+
+    /* NOTE: Every end point around a fixed start, all octants and their boundaries */
+    int32_t Center = TEST_SIZE / 2;
+    for(int32_t Y1 = Center - TEST_RADIUS; Result && (Y1 <= Center + TEST_RADIUS); ++Y1)
+    {
+        for(int32_t X1 = Center - TEST_RADIUS; Result && (X1 <= Center + TEST_RADIUS); ++X1)
+        {
+            Result = CompareLine(Center, Center, X1, Y1);
+            ++LineCount;
+        }
+    }
+
+    /* NOTE: Random lines, longer ones, anywhere in the buffer */
+    uint32_t State = 0x2545F491;
+    for(uint32_t LineIndex = 0; Result && (LineIndex < RANDOM_LINE_COUNT); ++LineIndex)
+    {
+        int32_t X0 = (int32_t)(RandomU32(&State) % TEST_SIZE);
+        int32_t Y0 = (int32_t)(RandomU32(&State) % TEST_SIZE);
+        int32_t X1 = (int32_t)(RandomU32(&State) % TEST_SIZE);
+        int32_t Y1 = (int32_t)(RandomU32(&State) % TEST_SIZE);
+        Result = CompareLine(X0, Y0, X1, Y1);
+        ++LineCount;
+    }
+
+    if(Result)
+    {
+        printf("%u lines compared, all pixel identical\n", LineCount);
+    }
+
+    return Result;
+}
+
+int main()
+{
+    int Result = 1;
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    if(InitScreenBuffer(&GlobalExpected, TEST_SIZE, TEST_SIZE) &&
+       InitScreenBuffer(&GlobalActual, TEST_SIZE, TEST_SIZE) &&
+       InitScreenBuffer(&GlobalScratch, TEST_SIZE, TEST_SIZE))
+    {
+        printf("======= Comparison against Line_Draw_By_Bresenham ======= \n");
+        if(RunComparison())
+        {
+            Result = 0;
+
+            screen_buffer Buffer = {};
+            if(InitScreenBuffer(&Buffer, 1920, 1080))
+            {
+                int32_t X0 = 10;
+                int32_t Y0 = 10;
+                int32_t X1 = 1900;
+                int32_t Y1 = 800;
+                uint64_t ByteCount = (uint64_t)(X1 - X0)*Buffer.BytesPerPixel;
+
+                draw_line_method Methods[] = {Line_Draw_By_Bresenham, Line_Draw_By_Bresenham_Stepping};
+                repetition_tester Testers[2] = {};
+                for(uint32_t Pass = 0; Pass < 2; ++Pass)
+                {
+                    for(uint32_t MethodIndex = 0; MethodIndex < 2; ++MethodIndex)
+                    {
+                        draw_line_method Method = Methods[MethodIndex];
+                        PrintLineDrawingMethod(Method);
+
+                        repetition_tester *Tester = &Testers[MethodIndex];
+                        NewTestWave(Tester, ByteCount, CPUTimerFreq, 3);
+                        while(IsTesting(Tester))
+                        {
+                            BeginTime(Tester);
+                            DrawLine(&Buffer, X0, Y0, X1, Y1, LineColor, Method);
+                            EndTime(Tester);
+
+                            CountBytes(Tester, ByteCount);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        printf("ERROR: Could not allocate memory for buffer \n");
+    }
+
+    return(Result);
+}
@@ -0,0 +1,198 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_rasterizer.cpp"
+
+/*
+    NOTE(Axel): listing_2 on Linux, without the copy. We draw straight in the XImage the
+      X server reads through MIT-SHM (see shared_x11.cpp), then:
+        - the image can't be touched until the server sends the ShmCompletion, so
+          the loop waits on it before drawing the next frame
+        - frames are paced to a target rate (60Hz by default) by sleeping until the
+          next frame time instead of spinning. Plain X11 has no vsync, that would
+          need the Present extension, a fixed rate is what we can do everywhere
+          (and the only thing that means something under Xvfb)
+
+      Usage: listing_8 [--frames N] [--rate Hz]   (--rate 0 is unbounded)
+      Headless: xvfb-run -s "-screen 0 1920x1080x24" ./build/listing_8_main_rc --frames 600
+*/
+#if _WIN32
+
+int main()
+{
+    printf("listing_8 is the Linux X11 backend, listing_2 is the Windows one.\n");
+    return(0);
+}
+
+#else
+
+#include "shared_x11.cpp"
+
+#define WINDOW_WIDTH 1280
+#define WINDOW_HEIGHT 720
+#define FAN_LINE_COUNT 256
+
+struct frame_stats
+{
+    repetition_test_results FrameTime;  /* NOTE: Start of a frame to the start of the next */
+    repetition_test_results RenderTime; /* NOTE: Clear + lines */
+    repetition_test_results WaitTime;   /* NOTE: Blocked on the previous present */
+    uint32_t MissedFrameCount;
+};
+
+static void InitResults(repetition_test_results *Results)
+{
+    *Results = {};
+    Results->MinTime = (uint64_t)-1;
+}
+
+/*
+    NOTE(Axel): A fan of lines turning around the center, every octant gets drawn.
+*/
+static void RenderFrame(screen_buffer *Buffer, uint32_t FrameIndex)
+{
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+
+    int32_t CenterX = (int32_t)Buffer->Width / 2;
+    int32_t CenterY = (int32_t)Buffer->Height / 2;
+    real32 Radius = 0.45f*(real32)((Buffer->Width < Buffer->Height) ? Buffer->Width : Buffer->Height);
+    real32 Tau = 6.28318530718f;
+    real32 Rotation = 0.01f*(real32)FrameIndex;
+
+    for(uint32_t LineIndex = 0; LineIndex < FAN_LINE_COUNT; ++LineIndex)
+    {
+        real32 Angle = Rotation + Tau*(real32)LineIndex / (real32)FAN_LINE_COUNT;
+        int32_t X1 = CenterX + RoundReal32Toint32_t(Radius*cosf(Angle));
+        int32_t Y1 = CenterY + RoundReal32Toint32_t(Radius*sinf(Angle));
+        DrawLine(Buffer, CenterX, CenterY, X1, Y1, LineColor);
+    }
+}
+
+static void PrintFrameResults(char const *Label, repetition_test_results Results, uint64_t CPUTimerFreq)
+{
+    printf("--- %s (%llu) ---\n", Label, (unsigned long long)Results.TestCount);
+    if(Results.TestCount)
+    {
+        PrintResults(Results, CPUTimerFreq, 0);
+    }
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t FrameCount = 0; /* NOTE: 0 runs until the window is closed */
+    uint32_t TargetRate = 60;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--frames") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            FrameCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--rate") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            TargetRate = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    x11_window Window = {};
+    x11_image Image = {};
+    if(X11OpenWindow(&Window, WINDOW_WIDTH, WINDOW_HEIGHT, "draw me a line") &&
+       X11CreateImage(&Window, &Image, WINDOW_WIDTH, WINDOW_HEIGHT))
+    {
+        printf("%ux%u, %s, target rate: ", WINDOW_WIDTH, WINDOW_HEIGHT,
+               Image.Shared ? "MIT-SHM (no copy)" : "XPutImage (copy)");
+        if(TargetRate)
+        {
+            printf("%uHz\n", TargetRate);
+        }
+        else
+        {
+            printf("unbounded\n");
+        }
+
+        frame_stats Stats = {};
+        InitResults(&Stats.FrameTime);
+        InitResults(&Stats.RenderTime);
+        InitResults(&Stats.WaitTime);
+
+        uint64_t OSTimerFreq = GetOSTimerFreq();
+        uint64_t FramePeriod = TargetRate ? (OSTimerFreq / TargetRate) : 0;
+        uint64_t NextFrameOSTime = ReadOSTimer();
+        uint64_t LastFrameStart = 0;
+
+        for(uint32_t FrameIndex = 0;
+            X11ProcessPendingEvents(&Window) && (!FrameCount || (FrameIndex < FrameCount));
+            ++FrameIndex)
+        {
+            uint64_t FrameStart = ReadCPUTimer();
+            if(LastFrameStart)
+            {
+                AccumulateResult(&Stats.FrameTime, FrameStart - LastFrameStart);
+            }
+            LastFrameStart = FrameStart;
+
+            /* NOTE: Backpressure, we draw in the memory the server reads */
+            X11WaitForPresent(&Window, &Image);
+            uint64_t RenderStart = ReadCPUTimer();
+            AccumulateResult(&Stats.WaitTime, RenderStart - FrameStart);
+
+            RenderFrame(&Image.Buffer, FrameIndex);
+            AccumulateResult(&Stats.RenderTime, ReadCPUTimer() - RenderStart);
+
+            X11Present(&Window, &Image);
+
+            if(FramePeriod)
+            {
+                NextFrameOSTime += FramePeriod;
+                uint64_t Now = ReadOSTimer();
+                if(Now < NextFrameOSTime)
+                {
+                    SleepUntilOSTime(NextFrameOSTime);
+                }
+                else
+                {
+                    /* NOTE: Late, don't try to catch up with a burst of frames */
+                    ++Stats.MissedFrameCount;
+                    NextFrameOSTime = Now;
+                }
+            }
+        }
+
+        X11WaitForPresent(&Window, &Image);
+
+        PrintFrameResults("Frame time", Stats.FrameTime, CPUTimerFreq);
+        PrintFrameResults("Render", Stats.RenderTime, CPUTimerFreq);
+        PrintFrameResults("Wait on previous present", Stats.WaitTime, CPUTimerFreq);
+        PrintFrameResults("Present latency (put -> completion)", Window.PresentLatency, CPUTimerFreq);
+        if(Stats.FrameTime.TestCount)
+        {
+            double AverageSeconds = SecondsFromCPUTime((double)Stats.FrameTime.TotalTime /
+                                                       (double)Stats.FrameTime.TestCount, CPUTimerFreq);
+            printf("Average rate: %.2fHz, missed frames: %u\n",
+                   (AverageSeconds > 0.0) ? (1.0 / AverageSeconds) : 0.0, Stats.MissedFrameCount);
+        }
+
+        X11DestroyImage(&Window, &Image);
+        Result = 0;
+    }
+
+    X11CloseWindow(&Window);
+
+    return(Result);
+}
+
+#endif
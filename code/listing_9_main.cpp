@@ -0,0 +1,255 @@
+#include<stdint.h>
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+typedef int32_t b32;
+typedef float real32;
+typedef double real64;
+
+static int32_t LineColor  = (255 << 16) | (0 << 8) | (0 << 0);
+
+#include "shared_platform_metrics.cpp"
+#include "shared_repetition_tester.cpp"
+#include "shared_threads.cpp"
+#include "shared_rasterizer.cpp"
+#include "shared_frame_pipeline.cpp"
+
+/*
+    NOTE(Axel): listing_8 drew and presented on the same thread, so a frame cost
+      raster + present. Here the two are decoupled:
+        - a render thread draws frames as fast as it can, never waiting on the display
+        - the main thread presents at the target rate whatever frame is the latest
+      with 3 shared memory images handed over through the frame_mailbox
+      (shared_frame_pipeline.cpp). Rendered frames that were replaced before
+      being shown are dropped frames, ticks where nothing new was ready repeat
+      the frame on screen.
+
+      Only the main thread talks to the X server, Xlib is not thread safe unless
+      XInitThreads is called and we don't need it to be.
+
+      Usage: listing_9 [--frames N] [--rate Hz] [--lines N]
+      Headless: xvfb-run -s "-screen 0 1920x1080x24" ./build/listing_9_main_rc --frames 600
+*/
+#if _WIN32
+
+int main()
+{
+    printf("listing_9 uses the Linux X11 backend of listing_8.\n");
+    return(0);
+}
+
+#else
+
+#include "shared_x11.cpp"
+
+#define WINDOW_WIDTH 1280
+#define WINDOW_HEIGHT 720
+
+struct render_context
+{
+    screen_buffer *Buffers[FRAME_BUFFER_COUNT];
+    frame_mailbox *Mailbox;
+    uint32_t LineCount;
+    uint32_t volatile Running;
+
+    repetition_test_results RenderTime;
+};
+
+static void InitResults(repetition_test_results *Results)
+{
+    *Results = {};
+    Results->MinTime = (uint64_t)-1;
+}
+
+/*
+    NOTE(Axel): Same fan as listing_8, LineCount lines around the center.
+*/
+static void RenderFrame(screen_buffer *Buffer, uint32_t FrameIndex, uint32_t LineCount)
+{
+    memset(Buffer->Memory, 0, Buffer->MemoryCount);
+
+    int32_t CenterX = (int32_t)Buffer->Width / 2;
+    int32_t CenterY = (int32_t)Buffer->Height / 2;
+    real32 Radius = 0.45f*(real32)((Buffer->Width < Buffer->Height) ? Buffer->Width : Buffer->Height);
+    real32 Tau = 6.28318530718f;
+    real32 Rotation = 0.01f*(real32)FrameIndex;
+
+    for(uint32_t LineIndex = 0; LineIndex < LineCount; ++LineIndex)
+    {
+        real32 Angle = Rotation + Tau*(real32)LineIndex / (real32)LineCount;
+        int32_t X1 = CenterX + RoundReal32Toint32_t(Radius*cosf(Angle));
+        int32_t Y1 = CenterY + RoundReal32Toint32_t(Radius*sinf(Angle));
+        DrawLine(Buffer, CenterX, CenterY, X1, Y1, LineColor);
+    }
+}
+
+static void RenderThreadProc(void *Param)
+{
+    render_context *Context = (render_context *)Param;
+    frame_mailbox *Mailbox = Context->Mailbox;
+
+    uint32_t FrameIndex = 0;
+    while(AtomicLoadU32(&Context->Running))
+    {
+        uint64_t RenderStart = ReadCPUTimer();
+        RenderFrame(Context->Buffers[Mailbox->RenderIndex], FrameIndex++, Context->LineCount);
+        AccumulateResult(&Context->RenderTime, ReadCPUTimer() - RenderStart);
+
+        PublishFrame(Mailbox);
+    }
+}
+
+static void PrintFrameResults(char const *Label, repetition_test_results Results, uint64_t CPUTimerFreq)
+{
+    printf("--- %s (%llu) ---\n", Label, (unsigned long long)Results.TestCount);
+    if(Results.TestCount)
+    {
+        PrintResults(Results, CPUTimerFreq, 0);
+    }
+}
+
+int main(int ArgCount, char **Args)
+{
+    int Result = 1;
+
+    uint32_t FrameCount = 0; /* NOTE: 0 runs until the window is closed */
+    uint32_t TargetRate = 60;
+    uint32_t LineCount = 4096;
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        if((strcmp(Args[ArgIndex], "--frames") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            FrameCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--rate") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            TargetRate = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Args[ArgIndex], "--lines") == 0) && (ArgIndex + 1 < ArgCount))
+        {
+            LineCount = (uint32_t)atoi(Args[++ArgIndex]);
+        }
+    }
+
+    if(!TargetRate)
+    {
+        /* NOTE: Unbounded makes no sense here, the renderer is the unbounded side */
+        TargetRate = 60;
+    }
+
+    uint64_t CPUTimerFreq = EstimateCPUTimerFreq();
+
+    x11_window Window = {};
+    x11_image Images[FRAME_BUFFER_COUNT] = {};
+    b32 ImagesCreated = X11OpenWindow(&Window, WINDOW_WIDTH, WINDOW_HEIGHT, "draw me a line");
+    for(uint32_t ImageIndex = 0; ImagesCreated && (ImageIndex < FRAME_BUFFER_COUNT); ++ImageIndex)
+    {
+        ImagesCreated = X11CreateImage(&Window, &Images[ImageIndex], WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+
+    if(ImagesCreated)
+    {
+        printf("%ux%u, %s, %u lines per frame, present at %uHz\n", WINDOW_WIDTH, WINDOW_HEIGHT,
+               Images[0].Shared ? "MIT-SHM (no copy)" : "XPutImage (copy)", LineCount, TargetRate);
+
+        frame_mailbox Mailbox;
+        InitFrameMailbox(&Mailbox);
+
+        render_context Context = {};
+        for(uint32_t ImageIndex = 0; ImageIndex < FRAME_BUFFER_COUNT; ++ImageIndex)
+        {
+            Context.Buffers[ImageIndex] = &Images[ImageIndex].Buffer;
+        }
+        Context.Mailbox = &Mailbox;
+        Context.LineCount = LineCount;
+        Context.Running = true;
+        InitResults(&Context.RenderTime);
+
+        repetition_test_results PresentTime;
+        repetition_test_results TickTime;
+        InitResults(&PresentTime);
+        InitResults(&TickTime);
+
+        os_thread RenderThread = {};
+        if(CreateOSThread(&RenderThread, RenderThreadProc, &Context))
+        {
+            uint64_t OSTimerFreq = GetOSTimerFreq();
+            uint64_t FramePeriod = OSTimerFreq / TargetRate;
+            uint64_t NextFrameOSTime = ReadOSTimer();
+            uint64_t LastTickStart = 0;
+            uint64_t RunStart = ReadCPUTimer();
+
+            for(uint32_t TickIndex = 0;
+                X11ProcessPendingEvents(&Window) && (!FrameCount || (TickIndex < FrameCount));
+                ++TickIndex)
+            {
+                uint64_t TickStart = ReadCPUTimer();
+                if(LastTickStart)
+                {
+                    AccumulateResult(&TickTime, TickStart - LastTickStart);
+                }
+                LastTickStart = TickStart;
+
+                /* NOTE: The buffer on screen goes back in the mailbox with the swap,
+                   the server must be done reading it before the renderer gets it */
+                X11WaitForPresent(&Window, &Images[Mailbox.PresentIndex]);
+                if(AcquireFrame(&Mailbox))
+                {
+                    uint64_t PresentStart = ReadCPUTimer();
+                    X11Present(&Window, &Images[Mailbox.PresentIndex]);
+                    AccumulateResult(&PresentTime, ReadCPUTimer() - PresentStart);
+                }
+
+                NextFrameOSTime += FramePeriod;
+                uint64_t Now = ReadOSTimer();
+                if(Now < NextFrameOSTime)
+                {
+                    SleepUntilOSTime(NextFrameOSTime);
+                }
+                else
+                {
+                    NextFrameOSTime = Now;
+                }
+            }
+
+            uint64_t RunTime = ReadCPUTimer() - RunStart;
+
+            AtomicExchangeU32(&Context.Running, false);
+            JoinOSThread(&RenderThread);
+            for(uint32_t ImageIndex = 0; ImageIndex < FRAME_BUFFER_COUNT; ++ImageIndex)
+            {
+                X11WaitForPresent(&Window, &Images[ImageIndex]);
+            }
+
+            PrintFrameResults("Render (render thread)", Context.RenderTime, CPUTimerFreq);
+            PrintFrameResults("Present call (main thread)", PresentTime, CPUTimerFreq);
+            PrintFrameResults("Present latency (put -> completion)", Window.PresentLatency, CPUTimerFreq);
+            PrintFrameResults("Present tick", TickTime, CPUTimerFreq);
+
+            double Seconds = SecondsFromCPUTime((double)RunTime, CPUTimerFreq);
+            if(Seconds > 0.0)
+            {
+                printf("Rendered: %u (%.1f frames/s), presented: %u (%.1f frames/s)\n",
+                       Mailbox.RenderedCount, Mailbox.RenderedCount / Seconds,
+                       Mailbox.PresentedCount, Mailbox.PresentedCount / Seconds);
+                printf("Dropped (rendered, never shown): %u, repeated ticks (nothing new): %u\n",
+                       Mailbox.DroppedCount, Mailbox.RepeatedCount);
+            }
+
+            Result = 0;
+        }
+
+        for(uint32_t ImageIndex = 0; ImageIndex < FRAME_BUFFER_COUNT; ++ImageIndex)
+        {
+            X11DestroyImage(&Window, &Images[ImageIndex]);
+        }
+    }
+
+    X11CloseWindow(&Window);
+
+    return(Result);
+}
+
+#endif
@@ -0,0 +1,783 @@
+#include <stdint.h>
+#include <math.h>
+
+/*
+    NOTE(Axel): Circles, ellipses and arcs with the decision variable of DrawLineStepping.
+      The implicit function (x^2 + y^2 - R^2 for a circle) is evaluated at the
+      midpoint between the two candidate pixels, and instead of computing it at
+      every step we add its differences. It is a polynomial of degree 2, so the
+      differences change by constants: the loop is compares and adds, no multiply.
+
+      Circle: one octant is walked (0 <= x <= y, x moves every step, y sometimes),
+      the 7 others are mirrors and transposes of it, 8 pixels per step. The pixel
+      of column x in that octant is at
+        y(x) = max(y : 4x^2 + (2y - 1)^2 < 4R^2) = max(y : y(y - 1) < R^2 - x^2)
+      and the octant ends at the last x with x <= y(x). That's what gets solved
+      to start a walk in the middle of an octant, in the second form every value
+      stays under R^2 (2^62 for any int32 radius). The walk keeps its decision in
+      64 bits up to MAX_CIRCLE_WALK_RADIUS, past that the circle is bigger than any
+      screen and every visible step of an octant is solved instead (same pixels).
+
+      Ellipse: axis aligned, 4-way symmetry, two regions (x moves every step while
+      the slope is under 1, then y moves every step). 64 bits decision, radii up
+      to MAX_ELLIPSE_WALK_RADIUS. Past that the ellipse is bigger than any screen,
+      it is solved row by row for the visible rows only (WalkEllipseRows).
+
+      Filled variants write spans: a row is filled from the leftmost to the
+      rightmost pixel the outline has on that row, each row once.
+
+      Clipping: a shape completely inside the buffer is drawn with pointer steps and
+      no test. A circle crossing the edges is drawn octant by octant: the range of
+      columns of every octant that lands in the rectangle is solved first (arcs
+      too, their angles become a range of columns in every octant) and only those
+      steps are walked, a ring 100 times the size of the screen costs what is
+      visible. An ellipse crossing the edges tests its pixels, and its walk stops as
+      soon as what is left of it can't reach the rectangle.
+*/
+
+/*
+    NOTE(Axel): Octant K covers the angles [45K, 45K + 45) degrees, clockwise on the
+      screen (y goes down) from +x. Its pixel for the walk position (x, y) is
+      (SignX*x, SignY*y), transposed for 0, 3, 4 and 7. The even octants go away
+      from their first angle when x grows, the odd ones come back to it.
+*/
+static int32_t CircleOctantSignX[8] = {1, 1, -1, -1, -1, -1, 1, 1};
+static int32_t CircleOctantSignY[8] = {1, 1, 1, 1, -1, -1, -1, -1};
+static b32 CircleOctantSwap[8] = {true, false, false, true, true, false, false, true};
+
+#define MAX_CIRCLE_WALK_RADIUS 16384
+
+/*
+    NOTE(Axel): 0 <= X <= Radius.
+*/
+static int64_t CircleYAtX(int64_t Radius, int64_t X)
+{
+    int64_t Limit = Radius*Radius - X*X;
+    int64_t Result = (int64_t)(sqrt((double)Limit) + 0.5);
+    while((Result > 0) && (Result*(Result - 1) >= Limit))
+    {
+        --Result;
+    }
+
+    while((Result + 1)*Result < Limit)
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Last column of the octant walk, the last x with x <= y(x), which is
+      2x^2 - x < R^2.
+*/
+static int64_t CircleOctantEnd(int64_t Radius)
+{
+    int64_t Limit = Radius*Radius;
+    int64_t Result = (int64_t)((double)Radius*0.70710678);
+    while((Result > 0) && ((2*Result*Result - Result) >= Limit))
+    {
+        --Result;
+    }
+
+    while((2*(Result + 1)*(Result + 1) - (Result + 1)) < Limit)
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Last column with y(x) >= MinY (x^2 < R^2 - MinY(MinY - 1)), -1 if there
+      is none. y(0) is R, nothing is above it.
+*/
+static int64_t CircleLastXAbove(int64_t Radius, int64_t MinY)
+{
+    int64_t Result = Radius;
+    if(MinY > Radius)
+    {
+        Result = -1;
+    }
+    else if(MinY > 0)
+    {
+        int64_t Limit = Radius*Radius - MinY*(MinY - 1);
+        Result = (int64_t)sqrt((double)Limit);
+        while((Result >= 0) && (Result*Result >= Limit))
+        {
+            --Result;
+        }
+
+        while((Result + 1)*(Result + 1) < Limit)
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+inline b32 IsRectInside(clip_rect Rect, int64_t MinX, int64_t MinY, int64_t MaxX, int64_t MaxY)
+{
+    b32 Result = ((MinX >= Rect.MinX) && (MaxX <= Rect.MaxX) &&
+                  (MinY >= Rect.MinY) && (MaxY <= Rect.MaxY));
+    return Result;
+}
+
+inline b32 IsRectOutside(clip_rect Rect, int64_t MinX, int64_t MinY, int64_t MaxX, int64_t MaxY)
+{
+    b32 Result = ((MaxX < Rect.MinX) || (MinX > Rect.MaxX) ||
+                  (MaxY < Rect.MinY) || (MinY > Rect.MaxY));
+    return Result;
+}
+
+/*
+    NOTE(Axel): Whole circle in the buffer, 8 pixels per step, offsets from the center
+      kept up to date with adds.
+*/
+static void DrawCircleInside(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY,
+                             int32_t Radius, int32_t Color)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    uint32_t *Center = (uint32_t *)Buffer->Memory + CenterY*PitchInPixels + CenterX;
+
+    int32_t X = 0;
+    int32_t Y = Radius;
+    intptr_t RowX = 0;
+    intptr_t RowY = Radius*PitchInPixels;
+
+    int32_t decision    = 1 - Radius;
+    int32_t IncrementE  = 3;
+    int32_t IncrementSE = 5 - 2*Radius;
+    while(X <= Y)
+    {
+        Center[RowY + X] = (uint32_t)Color;
+        Center[RowY - X] = (uint32_t)Color;
+        Center[-RowY + X] = (uint32_t)Color;
+        Center[-RowY - X] = (uint32_t)Color;
+        Center[RowX + Y] = (uint32_t)Color;
+        Center[RowX - Y] = (uint32_t)Color;
+        Center[-RowX + Y] = (uint32_t)Color;
+        Center[-RowX - Y] = (uint32_t)Color;
+
+        if(decision < 0)
+        {
+            decision += IncrementE;
+            IncrementSE += 2;
+        }
+        else
+        {
+            decision += IncrementSE;
+            IncrementSE += 4;
+            --Y;
+            RowY -= PitchInPixels;
+        }
+
+        IncrementE += 2;
+        ++X;
+        RowX += PitchInPixels;
+    }
+}
+
+/*
+    NOTE(Axel): Columns [FirstX, LastX] of one octant (LastX <= CircleOctantEnd), only
+      the ones that land in Rect are walked. The decision variable is rebuilt for
+      the first one:
+        decision = (x + 1)^2 + (y - 1/2)^2 - R^2 - 1/4
+      (the 1/4 never changes the sign, it keeps the variable an integer).
+      Past MAX_CIRCLE_WALK_RADIUS every column is solved, one sqrt each, there are
+      no more of them than the rectangle is wide or high.
+*/
+static void DrawCircleOctant(screen_buffer *Buffer, clip_rect Rect,
+                             int32_t CenterX, int32_t CenterY, int32_t Radius,
+                             uint32_t Octant, int64_t FirstX, int64_t LastX, int32_t Color)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    int64_t SignX = CircleOctantSignX[Octant];
+    int64_t SignY = CircleOctantSignY[Octant];
+    b32 Swap = CircleOctantSwap[Octant];
+
+    /* NOTE: The rectangle in offsets from the center along the signs of the octant */
+    int64_t MinU = (SignX > 0) ? ((int64_t)Rect.MinX - CenterX) : ((int64_t)CenterX - Rect.MaxX);
+    int64_t MaxU = (SignX > 0) ? ((int64_t)Rect.MaxX - CenterX) : ((int64_t)CenterX - Rect.MinX);
+    int64_t MinV = (SignY > 0) ? ((int64_t)Rect.MinY - CenterY) : ((int64_t)CenterY - Rect.MaxY);
+    int64_t MaxV = (SignY > 0) ? ((int64_t)Rect.MaxY - CenterY) : ((int64_t)CenterY - Rect.MinY);
+    if(Swap)
+    {
+        int64_t Temp = MinU; MinU = MinV; MinV = Temp;
+        Temp = MaxU; MaxU = MaxV; MaxV = Temp;
+    }
+
+    /* NOTE: x is in [MinU, MaxU] directly, y(x) in [MinV, MaxV] is solved for */
+    FirstX = (FirstX > MinU) ? FirstX : MinU;
+    LastX = (LastX < MaxU) ? LastX : MaxU;
+
+    int64_t LastXInV = CircleLastXAbove(Radius, MinV);
+    int64_t FirstXInV = (MaxV >= 0) ? (CircleLastXAbove(Radius, MaxV + 1) + 1) : (LastX + 1);
+    FirstX = (FirstX > FirstXInV) ? FirstX : FirstXInV;
+    LastX = (LastX < LastXInV) ? LastX : LastXInV;
+
+    if((FirstX <= LastX) && (Radius > MAX_CIRCLE_WALK_RADIUS))
+    {
+        for(int64_t X = FirstX; X <= LastX; ++X)
+        {
+            int64_t Y = CircleYAtX(Radius, X);
+            int64_t PixelX = CenterX + SignX*(Swap ? Y : X);
+            int64_t PixelY = CenterY + SignY*(Swap ? X : Y);
+            DrawPixel(Buffer, (int32_t)PixelX, (int32_t)PixelY, Color);
+        }
+    }
+    else if(FirstX <= LastX)
+    {
+        int64_t X = FirstX;
+        int64_t Y = CircleYAtX(Radius, X);
+
+        int64_t decision    = (X + 1)*(X + 1) + Y*Y - Y - (int64_t)Radius*Radius;
+        int64_t IncrementE  = 2*X + 3;
+        int64_t IncrementSE = 2*(X - Y) + 5;
+
+        intptr_t StepX = Swap ? (intptr_t)SignY*PitchInPixels : (intptr_t)SignX;
+        intptr_t StepY = Swap ? -(intptr_t)SignX : -(intptr_t)SignY*PitchInPixels;
+        int64_t PixelX = CenterX + SignX*(Swap ? Y : X);
+        int64_t PixelY = CenterY + SignY*(Swap ? X : Y);
+
+        uint32_t *Pixel = (uint32_t *)Buffer->Memory + (intptr_t)PixelY*PitchInPixels + (intptr_t)PixelX;
+        for(int64_t Count = LastX - FirstX + 1; Count > 0; --Count)
+        {
+            *Pixel = (uint32_t)Color;
+
+            if(decision < 0)
+            {
+                decision += IncrementE;
+                IncrementSE += 2;
+            }
+            else
+            {
+                decision += IncrementSE;
+                IncrementSE += 4;
+                Pixel += StepY;
+            }
+
+            IncrementE += 2;
+            Pixel += StepX;
+        }
+    }
+}
+
+inline void DrawPixelClipped(screen_buffer *Buffer, clip_rect Rect, int64_t X, int64_t Y, int32_t Color)
+{
+    if((X >= Rect.MinX) && (X <= Rect.MaxX) && (Y >= Rect.MinY) && (Y <= Rect.MaxY))
+    {
+        DrawPixel(Buffer, (int32_t)X, (int32_t)Y, Color);
+    }
+}
+
+static void DrawCircle(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY, int32_t Radius, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    int64_t MinX = (int64_t)CenterX - Radius;
+    int64_t MinY = (int64_t)CenterY - Radius;
+    int64_t MaxX = (int64_t)CenterX + Radius;
+    int64_t MaxY = (int64_t)CenterY + Radius;
+
+    if(Radius == 0)
+    {
+        DrawPixelClipped(Buffer, Screen, CenterX, CenterY, Color);
+    }
+    else if((Radius > 0) && !IsRectOutside(Screen, MinX, MinY, MaxX, MaxY))
+    {
+        if((Radius <= MAX_CIRCLE_WALK_RADIUS) && IsRectInside(Screen, MinX, MinY, MaxX, MaxY))
+        {
+            DrawCircleInside(Buffer, CenterX, CenterY, Radius, Color);
+        }
+        else
+        {
+            int64_t OctantEnd = CircleOctantEnd(Radius);
+            for(uint32_t Octant = 0; Octant < 8; ++Octant)
+            {
+                DrawCircleOctant(Buffer, Screen, CenterX, CenterY, Radius, Octant, 0, OctantEnd, Color);
+            }
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Pixels of DrawCircle from StartAngle to EndAngle (radians, clockwise on
+      the screen from +x, a sweep of 2pi or more is the whole circle). In every
+      octant the angles become columns, x = R*sin(angle in the octant), so an arc
+      is 1 to 9 octant walks, nothing tested per pixel. Arcs sharing an angle
+      share its column: a sector split in pieces has no gap (a pixel exactly on a
+      diagonal may be drawn by both).
+*/
+static int64_t ArcColumnAt(int64_t Radius, real64 Fraction, b32 After)
+{
+    int64_t Result = After ? 1 : 0;
+    if(Fraction >= 1.0)
+    {
+        Result = INT64_MAX / 2;
+    }
+    else if(Fraction > 0.0)
+    {
+        real64 X = (real64)Radius*sin(Fraction*0.78539816339744831);
+        Result = After ? ((int64_t)floor(X) + 1) : (int64_t)ceil(X);
+    }
+
+    return Result;
+}
+
+static void DrawArc(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY, int32_t Radius,
+                    real32 StartAngle, real32 EndAngle, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    int64_t MinX = (int64_t)CenterX - Radius;
+    int64_t MinY = (int64_t)CenterY - Radius;
+    int64_t MaxX = (int64_t)CenterX + Radius;
+    int64_t MaxY = (int64_t)CenterY + Radius;
+
+    /* NOTE: In octants, each angle converted on its own so two arcs sharing one agree */
+    real64 OctantsPerRadian = 4.0 / 3.14159265358979324;
+    real64 Start = (real64)StartAngle*OctantsPerRadian;
+    real64 End = (real64)EndAngle*OctantsPerRadian;
+
+    if((Radius == 0) && (End > Start))
+    {
+        DrawPixelClipped(Buffer, Screen, CenterX, CenterY, Color);
+    }
+    else if((Radius > 0) && (End > Start) && !IsRectOutside(Screen, MinX, MinY, MaxX, MaxY))
+    {
+        if((End - Start) >= 8.0)
+        {
+            Start = 0.0;
+            End = 8.0;
+        }
+        else
+        {
+            real64 Turns = 8.0*floor(Start / 8.0);
+            Start -= Turns;
+            End -= Turns;
+        }
+
+        int64_t OctantEnd = CircleOctantEnd(Radius);
+        for(uint32_t Index = (uint32_t)Start; (Index < 16) && ((real64)Index < End); ++Index)
+        {
+            real64 Low = ((Start > (real64)Index) ? Start : (real64)Index) - (real64)Index;
+            real64 High = ((End < (real64)(Index + 1)) ? End : (real64)(Index + 1)) - (real64)Index;
+
+            uint32_t Octant = Index & 7;
+            int64_t FirstX = 0;
+            int64_t OnePastLastX = 0;
+            if(Octant & 1)
+            {
+                FirstX = ArcColumnAt(Radius, 1.0 - High, true);
+                OnePastLastX = ArcColumnAt(Radius, 1.0 - Low, true);
+            }
+            else
+            {
+                FirstX = ArcColumnAt(Radius, Low, false);
+                OnePastLastX = ArcColumnAt(Radius, High, false);
+            }
+
+            int64_t LastX = (OnePastLastX - 1 < OctantEnd) ? (OnePastLastX - 1) : OctantEnd;
+            DrawCircleOctant(Buffer, Screen, CenterX, CenterY, Radius, Octant, FirstX, LastX, Color);
+        }
+    }
+}
+
+inline void FillSpan(screen_buffer *Buffer, clip_rect Rect, int64_t Y, int64_t X0, int64_t X1, int32_t Color)
+{
+    X0 = (X0 > Rect.MinX) ? X0 : Rect.MinX;
+    X1 = (X1 < Rect.MaxX) ? X1 : Rect.MaxX;
+    if((Y >= Rect.MinY) && (Y <= Rect.MaxY) && (X0 <= X1))
+    {
+        uint32_t *Pixel = (uint32_t *)(Buffer->Memory + (intptr_t)Y*Buffer->Pitch) + X0;
+        FillRow(Pixel, (uint32_t)(X1 - X0 + 1), (uint32_t)Color);
+    }
+}
+
+/*
+    NOTE(Axel): Half width of the row Y (0 <= Y <= Radius), the rightmost outline pixel
+      on it: y(Y) where the row is a column of the transposed octants (Y up to the
+      end of the octant), otherwise the last column of the octant still on the row.
+*/
+inline int64_t CircleHalfWidth(int64_t Radius, int64_t OctantEnd, int64_t Y)
+{
+    int64_t Result = (Y <= OctantEnd) ? CircleYAtX(Radius, Y) : CircleLastXAbove(Radius, Y);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Row y is filled from the first to the last outline pixel, [-w, w]. Only the
+      rows of the rectangle are solved, one sqrt each, whatever the radius.
+*/
+static void FillCircle(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY, int32_t Radius, int32_t Color)
+{
+    clip_rect Screen = GetScreenClipRect(Buffer);
+    int64_t CX = CenterX;
+    int64_t CY = CenterY;
+
+    if((Radius >= 0) && !IsRectOutside(Screen, CX - Radius, CY - Radius, CX + Radius, CY + Radius))
+    {
+        int64_t OctantEnd = CircleOctantEnd(Radius);
+        int64_t FirstY = (int64_t)Screen.MinY - CY;
+        int64_t LastY = (int64_t)Screen.MaxY - CY;
+        FirstY = (FirstY > -Radius) ? FirstY : -Radius;
+        LastY = (LastY < Radius) ? LastY : Radius;
+
+        for(int64_t Y = FirstY; Y <= LastY; ++Y)
+        {
+            int64_t Half = CircleHalfWidth(Radius, OctantEnd, (Y < 0) ? -Y : Y);
+            FillSpan(Buffer, Screen, CY + Y, CX - Half, CX + Half, Color);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): The two regions of the midpoint ellipse, with everything scaled by 4
+      to stay in integers. Region 1 (slope under 1, x moves every step), decision at
+      (x + 1, y - 1/2):
+        P = 4b^2(x + 1)^2 + a^2(2y - 1)^2 - 4a^2b^2
+      region 2 (y moves every step), decision at (x + 1/2, y - 1):
+        Q = b^2(2x + 1)^2 + 4a^2(y - 1)^2 - 4a^2b^2
+      Both are updated with their differences (IncrementX/IncrementY), which move by
+      8b^2 and 8a^2. Thin ellipses can leave region 2 before reaching x = a on the
+      last row, the row is finished to a (the tip of the ellipse is there).
+      PlotEllipseStep gets every (x, y) of the quarter, FillEllipseRow every row
+      once with its last x.
+*/
+#define MAX_ELLIPSE_WALK_RADIUS 16384
+
+struct ellipse_walk
+{
+    screen_buffer *Buffer;
+    clip_rect Rect;
+    int64_t CenterX;
+    int64_t CenterY;
+    int32_t Color;
+
+    b32 Clip;
+    b32 Fill;
+};
+
+inline void PlotEllipseStep(ellipse_walk *Walk, uint32_t *Center, intptr_t Row, int64_t X, int64_t Y)
+{
+    if(Walk->Fill)
+    {
+        return;
+    }
+
+    if(Walk->Clip)
+    {
+        DrawPixelClipped(Walk->Buffer, Walk->Rect, Walk->CenterX + X, Walk->CenterY + Y, Walk->Color);
+        DrawPixelClipped(Walk->Buffer, Walk->Rect, Walk->CenterX - X, Walk->CenterY + Y, Walk->Color);
+        DrawPixelClipped(Walk->Buffer, Walk->Rect, Walk->CenterX + X, Walk->CenterY - Y, Walk->Color);
+        DrawPixelClipped(Walk->Buffer, Walk->Rect, Walk->CenterX - X, Walk->CenterY - Y, Walk->Color);
+    }
+    else
+    {
+        Center[Row + X] = (uint32_t)Walk->Color;
+        Center[Row - X] = (uint32_t)Walk->Color;
+        Center[-Row + X] = (uint32_t)Walk->Color;
+        Center[-Row - X] = (uint32_t)Walk->Color;
+    }
+}
+
+inline void FillEllipseRow(ellipse_walk *Walk, int64_t X, int64_t Y)
+{
+    if(Walk->Fill)
+    {
+        FillSpan(Walk->Buffer, Walk->Rect, Walk->CenterY + Y, Walk->CenterX - X, Walk->CenterX + X, Walk->Color);
+        if(Y)
+        {
+            FillSpan(Walk->Buffer, Walk->Rect, Walk->CenterY - Y, Walk->CenterX - X, Walk->CenterX + X, Walk->Color);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): What the walk has left to plot is at |x| >= X and |y| <= Y, both only
+      get worse, once that is out of the rectangle the walk is over.
+*/
+inline b32 IsEllipseRestVisible(ellipse_walk *Walk, int64_t X, int64_t Y, int64_t RadiusX)
+{
+    clip_rect Rect = Walk->Rect;
+    b32 Result = (((Walk->CenterY - Y) <= Rect.MaxY) && ((Walk->CenterY + Y) >= Rect.MinY) &&
+                  ((((Walk->CenterX + X) <= Rect.MaxX) && ((Walk->CenterX + RadiusX) >= Rect.MinX)) ||
+                   (((Walk->CenterX - X) >= Rect.MinX) && ((Walk->CenterX - RadiusX) <= Rect.MaxX))));
+    return Result;
+}
+
+static void WalkEllipse(ellipse_walk *Walk, int32_t RadiusX, int32_t RadiusY)
+{
+    intptr_t PitchInPixels = Walk->Buffer->Pitch / Walk->Buffer->BytesPerPixel;
+    uint32_t *Center = 0;
+    if(!Walk->Clip)
+    {
+        Center = ((uint32_t *)Walk->Buffer->Memory + (intptr_t)Walk->CenterY*PitchInPixels +
+                  (intptr_t)Walk->CenterX);
+    }
+
+    int64_t A2 = (int64_t)RadiusX*RadiusX;
+    int64_t B2 = (int64_t)RadiusY*RadiusY;
+
+    int64_t X = 0;
+    int64_t Y = RadiusY;
+    intptr_t Row = RadiusY*PitchInPixels;
+
+    /* NOTE: Region 1, GradientX < GradientY while the slope is under 1 */
+    int64_t decision   = 4*B2 - 4*A2*RadiusY + A2;
+    int64_t IncrementX = 12*B2;
+    int64_t IncrementY = 8*A2*(RadiusY - 1);
+    int64_t GradientX  = 0;
+    int64_t GradientY  = 2*A2*RadiusY;
+    b32 CanStop = (Walk->Clip && !Walk->Fill);
+    while(GradientX < GradientY)
+    {
+        if(CanStop && !IsEllipseRestVisible(Walk, X, Y, RadiusX))
+        {
+            return;
+        }
+
+        PlotEllipseStep(Walk, Center, Row, X, Y);
+        if(decision < 0)
+        {
+            decision += IncrementX;
+        }
+        else
+        {
+            FillEllipseRow(Walk, X, Y);
+            decision += IncrementX - IncrementY;
+            IncrementY -= 8*A2;
+            GradientY -= 2*A2;
+            --Y;
+            Row -= PitchInPixels;
+        }
+
+        IncrementX += 8*B2;
+        GradientX += 2*B2;
+        ++X;
+    }
+
+    /* NOTE: Region 2 */
+    decision   = B2*(2*X + 1)*(2*X + 1) + 4*A2*(Y - 1)*(Y - 1) - 4*A2*B2;
+    IncrementX = 8*B2*(X + 1);
+    IncrementY = 8*A2*Y - 12*A2;
+    while(Y > 0)
+    {
+        if(CanStop && !IsEllipseRestVisible(Walk, X, Y, RadiusX))
+        {
+            return;
+        }
+
+        PlotEllipseStep(Walk, Center, Row, X, Y);
+        FillEllipseRow(Walk, X, Y);
+        if(decision > 0)
+        {
+            decision -= IncrementY;
+        }
+        else
+        {
+            decision += IncrementX - IncrementY;
+            IncrementX += 8*B2;
+            ++X;
+        }
+
+        IncrementY -= 8*A2;
+        --Y;
+        Row -= PitchInPixels;
+    }
+
+    /* NOTE: Last row, finished up to the tip */
+    for(; X <= RadiusX; ++X)
+    {
+        PlotEllipseStep(Walk, Center, Row, X, 0);
+    }
+    FillEllipseRow(Walk, RadiusX, 0);
+}
+
+/*
+    NOTE(Axel): Half width of the row Y (0 <= Y <= RadiusY), -1 past the top. The two
+      rules of the walk, whichever goes further: the row reaches the columns whose
+      midpoint with the row inside is in the ellipse (flat parts, x < w(Y - 1/2)),
+      and the column rounded on the row itself (steep parts, w(Y) + 1/2), where
+        w(y) = a*sqrt(b^2 - y^2)/b
+*/
+static int64_t EllipseHalfWidth(int64_t RadiusX, int64_t RadiusY, int64_t Y)
+{
+    int64_t Result = -1;
+    if(Y <= RadiusY)
+    {
+        Result = RadiusX;
+        if(RadiusY > 0)
+        {
+            real64 Scale = (real64)RadiusX / (real64)RadiusY;
+            real64 Flat = Scale*sqrt(((real64)(RadiusY - Y) + 0.5)*((real64)(RadiusY + Y) - 0.5));
+            real64 Steep = Scale*sqrt((real64)(RadiusY - Y)*(real64)(RadiusY + Y));
+            int64_t FlatX = (int64_t)ceil(Flat) - 1;
+            int64_t SteepX = (int64_t)(Steep + 0.5);
+            Result = (FlatX > SteepX) ? FlatX : SteepX;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Ellipses too big for the walk (4a^2b^2 alone is 2^58 at 16384). Filled,
+      row y is [-X(y), X(y)]. Outlined, it is the pixels of that row with nothing
+      filled above them (further from the center), [X(y + 1) + 1, X(y)] and its
+      mirror, at least the pixel X(y): rows connect without gaps, and a fill is
+      exactly what its outline encloses. Only the rows of the rectangle are solved,
+      one sqrt each, whatever the radius.
+*/
+static void WalkEllipseRows(ellipse_walk *Walk, int32_t RadiusX, int32_t RadiusY)
+{
+    clip_rect Rect = Walk->Rect;
+    int64_t FirstY = (int64_t)Rect.MinY - Walk->CenterY;
+    int64_t LastY = (int64_t)Rect.MaxY - Walk->CenterY;
+    FirstY = (FirstY > -RadiusY) ? FirstY : -RadiusY;
+    LastY = (LastY < RadiusY) ? LastY : RadiusY;
+
+    for(int64_t Y = FirstY; Y <= LastY; ++Y)
+    {
+        int64_t Distance = (Y < 0) ? -Y : Y;
+        int64_t Half = EllipseHalfWidth(RadiusX, RadiusY, Distance);
+        int64_t Inner = EllipseHalfWidth(RadiusX, RadiusY, Distance + 1) + 1;
+        Inner = (Inner < Half) ? Inner : Half;
+
+        if(Walk->Fill || (Inner == 0))
+        {
+            FillSpan(Walk->Buffer, Rect, Walk->CenterY + Y, Walk->CenterX - Half, Walk->CenterX + Half, Walk->Color);
+        }
+        else
+        {
+            FillSpan(Walk->Buffer, Rect, Walk->CenterY + Y, Walk->CenterX - Half, Walk->CenterX - Inner, Walk->Color);
+            FillSpan(Walk->Buffer, Rect, Walk->CenterY + Y, Walk->CenterX + Inner, Walk->CenterX + Half, Walk->Color);
+        }
+    }
+}
+
+static void DrawEllipse(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY,
+                        int32_t RadiusX, int32_t RadiusY, int32_t Color)
+{
+    ellipse_walk Walk = {};
+    Walk.Buffer = Buffer;
+    Walk.Rect = GetScreenClipRect(Buffer);
+    Walk.CenterX = CenterX;
+    Walk.CenterY = CenterY;
+    Walk.Color = Color;
+
+    int64_t MinX = (int64_t)CenterX - RadiusX;
+    int64_t MinY = (int64_t)CenterY - RadiusY;
+    int64_t MaxX = (int64_t)CenterX + RadiusX;
+    int64_t MaxY = (int64_t)CenterY + RadiusY;
+
+    if((RadiusX >= 0) && (RadiusY >= 0) && !IsRectOutside(Walk.Rect, MinX, MinY, MaxX, MaxY))
+    {
+        if((RadiusX > MAX_ELLIPSE_WALK_RADIUS) || (RadiusY > MAX_ELLIPSE_WALK_RADIUS))
+        {
+            WalkEllipseRows(&Walk, RadiusX, RadiusY);
+        }
+        else
+        {
+            Walk.Clip = !IsRectInside(Walk.Rect, MinX, MinY, MaxX, MaxY);
+            WalkEllipse(&Walk, RadiusX, RadiusY);
+        }
+    }
+}
+
+static void FillEllipse(screen_buffer *Buffer, int32_t CenterX, int32_t CenterY,
+                        int32_t RadiusX, int32_t RadiusY, int32_t Color)
+{
+    ellipse_walk Walk = {};
+    Walk.Buffer = Buffer;
+    Walk.Rect = GetScreenClipRect(Buffer);
+    Walk.CenterX = CenterX;
+    Walk.CenterY = CenterY;
+    Walk.Color = Color;
+
+    int64_t MinX = (int64_t)CenterX - RadiusX;
+    int64_t MinY = (int64_t)CenterY - RadiusY;
+    int64_t MaxX = (int64_t)CenterX + RadiusX;
+    int64_t MaxY = (int64_t)CenterY + RadiusY;
+
+    if((RadiusX >= 0) && (RadiusY >= 0) && !IsRectOutside(Walk.Rect, MinX, MinY, MaxX, MaxY))
+    {
+        Walk.Clip = true;
+        Walk.Fill = true;
+        if((RadiusX > MAX_ELLIPSE_WALK_RADIUS) || (RadiusY > MAX_ELLIPSE_WALK_RADIUS))
+        {
+            WalkEllipseRows(&Walk, RadiusX, RadiusY);
+        }
+        else
+        {
+            WalkEllipse(&Walk, RadiusX, RadiusY);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Many circles (range rings), same layout as line_segment_batch.
+*/
+struct circle_batch
+{
+    int32_t *CenterX;
+    int32_t *CenterY;
+    int32_t *Radius;
+
+    uint32_t Count;
+    uint32_t Capacity;
+
+    buffer Memory;
+};
+
+static b32 AllocateCircleBatch(circle_batch *Batch, uint32_t Capacity)
+{
+    *Batch = {};
+
+    size_t LaneCount = ((size_t)Capacity + 15) & ~(size_t)15;
+    buffer Memory = AllocateBuffer(3*LaneCount*sizeof(int32_t) + 64);
+    if(Memory.Data)
+    {
+        int32_t *Base = (int32_t *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Batch->CenterX = Base;
+        Batch->CenterY = Base + LaneCount;
+        Batch->Radius = Base + 2*LaneCount;
+        Batch->Capacity = Capacity;
+        Batch->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreeCircleBatch(circle_batch *Batch)
+{
+    FreeBuffer(&Batch->Memory);
+    *Batch = {};
+}
+
+inline void PushCircle(circle_batch *Batch, int32_t CenterX, int32_t CenterY, int32_t Radius)
+{
+    if(Batch->Count < Batch->Capacity)
+    {
+        uint32_t Index = Batch->Count++;
+        Batch->CenterX[Index] = CenterX;
+        Batch->CenterY[Index] = CenterY;
+        Batch->Radius[Index] = Radius;
+    }
+}
+
+static void DrawCircleBatch(screen_buffer *Buffer, circle_batch *Batch, int32_t Color)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawCircle(Buffer, Batch->CenterX[Index], Batch->CenterY[Index], Batch->Radius[Index], Color);
+    }
+}
+
+static void FillCircleBatch(screen_buffer *Buffer, circle_batch *Batch, int32_t Color)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        FillCircle(Buffer, Batch->CenterX[Index], Batch->CenterY[Index], Batch->Radius[Index], Color);
+    }
+}
@@ -0,0 +1,126 @@
+#include <stdint.h>
+#include <string.h>
+
+/*
+    NOTE(Axel): Filling the screen with a clear color. Three ways:
+        - scalar: a store per pixel, the compiler turns it in vector stores but
+          every cache line is read first (read for ownership) then written back,
+          so a 8MB clear moves 16MB
+        - streaming: non-temporal stores (ClearBufferStreaming, shared_kernels.cpp,
+          as wide as the CPU allows), the lines go straight to memory without
+          being read, half the traffic. Only worth it when the buffer doesn't fit
+          in the cache anyway, the pixels are NOT in the cache after
+        - lazy: nothing is cleared up front, tiles that are still dirty from the
+          last frame are marked pending and the line kernel clears a tile the first
+          time a segment goes through it (DrawLineLazyClear). Tiles nobody draws in
+          are cleared at the end of the frame only if the last frame drew in them,
+          so tiles that stay empty cost nothing, frame after frame.
+*/
+
+static void ClearBufferScalar(screen_buffer *Buffer, uint32_t Color)
+{
+    for(uint32_t Y = 0; Y < Buffer->Height; ++Y)
+    {
+        uint32_t *Pixel = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch);
+        for(uint32_t X = 0; X < Buffer->Width; ++X)
+        {
+            *Pixel++ = Color;
+        }
+    }
+}
+
+struct lazy_clear
+{
+    uint32_t Color;
+
+    dirty_region Pending; /* NOTE: Tiles with old pixels, to clear before use */
+    dirty_region Written; /* NOTE: Tiles drawn in this frame */
+    dirty_region Scratch; /* NOTE: Tiles of the segment being drawn */
+
+    uint64_t ClearedByteCount;
+};
+
+static b32 InitLazyClear(lazy_clear *Lazy, screen_buffer *Buffer, uint32_t Color)
+{
+    *Lazy = {};
+    Lazy->Color = Color;
+
+    b32 Result = (InitDirtyRegion(&Lazy->Pending, Buffer->Width, Buffer->Height) &&
+                  InitDirtyRegion(&Lazy->Written, Buffer->Width, Buffer->Height) &&
+                  InitDirtyRegion(&Lazy->Scratch, Buffer->Width, Buffer->Height));
+    if(Result)
+    {
+        /* NOTE: The memory comes uninitialized out of InitScreenBuffer */
+        MarkAllDirty(&Lazy->Pending);
+    }
+
+    return Result;
+}
+
+static void FreeLazyClear(lazy_clear *Lazy)
+{
+    FreeDirtyRegion(&Lazy->Pending);
+    FreeDirtyRegion(&Lazy->Written);
+    FreeDirtyRegion(&Lazy->Scratch);
+}
+
+/*
+    NOTE(Axel): Clears the tiles of Mask (a tile row) that are still pending. Regular
+      stores on purpose, the line kernel is about to write in the tile.
+*/
+static void ResolvePendingTiles(screen_buffer *Buffer, lazy_clear *Lazy, uint32_t TileY, uint64_t Mask)
+{
+    uint64_t ToClear = Lazy->Pending.Rows[TileY] & Mask;
+    Lazy->Pending.Rows[TileY] &= ~ToClear;
+    while(ToClear)
+    {
+        uint32_t TileX = FindLowestSetBit(ToClear);
+        ToClear &= ToClear - 1;
+
+        dirty_rect Tile = GetTileRect(&Lazy->Pending, TileX, TileY);
+        ClearRect(Buffer, Tile, Lazy->Color);
+        Lazy->ClearedByteCount += (uint64_t)Tile.Width*Tile.Height*Buffer->BytesPerPixel;
+    }
+}
+
+/*
+    NOTE(Axel): Whatever was drawn last frame becomes pending, the rest of the screen
+      still has the clear color.
+*/
+static void BeginLazyClearFrame(lazy_clear *Lazy)
+{
+    UnionDirtyRegion(&Lazy->Pending, &Lazy->Written);
+    ResetDirtyRegion(&Lazy->Written);
+    Lazy->ClearedByteCount = 0;
+}
+
+/*
+    NOTE(Axel): The tiles the segment crosses are the ones MarkDirtyLine would mark.
+*/
+static void DrawLineLazyClear(screen_buffer *Buffer, lazy_clear *Lazy,
+                              int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, int32_t Color)
+{
+    uint32_t TileMinY = 0;
+    uint32_t TileMaxY = 0;
+    MarkLineTilesOnly(&Lazy->Scratch, X0, Y0, X1, Y1, &TileMinY, &TileMaxY);
+
+    for(uint32_t TileY = TileMinY; TileY <= TileMaxY; ++TileY)
+    {
+        uint64_t Touched = Lazy->Scratch.Rows[TileY];
+        ResolvePendingTiles(Buffer, Lazy, TileY, Touched);
+        Lazy->Written.Rows[TileY] |= Touched;
+    }
+
+    DrawLine(Buffer, X0, Y0, X1, Y1, Color);
+}
+
+/*
+    NOTE(Axel): After this every pixel is either drawn this frame or the clear color.
+*/
+static void EndLazyClearFrame(screen_buffer *Buffer, lazy_clear *Lazy)
+{
+    for(uint32_t TileY = 0; TileY < Lazy->Pending.TileCountY; ++TileY)
+    {
+        ResolvePendingTiles(Buffer, Lazy, TileY, ~0ull);
+    }
+}
@@ -0,0 +1,101 @@
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): The binary is built for the x64 baseline (SSE2) only, the wider kernels
+      are compiled for their instruction set function by function and picked at
+      startup from what the CPU (and the OS, it has to save the wide registers on a
+      context switch) supports:
+        - CPUID leaf 1 ECX: bit 27 OSXSAVE (XGETBV is there), bit 28 AVX
+        - CPUID leaf 7 EBX: bit 5 AVX2, bit 16 AVX512F, bit 30 AVX512BW
+        - XCR0: bits 1-2 the OS saves XMM/YMM, bits 5-7 the OS saves the AVX-512 state
+      GCC/Clang refuse the intrinsics of a set the function isn't compiled for, hence
+      TARGET_AVX2/TARGET_AVX512 on every function using them (clang++ on Windows
+      too). MSVC compiles any intrinsic anywhere, the macros are empty there. A
+      function with a target can't be inlined into one without it: the whole loop
+      goes in the targeted function, the dispatch happens once per call, not once
+      per pixel.
+*/
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#endif
+
+enum isa_level : uint32_t
+{
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_AVX512,
+
+    ISA_Count,
+};
+
+static char const *ISALevelNames[ISA_Count] = {"sse2", "avx2", "avx512"};
+
+static uint64_t ReadXCR0(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    uint64_t Result = _xgetbv(0);
+#else
+    uint32_t Low, High;
+    __asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+    uint64_t Result = ((uint64_t)High << 32) | Low;
+#endif
+    return Result;
+}
+
+static isa_level DetectISALevel(void)
+{
+    uint32_t Registers[4];
+    ReadCPUID(0, 0, Registers);
+    uint32_t MaxLeaf = Registers[0];
+
+    ReadCPUID(1, 0, Registers);
+    b32 HasOSXSave = (Registers[2] >> 27) & 1;
+    b32 HasAVX = (Registers[2] >> 28) & 1;
+
+    uint32_t LeafSevenEBX = 0;
+    if(MaxLeaf >= 7)
+    {
+        ReadCPUID(7, 0, Registers);
+        LeafSevenEBX = Registers[1];
+    }
+
+    uint64_t XCR0 = HasOSXSave ? ReadXCR0() : 0;
+    b32 OSSavesYMM = ((XCR0 & 0x6) == 0x6);
+    b32 OSSavesZMM = ((XCR0 & 0xe6) == 0xe6);
+
+    isa_level Result = ISA_SSE2;
+    if(HasAVX && OSSavesYMM && ((LeafSevenEBX >> 5) & 1))
+    {
+        Result = ISA_AVX2;
+        if(OSSavesZMM && ((LeafSevenEBX >> 16) & 1) && ((LeafSevenEBX >> 30) & 1))
+        {
+            Result = ISA_AVX512;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): "sse2", "avx2" or "avx512" (the --isa of the listings), ISA_Count if it
+      is none of them.
+*/
+static isa_level GetISALevelFromName(char const *Name)
+{
+    isa_level Result = ISA_Count;
+    for(uint32_t Level = 0; Level < ISA_Count; ++Level)
+    {
+        if(strcmp(Name, ISALevelNames[Level]) == 0)
+        {
+            Result = (isa_level)Level;
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,358 @@
+#include <stdint.h>
+#include <math.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): Quadratic and cubic Béziers flattened into lines, in pixels of the
+      target buffer.
+
+      How many lines: Wang's formula. A Bézier of degree d cut in n equal steps of t
+      has its chords within Tolerance of the curve when
+        n >= sqrt(d(d - 1)/8 * M / Tolerance)
+      M being the longest second difference of the control points
+      (|P(i) - 2P(i + 1) + P(i + 2)|, 0 for a straight curve). The count follows the
+      curve: a flat one is one line, a tight turn gets many, and a tolerance of a
+      quarter of a pixel stays invisible once the points are rounded to pixels.
+
+      Where: the steps are equal, so the points come from forward differencing.
+      The curve is a polynomial of degree 3 in t, stepping t by h only needs 3 adds
+      per coordinate (the differences of a cubic: the third one is constant). The
+      AVX2 version has 8 consecutive points in the lanes, each lane steps by 8h. The
+      float adds drift slowly, so the lanes are restarted from the polynomial every
+      CURVE_RESTART_GROUPS groups, and the last point is the real end point (curves
+      of a path stay connected).
+
+      The points are rounded to pixels and go straight into a polyline (path) or a
+      line_segment_batch (many separate curves): no intermediate float points.
+*/
+
+#define CURVE_MAX_SEGMENTS 65536
+#define CURVE_RESTART_GROUPS 16
+
+struct quadratic_bezier
+{
+    real32 X[3];
+    real32 Y[3];
+};
+
+struct cubic_bezier
+{
+    real32 X[4];
+    real32 Y[4];
+};
+
+/*
+    NOTE(Axel): P(t) = A*t^3 + B*t^2 + C*t + D, per coordinate, E[0] is A.
+*/
+struct curve_polynomial
+{
+    real32 X[4];
+    real32 Y[4];
+};
+
+inline real32 GetSecondDifference(real32 *X, real32 *Y, uint32_t Index)
+{
+    real32 DX = X[Index] - 2.0f*X[Index + 1] + X[Index + 2];
+    real32 DY = Y[Index] - 2.0f*Y[Index + 1] + Y[Index + 2];
+    real32 Result = sqrtf(DX*DX + DY*DY);
+    return Result;
+}
+
+inline uint32_t GetWangSegmentCount(real32 Factor, real32 SecondDifference, real32 Tolerance)
+{
+    real32 Count = ceilf(sqrtf(Factor*SecondDifference / Tolerance));
+    uint32_t Result = (Count >= (real32)CURVE_MAX_SEGMENTS) ? CURVE_MAX_SEGMENTS : (uint32_t)Count;
+    Result = (Result < 1) ? 1 : Result;
+    return Result;
+}
+
+static uint32_t GetSegmentCount(quadratic_bezier *Curve, real32 Tolerance)
+{
+    uint32_t Result = GetWangSegmentCount(2.0f / 8.0f, GetSecondDifference(Curve->X, Curve->Y, 0), Tolerance);
+    return Result;
+}
+
+static uint32_t GetSegmentCount(cubic_bezier *Curve, real32 Tolerance)
+{
+    real32 First = GetSecondDifference(Curve->X, Curve->Y, 0);
+    real32 Second = GetSecondDifference(Curve->X, Curve->Y, 1);
+    uint32_t Result = GetWangSegmentCount(6.0f / 8.0f, (First > Second) ? First : Second, Tolerance);
+    return Result;
+}
+
+static curve_polynomial GetPolynomial(quadratic_bezier *Curve)
+{
+    curve_polynomial Result = {};
+    for(uint32_t Axis = 0; Axis < 2; ++Axis)
+    {
+        real32 *P = Axis ? Curve->Y : Curve->X;
+        real32 *E = Axis ? Result.Y : Result.X;
+        E[0] = 0.0f;
+        E[1] = P[0] - 2.0f*P[1] + P[2];
+        E[2] = 2.0f*(P[1] - P[0]);
+        E[3] = P[0];
+    }
+
+    return Result;
+}
+
+static curve_polynomial GetPolynomial(cubic_bezier *Curve)
+{
+    curve_polynomial Result = {};
+    for(uint32_t Axis = 0; Axis < 2; ++Axis)
+    {
+        real32 *P = Axis ? Curve->Y : Curve->X;
+        real32 *E = Axis ? Result.Y : Result.X;
+        E[0] = -P[0] + 3.0f*P[1] - 3.0f*P[2] + P[3];
+        E[1] = 3.0f*P[0] - 6.0f*P[1] + 3.0f*P[2];
+        E[2] = 3.0f*(P[1] - P[0]);
+        E[3] = P[0];
+    }
+
+    return Result;
+}
+
+inline real32 EvaluatePolynomial(real32 *E, real32 T)
+{
+    real32 Result = ((E[0]*T + E[1])*T + E[2])*T + E[3];
+    return Result;
+}
+
+/*
+    NOTE(Axel): 8 lanes of one coordinate: the values at t, t + h, ... t + 7h and their
+      1st, 2nd, 3rd differences for a step of 8h.
+*/
+struct curve_lanes
+{
+    __m256 Value;
+    __m256 Delta1;
+    __m256 Delta2;
+    __m256 Delta3;
+};
+
+TARGET_AVX2
+static curve_lanes StartCurveLanes(real32 *E, __m256 T, real32 Step)
+{
+    __m256 A = _mm256_set1_ps(E[0]);
+    __m256 B = _mm256_set1_ps(E[1]);
+    __m256 C = _mm256_set1_ps(E[2]);
+    __m256 D = _mm256_set1_ps(E[3]);
+    __m256 H = _mm256_set1_ps(Step);
+    __m256 H2 = _mm256_set1_ps(Step*Step);
+    __m256 H3 = _mm256_set1_ps(Step*Step*Step);
+    __m256 Three = _mm256_set1_ps(3.0f);
+    __m256 Two = _mm256_set1_ps(2.0f);
+    __m256 Six = _mm256_set1_ps(6.0f);
+    __m256 T2 = _mm256_mul_ps(T, T);
+
+    curve_lanes Result;
+
+    /* NOTE: P(t) */
+    Result.Value = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(A, T), B), T), C), T), D);
+
+    /* NOTE: P(t + H) - P(t) = A(3t^2H + 3tH^2 + H^3) + B(2tH + H^2) + CH */
+    __m256 CubicTerm = _mm256_add_ps(_mm256_mul_ps(Three, _mm256_add_ps(_mm256_mul_ps(T2, H), _mm256_mul_ps(T, H2))), H3);
+    __m256 SquareTerm = _mm256_add_ps(_mm256_mul_ps(Two, _mm256_mul_ps(T, H)), H2);
+    Result.Delta1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(A, CubicTerm), _mm256_mul_ps(B, SquareTerm)),
+                                  _mm256_mul_ps(C, H));
+
+    /* NOTE: A(6tH^2 + 6H^3) + 2BH^2, then 6AH^3 */
+    Result.Delta2 = _mm256_add_ps(_mm256_mul_ps(A, _mm256_mul_ps(Six, _mm256_add_ps(_mm256_mul_ps(T, H2), H3))),
+                                  _mm256_mul_ps(Two, _mm256_mul_ps(B, H2)));
+    Result.Delta3 = _mm256_mul_ps(Six, _mm256_mul_ps(A, H3));
+
+    return Result;
+}
+
+TARGET_AVX2
+inline __m256 StepCurveLanes(curve_lanes *Lanes)
+{
+    __m256 Result = Lanes->Value;
+    Lanes->Value = _mm256_add_ps(Lanes->Value, Lanes->Delta1);
+    Lanes->Delta1 = _mm256_add_ps(Lanes->Delta1, Lanes->Delta2);
+    Lanes->Delta2 = _mm256_add_ps(Lanes->Delta2, Lanes->Delta3);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Points 1 to SegmentCount of the curve (point 0 is its start), 8 at a
+      time, rounded to pixels.
+*/
+struct curve_stepper
+{
+    curve_polynomial Polynomial;
+    real32 StepT;
+    uint32_t NextIndex;
+    uint32_t GroupsUntilRestart;
+
+    curve_lanes X;
+    curve_lanes Y;
+};
+
+TARGET_AVX2
+static curve_stepper StartCurve(curve_polynomial Polynomial, uint32_t SegmentCount)
+{
+    curve_stepper Result = {};
+    Result.Polynomial = Polynomial;
+    Result.StepT = 1.0f / (real32)SegmentCount;
+    Result.NextIndex = 1;
+
+    return Result;
+}
+
+TARGET_AVX2
+inline void NextCurvePoints(curve_stepper *Stepper, __m256i *X, __m256i *Y)
+{
+    if(Stepper->GroupsUntilRestart == 0)
+    {
+        __m256 Index = _mm256_add_ps(_mm256_set1_ps((real32)Stepper->NextIndex),
+                                     _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+        __m256 T = _mm256_mul_ps(Index, _mm256_set1_ps(Stepper->StepT));
+        Stepper->X = StartCurveLanes(Stepper->Polynomial.X, T, 8.0f*Stepper->StepT);
+        Stepper->Y = StartCurveLanes(Stepper->Polynomial.Y, T, 8.0f*Stepper->StepT);
+        Stepper->GroupsUntilRestart = CURVE_RESTART_GROUPS;
+    }
+
+    *X = _mm256_cvtps_epi32(StepCurveLanes(&Stepper->X));
+    *Y = _mm256_cvtps_epi32(StepCurveLanes(&Stepper->Y));
+    Stepper->NextIndex += 8;
+    --Stepper->GroupsUntilRestart;
+}
+
+/*
+    NOTE(Axel): Appends the curve to the polyline, its start point only if it isn't
+      already the last point (a path of curves shares them). Stops when the polyline
+      is full.
+*/
+TARGET_AVX2
+static void FlattenPolynomial(curve_polynomial Polynomial, uint32_t SegmentCount,
+                              real32 EndX, real32 EndY, polyline *Out)
+{
+    int32_t StartX = (int32_t)lrintf(Polynomial.X[3]);
+    int32_t StartY = (int32_t)lrintf(Polynomial.Y[3]);
+    if(!Out->Count || (Out->X[Out->Count - 1] != StartX) || (Out->Y[Out->Count - 1] != StartY))
+    {
+        PushPoint(Out, StartX, StartY);
+    }
+
+    b32 Complete = (SegmentCount <= (Out->Capacity - Out->Count));
+    uint32_t Remaining = Complete ? SegmentCount : (Out->Capacity - Out->Count);
+
+    curve_stepper Stepper = StartCurve(Polynomial, SegmentCount);
+    while(Remaining)
+    {
+        __m256i X, Y;
+        NextCurvePoints(&Stepper, &X, &Y);
+        if(Remaining >= 8)
+        {
+            _mm256_storeu_si256((__m256i *)(Out->X + Out->Count), X);
+            _mm256_storeu_si256((__m256i *)(Out->Y + Out->Count), Y);
+            Out->Count += 8;
+            Remaining -= 8;
+        }
+        else
+        {
+            int32_t LaneX[8];
+            int32_t LaneY[8];
+            _mm256_storeu_si256((__m256i *)LaneX, X);
+            _mm256_storeu_si256((__m256i *)LaneY, Y);
+            for(uint32_t Lane = 0; Lane < Remaining; ++Lane)
+            {
+                PushPoint(Out, LaneX[Lane], LaneY[Lane]);
+            }
+            Remaining = 0;
+        }
+    }
+
+    if(Complete)
+    {
+        Out->X[Out->Count - 1] = (int32_t)lrintf(EndX);
+        Out->Y[Out->Count - 1] = (int32_t)lrintf(EndY);
+    }
+}
+
+static void FlattenCurve(quadratic_bezier *Curve, real32 Tolerance, polyline *Out)
+{
+    FlattenPolynomial(GetPolynomial(Curve), GetSegmentCount(Curve, Tolerance), Curve->X[2], Curve->Y[2], Out);
+}
+
+static void FlattenCurve(cubic_bezier *Curve, real32 Tolerance, polyline *Out)
+{
+    FlattenPolynomial(GetPolynomial(Curve), GetSegmentCount(Curve, Tolerance), Curve->X[3], Curve->Y[3], Out);
+}
+
+/*
+    NOTE(Axel): Same points, as segments: the starts are the ends shifted by one lane,
+      lane 0 taking the last end of the previous group.
+*/
+TARGET_AVX2
+static void FlattenPolynomialToBatch(curve_polynomial Polynomial, uint32_t SegmentCount,
+                                     real32 EndX, real32 EndY, line_segment_batch *Out)
+{
+    b32 Complete = (SegmentCount <= (Out->Capacity - Out->Count));
+    uint32_t Remaining = Complete ? SegmentCount : (Out->Capacity - Out->Count);
+
+    __m256i Shift = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    __m256i LastX = _mm256_set1_epi32((int32_t)lrintf(Polynomial.X[3]));
+    __m256i LastY = _mm256_set1_epi32((int32_t)lrintf(Polynomial.Y[3]));
+
+    curve_stepper Stepper = StartCurve(Polynomial, SegmentCount);
+    while(Remaining)
+    {
+        __m256i X1, Y1;
+        NextCurvePoints(&Stepper, &X1, &Y1);
+        __m256i X0 = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(X1, Shift), LastX, 1);
+        __m256i Y0 = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(Y1, Shift), LastY, 1);
+        LastX = _mm256_permutevar8x32_epi32(X1, _mm256_set1_epi32(7));
+        LastY = _mm256_permutevar8x32_epi32(Y1, _mm256_set1_epi32(7));
+
+        if(Remaining >= 8)
+        {
+            _mm256_storeu_si256((__m256i *)(Out->X0 + Out->Count), X0);
+            _mm256_storeu_si256((__m256i *)(Out->Y0 + Out->Count), Y0);
+            _mm256_storeu_si256((__m256i *)(Out->X1 + Out->Count), X1);
+            _mm256_storeu_si256((__m256i *)(Out->Y1 + Out->Count), Y1);
+            Out->Count += 8;
+            Remaining -= 8;
+        }
+        else
+        {
+            int32_t Lanes[4][8];
+            _mm256_storeu_si256((__m256i *)Lanes[0], X0);
+            _mm256_storeu_si256((__m256i *)Lanes[1], Y0);
+            _mm256_storeu_si256((__m256i *)Lanes[2], X1);
+            _mm256_storeu_si256((__m256i *)Lanes[3], Y1);
+            for(uint32_t Lane = 0; Lane < Remaining; ++Lane)
+            {
+                PushSegment(Out, Lanes[0][Lane], Lanes[1][Lane], Lanes[2][Lane], Lanes[3][Lane]);
+            }
+            Remaining = 0;
+        }
+    }
+
+    if(Complete)
+    {
+        Out->X1[Out->Count - 1] = (int32_t)lrintf(EndX);
+        Out->Y1[Out->Count - 1] = (int32_t)lrintf(EndY);
+    }
+}
+
+static void FlattenCurves(cubic_bezier *Curves, uint32_t CurveCount, real32 Tolerance, line_segment_batch *Out)
+{
+    for(uint32_t Index = 0; Index < CurveCount; ++Index)
+    {
+        cubic_bezier *Curve = Curves + Index;
+        FlattenPolynomialToBatch(GetPolynomial(Curve), GetSegmentCount(Curve, Tolerance),
+                                 Curve->X[3], Curve->Y[3], Out);
+    }
+}
+
+static void FlattenCurves(quadratic_bezier *Curves, uint32_t CurveCount, real32 Tolerance, line_segment_batch *Out)
+{
+    for(uint32_t Index = 0; Index < CurveCount; ++Index)
+    {
+        quadratic_bezier *Curve = Curves + Index;
+        FlattenPolynomialToBatch(GetPolynomial(Curve), GetSegmentCount(Curve, Tolerance),
+                                 Curve->X[2], Curve->Y[2], Out);
+    }
+}
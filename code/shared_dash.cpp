@@ -0,0 +1,301 @@
+#include <stdint.h>
+
+/*
+    NOTE(Axel): Dashed and stippled lines with the pattern carried by the line, not by
+      the caller. A pattern is a list of runs, on, off, on, off... in pixels along
+      the major axis (the unit of Bresenham, a diagonal dash is longer than a
+      horizontal one, like the stipple of OpenGL). A dash_phase is the state, the
+      current run and how much of it is done (zero is the start of the pattern).
+      DrawDashedLine starts from it and leaves it where the line ends, the next
+      segment of a polyline goes on from there. The end point is not drawn (as
+      DrawLineStepping), so a joint pixel is counted once and the pattern goes
+      round corners without a hitch.
+
+      The Bresenham state runs along the whole line, the runs only say what to do
+      with it:
+        - shallow x-major lines (8 pixels a row or more): the spans of DrawLineRuns
+          (one per row, the next end is an add away) cut by the runs. On, the piece
+          is filled (FillRow when long enough), off, the spans are only counted.
+        - the others: the decision loop of DrawLineStepping for the on runs. An off
+          run is jumped over at once, the minor steps it holds come from one
+          division (the decision stays in a known range), the decision and the
+          pointer move by that. Walking even a short gap costs more, the decision
+          branch mispredicts every few pixels.
+      Same pixels as DrawLineStepping with every pixel tested against the pattern.
+
+      MakeStipplePattern turns a bit pattern (bit 0 first, each bit Scale pixels)
+      into runs, the drawing only ever sees runs.
+*/
+#define MAX_DASH_RUNS 64
+#define MAX_STIPPLE_BITS 32
+
+struct dash_pattern
+{
+    /* NOTE: Even indices are on, odd ones off, RunCount is even */
+    uint32_t Runs[MAX_DASH_RUNS];
+    uint32_t RunCount;
+    uint32_t Period;
+};
+
+struct dash_phase
+{
+    uint32_t Run;
+    uint32_t Done;
+};
+
+/*
+    NOTE(Axel): Lengths are on/off pairs, an odd count ends with an on run followed by
+      no gap. Returns false when it doesn't fit or has no pixel at all.
+*/
+static b32 MakeDashPattern(dash_pattern *Pattern, uint32_t *Lengths, uint32_t Count)
+{
+    *Pattern = {};
+
+    b32 Result = (Count <= MAX_DASH_RUNS);
+    for(uint32_t Index = 0; Result && (Index < Count); ++Index)
+    {
+        Pattern->Runs[Index] = Lengths[Index];
+        Pattern->Period += Lengths[Index];
+    }
+
+    Pattern->RunCount = (Count + 1) & ~1u;
+    Result = Result && (Pattern->Period > 0);
+
+    return Result;
+}
+
+static b32 MakeStipplePattern(dash_pattern *Pattern, uint32_t Bits, uint32_t BitCount, uint32_t Scale)
+{
+    *Pattern = {};
+
+    b32 Result = (BitCount > 0) && (BitCount <= MAX_STIPPLE_BITS) && (Scale > 0);
+    if(Result)
+    {
+        /* NOTE: Runs[0] is on, a pattern starting with a 0 bit starts with an empty on run */
+        uint32_t Run = 0;
+        uint32_t Value = 1;
+        for(uint32_t Bit = 0; Bit < BitCount; ++Bit)
+        {
+            if(((Bits >> Bit) & 1) != Value)
+            {
+                ++Run;
+                Value ^= 1;
+            }
+            Pattern->Runs[Run] += Scale;
+        }
+
+        Pattern->RunCount = (Run + 2) & ~1u;
+        Pattern->Period = BitCount*Scale;
+    }
+
+    return Result;
+}
+
+/* NOTE: Past the finished (and the empty) runs */
+inline void NextDashRun(dash_pattern *Pattern, dash_phase *Phase)
+{
+    while(Phase->Done >= Pattern->Runs[Phase->Run])
+    {
+        Phase->Run = (Phase->Run + 1 == Pattern->RunCount) ? 0 : (Phase->Run + 1);
+        Phase->Done = 0;
+    }
+}
+
+/*
+    NOTE(Axel): The phase Offset pixels into the pattern, never on a finished run.
+*/
+static dash_phase GetDashPhase(dash_pattern *Pattern, uint64_t Offset)
+{
+    uint32_t Remaining = (uint32_t)(Offset % Pattern->Period);
+
+    dash_phase Result = {};
+    while(Remaining >= Pattern->Runs[Result.Run])
+    {
+        Remaining -= Pattern->Runs[Result.Run];
+        ++Result.Run;
+    }
+    Result.Done = Remaining;
+
+    return Result;
+}
+
+static void DrawDashedLine(screen_buffer *Buffer,
+                           int32_t X0, int32_t Y0,
+                           int32_t X1, int32_t Y1, int32_t Color,
+                           dash_pattern *Pattern, dash_phase *Phase)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    intptr_t StepX = 1;
+    intptr_t StepY = PitchInPixels;
+    if(dx < 0)
+    {
+        dx = -dx;
+        StepX = -1;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        StepY = -PitchInPixels;
+    }
+
+    int32_t Major = dx;
+    int32_t Minor = dy;
+    intptr_t MajorStep = StepX;
+    intptr_t MinorStep = StepY;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = StepY;
+        MinorStep = StepX;
+    }
+
+    uint32_t *Origin = (uint32_t *)Buffer->Memory + Y0*PitchInPixels + X0;
+    NextDashRun(Pattern, Phase);
+
+    if((dy <= dx) && ((int64_t)Major >= (int64_t)LINE_RUN_MIN_FILL*Minor))
+    {
+        /* NOTE: Span V is [F(V), F(V + 1)) on row V, the F(V) of DrawLineRuns */
+        int64_t V = 0;
+        int64_t SpanEnd = Major;
+        int64_t Quotient = 0;
+        int64_t Remainder = 0;
+        int64_t RemainderStep = 0;
+        int64_t Divisor = 2*(int64_t)Minor;
+        if(Minor > 0)
+        {
+            SpanEnd = Major / Divisor;
+            Remainder = Major % Divisor;
+            Quotient = Major / Minor;
+            RemainderStep = 2*(Major % Minor);
+        }
+
+        int64_t Step = 0;
+        while(Step < Major)
+        {
+            int64_t RunEnd = Step + (Pattern->Runs[Phase->Run] - Phase->Done);
+            RunEnd = (RunEnd < Major) ? RunEnd : Major;
+            b32 IsOn = ((Phase->Run & 1) == 0);
+            Phase->Done += (uint32_t)(RunEnd - Step);
+
+            while(Step < RunEnd)
+            {
+                int64_t End = (SpanEnd < RunEnd) ? SpanEnd : RunEnd;
+                if(IsOn)
+                {
+                    uint32_t Count = (uint32_t)(End - Step);
+                    uint32_t *Span = Origin + (intptr_t)V*MinorStep + ((StepX < 0) ? -(End - 1) : Step);
+                    if(Count >= LINE_RUN_MIN_FILL)
+                    {
+                        FillRow(Span, Count, (uint32_t)Color);
+                    }
+                    else
+                    {
+                        for(uint32_t Index = 0; Index < Count; ++Index)
+                        {
+                            Span[Index] = (uint32_t)Color;
+                        }
+                    }
+                }
+
+                Step = End;
+                if(Step == SpanEnd)
+                {
+                    ++V;
+                    SpanEnd += Quotient;
+                    Remainder += RemainderStep;
+                    if(Remainder >= Divisor)
+                    {
+                        Remainder -= Divisor;
+                        ++SpanEnd;
+                    }
+
+                    if(V == Minor)
+                    {
+                        SpanEnd = Major;
+                    }
+                }
+            }
+
+            NextDashRun(Pattern, Phase);
+        }
+    }
+    else
+    {
+        int32_t decision    = (2 * Minor) - Major;
+        int32_t IncrementNE = (2 * (Minor - Major));
+        int32_t IncrementE  = (2 * Minor);
+
+        uint32_t *Pixel = Origin;
+        int32_t Step = 0;
+        while(Step < Major)
+        {
+            int32_t Count = (int32_t)(Pattern->Runs[Phase->Run] - Phase->Done);
+            Count = (Count < Major - Step) ? Count : (Major - Step);
+
+            if((Phase->Run & 1) == 0)
+            {
+                /*
+                    NOTE(Axel): Without the branch of DrawLineStepping, a dash is too short
+                      for the predictor to learn the slope, a mask does the same.
+                */
+                for(int32_t Index = Count; Index > 0; --Index)
+                {
+                    intptr_t Mask = -(intptr_t)(decision > 0);
+                    Pixel += MinorStep & Mask;
+                    decision += IncrementE + ((IncrementNE - IncrementE) & (int32_t)Mask);
+
+                    *Pixel = (uint32_t)Color;
+                    Pixel += MajorStep;
+                }
+            }
+            else
+            {
+                /*
+                    NOTE(Axel): The decision stays in (2*Minor - 2*Major, 2*Minor], so after
+                      Count steps the number of minor steps K is the one that puts
+                      decision + 2*Minor*Count - 2*Major*K back in there.
+                */
+                int64_t Numerator = (int64_t)decision + 2*(int64_t)Minor*(Count - 1);
+                int64_t MinorCount = (Numerator > 0) ? ((Numerator + 2*(int64_t)Major - 1) / (2*(int64_t)Major)) : 0;
+                decision = (int32_t)(decision + 2*(int64_t)Minor*Count - 2*(int64_t)Major*MinorCount);
+                Pixel += (intptr_t)Count*MajorStep + (intptr_t)MinorCount*MinorStep;
+            }
+
+            Phase->Done += (uint32_t)Count;
+            Step += Count;
+            NextDashRun(Pattern, Phase);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): One phase through the whole polyline.
+*/
+static void DrawDashedPolyline(screen_buffer *Buffer, polyline *Polyline, int32_t Color,
+                               dash_pattern *Pattern, dash_phase *Phase)
+{
+    for(uint32_t Index = 1; Index < Polyline->Count; ++Index)
+    {
+        DrawDashedLine(Buffer, Polyline->X[Index - 1], Polyline->Y[Index - 1],
+                       Polyline->X[Index], Polyline->Y[Index], Color, Pattern, Phase);
+    }
+}
+
+/*
+    NOTE(Axel): Independent lines (a grid), each one starts at Start.
+*/
+static void DrawDashedLineBatch(screen_buffer *Buffer, line_segment_batch *Batch, int32_t Color,
+                                dash_pattern *Pattern, dash_phase Start)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        dash_phase Phase = Start;
+        DrawDashedLine(Buffer, Batch->X0[Index], Batch->Y0[Index],
+                       Batch->X1[Index], Batch->Y1[Index], Color, Pattern, &Phase);
+    }
+}
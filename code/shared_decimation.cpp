@@ -0,0 +1,128 @@
+#include <stdint.h>
+
+/*
+    NOTE(Axel): Dropping the points of a polyline that don't change its pixels. Both
+      passes are exact for DrawLineStepping (the pixels of the output are the pixels
+      of the input, not "close"), they rely on what it draws for a segment: pixel I
+      of Major at M(I) on the minor axis (see MinorAtStep), the end point is not
+      drawn, so a segment of length 0 draws nothing.
+
+      Columns: consecutive points with the same X are vertical segments. Vertical
+      segment from Y0 to Y1 draws [Y0, Y1) (or (Y1, Y0] going up), and a chain of
+      them draws every Y from the min to the max of the chain, except the last
+      point when it's a new extreme reached only at the end (nobody started a
+      segment there). So the run only needs:
+        - its first point and its last point (the segments to the other columns
+          start/end there, untouched)
+        - the min and the max of the run without the last point (and without its
+          repeats right before it, they only start segments of length 0). The
+          one equal to the last point goes first if any: right before the last
+          point it would be a duplicate, and an extreme reached only at the end
+          isn't drawn.
+      Any polyline works, with a monotonic X (time series, plots) it means at most
+      4 points per column: the raster work follows the width, not the point count.
+
+      Collinear: B is dropped from A, B, C when C - B goes the same way as B - A.
+      All three are on the lattice line of direction (a, b) (the smallest integer
+      step), A->B is m steps and A->C is k: M(I) only depends on a and b
+      (ceil((2b(I + 1) - a) / 2a) once the common factor is gone), so A->C draws
+      the pixels of A->B then of B->C. Duplicate points go too. Catches straight
+      stretches of any slope, any polyline.
+*/
+
+/*
+    NOTE(Axel): Skips a point equal to the last one, a segment of length 0 draws nothing.
+*/
+inline void PushDecimatedPoint(polyline *Dest, int32_t X, int32_t Y)
+{
+    if(!Dest->Count || (Dest->X[Dest->Count - 1] != X) || (Dest->Y[Dest->Count - 1] != Y))
+    {
+        PushPoint(Dest, X, Y);
+    }
+}
+
+/*
+    NOTE(Axel): Dest must have the capacity of Source.
+*/
+static void DecimatePolylineColumns(polyline *Source, polyline *Dest)
+{
+    Dest->Count = 0;
+
+    int32_t *X = Source->X;
+    int32_t *Y = Source->Y;
+    uint32_t Index = 0;
+    while(Index < Source->Count)
+    {
+        int32_t ColumnX = X[Index];
+        uint32_t Last = Index;
+        while(((Last + 1) < Source->Count) && (X[Last + 1] == ColumnX))
+        {
+            ++Last;
+        }
+
+        uint32_t End = Last;
+        while((End > Index) && (Y[End - 1] == Y[Last]))
+        {
+            --End;
+        }
+
+        int32_t MinY = Y[Index];
+        int32_t MaxY = Y[Index];
+        for(uint32_t Inner = Index + 1; Inner < End; ++Inner)
+        {
+            MinY = (Y[Inner] < MinY) ? Y[Inner] : MinY;
+            MaxY = (Y[Inner] > MaxY) ? Y[Inner] : MaxY;
+        }
+
+        PushDecimatedPoint(Dest, ColumnX, Y[Index]);
+        if(MinY == Y[Last])
+        {
+            PushDecimatedPoint(Dest, ColumnX, MinY);
+            PushDecimatedPoint(Dest, ColumnX, MaxY);
+        }
+        else
+        {
+            PushDecimatedPoint(Dest, ColumnX, MaxY);
+            PushDecimatedPoint(Dest, ColumnX, MinY);
+        }
+        PushDecimatedPoint(Dest, ColumnX, Y[Last]);
+
+        Index = Last + 1;
+    }
+}
+
+/*
+    NOTE(Axel): Dest must have the capacity of Source.
+*/
+static void MergeCollinearPoints(polyline *Source, polyline *Dest)
+{
+    Dest->Count = 0;
+
+    for(uint32_t Index = 0; Index < Source->Count; ++Index)
+    {
+        int32_t X = Source->X[Index];
+        int32_t Y = Source->Y[Index];
+
+        uint32_t Count = Dest->Count;
+        if(Count && (Dest->X[Count - 1] == X) && (Dest->Y[Count - 1] == Y))
+        {
+            continue;
+        }
+
+        if(Count >= 2)
+        {
+            int64_t FirstX = (int64_t)Dest->X[Count - 1] - Dest->X[Count - 2];
+            int64_t FirstY = (int64_t)Dest->Y[Count - 1] - Dest->Y[Count - 2];
+            int64_t SecondX = (int64_t)X - Dest->X[Count - 1];
+            int64_t SecondY = (int64_t)Y - Dest->Y[Count - 1];
+            if(((FirstX*SecondY - FirstY*SecondX) == 0) && ((FirstX*SecondX + FirstY*SecondY) > 0))
+            {
+                Dest->X[Count - 1] = X;
+                Dest->Y[Count - 1] = Y;
+                continue;
+            }
+        }
+
+        PushPoint(Dest, X, Y);
+    }
+}
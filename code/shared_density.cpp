@@ -0,0 +1,335 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): Density plots. Instead of writing a color, every pixel a line goes
+      through gets +1, and the counts become colors at the end (LUT, linear or log).
+
+      With several threads, each one draws its share of the lines in its own
+      density_buffer: no atomics, no sharing, the same kernel as the single
+      threaded one. Then the buffers are added together, every thread taking a
+      band of rows (8 counters per AVX2 add), and the private buffers are zeroed
+      by the same pass so the next frame starts clean without another pass over
+      the memory.
+
+      The counters are 32 bits: a few hundred thousand trajectories easily go
+      over 65535 on the pixels they all share, and a 16 bits counter that wraps
+      shows a hole in the hottest spot.
+*/
+
+#define DENSITY_LUT_SIZE 512
+
+struct density_buffer
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Pitch; /* NOTE: In counters, a multiple of 8 */
+
+    uint32_t *Counts;
+    buffer Memory;
+};
+
+static b32 InitDensityBuffer(density_buffer *Density, uint32_t Width, uint32_t Height)
+{
+    *Density = {};
+
+    uint32_t Pitch = (Width + 7) & ~7u;
+    buffer Memory = AllocateBuffer((size_t)Pitch*Height*sizeof(uint32_t) + 64);
+    if(Memory.Data)
+    {
+        Density->Width = Width;
+        Density->Height = Height;
+        Density->Pitch = Pitch;
+        Density->Counts = (uint32_t *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Density->Memory = Memory;
+        memset(Density->Counts, 0, (size_t)Pitch*Height*sizeof(uint32_t));
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreeDensityBuffer(density_buffer *Density)
+{
+    FreeBuffer(&Density->Memory);
+    *Density = {};
+}
+
+static void ClearDensityBuffer(density_buffer *Density)
+{
+    memset(Density->Counts, 0, (size_t)Density->Pitch*Density->Height*sizeof(uint32_t));
+}
+
+/*
+    NOTE(Axel): DrawLineStepping with an increment instead of a store, same pixels. The
+      end points must be in the buffer (clip first).
+*/
+static void DrawLineDensity(density_buffer *Density, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    intptr_t Pitch = Density->Pitch;
+
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    intptr_t StepX = 1;
+    intptr_t StepY = Pitch;
+    if(dx < 0)
+    {
+        dx = -dx;
+        StepX = -1;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        StepY = -Pitch;
+    }
+
+    int32_t Major = dx;
+    int32_t Minor = dy;
+    intptr_t MajorStep = StepX;
+    intptr_t MinorStep = StepY;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = StepY;
+        MinorStep = StepX;
+    }
+
+    int32_t decision    = (2 * Minor) - Major;
+    int32_t IncrementNE = (2 * (Minor - Major));
+    int32_t IncrementE  = (2 * Minor);
+
+    uint32_t *Counter = Density->Counts + Y0*Pitch + X0;
+    for(int32_t Count = Major; Count > 0; --Count)
+    {
+        if(decision <= 0)
+        {
+            decision += IncrementE;
+        }
+        else
+        {
+            Counter += MinorStep;
+            decision += IncrementNE;
+        }
+
+        ++*Counter;
+        Counter += MajorStep;
+    }
+}
+
+static void AccumulateSegments(density_buffer *Density, line_segment_batch *Batch,
+                               uint32_t First, uint32_t OnePastLast)
+{
+    for(uint32_t Index = First; Index < OnePastLast; ++Index)
+    {
+        DrawLineDensity(Density, Batch->X0[Index], Batch->Y0[Index], Batch->X1[Index], Batch->Y1[Index]);
+    }
+}
+
+/*
+    NOTE(Axel): Dest[rows] = sum of Sources[rows], and the sources are zeroed. Returns the
+      highest count of those rows (for the LUT). Dest can't be one of the sources.
+*/
+TARGET_AVX2
+static uint32_t ReduceDensityRows(density_buffer *Dest, density_buffer *Sources, uint32_t SourceCount,
+                                  uint32_t FirstRow, uint32_t OnePastLastRow)
+{
+    __m256i Zero = _mm256_setzero_si256();
+    __m256i Max = _mm256_setzero_si256();
+
+    for(uint32_t Y = FirstRow; Y < OnePastLastRow; ++Y)
+    {
+        size_t RowOffset = (size_t)Y*Dest->Pitch;
+        __m256i *Out = (__m256i *)(Dest->Counts + RowOffset);
+        for(uint32_t X = 0; X < Dest->Pitch; X += 8)
+        {
+            __m256i Sum = Zero;
+            for(uint32_t SourceIndex = 0; SourceIndex < SourceCount; ++SourceIndex)
+            {
+                __m256i *In = (__m256i *)(Sources[SourceIndex].Counts + RowOffset + X);
+                Sum = _mm256_add_epi32(Sum, _mm256_load_si256(In));
+                _mm256_store_si256(In, Zero);
+            }
+
+            Max = _mm256_max_epu32(Max, Sum);
+            _mm256_store_si256(Out++, Sum);
+        }
+    }
+
+    uint32_t Lanes[8];
+    _mm256_storeu_si256((__m256i *)Lanes, Max);
+
+    uint32_t Result = 0;
+    for(uint32_t Lane = 0; Lane < 8; ++Lane)
+    {
+        Result = (Lanes[Lane] > Result) ? Lanes[Lane] : Result;
+    }
+
+    return Result;
+}
+
+enum density_scale : uint32_t
+{
+    DensityScale_Linear,
+    DensityScale_Log,
+};
+
+/*
+    NOTE(Axel): Count -> LUT index:
+        - linear: Count*Scale, Scale bringing the highest count to the last entry
+        - log: the bits of the float (Count + 1) shifted down, that's the exponent
+          and the top 4 bits of the mantissa, a log2 with 16 steps per octave (the
+          steps are straight lines, fine for colors) and no log call
+      Index 0 is only for a count of 0, a pixel hit once is never the background.
+*/
+struct density_lut
+{
+    density_scale Scale;
+    real32 LinearScale;
+    uint32_t Colors[DENSITY_LUT_SIZE];
+};
+
+inline uint32_t LerpColor(uint32_t A, uint32_t B, real32 T)
+{
+    uint32_t Result = 0;
+    for(uint32_t Shift = 0; Shift < 24; Shift += 8)
+    {
+        real32 Channel = (real32)((A >> Shift) & 0xFF)*(1.0f - T) + (real32)((B >> Shift) & 0xFF)*T;
+        Result |= ((uint32_t)(Channel + 0.5f) & 0xFF) << Shift;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Black background, then dark red -> orange -> yellow -> white.
+*/
+static uint32_t GetHeatColor(real32 T)
+{
+    static uint32_t Stops[] = {0x200000, 0xC02000, 0xFF9000, 0xFFF040, 0xFFFFFF};
+    uint32_t StopCount = sizeof(Stops)/sizeof(Stops[0]);
+
+    T = (T < 0.0f) ? 0.0f : ((T > 1.0f) ? 1.0f : T);
+    real32 Position = T*(real32)(StopCount - 1);
+    uint32_t Stop = (uint32_t)Position;
+    if(Stop >= StopCount - 1)
+    {
+        Stop = StopCount - 2;
+    }
+
+    uint32_t Result = LerpColor(Stops[Stop], Stops[Stop + 1], Position - (real32)Stop);
+    return Result;
+}
+
+inline uint32_t GetLogDensityIndex(uint32_t Count)
+{
+    /* NOTE: Counts over 2^31 are clamped, the SIMD conversion is signed */
+    Count = (Count > 0x7FFFFFFF) ? 0x7FFFFFFF : Count;
+    real32 Value = (real32)(int32_t)Count + 1.0f;
+    uint32_t Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+
+    uint32_t Result = (Bits >> 19) - (127 << 4);
+    return Result;
+}
+
+inline uint32_t GetDensityIndex(density_lut *Lut, uint32_t Count)
+{
+    uint32_t Result = 0;
+    if(Lut->Scale == DensityScale_Log)
+    {
+        Result = GetLogDensityIndex(Count);
+    }
+    else
+    {
+        Count = (Count > 0x7FFFFFFF) ? 0x7FFFFFFF : Count;
+        real32 Value = (real32)(int32_t)Count*Lut->LinearScale;
+        Result = (Value >= (real32)(DENSITY_LUT_SIZE - 1)) ? (DENSITY_LUT_SIZE - 1) : (uint32_t)Value;
+        Result = ((Result == 0) && Count) ? 1 : Result;
+    }
+
+    return Result;
+}
+
+static void BuildDensityLUT(density_lut *Lut, density_scale Scale, uint32_t MaxCount)
+{
+    Lut->Scale = Scale;
+    Lut->LinearScale = MaxCount ? ((real32)(DENSITY_LUT_SIZE - 1) / (real32)MaxCount) : 0.0f;
+
+    uint32_t TopIndex = GetDensityIndex(Lut, MaxCount);
+    TopIndex = (TopIndex < 1) ? 1 : TopIndex;
+
+    Lut->Colors[0] = 0;
+    for(uint32_t Index = 1; Index < DENSITY_LUT_SIZE; ++Index)
+    {
+        Lut->Colors[Index] = GetHeatColor((real32)Index / (real32)TopIndex);
+    }
+}
+
+static void ColorizeDensityRowsScalar(screen_buffer *Buffer, density_buffer *Density, density_lut *Lut,
+                                      uint32_t FirstRow, uint32_t OnePastLastRow)
+{
+    for(uint32_t Y = FirstRow; Y < OnePastLastRow; ++Y)
+    {
+        uint32_t *Count = Density->Counts + (size_t)Y*Density->Pitch;
+        uint32_t *Pixel = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch);
+        for(uint32_t X = 0; X < Density->Width; ++X)
+        {
+            Pixel[X] = Lut->Colors[GetDensityIndex(Lut, Count[X])];
+        }
+    }
+}
+
+/*
+    NOTE(Axel): 8 pixels at a time, the LUT read is a gather. Same indices as the scalar
+      version, bit for bit (same float operations, truncation both ways).
+*/
+TARGET_AVX2
+static void ColorizeDensityRows(screen_buffer *Buffer, density_buffer *Density, density_lut *Lut,
+                                uint32_t FirstRow, uint32_t OnePastLastRow)
+{
+    __m256i MaxSigned = _mm256_set1_epi32(0x7FFFFFFF);
+    __m256i One = _mm256_set1_epi32(1);
+    __m256i LastIndex = _mm256_set1_epi32(DENSITY_LUT_SIZE - 1);
+    __m256i LogBias = _mm256_set1_epi32(127 << 4);
+    __m256 OneF = _mm256_set1_ps(1.0f);
+    __m256 Scale = _mm256_set1_ps(Lut->LinearScale);
+    b32 Log = (Lut->Scale == DensityScale_Log);
+
+    uint32_t WideWidth = Density->Width & ~7u;
+    for(uint32_t Y = FirstRow; Y < OnePastLastRow; ++Y)
+    {
+        uint32_t *Count = Density->Counts + (size_t)Y*Density->Pitch;
+        uint32_t *Pixel = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch);
+
+        uint32_t X = 0;
+        for(; X < WideWidth; X += 8)
+        {
+            __m256i Counts = _mm256_min_epu32(_mm256_load_si256((__m256i *)(Count + X)), MaxSigned);
+            __m256 CountsF = _mm256_cvtepi32_ps(Counts);
+
+            __m256i Index;
+            if(Log)
+            {
+                Index = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(_mm256_add_ps(CountsF, OneF)), 19),
+                                         LogBias);
+            }
+            else
+            {
+                Index = _mm256_cvttps_epi32(_mm256_mul_ps(CountsF, Scale));
+                Index = _mm256_min_epu32(Index, LastIndex);
+                Index = _mm256_max_epu32(Index, _mm256_min_epu32(Counts, One));
+            }
+
+            __m256i Colors = _mm256_i32gather_epi32((int const *)Lut->Colors, Index, 4);
+            _mm256_storeu_si256((__m256i *)(Pixel + X), Colors);
+        }
+
+        for(; X < Density->Width; ++X)
+        {
+            Pixel[X] = Lut->Colors[GetDensityIndex(Lut, Count[X])];
+        }
+    }
+}
@@ -0,0 +1,392 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+/*
+    NOTE(Axel): What changed on screen this frame, at the granularity of 64x64 tiles.
+      One bit per tile, one uint64_t per row of tiles: a 1920x1080 screen is 17
+      words, marking is a couple of ors and the whole region fits in a cache line
+      or two, so it costs nothing next to the pixels it saves.
+
+      Lines mark the tiles they cross (not their bounding box, a long diagonal
+      would dirty a whole quarter of the screen), then the bits are coalesced in
+      rectangles for whoever has to touch the pixels (clear, present).
+
+      Clearing what was drawn last frame and presenting both what was erased and
+      what was drawn means keeping the region of the previous frame around, see
+      UnionDirtyRegion.
+*/
+
+#define DIRTY_TILE_SHIFT 6
+#define DIRTY_TILE_SIZE (1 << DIRTY_TILE_SHIFT)
+#define MAX_DIRTY_TILE_COLUMNS 64
+
+struct dirty_region
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t TileCountX;
+    uint32_t TileCountY;
+    uint64_t *Rows;
+};
+
+struct dirty_rect
+{
+    uint32_t X;
+    uint32_t Y;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+static b32 InitDirtyRegion(dirty_region *Region, uint32_t Width, uint32_t Height)
+{
+    b32 Result = false;
+
+    *Region = {};
+    Region->Width = Width;
+    Region->Height = Height;
+    Region->TileCountX = (Width + DIRTY_TILE_SIZE - 1) >> DIRTY_TILE_SHIFT;
+    Region->TileCountY = (Height + DIRTY_TILE_SIZE - 1) >> DIRTY_TILE_SHIFT;
+    if(Region->TileCountX <= MAX_DIRTY_TILE_COLUMNS)
+    {
+        Region->Rows = (uint64_t *)calloc(Region->TileCountY, sizeof(uint64_t));
+        Result = (Region->Rows != 0);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Dirty regions are limited to %u pixels wide.\n",
+                MAX_DIRTY_TILE_COLUMNS*DIRTY_TILE_SIZE);
+    }
+
+    return Result;
+}
+
+static void FreeDirtyRegion(dirty_region *Region)
+{
+    free(Region->Rows);
+    *Region = {};
+}
+
+inline void ResetDirtyRegion(dirty_region *Region)
+{
+    memset(Region->Rows, 0, Region->TileCountY*sizeof(uint64_t));
+}
+
+inline void MarkAllDirty(dirty_region *Region)
+{
+    uint64_t Row = (Region->TileCountX == 64) ? ~0ull : ((1ull << Region->TileCountX) - 1);
+    for(uint32_t TileY = 0; TileY < Region->TileCountY; ++TileY)
+    {
+        Region->Rows[TileY] = Row;
+    }
+}
+
+inline int32_t ClampTile(int32_t Tile, uint32_t TileCount)
+{
+    int32_t Result = Tile;
+    if(Result < 0)
+    {
+        Result = 0;
+    }
+
+    if(Result >= (int32_t)TileCount)
+    {
+        Result = (int32_t)TileCount - 1;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Pixels, both corners included. Anything outside of the screen is ignored.
+*/
+static void MarkDirtyRect(dirty_region *Region, int32_t MinX, int32_t MinY, int32_t MaxX, int32_t MaxY)
+{
+    if((MaxX >= 0) && (MaxY >= 0) &&
+       (MinX < (int32_t)Region->Width) && (MinY < (int32_t)Region->Height) &&
+       (MinX <= MaxX) && (MinY <= MaxY))
+    {
+        int32_t TileMinX = ClampTile(MinX >> DIRTY_TILE_SHIFT, Region->TileCountX);
+        int32_t TileMaxX = ClampTile(MaxX >> DIRTY_TILE_SHIFT, Region->TileCountX);
+        int32_t TileMinY = ClampTile(MinY >> DIRTY_TILE_SHIFT, Region->TileCountY);
+        int32_t TileMaxY = ClampTile(MaxY >> DIRTY_TILE_SHIFT, Region->TileCountY);
+
+        uint32_t SpanCount = (uint32_t)(TileMaxX - TileMinX + 1);
+        uint64_t Span = ((SpanCount == 64) ? ~0ull : ((1ull << SpanCount) - 1)) << TileMinX;
+        for(int32_t TileY = TileMinY; TileY <= TileMaxY; ++TileY)
+        {
+            Region->Rows[TileY] |= Span;
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Every tile the segment goes through. For each row of tiles we take the
+      part of the ideal line inside the band, widened by one pixel on both axes
+      to cover the rounding of any of our line methods (and the first pixel of
+      Bresenham being one row off), and mark it like a rectangle.
+*/
+static void MarkDirtyLine(dirty_region *Region, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    if(Y0 > Y1)
+    {
+        int32_t Swap = X0; X0 = X1; X1 = Swap;
+        Swap = Y0; Y0 = Y1; Y1 = Swap;
+    }
+
+    /* NOTE: In 64 bits, the end points can be anywhere in int32 */
+    int64_t MinX = (X0 < X1) ? X0 : X1;
+    int64_t MaxX = (X0 < X1) ? X1 : X0;
+    int64_t dx = (int64_t)X1 - X0;
+    int64_t dy = (int64_t)Y1 - Y0;
+
+    /* NOTE: Only the bands of the screen, a line far above or below walks nothing */
+    int64_t FirstY = (int64_t)Y0 - 1;
+    int64_t LastY = (int64_t)Y1 + 1;
+    FirstY = (FirstY > 0) ? FirstY : 0;
+    LastY = (LastY < (int64_t)Region->Height - 1) ? LastY : ((int64_t)Region->Height - 1);
+    if((MaxX < 0) || (MinX >= (int64_t)Region->Width))
+    {
+        LastY = FirstY - 1;
+    }
+
+    /*
+        NOTE: (y - Y0)*dx needs 64 bits for a segment up to 2^31 long on both axes,
+          longer ones (end points at both ends of int32) go through doubles
+    */
+    b32 Exact = ((dx < ((int64_t)1 << 31)) && (dx > -((int64_t)1 << 31)) && (dy < ((int64_t)1 << 31)));
+
+    int64_t BandMinY = FirstY;
+    while(BandMinY <= LastY)
+    {
+        int64_t BandMaxY = ((BandMinY >> DIRTY_TILE_SHIFT) << DIRTY_TILE_SHIFT) + DIRTY_TILE_SIZE - 1;
+        if(BandMaxY > LastY)
+        {
+            BandMaxY = LastY;
+        }
+
+        int64_t SpanMinX = MinX;
+        int64_t SpanMaxX = MaxX;
+        if(dy && Exact)
+        {
+            int64_t XA = X0 + ((BandMinY - 1 - Y0)*dx) / dy;
+            int64_t XB = X0 + ((BandMaxY + 1 - Y0)*dx) / dy;
+            SpanMinX = ((XA < XB) ? XA : XB) - 1;
+            SpanMaxX = ((XA < XB) ? XB : XA) + 1;
+        }
+        else if(dy)
+        {
+            /* NOTE: One more pixel on both sides for the rounding of the doubles */
+            double Slope = (double)dx / (double)dy;
+            double XA = (double)X0 + (double)(BandMinY - 1 - Y0)*Slope;
+            double XB = (double)X0 + (double)(BandMaxY + 1 - Y0)*Slope;
+            SpanMinX = (int64_t)floor((XA < XB) ? XA : XB) - 2;
+            SpanMaxX = (int64_t)ceil((XA < XB) ? XB : XA) + 2;
+        }
+
+        if(dy)
+        {
+            if(SpanMinX < MinX)
+            {
+                SpanMinX = MinX;
+            }
+
+            if(SpanMaxX > MaxX)
+            {
+                SpanMaxX = MaxX;
+            }
+        }
+
+        MarkDirtyRect(Region, (int32_t)SpanMinX, (int32_t)BandMinY, (int32_t)SpanMaxX, (int32_t)BandMaxY);
+        BandMinY = BandMaxY + 1;
+    }
+}
+
+/*
+    NOTE(Axel): The tiles of one segment alone, for the structures that need them one by
+      one (lazy clear, scene). Only the tile rows the segment spans are reset, they
+      are returned in TileMinY/TileMaxY.
+*/
+static void MarkLineTilesOnly(dirty_region *Scratch, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1,
+                              uint32_t *TileMinY, uint32_t *TileMaxY)
+{
+    int64_t MinY = (int64_t)((Y0 < Y1) ? Y0 : Y1) - 1;
+    int64_t MaxY = (int64_t)((Y0 < Y1) ? Y1 : Y0) + 1;
+    *TileMinY = (uint32_t)ClampTile((int32_t)(MinY >> DIRTY_TILE_SHIFT), Scratch->TileCountY);
+    *TileMaxY = (uint32_t)ClampTile((int32_t)(MaxY >> DIRTY_TILE_SHIFT), Scratch->TileCountY);
+
+    for(uint32_t TileY = *TileMinY; TileY <= *TileMaxY; ++TileY)
+    {
+        Scratch->Rows[TileY] = 0;
+    }
+
+    MarkDirtyLine(Scratch, X0, Y0, X1, Y1);
+}
+
+static void UnionDirtyRegion(dirty_region *Dest, dirty_region *Source)
+{
+    for(uint32_t TileY = 0; TileY < Dest->TileCountY; ++TileY)
+    {
+        Dest->Rows[TileY] |= Source->Rows[TileY];
+    }
+}
+
+static uint32_t CountDirtyTiles(dirty_region *Region)
+{
+    uint32_t Result = 0;
+    for(uint32_t TileY = 0; TileY < Region->TileCountY; ++TileY)
+    {
+        uint64_t Row = Region->Rows[TileY];
+        while(Row)
+        {
+            Row &= Row - 1;
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+inline uint32_t FindLowestSetBit(uint64_t Value)
+{
+    uint32_t Result = 0;
+    while(!(Value & 1))
+    {
+        Value >>= 1;
+        ++Result;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Runs of dirty tiles on a tile row become a rectangle, and a rectangle
+      grows down as long as the next row has exactly the same run. Rectangles are
+      clipped to the screen and never overlap, so clearing or presenting them
+      touches every dirty pixel exactly once.
+      Returns the number of rectangles written, at most MaxRectCount. Past that the
+      rest of the region is merged in the last one: everything is still covered,
+      but rectangles can overlap.
+*/
+static uint32_t GetDirtyRects(dirty_region *Region, dirty_rect *Rects, uint32_t MaxRectCount)
+{
+    uint32_t Result = 0;
+
+    for(uint32_t TileY = 0; TileY < Region->TileCountY; ++TileY)
+    {
+        uint64_t Row = Region->Rows[TileY];
+        uint32_t Y = TileY << DIRTY_TILE_SHIFT;
+        uint32_t Height = Region->Height - Y;
+        if(Height > DIRTY_TILE_SIZE)
+        {
+            Height = DIRTY_TILE_SIZE;
+        }
+
+        while(Row)
+        {
+            uint32_t First = FindLowestSetBit(Row);
+            uint64_t Shifted = Row >> First;
+            uint32_t Count = (~Shifted) ? FindLowestSetBit(~Shifted) : (64 - First);
+            Row &= ~(((Count == 64) ? ~0ull : ((1ull << Count) - 1)) << First);
+
+            uint32_t X = First << DIRTY_TILE_SHIFT;
+            uint32_t Width = (Count << DIRTY_TILE_SHIFT);
+            if(X + Width > Region->Width)
+            {
+                Width = Region->Width - X;
+            }
+
+            /* NOTE: Only a rectangle ending right above can grow */
+            b32 Grown = false;
+            for(uint32_t OpenIndex = 0; OpenIndex < Result; ++OpenIndex)
+            {
+                dirty_rect *Open = Rects + OpenIndex;
+                if((Open->X == X) && (Open->Width == Width) && (Open->Y + Open->Height == Y))
+                {
+                    Open->Height += Height;
+                    Grown = true;
+                    break;
+                }
+            }
+
+            if(!Grown)
+            {
+                if(Result < MaxRectCount)
+                {
+                    dirty_rect *Rect = Rects + Result++;
+                    Rect->X = X;
+                    Rect->Y = Y;
+                    Rect->Width = Width;
+                    Rect->Height = Height;
+                }
+                else if(Result)
+                {
+                    /* NOTE: Out of rectangles, the last one becomes the bounding box */
+                    dirty_rect *Rect = Rects + Result - 1;
+                    uint32_t MaxX = ((X + Width) > (Rect->X + Rect->Width)) ? (X + Width) : (Rect->X + Rect->Width);
+                    uint32_t MaxY = ((Y + Height) > (Rect->Y + Rect->Height)) ? (Y + Height) : (Rect->Y + Rect->Height);
+                    Rect->X = (X < Rect->X) ? X : Rect->X;
+                    Rect->Y = (Y < Rect->Y) ? Y : Rect->Y;
+                    Rect->Width = MaxX - Rect->X;
+                    Rect->Height = MaxY - Rect->Y;
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+inline dirty_rect GetTileRect(dirty_region *Region, uint32_t TileX, uint32_t TileY)
+{
+    dirty_rect Result;
+    Result.X = TileX << DIRTY_TILE_SHIFT;
+    Result.Y = TileY << DIRTY_TILE_SHIFT;
+    Result.Width = Region->Width - Result.X;
+    Result.Height = Region->Height - Result.Y;
+    if(Result.Width > DIRTY_TILE_SIZE)
+    {
+        Result.Width = DIRTY_TILE_SIZE;
+    }
+
+    if(Result.Height > DIRTY_TILE_SIZE)
+    {
+        Result.Height = DIRTY_TILE_SIZE;
+    }
+
+    return Result;
+}
+
+static uint64_t GetDirtyPixelCount(dirty_rect *Rects, uint32_t RectCount)
+{
+    uint64_t Result = 0;
+    for(uint32_t RectIndex = 0; RectIndex < RectCount; ++RectIndex)
+    {
+        Result += (uint64_t)Rects[RectIndex].Width*Rects[RectIndex].Height;
+    }
+
+    return Result;
+}
+
+static void ClearRect(screen_buffer *Buffer, dirty_rect Rect, uint32_t Color)
+{
+    for(uint32_t Y = Rect.Y; Y < Rect.Y + Rect.Height; ++Y)
+    {
+        uint32_t *Pixel = (uint32_t *)(Buffer->Memory + (size_t)Y*Buffer->Pitch) + Rect.X;
+        for(uint32_t X = 0; X < Rect.Width; ++X)
+        {
+            *Pixel++ = Color;
+        }
+    }
+}
+
+static void CopyRect(screen_buffer *Dest, screen_buffer *Source, dirty_rect Rect)
+{
+    size_t RowSize = (size_t)Rect.Width*Source->BytesPerPixel;
+    for(uint32_t Y = Rect.Y; Y < Rect.Y + Rect.Height; ++Y)
+    {
+        size_t Offset = (size_t)Y*Source->Pitch + (size_t)Rect.X*Source->BytesPerPixel;
+        memcpy(Dest->Memory + Offset, Source->Memory + Offset, RowSize);
+    }
+}
@@ -0,0 +1,89 @@
+#include <stdint.h>
+
+/*
+    NOTE(Axel): Triple buffering between a render thread and a present thread.
+      Each of the 3 buffers is always owned by exactly one of:
+        - the render thread (the one it draws into)
+        - the present thread (the one on screen / being read by the server)
+        - the mailbox (the last finished frame, waiting to be picked up)
+      Handing a buffer over is a single atomic exchange of indices with the
+      mailbox, no lock, and neither side ever waits on the other: the renderer
+      always has a buffer to draw into, the presenter always has one to show.
+
+      The mailbox holds the index plus a "fresh" bit telling if it is a frame
+      the present thread hasn't seen yet:
+        - the renderer publishes a fresh frame and gets back whatever was in the
+          mailbox, when that one was still fresh it was never shown (dropped)
+        - the presenter only swaps when the mailbox is fresh, otherwise it shows
+          its current buffer again (repeated)
+*/
+
+#define FRAME_BUFFER_COUNT 3
+#define FRAME_INDEX_MASK 0x3
+#define FRAME_FRESH_BIT 0x4
+
+struct frame_mailbox
+{
+    alignas(CACHE_LINE_SIZE) uint32_t volatile Shared;
+
+    /* NOTE: Only touched by the render thread */
+    alignas(CACHE_LINE_SIZE) uint32_t RenderIndex;
+    uint32_t RenderedCount;
+    uint32_t DroppedCount;
+
+    /* NOTE: Only touched by the present thread */
+    alignas(CACHE_LINE_SIZE) uint32_t PresentIndex;
+    uint32_t PresentedCount;
+    uint32_t RepeatedCount;
+};
+
+static void InitFrameMailbox(frame_mailbox *Mailbox)
+{
+    *Mailbox = {};
+    Mailbox->RenderIndex = 0;
+    Mailbox->Shared = 1;
+    Mailbox->PresentIndex = 2;
+}
+
+/*
+    NOTE(Axel): Render thread, once RenderIndex is fully drawn. Returns the next buffer
+      to draw into.
+*/
+static uint32_t PublishFrame(frame_mailbox *Mailbox)
+{
+    uint32_t Old = AtomicExchangeU32(&Mailbox->Shared, Mailbox->RenderIndex | FRAME_FRESH_BIT);
+    if(Old & FRAME_FRESH_BIT)
+    {
+        ++Mailbox->DroppedCount;
+    }
+
+    ++Mailbox->RenderedCount;
+    Mailbox->RenderIndex = Old & FRAME_INDEX_MASK;
+
+    return Mailbox->RenderIndex;
+}
+
+/*
+    NOTE(Axel): Present thread, once the server is done with PresentIndex. Returns true
+      when PresentIndex now is a new frame.
+*/
+static b32 AcquireFrame(frame_mailbox *Mailbox)
+{
+    b32 Result = false;
+
+    if(AtomicLoadU32(&Mailbox->Shared) & FRAME_FRESH_BIT)
+    {
+        /* NOTE: Only the renderer can change Shared meanwhile, and it only ever
+           puts a fresh frame in it, so a plain exchange is enough */
+        uint32_t Old = AtomicExchangeU32(&Mailbox->Shared, Mailbox->PresentIndex);
+        Mailbox->PresentIndex = Old & FRAME_INDEX_MASK;
+        ++Mailbox->PresentedCount;
+        Result = true;
+    }
+    else
+    {
+        ++Mailbox->RepeatedCount;
+    }
+
+    return Result;
+}
@@ -0,0 +1,1204 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/*
+    NOTE(Axel): Frames to disk for the batch jobs, encoded straight from the 32 bits
+      screen_buffer (BGRX, X ignored) as 8 bits RGB:
+        - QOI: the fastest to encode, and small on what we draw (runs of the same
+          pixel, small differences)
+        - PNG stored: deflate without compression, a copy plus the checksums
+        - PNG fast: deflate with the fixed Huffman codes and two matches only, the
+          pixel on the left and the pixel above. No search at all, flat areas and
+          lines cost a few bits a run
+        - PPM: raw P6, converted straight into the file mapped in memory
+      The frame is cut in bands of IMAGE_BAND_HEIGHT rows that the image_writer
+      threads encode in parallel, each band in its own buffer. The thread that
+      finishes the last band writes the header, the bands and the trailer with one
+      gathered write (writev), the bands are never copied into a single output.
+        - QOI: a band starts from the last pixel of the band above (it is in the
+          frame) with an empty index, and ends its run. A decoder doesn't see the
+          cuts, the file is one ordinary QOI stream.
+        - PNG: a band is one IDAT chunk (with its own CRC) and its deflate blocks
+          end on a byte (an empty stored block, a zlib sync flush). The Adler32 of
+          the bands are combined at the end, the last IDAT only holds that.
+
+      BeginImageWrite returns right away and WaitImageWrite waits for the file, the
+      renderer draws the next frame in another buffer in between. The frame must not
+      change until WaitImageWrite returns. Without a file name the frame is only
+      encoded (to time the encoders alone).
+*/
+#define IMAGE_BAND_HEIGHT 32
+#define MAX_IMAGE_BANDS 256
+#define MAX_IMAGE_WIDTH 16384
+#define MAX_IMAGE_HEIGHT (IMAGE_BAND_HEIGHT*MAX_IMAGE_BANDS)
+#define MAX_IMAGE_HEADER_SIZE 64
+#define MAX_IMAGE_FILE_NAME 256
+
+/* NOTE: Deflate can't look further back than this, no match on the row above past it */
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_MAX_MATCH_PIXELS 86
+
+#define ADLER_MOD 65521
+#define ADLER_PIXELS_PER_MOD 1024
+
+#define QOI_MAX_RUN 62
+
+enum image_format
+{
+    Image_QOI,
+    Image_PNGStored,
+    Image_PNGFast,
+    Image_PPM,
+
+    Image_Count,
+};
+
+static char const *ImageFormatNames[Image_Count] =
+{
+    "qoi",
+    "png stored",
+    "png fast",
+    "ppm",
+};
+
+static char const *ImageFormatExtensions[Image_Count] =
+{
+    "qoi",
+    "png",
+    "png",
+    "ppm",
+};
+
+struct image_band
+{
+    uint8_t *Data;
+    size_t Size;
+    uint32_t Adler;
+};
+
+struct mapped_file
+{
+    uint8_t *Memory;
+    size_t Size;
+#if _WIN32
+    HANDLE File;
+    HANDLE Mapping;
+#else
+    int File;
+#endif
+};
+
+struct image_writer
+{
+    uint32_t ThreadCount;
+    os_thread Threads[MAX_THREAD_COUNT];
+    os_semaphore Start;
+    os_semaphore Done;
+    b32 Quit;
+    b32 Busy;
+
+    /* NOTE: The job, set by BeginImageWrite before waking up the threads */
+    screen_buffer *Frame;
+    image_format Format;
+    char FileName[MAX_IMAGE_FILE_NAME];
+    uint32_t BandCount;
+    uint32_t volatile NextBand;
+    uint32_t volatile FinishedBandCount;
+
+    uint8_t Header[MAX_IMAGE_HEADER_SIZE];
+    size_t HeaderSize;
+    uint8_t Trailer[MAX_IMAGE_HEADER_SIZE];
+    size_t TrailerSize;
+    uint8_t *Pixels;
+    mapped_file Mapped;
+
+    image_band Bands[MAX_IMAGE_BANDS];
+    size_t BandCapacity;
+    buffer BandMemory;
+    buffer PixelMemory;
+
+    /* NOTE: Set by the thread that finishes the job */
+    b32 Succeeded;
+    uint64_t OutputSize;
+};
+
+/*
+    NOTE(Axel): CRC32 of PNG chunks, 8 bytes a step (slicing by 8).
+*/
+static uint32_t CRC32Table[8][256];
+
+static void InitCRC32Table(void)
+{
+    for(uint32_t Index = 0; Index < 256; ++Index)
+    {
+        uint32_t CRC = Index;
+        for(uint32_t Bit = 0; Bit < 8; ++Bit)
+        {
+            CRC = (CRC & 1) ? (0xEDB88320 ^ (CRC >> 1)) : (CRC >> 1);
+        }
+        CRC32Table[0][Index] = CRC;
+    }
+
+    for(uint32_t Slice = 1; Slice < 8; ++Slice)
+    {
+        for(uint32_t Index = 0; Index < 256; ++Index)
+        {
+            uint32_t Previous = CRC32Table[Slice - 1][Index];
+            CRC32Table[Slice][Index] = (Previous >> 8) ^ CRC32Table[0][Previous & 0xFF];
+        }
+    }
+}
+
+static uint32_t UpdateCRC32(uint32_t CRC, uint8_t *Data, size_t Size)
+{
+    uint32_t Result = ~CRC;
+
+    while(Size >= 8)
+    {
+        uint32_t Low;
+        uint32_t High;
+        memcpy(&Low, Data, 4);
+        memcpy(&High, Data + 4, 4);
+        Low ^= Result;
+        Result = (CRC32Table[7][Low & 0xFF] ^ CRC32Table[6][(Low >> 8) & 0xFF] ^
+                  CRC32Table[5][(Low >> 16) & 0xFF] ^ CRC32Table[4][Low >> 24] ^
+                  CRC32Table[3][High & 0xFF] ^ CRC32Table[2][(High >> 8) & 0xFF] ^
+                  CRC32Table[1][(High >> 16) & 0xFF] ^ CRC32Table[0][High >> 24]);
+        Data += 8;
+        Size -= 8;
+    }
+
+    while(Size--)
+    {
+        Result = CRC32Table[0][(Result ^ *Data++) & 0xFF] ^ (Result >> 8);
+    }
+
+    Result = ~Result;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Adler32 of the RGB bytes, read from the BGRX pixels. 1024 pixels (3072
+      bytes) between two modulos keeps B in 32 bits.
+*/
+static uint32_t UpdateAdler32Pixels(uint32_t Adler, uint32_t *Pixels, uint32_t Count)
+{
+    uint32_t A = Adler & 0xFFFF;
+    uint32_t B = Adler >> 16;
+
+    while(Count)
+    {
+        uint32_t Chunk = (Count < ADLER_PIXELS_PER_MOD) ? Count : ADLER_PIXELS_PER_MOD;
+        Count -= Chunk;
+        for(uint32_t Index = 0; Index < Chunk; ++Index)
+        {
+            uint32_t Pixel = *Pixels++;
+            A += (Pixel >> 16) & 0xFF;
+            B += A;
+            A += (Pixel >> 8) & 0xFF;
+            B += A;
+            A += Pixel & 0xFF;
+            B += A;
+        }
+        A %= ADLER_MOD;
+        B %= ADLER_MOD;
+    }
+
+    uint32_t Result = (B << 16) | A;
+    return Result;
+}
+
+inline uint32_t UpdateAdler32Byte(uint32_t Adler, uint8_t Byte)
+{
+    uint32_t A = ((Adler & 0xFFFF) + Byte) % ADLER_MOD;
+    uint32_t B = ((Adler >> 16) + A) % ADLER_MOD;
+    uint32_t Result = (B << 16) | A;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Adler32 of A then B from the Adler32 of each (adler32_combine in zlib),
+      SecondSize is the byte count of B.
+*/
+static uint32_t CombineAdler32(uint32_t First, uint32_t Second, uint64_t SecondSize)
+{
+    uint32_t Remainder = (uint32_t)(SecondSize % ADLER_MOD);
+    uint32_t A = First & 0xFFFF;
+    uint32_t B = (uint32_t)(((uint64_t)Remainder*A) % ADLER_MOD);
+    A += (Second & 0xFFFF) + ADLER_MOD - 1;
+    B += (First >> 16) + (Second >> 16) + ADLER_MOD - Remainder;
+    if(A >= ADLER_MOD) A -= ADLER_MOD;
+    if(A >= ADLER_MOD) A -= ADLER_MOD;
+    if(B >= 2*ADLER_MOD) B -= 2*ADLER_MOD;
+    if(B >= ADLER_MOD) B -= ADLER_MOD;
+
+    uint32_t Result = (B << 16) | A;
+    return Result;
+}
+
+inline uint8_t *PutU32BigEndian(uint8_t *At, uint32_t Value)
+{
+    At[0] = (uint8_t)(Value >> 24);
+    At[1] = (uint8_t)(Value >> 16);
+    At[2] = (uint8_t)(Value >> 8);
+    At[3] = (uint8_t)Value;
+    return At + 4;
+}
+
+inline uint8_t *PutRGB(uint8_t *At, uint32_t Pixel)
+{
+    At[0] = (uint8_t)(Pixel >> 16);
+    At[1] = (uint8_t)(Pixel >> 8);
+    At[2] = (uint8_t)Pixel;
+    return At + 3;
+}
+
+static uint8_t *ConvertRowToRGB(uint8_t *At, uint32_t *Row, uint32_t Width)
+{
+    for(uint32_t X = 0; X < Width; ++X)
+    {
+        At = PutRGB(At, Row[X]);
+    }
+
+    return At;
+}
+
+/*
+    NOTE(Axel): Deflate bits go out from the lowest bit, Huffman codes from their highest
+      one: the codes are stored reversed. A put is at most 31 bits (a length and a
+      distance with their extra bits), it always fits on top of the 32 still pending.
+*/
+struct bit_writer
+{
+    uint8_t *At;
+    uint64_t Bits;
+    uint32_t Count;
+};
+
+inline void PutBits(bit_writer *Writer, uint32_t Bits, uint32_t Count)
+{
+    Writer->Bits |= (uint64_t)Bits << Writer->Count;
+    Writer->Count += Count;
+    if(Writer->Count >= 32)
+    {
+        uint32_t Low = (uint32_t)Writer->Bits;
+        memcpy(Writer->At, &Low, 4);
+        Writer->At += 4;
+        Writer->Bits >>= 32;
+        Writer->Count -= 32;
+    }
+}
+
+static void FlushBits(bit_writer *Writer)
+{
+    while(Writer->Count > 0)
+    {
+        *Writer->At++ = (uint8_t)Writer->Bits;
+        Writer->Bits >>= 8;
+        Writer->Count = (Writer->Count > 8) ? (Writer->Count - 8) : 0;
+    }
+    Writer->Bits = 0;
+}
+
+struct deflate_code
+{
+    uint32_t Bits;
+    uint32_t Count;
+};
+
+/* NOTE: Literals 0-255 and end of block 256, then the match lengths 3-258 (code and extra bits) */
+static deflate_code DeflateLiteralCodes[257];
+static deflate_code DeflateLengthCodes[259];
+
+static uint16_t const DeflateLengthBase[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+static uint8_t const DeflateLengthExtra[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+static uint16_t const DeflateDistanceBase[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+
+inline uint32_t ReverseBits(uint32_t Bits, uint32_t Count)
+{
+    uint32_t Result = 0;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        Result = (Result << 1) | ((Bits >> Index) & 1);
+    }
+
+    return Result;
+}
+
+static deflate_code GetFixedLiteralCode(uint32_t Symbol)
+{
+    deflate_code Result = {};
+    if(Symbol < 144)
+    {
+        Result.Bits = 0x30 + Symbol;
+        Result.Count = 8;
+    }
+    else if(Symbol < 256)
+    {
+        Result.Bits = 0x190 + (Symbol - 144);
+        Result.Count = 9;
+    }
+    else if(Symbol < 280)
+    {
+        Result.Bits = Symbol - 256;
+        Result.Count = 7;
+    }
+    else
+    {
+        Result.Bits = 0xC0 + (Symbol - 280);
+        Result.Count = 8;
+    }
+    Result.Bits = ReverseBits(Result.Bits, Result.Count);
+
+    return Result;
+}
+
+static void InitDeflateTables(void)
+{
+    for(uint32_t Symbol = 0; Symbol < 257; ++Symbol)
+    {
+        DeflateLiteralCodes[Symbol] = GetFixedLiteralCode(Symbol);
+    }
+
+    for(uint32_t Code = 0; Code < 29; ++Code)
+    {
+        deflate_code Symbol = GetFixedLiteralCode(257 + Code);
+        uint32_t End = (Code == 28) ? 259 : DeflateLengthBase[Code + 1];
+        for(uint32_t Length = DeflateLengthBase[Code]; Length < End; ++Length)
+        {
+            uint32_t Extra = Length - DeflateLengthBase[Code];
+            DeflateLengthCodes[Length].Bits = Symbol.Bits | (Extra << Symbol.Count);
+            DeflateLengthCodes[Length].Count = Symbol.Count + DeflateLengthExtra[Code];
+        }
+    }
+}
+
+/* NOTE: The fixed distance codes are plain 5 bits */
+static deflate_code GetDistanceCode(uint32_t Distance)
+{
+    uint32_t Code = 29;
+    while(DeflateDistanceBase[Code] > Distance)
+    {
+        --Code;
+    }
+
+    uint32_t ExtraCount = (Code < 4) ? 0 : ((Code / 2) - 1);
+    deflate_code Result = {};
+    Result.Bits = ReverseBits(Code, 5) | ((Distance - DeflateDistanceBase[Code]) << 5);
+    Result.Count = 5 + ExtraCount;
+
+    return Result;
+}
+
+inline void PutMatch(bit_writer *Writer, uint32_t Length, deflate_code Distance)
+{
+    deflate_code Code = DeflateLengthCodes[Length];
+    PutBits(Writer, Code.Bits | (Distance.Bits << Code.Count), Code.Count + Distance.Count);
+}
+
+inline uint32_t CountRepeatedPixel(uint32_t *Row, uint32_t Pixel, uint32_t Count)
+{
+    uint32_t Result = 0;
+    while((Result < Count) && (((Row[Result] ^ Pixel) & 0xFFFFFF) == 0))
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+inline uint32_t CountSamePixels(uint32_t *Row, uint32_t *Reference, uint32_t Count)
+{
+    uint32_t Result = 0;
+    while((Result < Count) && (((Row[Result] ^ Reference[Result]) & 0xFFFFFF) == 0))
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): The row is filter 0 then its RGB bytes. At each pixel the longest of the
+      two matches wins: the run of pixels equal to the one on the left (distance 3,
+      the copy overlaps itself), or the run equal to the row above (distance one
+      row). When neither starts here the pixel goes out as 3 literals.
+      The row above is there for the first row of a band too, deflate looks back
+      in the whole stream, not only in the band.
+*/
+static uint8_t *EncodePNGFastBand(uint8_t *At, screen_buffer *Frame, uint32_t FirstRow, uint32_t RowCount,
+                                  b32 IsLast, uint32_t *Adler)
+{
+    bit_writer Writer = {};
+    Writer.At = At;
+
+    uint32_t Width = Frame->Width;
+    uint32_t RowSize = 1 + 3*Width;
+    b32 CanMatchAbove = (RowSize <= DEFLATE_WINDOW_SIZE);
+    deflate_code Left = GetDistanceCode(3);
+    deflate_code Above = GetDistanceCode(CanMatchAbove ? RowSize : 1);
+
+    /* NOTE: BFINAL, then BTYPE 01 (fixed codes) */
+    PutBits(&Writer, (IsLast ? 1 : 0) | (1 << 1), 3);
+
+    uint32_t BandAdler = 1;
+    for(uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+    {
+        uint32_t *Row = (uint32_t *)(Frame->Memory + (size_t)Y*Frame->Pitch);
+        uint32_t *RowAbove = (uint32_t *)(Frame->Memory + (size_t)(Y - 1)*Frame->Pitch);
+        b32 HasAbove = CanMatchAbove && (Y > 0);
+
+        PutBits(&Writer, DeflateLiteralCodes[0].Bits, DeflateLiteralCodes[0].Count);
+        BandAdler = UpdateAdler32Byte(BandAdler, 0);
+        BandAdler = UpdateAdler32Pixels(BandAdler, Row, Width);
+
+        uint32_t X = 0;
+        while(X < Width)
+        {
+            uint32_t Limit = Width - X;
+            Limit = (Limit < DEFLATE_MAX_MATCH_PIXELS) ? Limit : DEFLATE_MAX_MATCH_PIXELS;
+
+            uint32_t LeftCount = (X > 0) ? CountRepeatedPixel(Row + X, Row[X - 1], Limit) : 0;
+            uint32_t AboveCount = HasAbove ? CountSamePixels(Row + X, RowAbove + X, Limit) : 0;
+
+            if((LeftCount == 0) && (AboveCount == 0))
+            {
+                uint32_t Pixel = Row[X];
+                deflate_code R = DeflateLiteralCodes[(Pixel >> 16) & 0xFF];
+                deflate_code G = DeflateLiteralCodes[(Pixel >> 8) & 0xFF];
+                deflate_code B = DeflateLiteralCodes[Pixel & 0xFF];
+                PutBits(&Writer, R.Bits | (G.Bits << R.Count), R.Count + G.Count);
+                PutBits(&Writer, B.Bits, B.Count);
+                ++X;
+            }
+            else if(LeftCount >= AboveCount)
+            {
+                PutMatch(&Writer, 3*LeftCount, Left);
+                X += LeftCount;
+            }
+            else
+            {
+                PutMatch(&Writer, 3*AboveCount, Above);
+                X += AboveCount;
+            }
+        }
+    }
+
+    PutBits(&Writer, DeflateLiteralCodes[256].Bits, DeflateLiteralCodes[256].Count);
+    if(!IsLast)
+    {
+        /* NOTE: Empty stored block: back on a byte, the next band starts a block there */
+        PutBits(&Writer, 0, 3);
+        FlushBits(&Writer);
+        *Writer.At++ = 0x00;
+        *Writer.At++ = 0x00;
+        *Writer.At++ = 0xFF;
+        *Writer.At++ = 0xFF;
+    }
+    FlushBits(&Writer);
+
+    *Adler = BandAdler;
+    return Writer.At;
+}
+
+/*
+    NOTE(Axel): A stored block a row (the row size stays under 65535 with MAX_IMAGE_WIDTH).
+*/
+static uint8_t *EncodePNGStoredBand(uint8_t *At, screen_buffer *Frame, uint32_t FirstRow, uint32_t RowCount,
+                                    b32 IsLast, uint32_t *Adler)
+{
+    uint32_t Width = Frame->Width;
+    uint32_t RowSize = 1 + 3*Width;
+
+    uint32_t BandAdler = 1;
+    for(uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+    {
+        uint32_t *Row = (uint32_t *)(Frame->Memory + (size_t)Y*Frame->Pitch);
+
+        *At++ = (IsLast && (Y == FirstRow + RowCount - 1)) ? 1 : 0;
+        *At++ = (uint8_t)RowSize;
+        *At++ = (uint8_t)(RowSize >> 8);
+        *At++ = (uint8_t)~RowSize;
+        *At++ = (uint8_t)(~RowSize >> 8);
+
+        *At++ = 0;
+        At = ConvertRowToRGB(At, Row, Width);
+
+        BandAdler = UpdateAdler32Byte(BandAdler, 0);
+        BandAdler = UpdateAdler32Pixels(BandAdler, Row, Width);
+    }
+
+    *Adler = BandAdler;
+    return At;
+}
+
+/*
+    NOTE(Axel): Alpha is always 255 (3 channels), the pixels are compared on RGB only.
+      Only the index slots written in this band are trusted: the decoder has the same
+      pixel in them, whatever the bands before left in the others.
+*/
+static uint8_t *EncodeQOIBand(uint8_t *At, screen_buffer *Frame, uint32_t FirstRow, uint32_t RowCount)
+{
+    uint32_t Width = Frame->Width;
+    uint32_t Index[64];
+    uint64_t IndexValid = 0;
+    uint32_t Run = 0;
+
+    uint32_t Previous = 0;
+    if(FirstRow > 0)
+    {
+        uint32_t *RowAbove = (uint32_t *)(Frame->Memory + (size_t)(FirstRow - 1)*Frame->Pitch);
+        Previous = RowAbove[Width - 1] & 0xFFFFFF;
+    }
+
+    for(uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+    {
+        uint32_t *Row = (uint32_t *)(Frame->Memory + (size_t)Y*Frame->Pitch);
+        for(uint32_t X = 0; X < Width; ++X)
+        {
+            uint32_t Pixel = Row[X] & 0xFFFFFF;
+            if(Pixel == Previous)
+            {
+                if(++Run == QOI_MAX_RUN)
+                {
+                    *At++ = (uint8_t)(0xC0 | (Run - 1));
+                    Run = 0;
+                }
+                continue;
+            }
+
+            if(Run)
+            {
+                *At++ = (uint8_t)(0xC0 | (Run - 1));
+                Run = 0;
+            }
+
+            uint32_t R = (Pixel >> 16) & 0xFF;
+            uint32_t G = (Pixel >> 8) & 0xFF;
+            uint32_t B = Pixel & 0xFF;
+            uint32_t Hash = (R*3 + G*5 + B*7 + 255*11) & 63;
+            if(((IndexValid >> Hash) & 1) && (Index[Hash] == Pixel))
+            {
+                *At++ = (uint8_t)Hash;
+            }
+            else
+            {
+                Index[Hash] = Pixel;
+                IndexValid |= (uint64_t)1 << Hash;
+
+                int32_t DR = (int8_t)(R - ((Previous >> 16) & 0xFF));
+                int32_t DG = (int8_t)(G - ((Previous >> 8) & 0xFF));
+                int32_t DB = (int8_t)(B - (Previous & 0xFF));
+                int32_t DRG = DR - DG;
+                int32_t DBG = DB - DG;
+                if((DR >= -2) && (DR <= 1) && (DG >= -2) && (DG <= 1) && (DB >= -2) && (DB <= 1))
+                {
+                    *At++ = (uint8_t)(0x40 | ((DR + 2) << 4) | ((DG + 2) << 2) | (DB + 2));
+                }
+                else if((DG >= -32) && (DG <= 31) && (DRG >= -8) && (DRG <= 7) && (DBG >= -8) && (DBG <= 7))
+                {
+                    *At++ = (uint8_t)(0x80 | (DG + 32));
+                    *At++ = (uint8_t)(((DRG + 8) << 4) | (DBG + 8));
+                }
+                else
+                {
+                    *At++ = 0xFE;
+                    At = PutRGB(At, Pixel);
+                }
+            }
+            Previous = Pixel;
+        }
+    }
+
+    if(Run)
+    {
+        *At++ = (uint8_t)(0xC0 | (Run - 1));
+    }
+
+    return At;
+}
+
+static void EncodeImageBand(image_writer *Writer, uint32_t BandIndex)
+{
+    screen_buffer *Frame = Writer->Frame;
+    image_band *Band = Writer->Bands + BandIndex;
+    uint32_t FirstRow = BandIndex*IMAGE_BAND_HEIGHT;
+    uint32_t RowCount = Frame->Height - FirstRow;
+    RowCount = (RowCount < IMAGE_BAND_HEIGHT) ? RowCount : IMAGE_BAND_HEIGHT;
+    b32 IsLast = (BandIndex == Writer->BandCount - 1);
+
+    uint8_t *Start = Band->Data;
+    uint8_t *At = Start;
+    switch(Writer->Format)
+    {
+        case Image_QOI:
+        {
+            At = EncodeQOIBand(At, Frame, FirstRow, RowCount);
+        } break;
+
+        case Image_PNGStored:
+        case Image_PNGFast:
+        {
+            /* NOTE: Length and type now, the length and the CRC once the data is in */
+            uint8_t *Chunk = At;
+            At += 8;
+            if(BandIndex == 0)
+            {
+                /* NOTE: zlib header, deflate with a 32K window, no dictionary */
+                *At++ = 0x78;
+                *At++ = 0x01;
+            }
+
+            if(Writer->Format == Image_PNGStored)
+            {
+                At = EncodePNGStoredBand(At, Frame, FirstRow, RowCount, IsLast, &Band->Adler);
+            }
+            else
+            {
+                At = EncodePNGFastBand(At, Frame, FirstRow, RowCount, IsLast, &Band->Adler);
+            }
+
+            uint32_t DataSize = (uint32_t)(At - (Chunk + 8));
+            PutU32BigEndian(Chunk, DataSize);
+            memcpy(Chunk + 4, "IDAT", 4);
+            At = PutU32BigEndian(At, UpdateCRC32(0, Chunk + 4, DataSize + 4));
+        } break;
+
+        case Image_PPM:
+        {
+            uint8_t *Dest = Writer->Pixels + (size_t)FirstRow*3*Frame->Width;
+            for(uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+            {
+                Dest = ConvertRowToRGB(Dest, (uint32_t *)(Frame->Memory + (size_t)Y*Frame->Pitch), Frame->Width);
+            }
+        } break;
+
+        default: break;
+    }
+
+    Band->Size = (size_t)(At - Start);
+}
+
+static uint8_t *PutPNGChunk(uint8_t *At, char const *Type, uint8_t *Data, uint32_t Size)
+{
+    uint8_t *Chunk = At;
+    At = PutU32BigEndian(At, Size);
+    memcpy(At, Type, 4);
+    At += 4;
+    if(Size)
+    {
+        memcpy(At, Data, Size);
+        At += Size;
+    }
+    At = PutU32BigEndian(At, UpdateCRC32(0, Chunk + 4, Size + 4));
+
+    return At;
+}
+
+/*
+    NOTE(Axel): Everything before the bands, and what doesn't depend on them after.
+*/
+static void PrepareImageHeaders(image_writer *Writer)
+{
+    screen_buffer *Frame = Writer->Frame;
+    uint8_t *Header = Writer->Header;
+    uint8_t *Trailer = Writer->Trailer;
+
+    switch(Writer->Format)
+    {
+        case Image_QOI:
+        {
+            memcpy(Header, "qoif", 4);
+            Header = PutU32BigEndian(Header + 4, Frame->Width);
+            Header = PutU32BigEndian(Header, Frame->Height);
+            *Header++ = 3;
+            *Header++ = 0;
+
+            memset(Trailer, 0, 7);
+            Trailer[7] = 1;
+            Trailer += 8;
+        } break;
+
+        case Image_PNGStored:
+        case Image_PNGFast:
+        {
+            uint8_t Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            memcpy(Header, Signature, 8);
+            Header += 8;
+
+            /* NOTE: 8 bits RGB, deflate, adaptive filters (we only use 0), not interlaced */
+            uint8_t Info[13];
+            PutU32BigEndian(Info, Frame->Width);
+            PutU32BigEndian(Info + 4, Frame->Height);
+            Info[8] = 8;
+            Info[9] = 2;
+            Info[10] = 0;
+            Info[11] = 0;
+            Info[12] = 0;
+            Header = PutPNGChunk(Header, "IHDR", Info, sizeof(Info));
+
+            /* NOTE: The Adler32 IDAT is added by FinishImage */
+        } break;
+
+        case Image_PPM:
+        {
+            Header += sprintf((char *)Header, "P6\n%u %u\n255\n", Frame->Width, Frame->Height);
+        } break;
+
+        default: break;
+    }
+
+    Writer->HeaderSize = (size_t)(Header - Writer->Header);
+    Writer->TrailerSize = (size_t)(Trailer - Writer->Trailer);
+}
+
+#if _WIN32
+static b32 OpenMappedFile(mapped_file *Mapped, char const *FileName, size_t Size)
+{
+    b32 Result = false;
+
+    *Mapped = {};
+    Mapped->File = CreateFileA(FileName, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, 0);
+    if(Mapped->File != INVALID_HANDLE_VALUE)
+    {
+        Mapped->Mapping = CreateFileMappingA(Mapped->File, 0, PAGE_READWRITE, (DWORD)((uint64_t)Size >> 32),
+                                             (DWORD)Size, 0);
+        if(Mapped->Mapping)
+        {
+            Mapped->Memory = (uint8_t *)MapViewOfFile(Mapped->Mapping, FILE_MAP_WRITE, 0, 0, Size);
+            if(Mapped->Memory)
+            {
+                Mapped->Size = Size;
+                Result = true;
+            }
+            else
+            {
+                CloseHandle(Mapped->Mapping);
+                CloseHandle(Mapped->File);
+            }
+        }
+        else
+        {
+            CloseHandle(Mapped->File);
+        }
+    }
+
+    return Result;
+}
+
+static b32 CloseMappedFile(mapped_file *Mapped)
+{
+    b32 Result = (UnmapViewOfFile(Mapped->Memory) != 0);
+    Result = (CloseHandle(Mapped->Mapping) != 0) && Result;
+    Result = (CloseHandle(Mapped->File) != 0) && Result;
+    *Mapped = {};
+
+    return Result;
+}
+
+static b32 WriteGathered(char const *FileName, image_writer *Writer)
+{
+    b32 Result = false;
+
+    HANDLE File = CreateFileA(FileName, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(File != INVALID_HANDLE_VALUE)
+    {
+        /* NOTE: No writev for plain files on Windows, a WriteFile a piece (bands are well under 4GB) */
+        DWORD Written = 0;
+        Result = (WriteFile(File, Writer->Header, (DWORD)Writer->HeaderSize, &Written, 0) != 0);
+        for(uint32_t BandIndex = 0; Result && (BandIndex < Writer->BandCount); ++BandIndex)
+        {
+            image_band *Band = Writer->Bands + BandIndex;
+            Result = ((WriteFile(File, Band->Data, (DWORD)Band->Size, &Written, 0) != 0) &&
+                      (Written == Band->Size));
+        }
+        Result = Result && (WriteFile(File, Writer->Trailer, (DWORD)Writer->TrailerSize, &Written, 0) != 0);
+        Result = (CloseHandle(File) != 0) && Result;
+    }
+
+    return Result;
+}
+#else
+static b32 OpenMappedFile(mapped_file *Mapped, char const *FileName, size_t Size)
+{
+    b32 Result = false;
+
+    *Mapped = {};
+    Mapped->File = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(Mapped->File >= 0)
+    {
+        void *Memory = MAP_FAILED;
+        if(ftruncate(Mapped->File, (off_t)Size) == 0)
+        {
+            Memory = mmap(0, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Mapped->File, 0);
+        }
+
+        if(Memory != MAP_FAILED)
+        {
+            Mapped->Memory = (uint8_t *)Memory;
+            Mapped->Size = Size;
+            Result = true;
+        }
+        else
+        {
+            close(Mapped->File);
+        }
+    }
+
+    return Result;
+}
+
+static b32 CloseMappedFile(mapped_file *Mapped)
+{
+    b32 Result = (munmap(Mapped->Memory, Mapped->Size) == 0);
+    Result = (close(Mapped->File) == 0) && Result;
+    *Mapped = {};
+
+    return Result;
+}
+
+static b32 WriteGathered(char const *FileName, image_writer *Writer)
+{
+    b32 Result = false;
+
+    int File = open(FileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(File >= 0)
+    {
+        struct iovec Pieces[MAX_IMAGE_BANDS + 2];
+        uint32_t PieceCount = 0;
+        Pieces[PieceCount].iov_base = Writer->Header;
+        Pieces[PieceCount++].iov_len = Writer->HeaderSize;
+        for(uint32_t BandIndex = 0; BandIndex < Writer->BandCount; ++BandIndex)
+        {
+            Pieces[PieceCount].iov_base = Writer->Bands[BandIndex].Data;
+            Pieces[PieceCount++].iov_len = Writer->Bands[BandIndex].Size;
+        }
+        Pieces[PieceCount].iov_base = Writer->Trailer;
+        Pieces[PieceCount++].iov_len = Writer->TrailerSize;
+
+        /* NOTE: writev can stop anywhere, even in the middle of a piece */
+        struct iovec *Piece = Pieces;
+        Result = true;
+        while(Result && PieceCount)
+        {
+            ssize_t Written = writev(File, Piece, (int)PieceCount);
+            if(Written < 0)
+            {
+                Result = (errno == EINTR);
+                continue;
+            }
+
+            while(PieceCount && ((size_t)Written >= Piece->iov_len))
+            {
+                Written -= (ssize_t)Piece->iov_len;
+                ++Piece;
+                --PieceCount;
+            }
+
+            if(PieceCount)
+            {
+                Piece->iov_base = (uint8_t *)Piece->iov_base + Written;
+                Piece->iov_len -= (size_t)Written;
+            }
+        }
+        Result = (close(File) == 0) && Result;
+    }
+
+    return Result;
+}
+#endif
+
+/*
+    NOTE(Axel): On the thread that finished the last band.
+*/
+static void FinishImage(image_writer *Writer)
+{
+    screen_buffer *Frame = Writer->Frame;
+
+    b32 Result = true;
+    uint64_t Size = Writer->HeaderSize;
+    switch(Writer->Format)
+    {
+        case Image_PNGStored:
+        case Image_PNGFast:
+        {
+            uint32_t Adler = Writer->Bands[0].Adler;
+            for(uint32_t BandIndex = 1; BandIndex < Writer->BandCount; ++BandIndex)
+            {
+                uint32_t RowCount = Frame->Height - BandIndex*IMAGE_BAND_HEIGHT;
+                RowCount = (RowCount < IMAGE_BAND_HEIGHT) ? RowCount : IMAGE_BAND_HEIGHT;
+                uint64_t BandSize = (uint64_t)RowCount*(1 + 3*Frame->Width);
+                Adler = CombineAdler32(Adler, Writer->Bands[BandIndex].Adler, BandSize);
+            }
+
+            uint8_t AdlerBytes[4];
+            PutU32BigEndian(AdlerBytes, Adler);
+            uint8_t *Trailer = PutPNGChunk(Writer->Trailer, "IDAT", AdlerBytes, 4);
+            Trailer = PutPNGChunk(Trailer, "IEND", 0, 0);
+            Writer->TrailerSize = (size_t)(Trailer - Writer->Trailer);
+        } break;
+
+        default: break;
+    }
+
+    if(Writer->Format == Image_PPM)
+    {
+        Size += 3ull*Frame->Width*Frame->Height;
+        if(Writer->Mapped.Memory)
+        {
+            Result = CloseMappedFile(&Writer->Mapped);
+        }
+    }
+    else
+    {
+        for(uint32_t BandIndex = 0; BandIndex < Writer->BandCount; ++BandIndex)
+        {
+            Size += Writer->Bands[BandIndex].Size;
+        }
+        Size += Writer->TrailerSize;
+
+        if(Writer->FileName[0])
+        {
+            Result = WriteGathered(Writer->FileName, Writer);
+        }
+    }
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to write %s\n", Writer->FileName);
+    }
+
+    Writer->OutputSize = Size;
+    Writer->Succeeded = Result;
+}
+
+/*
+    NOTE(Axel): Any thread can take the next band, the one that finishes the last one
+      finishes the file. Every wake up (one per thread and job, whichever thread
+      gets it) is answered by a Done once the bands are out, so when WaitImageWrite
+      has all of them no thread is still looking at the job, and none is left to
+      wake up late into the next one with a band count that isn't its own.
+*/
+static void ImageWriterThread(void *Param)
+{
+    image_writer *Writer = (image_writer *)Param;
+
+    for(;;)
+    {
+        WaitSemaphore(&Writer->Start);
+        if(Writer->Quit)
+        {
+            break;
+        }
+
+        for(;;)
+        {
+            uint32_t BandIndex = AtomicAddU32(&Writer->NextBand, 1) - 1;
+            if(BandIndex >= Writer->BandCount)
+            {
+                break;
+            }
+
+            EncodeImageBand(Writer, BandIndex);
+            if(AtomicAddU32(&Writer->FinishedBandCount, 1) == Writer->BandCount)
+            {
+                FinishImage(Writer);
+            }
+        }
+
+        SignalSemaphore(&Writer->Done, 1);
+    }
+}
+
+/*
+    NOTE(Axel): A band buffer holds the worst case of every format: 4 bytes a pixel
+      (QOI without any match), PNG fast is 27 bits a pixel at worst. On a failure
+      whatever was made is taken down again (the threads that did start are told to
+      quit and joined) and the writer is left zeroed, there is nothing to free.
+*/
+static b32 InitImageWriter(image_writer *Writer, uint32_t ThreadCount, uint32_t MaxWidth, uint32_t MaxHeight)
+{
+    b32 Result = false;
+
+    *Writer = {};
+    InitCRC32Table();
+    InitDeflateTables();
+
+    ThreadCount = (ThreadCount < 1) ? 1 : ThreadCount;
+    ThreadCount = (ThreadCount > MAX_THREAD_COUNT) ? MAX_THREAD_COUNT : ThreadCount;
+
+    if((MaxWidth <= MAX_IMAGE_WIDTH) && (MaxHeight <= MAX_IMAGE_HEIGHT))
+    {
+        uint32_t MaxBandCount = (MaxHeight + IMAGE_BAND_HEIGHT - 1) / IMAGE_BAND_HEIGHT;
+        Writer->BandCapacity = 4*(size_t)MaxWidth*IMAGE_BAND_HEIGHT + 16*IMAGE_BAND_HEIGHT + 64;
+        Writer->BandMemory = AllocateBuffer(Writer->BandCapacity*MaxBandCount);
+        Writer->PixelMemory = AllocateBuffer(3*(size_t)MaxWidth*MaxHeight);
+
+        b32 StartReady = false;
+        b32 DoneReady = false;
+        if(Writer->BandMemory.Data && Writer->PixelMemory.Data)
+        {
+            StartReady = InitSemaphore(&Writer->Start, 0);
+            DoneReady = StartReady && InitSemaphore(&Writer->Done, 0);
+        }
+
+        if(DoneReady)
+        {
+            for(uint32_t BandIndex = 0; BandIndex < MaxBandCount; ++BandIndex)
+            {
+                Writer->Bands[BandIndex].Data = Writer->BandMemory.Data + BandIndex*Writer->BandCapacity;
+            }
+
+            Result = true;
+            for(uint32_t ThreadIndex = 0; Result && (ThreadIndex < ThreadCount); ++ThreadIndex)
+            {
+                Result = CreateOSThread(Writer->Threads + ThreadIndex, ImageWriterThread, Writer);
+                Writer->ThreadCount += Result ? 1 : 0;
+            }
+        }
+
+        if(!Result)
+        {
+            if(Writer->ThreadCount)
+            {
+                Writer->Quit = true;
+                SignalSemaphore(&Writer->Start, Writer->ThreadCount);
+                for(uint32_t ThreadIndex = 0; ThreadIndex < Writer->ThreadCount; ++ThreadIndex)
+                {
+                    JoinOSThread(Writer->Threads + ThreadIndex);
+                }
+            }
+
+            if(DoneReady)
+            {
+                FreeSemaphore(&Writer->Done);
+            }
+            if(StartReady)
+            {
+                FreeSemaphore(&Writer->Start);
+            }
+            FreeBuffer(&Writer->BandMemory);
+            FreeBuffer(&Writer->PixelMemory);
+            *Writer = {};
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: %ux%u is over the %ux%u an image_writer can take\n",
+                MaxWidth, MaxHeight, MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): FileName can be 0, the frame is then only encoded.
+*/
+static b32 BeginImageWrite(image_writer *Writer, screen_buffer *Frame, image_format Format, char const *FileName)
+{
+    b32 Result = false;
+
+    uint32_t BandCount = (Frame->Height + IMAGE_BAND_HEIGHT - 1) / IMAGE_BAND_HEIGHT;
+    size_t NameSize = FileName ? strlen(FileName) : 0;
+    if(!Writer->Busy && (Format < Image_Count) && (NameSize < MAX_IMAGE_FILE_NAME) && (BandCount > 0) &&
+       (BandCount*Writer->BandCapacity <= Writer->BandMemory.Count) &&
+       (3*(size_t)Frame->Width*Frame->Height <= Writer->PixelMemory.Count) &&
+       (4*(size_t)Frame->Width*IMAGE_BAND_HEIGHT + 64 <= Writer->BandCapacity))
+    {
+        Writer->Frame = Frame;
+        Writer->Format = Format;
+        Writer->BandCount = BandCount;
+        memcpy(Writer->FileName, FileName ? FileName : "", NameSize + 1);
+        PrepareImageHeaders(Writer);
+
+        Result = true;
+        Writer->Pixels = Writer->PixelMemory.Data;
+        if((Format == Image_PPM) && FileName)
+        {
+            /* NOTE: The bands convert straight into the pages of the file */
+            size_t Size = Writer->HeaderSize + 3*(size_t)Frame->Width*Frame->Height;
+            Result = OpenMappedFile(&Writer->Mapped, FileName, Size);
+            if(Result)
+            {
+                memcpy(Writer->Mapped.Memory, Writer->Header, Writer->HeaderSize);
+                Writer->Pixels = Writer->Mapped.Memory + Writer->HeaderSize;
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: Unable to map %s\n", FileName);
+            }
+        }
+
+        if(Result)
+        {
+            Writer->Busy = true;
+            Writer->Succeeded = false;
+            AtomicExchangeU32(&Writer->FinishedBandCount, 0);
+            AtomicExchangeU32(&Writer->NextBand, 0);
+            SignalSemaphore(&Writer->Start, Writer->ThreadCount);
+        }
+    }
+
+    return Result;
+}
+
+static b32 WaitImageWrite(image_writer *Writer)
+{
+    b32 Result = true;
+
+    if(Writer->Busy)
+    {
+        for(uint32_t ThreadIndex = 0; ThreadIndex < Writer->ThreadCount; ++ThreadIndex)
+        {
+            WaitSemaphore(&Writer->Done);
+        }
+        Writer->Busy = false;
+        Result = Writer->Succeeded;
+    }
+
+    return Result;
+}
+
+static void FreeImageWriter(image_writer *Writer)
+{
+    WaitImageWrite(Writer);
+
+    Writer->Quit = true;
+    SignalSemaphore(&Writer->Start, Writer->ThreadCount);
+    for(uint32_t ThreadIndex = 0; ThreadIndex < Writer->ThreadCount; ++ThreadIndex)
+    {
+        JoinOSThread(Writer->Threads + ThreadIndex);
+    }
+
+    FreeSemaphore(&Writer->Start);
+    FreeSemaphore(&Writer->Done);
+    FreeBuffer(&Writer->BandMemory);
+    FreeBuffer(&Writer->PixelMemory);
+    *Writer = {};
+}
@@ -0,0 +1,424 @@
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): The pixel loops that are worth being wide, compiled three times (SSE2,
+      AVX2, AVX-512, see shared_cpu.cpp) in the same binary:
+        - FillRow: a run of pixels to one color (spans of the fills, runs of the lines)
+        - BlendRow: a run of pixels toward one color, Alpha in [0, 255]
+        - ClearBufferStreaming: the whole buffer with non-temporal stores
+      SelectRasterKernels picks the widest the CPU has (or the one asked for, to
+      compare them, never wider than the CPU), every call goes through
+      GlobalRasterKernels. Until it is called the SSE2 ones are used, they run
+      everywhere. Every level gives the same bits, the blend is integer only:
+        (S*A + D*(255 - A)) / 255 rounded = (X + 128 + ((X + 128) >> 8)) >> 8
+      which is exact for X <= 255*255 and fits in 16 bits at every step.
+*/
+
+inline uint32_t BlendChannel(uint32_t Source, uint32_t Dest, uint32_t Alpha)
+{
+    uint32_t X = Source*Alpha + Dest*(255 - Alpha) + 128;
+    uint32_t Result = (X + (X >> 8)) >> 8;
+    return Result;
+}
+
+inline uint32_t BlendPixel(uint32_t Dest, uint32_t Color, uint32_t Alpha)
+{
+    uint32_t Result = 0;
+    for(uint32_t Shift = 0; Shift < 32; Shift += 8)
+    {
+        Result |= BlendChannel((Color >> Shift) & 0xff, (Dest >> Shift) & 0xff, Alpha) << Shift;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): SSE2
+*/
+static void FillRowSSE2(uint32_t *Pixel, uint32_t Count, uint32_t Color)
+{
+    __m128i Value = _mm_set1_epi32((int)Color);
+    uint32_t Index = 0;
+    for(; Index + 4 <= Count; Index += 4)
+    {
+        _mm_storeu_si128((__m128i *)(Pixel + Index), Value);
+    }
+
+    for(; Index < Count; ++Index)
+    {
+        Pixel[Index] = Color;
+    }
+}
+
+/* NOTE: 8 channels as 16 bits, Source is already Color*Alpha */
+inline __m128i BlendChannelsSSE2(__m128i Dest, __m128i Source, __m128i InvAlpha)
+{
+    __m128i X = _mm_add_epi16(_mm_add_epi16(Source, _mm_mullo_epi16(Dest, InvAlpha)), _mm_set1_epi16(128));
+    __m128i Result = _mm_srli_epi16(_mm_add_epi16(X, _mm_srli_epi16(X, 8)), 8);
+    return Result;
+}
+
+static void BlendRowSSE2(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+    __m128i Zero = _mm_setzero_si128();
+    __m128i InvAlpha = _mm_set1_epi16((short)(255 - Alpha));
+    __m128i Source = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)Color), Zero),
+                                     _mm_set1_epi16((short)Alpha));
+
+    uint32_t Index = 0;
+    for(; Index + 4 <= Count; Index += 4)
+    {
+        __m128i Dest = _mm_loadu_si128((__m128i *)(Pixel + Index));
+        __m128i Low = BlendChannelsSSE2(_mm_unpacklo_epi8(Dest, Zero), Source, InvAlpha);
+        __m128i High = BlendChannelsSSE2(_mm_unpackhi_epi8(Dest, Zero), Source, InvAlpha);
+        _mm_storeu_si128((__m128i *)(Pixel + Index), _mm_packus_epi16(Low, High));
+    }
+
+    for(; Index < Count; ++Index)
+    {
+        Pixel[Index] = BlendPixel(Pixel[Index], Color, Alpha);
+    }
+}
+
+/*
+    NOTE(Axel): The whole memory block at once, the padding at the end of the rows (if any)
+      gets the clear color too. Non-temporal stores want addresses aligned on their
+      width, the pixels before the first aligned one (and after the last full group)
+      are plain stores.
+*/
+static void ClearBufferStreamingSSE2(screen_buffer *Buffer, uint32_t Color)
+{
+    uint32_t *Pixel = (uint32_t *)Buffer->Memory;
+    uint32_t *End = (uint32_t *)(Buffer->Memory + Buffer->MemoryCount);
+
+    while((Pixel < End) && ((uintptr_t)Pixel & 15))
+    {
+        *Pixel++ = Color;
+    }
+
+    __m128i Value = _mm_set1_epi32((int)Color);
+    while((End - Pixel) >= 16)
+    {
+        _mm_stream_si128((__m128i *)Pixel + 0, Value);
+        _mm_stream_si128((__m128i *)Pixel + 1, Value);
+        _mm_stream_si128((__m128i *)Pixel + 2, Value);
+        _mm_stream_si128((__m128i *)Pixel + 3, Value);
+        Pixel += 16;
+    }
+
+    while(Pixel < End)
+    {
+        *Pixel++ = Color;
+    }
+
+    /* NOTE: Streaming stores are weakly ordered, make them visible before anyone
+       (another thread, the X server) reads the buffer */
+    _mm_sfence();
+}
+
+/*
+    NOTE(Axel): AVX2, the tail of a fill is one masked store.
+*/
+TARGET_AVX2
+static void FillRowAVX2(uint32_t *Pixel, uint32_t Count, uint32_t Color)
+{
+    __m256i Value = _mm256_set1_epi32((int)Color);
+    uint32_t Index = 0;
+    for(; Index + 8 <= Count; Index += 8)
+    {
+        _mm256_storeu_si256((__m256i *)(Pixel + Index), Value);
+    }
+
+    if(Index < Count)
+    {
+        __m256i Mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(Count - Index)),
+                                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        _mm256_maskstore_epi32((int *)(Pixel + Index), Mask, Value);
+    }
+}
+
+TARGET_AVX2
+inline __m256i BlendChannelsAVX2(__m256i Dest, __m256i Source, __m256i InvAlpha)
+{
+    __m256i X = _mm256_add_epi16(_mm256_add_epi16(Source, _mm256_mullo_epi16(Dest, InvAlpha)),
+                                 _mm256_set1_epi16(128));
+    __m256i Result = _mm256_srli_epi16(_mm256_add_epi16(X, _mm256_srli_epi16(X, 8)), 8);
+    return Result;
+}
+
+TARGET_AVX2
+static void BlendRowAVX2(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+    __m256i Zero = _mm256_setzero_si256();
+    __m256i InvAlpha = _mm256_set1_epi16((short)(255 - Alpha));
+    __m256i Source = _mm256_mullo_epi16(_mm256_unpacklo_epi8(_mm256_set1_epi32((int)Color), Zero),
+                                        _mm256_set1_epi16((short)Alpha));
+
+    /* NOTE: Unpack and pack work inside each 128 bits half, the pixels come back in order */
+    uint32_t Index = 0;
+    for(; Index + 8 <= Count; Index += 8)
+    {
+        __m256i Dest = _mm256_loadu_si256((__m256i *)(Pixel + Index));
+        __m256i Low = BlendChannelsAVX2(_mm256_unpacklo_epi8(Dest, Zero), Source, InvAlpha);
+        __m256i High = BlendChannelsAVX2(_mm256_unpackhi_epi8(Dest, Zero), Source, InvAlpha);
+        _mm256_storeu_si256((__m256i *)(Pixel + Index), _mm256_packus_epi16(Low, High));
+    }
+
+    for(; Index < Count; ++Index)
+    {
+        Pixel[Index] = BlendPixel(Pixel[Index], Color, Alpha);
+    }
+}
+
+TARGET_AVX2
+static void ClearBufferStreamingAVX2(screen_buffer *Buffer, uint32_t Color)
+{
+    uint32_t *Pixel = (uint32_t *)Buffer->Memory;
+    uint32_t *End = (uint32_t *)(Buffer->Memory + Buffer->MemoryCount);
+
+    while((Pixel < End) && ((uintptr_t)Pixel & 31))
+    {
+        *Pixel++ = Color;
+    }
+
+    __m256i Value = _mm256_set1_epi32((int)Color);
+    while((End - Pixel) >= 32)
+    {
+        _mm256_stream_si256((__m256i *)Pixel + 0, Value);
+        _mm256_stream_si256((__m256i *)Pixel + 1, Value);
+        _mm256_stream_si256((__m256i *)Pixel + 2, Value);
+        _mm256_stream_si256((__m256i *)Pixel + 3, Value);
+        Pixel += 32;
+    }
+
+    while(Pixel < End)
+    {
+        *Pixel++ = Color;
+    }
+
+    _mm_sfence();
+}
+
+/*
+    NOTE(Axel): AVX-512 (F + BW for the 16 bits channels), masked stores for the tails.
+*/
+TARGET_AVX512
+static void FillRowAVX512(uint32_t *Pixel, uint32_t Count, uint32_t Color)
+{
+    __m512i Value = _mm512_set1_epi32((int)Color);
+    uint32_t Index = 0;
+    for(; Index + 16 <= Count; Index += 16)
+    {
+        _mm512_storeu_si512(Pixel + Index, Value);
+    }
+
+    if(Index < Count)
+    {
+        __mmask16 Mask = (__mmask16)((1u << (Count - Index)) - 1);
+        _mm512_mask_storeu_epi32(Pixel + Index, Mask, Value);
+    }
+}
+
+TARGET_AVX512
+inline __m512i BlendChannelsAVX512(__m512i Dest, __m512i Source, __m512i InvAlpha)
+{
+    __m512i X = _mm512_add_epi16(_mm512_add_epi16(Source, _mm512_mullo_epi16(Dest, InvAlpha)),
+                                 _mm512_set1_epi16(128));
+    __m512i Result = _mm512_srli_epi16(_mm512_add_epi16(X, _mm512_srli_epi16(X, 8)), 8);
+    return Result;
+}
+
+TARGET_AVX512
+static void BlendRowAVX512(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+    __m512i Zero = _mm512_setzero_si512();
+    __m512i InvAlpha = _mm512_set1_epi16((short)(255 - Alpha));
+    __m512i Source = _mm512_mullo_epi16(_mm512_unpacklo_epi8(_mm512_set1_epi32((int)Color), Zero),
+                                        _mm512_set1_epi16((short)Alpha));
+
+    uint32_t Index = 0;
+    for(; Index + 16 <= Count; Index += 16)
+    {
+        __m512i Dest = _mm512_loadu_si512(Pixel + Index);
+        __m512i Low = BlendChannelsAVX512(_mm512_unpacklo_epi8(Dest, Zero), Source, InvAlpha);
+        __m512i High = BlendChannelsAVX512(_mm512_unpackhi_epi8(Dest, Zero), Source, InvAlpha);
+        _mm512_storeu_si512(Pixel + Index, _mm512_packus_epi16(Low, High));
+    }
+
+    if(Index < Count)
+    {
+        __mmask16 Mask = (__mmask16)((1u << (Count - Index)) - 1);
+        __m512i Dest = _mm512_maskz_loadu_epi32(Mask, Pixel + Index);
+        __m512i Low = BlendChannelsAVX512(_mm512_unpacklo_epi8(Dest, Zero), Source, InvAlpha);
+        __m512i High = BlendChannelsAVX512(_mm512_unpackhi_epi8(Dest, Zero), Source, InvAlpha);
+        _mm512_mask_storeu_epi32(Pixel + Index, Mask, _mm512_packus_epi16(Low, High));
+    }
+}
+
+TARGET_AVX512
+static void ClearBufferStreamingAVX512(screen_buffer *Buffer, uint32_t Color)
+{
+    uint32_t *Pixel = (uint32_t *)Buffer->Memory;
+    uint32_t *End = (uint32_t *)(Buffer->Memory + Buffer->MemoryCount);
+
+    while((Pixel < End) && ((uintptr_t)Pixel & 63))
+    {
+        *Pixel++ = Color;
+    }
+
+    __m512i Value = _mm512_set1_epi32((int)Color);
+    while((End - Pixel) >= 64)
+    {
+        _mm512_stream_si512((__m512i *)Pixel + 0, Value);
+        _mm512_stream_si512((__m512i *)Pixel + 1, Value);
+        _mm512_stream_si512((__m512i *)Pixel + 2, Value);
+        _mm512_stream_si512((__m512i *)Pixel + 3, Value);
+        Pixel += 64;
+    }
+
+    while(Pixel < End)
+    {
+        *Pixel++ = Color;
+    }
+
+    _mm_sfence();
+}
+
+/*
+    NOTE(Axel): Dispatch
+*/
+typedef void fill_row(uint32_t *Pixel, uint32_t Count, uint32_t Color);
+typedef void blend_row(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha);
+typedef void clear_buffer(screen_buffer *Buffer, uint32_t Color);
+
+struct raster_kernels
+{
+    isa_level Level;
+    fill_row *FillRow;
+    blend_row *BlendRow;
+    clear_buffer *ClearBufferStreaming;
+};
+
+static raster_kernels RasterKernelTable[ISA_Count] =
+{
+    {ISA_SSE2, FillRowSSE2, BlendRowSSE2, ClearBufferStreamingSSE2},
+    {ISA_AVX2, FillRowAVX2, BlendRowAVX2, ClearBufferStreamingAVX2},
+    {ISA_AVX512, FillRowAVX512, BlendRowAVX512, ClearBufferStreamingAVX512},
+};
+
+static raster_kernels GlobalRasterKernels = {ISA_SSE2, FillRowSSE2, BlendRowSSE2, ClearBufferStreamingSSE2};
+
+/*
+    NOTE(Axel): ISA_Count for the widest the CPU has. Returns the level really selected.
+*/
+static isa_level SelectRasterKernels(isa_level Requested)
+{
+    isa_level Supported = DetectISALevel();
+    isa_level Result = (Requested < Supported) ? Requested : Supported;
+    GlobalRasterKernels = RasterKernelTable[Result];
+    return Result;
+}
+
+inline void FillRow(uint32_t *Pixel, uint32_t Count, uint32_t Color)
+{
+    GlobalRasterKernels.FillRow(Pixel, Count, Color);
+}
+
+inline void BlendRow(uint32_t *Pixel, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+    GlobalRasterKernels.BlendRow(Pixel, Count, Color, Alpha);
+}
+
+inline void ClearBufferStreaming(screen_buffer *Buffer, uint32_t Color)
+{
+    GlobalRasterKernels.ClearBufferStreaming(Buffer, Color);
+}
+
+/*
+    NOTE(Axel): Batched lines. The decision loop of DrawLineStepping is one pixel after the
+      other, each step depends on the one before, there is nothing to spread over
+      lanes. What can be wide is the store: a x-major line is runs of pixels on the
+      same row, run V (the pixels at minor offset V) is [F(V), F(V + 1)) with
+        F(V) = ((2*V - 1)*Major) / (2*Minor) (FirstStepAtMinor), F(Minor + 1) = Major
+      so F(V + 1) = F(V) + Major/Minor, + 1 when the remainder goes over, no
+      decision per pixel at all. Runs long enough go to FillRow, the short ones are
+      plain stores (the call costs more than a few pixels). A y-major line is one
+      pixel per row, that is DrawLineStepping as is. Same pixels as DrawLineBatch.
+*/
+#define LINE_RUN_MIN_FILL 8
+
+static void DrawLineRuns(screen_buffer *Buffer,
+                         int32_t X0, int32_t Y0,
+                         int32_t X1, int32_t Y1, int32_t Color)
+{
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    int32_t Major = (dx < 0) ? -dx : dx;
+    int32_t Minor = (dy < 0) ? -dy : dy;
+    if(Minor > Major)
+    {
+        DrawLineStepping(Buffer, X0, Y0, X1, Y1, Color);
+        return;
+    }
+
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+    intptr_t StepY = (dy < 0) ? -PitchInPixels : PitchInPixels;
+    uint32_t *Row = (uint32_t *)Buffer->Memory + Y0*PitchInPixels + X0;
+
+    int64_t Start = 0;
+    int64_t End = Major;
+    int64_t Quotient = 0;
+    int64_t Remainder = 0;
+    int64_t RemainderStep = 0;
+    int64_t Divisor = 2*(int64_t)Minor;
+    if(Minor > 0)
+    {
+        End = Major / Divisor;
+        Remainder = Major % Divisor;
+        Quotient = Major / Minor;
+        RemainderStep = 2*(Major % Minor);
+    }
+
+    for(int32_t V = 0; V <= Minor; ++V)
+    {
+        if(V == Minor)
+        {
+            End = Major;
+        }
+
+        uint32_t Count = (uint32_t)(End - Start);
+        uint32_t *First = (dx < 0) ? (Row - End + 1) : (Row + Start);
+        if(Count >= LINE_RUN_MIN_FILL)
+        {
+            FillRow(First, Count, (uint32_t)Color);
+        }
+        else
+        {
+            for(uint32_t Index = 0; Index < Count; ++Index)
+            {
+                First[Index] = (uint32_t)Color;
+            }
+        }
+
+        Row += StepY;
+        Start = End;
+        End += Quotient;
+        Remainder += RemainderStep;
+        if(Remainder >= Divisor)
+        {
+            Remainder -= Divisor;
+            ++End;
+        }
+    }
+}
+
+static void DrawLineBatchRuns(screen_buffer *Buffer, line_segment_batch *Batch, int32_t Color)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawLineRuns(Buffer, Batch->X0[Index], Batch->Y0[Index],
+                     Batch->X1[Index], Batch->Y1[Index], Color);
+    }
+}
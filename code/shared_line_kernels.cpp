@@ -0,0 +1,327 @@
+#include <stdint.h>
+#include <string.h>
+
+/*
+    NOTE(Axel): DrawLineStepping picks its major/minor steps at runtime, and writing
+      anything else than an opaque 32 bits pixel meant a switch on the format and
+      the mode for every pixel. Here the loop is a template on the three things
+      that change per draw:
+        - octant: bit 0 X goes left, bit 1 Y goes up, bit 2 Y is the major axis
+        - pixel format: BGRX8888 (the screen buffer), RGB565, Gray8
+        - write mode: opaque, blend toward the color by Alpha, saturating add
+      and every combination is compiled on its own (8*3*3 = 72 loops, one line of
+      source each, see MakeLineKernelTable). The table is built at compile time,
+      the octant is the only thing computed per segment, format and mode pick the
+      slice of the table once per batch. Nothing is tested per pixel, the pixels
+      are the ones of DrawLineStepping.
+
+      The color given to the kernels is already in the format of the target
+      (PackColor). Blend is per channel with the rounding of BlendChannel
+      (shared_kernels.cpp), add saturates every channel on its own.
+*/
+
+enum pixel_format : uint32_t
+{
+    PixelFormat_BGRX8888,
+    PixelFormat_RGB565,
+    PixelFormat_Gray8,
+
+    PixelFormat_Count,
+};
+
+enum line_write_mode : uint32_t
+{
+    LineWrite_Opaque,
+    LineWrite_Blend,
+    LineWrite_Add,
+
+    LineWrite_Count,
+};
+
+static char const *PixelFormatNames[PixelFormat_Count] = {"BGRX8888", "RGB565", "Gray8"};
+static char const *LineWriteModeNames[LineWrite_Count] = {"opaque", "blend", "add"};
+static uint32_t PixelFormatBytes[PixelFormat_Count] = {4, 2, 1};
+
+#define LINE_OCTANT_NEGATIVE_X 1
+#define LINE_OCTANT_NEGATIVE_Y 2
+#define LINE_OCTANT_Y_MAJOR 4
+#define LINE_OCTANT_COUNT 8
+#define LINE_KERNEL_COUNT (LINE_OCTANT_COUNT*PixelFormat_Count*LineWrite_Count)
+
+struct line_target
+{
+    uint8_t *Memory;
+    intptr_t Pitch;
+    uint32_t Width;
+    uint32_t Height;
+    pixel_format Format;
+};
+
+struct line_paint
+{
+    uint32_t Color; /* NOTE: In the format of the target */
+    uint32_t Alpha; /* NOTE: [0, 255], blend only */
+};
+
+inline line_target GetLineTarget(screen_buffer *Buffer)
+{
+    line_target Result = {};
+    Result.Memory = Buffer->Memory;
+    Result.Pitch = Buffer->Pitch;
+    Result.Width = Buffer->Width;
+    Result.Height = Buffer->Height;
+    Result.Format = PixelFormat_BGRX8888;
+    return Result;
+}
+
+/*
+    NOTE(Axel): From the 0xXXRRGGBB of the rest of the code. Gray is the usual luma
+      weights in 8 bits fixed point.
+*/
+static uint32_t PackColor(pixel_format Format, uint32_t Color)
+{
+    uint32_t R = (Color >> 16) & 0xff;
+    uint32_t G = (Color >> 8) & 0xff;
+    uint32_t B = (Color >> 0) & 0xff;
+
+    uint32_t Result = Color;
+    switch(Format)
+    {
+        case PixelFormat_RGB565:
+        {
+            Result = ((R >> 3) << 11) | ((G >> 2) << 5) | (B >> 3);
+        } break;
+
+        case PixelFormat_Gray8:
+        {
+            Result = (77*R + 150*G + 29*B + 128) >> 8;
+        } break;
+
+        default: break;
+    }
+
+    return Result;
+}
+
+inline uint32_t BlendField(uint32_t Dest, uint32_t Color, uint32_t Alpha, uint32_t Shift, uint32_t Mask)
+{
+    uint32_t Result = BlendChannel((Color >> Shift) & Mask, (Dest >> Shift) & Mask, Alpha) << Shift;
+    return Result;
+}
+
+inline uint32_t AddField(uint32_t Dest, uint32_t Color, uint32_t Shift, uint32_t Mask)
+{
+    uint32_t Sum = ((Dest >> Shift) & Mask) + ((Color >> Shift) & Mask);
+    uint32_t Result = ((Sum < Mask) ? Sum : Mask) << Shift;
+    return Result;
+}
+
+/*
+    NOTE(Axel): What a format is: the type of a pixel and how its channels blend and add.
+*/
+template<uint32_t Format> struct pixel_traits;
+
+template<> struct pixel_traits<PixelFormat_BGRX8888>
+{
+    typedef uint32_t pixel;
+
+    static uint32_t Blend(uint32_t Dest, uint32_t Color, uint32_t Alpha)
+    {
+        return BlendPixel(Dest, Color, Alpha);
+    }
+
+    static uint32_t Add(uint32_t Dest, uint32_t Color)
+    {
+        return (AddField(Dest, Color, 0, 0xff) | AddField(Dest, Color, 8, 0xff) |
+                AddField(Dest, Color, 16, 0xff) | AddField(Dest, Color, 24, 0xff));
+    }
+};
+
+template<> struct pixel_traits<PixelFormat_RGB565>
+{
+    typedef uint16_t pixel;
+
+    static uint32_t Blend(uint32_t Dest, uint32_t Color, uint32_t Alpha)
+    {
+        return (BlendField(Dest, Color, Alpha, 0, 0x1f) | BlendField(Dest, Color, Alpha, 5, 0x3f) |
+                BlendField(Dest, Color, Alpha, 11, 0x1f));
+    }
+
+    static uint32_t Add(uint32_t Dest, uint32_t Color)
+    {
+        return AddField(Dest, Color, 0, 0x1f) | AddField(Dest, Color, 5, 0x3f) | AddField(Dest, Color, 11, 0x1f);
+    }
+};
+
+template<> struct pixel_traits<PixelFormat_Gray8>
+{
+    typedef uint8_t pixel;
+
+    static uint32_t Blend(uint32_t Dest, uint32_t Color, uint32_t Alpha)
+    {
+        return BlendChannel(Color, Dest, Alpha);
+    }
+
+    static uint32_t Add(uint32_t Dest, uint32_t Color)
+    {
+        return AddField(Dest, Color, 0, 0xff);
+    }
+};
+
+/*
+    NOTE(Axel): The write of one pixel, one specialization per mode.
+*/
+template<uint32_t Format, uint32_t Mode> struct pixel_writer;
+
+template<uint32_t Format> struct pixel_writer<Format, LineWrite_Opaque>
+{
+    typedef typename pixel_traits<Format>::pixel pixel;
+    static void Write(pixel *Pixel, uint32_t Color, uint32_t)
+    {
+        *Pixel = (pixel)Color;
+    }
+};
+
+template<uint32_t Format> struct pixel_writer<Format, LineWrite_Blend>
+{
+    typedef typename pixel_traits<Format>::pixel pixel;
+    static void Write(pixel *Pixel, uint32_t Color, uint32_t Alpha)
+    {
+        *Pixel = (pixel)pixel_traits<Format>::Blend(*Pixel, Color, Alpha);
+    }
+};
+
+template<uint32_t Format> struct pixel_writer<Format, LineWrite_Add>
+{
+    typedef typename pixel_traits<Format>::pixel pixel;
+    static void Write(pixel *Pixel, uint32_t Color, uint32_t)
+    {
+        *Pixel = (pixel)pixel_traits<Format>::Add(*Pixel, Color);
+    }
+};
+
+/*
+    NOTE(Axel): DrawLineStepping with the steps known at compile time (the minor one is
+      still the pitch when Y is the minor axis). Start is the first end point,
+      Major/Minor the absolute extents.
+*/
+typedef void line_kernel(uint8_t *Start, intptr_t Pitch, int32_t Major, int32_t Minor, line_paint *Paint);
+
+template<uint32_t Octant, uint32_t Format, uint32_t Mode>
+static void DrawLineKernel(uint8_t *Start, intptr_t Pitch, int32_t Major, int32_t Minor, line_paint *Paint)
+{
+    typedef typename pixel_traits<Format>::pixel pixel;
+
+    intptr_t StepX = (Octant & LINE_OCTANT_NEGATIVE_X) ? -(intptr_t)sizeof(pixel) : (intptr_t)sizeof(pixel);
+    intptr_t StepY = (Octant & LINE_OCTANT_NEGATIVE_Y) ? -Pitch : Pitch;
+    intptr_t MajorStep = (Octant & LINE_OCTANT_Y_MAJOR) ? StepY : StepX;
+    intptr_t MinorStep = (Octant & LINE_OCTANT_Y_MAJOR) ? StepX : StepY;
+
+    uint32_t Color = Paint->Color;
+    uint32_t Alpha = Paint->Alpha;
+
+    int32_t decision    = (2 * Minor) - Major;
+    int32_t IncrementNE = (2 * (Minor - Major));
+    int32_t IncrementE  = (2 * Minor);
+
+    uint8_t *Pixel = Start;
+    for(int32_t Count = Major; Count > 0; --Count)
+    {
+        if(decision <= 0)
+        {
+            decision += IncrementE;
+        }
+        else
+        {
+            Pixel += MinorStep;
+            decision += IncrementNE;
+        }
+
+        pixel_writer<Format, Mode>::Write((pixel *)Pixel, Color, Alpha);
+        Pixel += MajorStep;
+    }
+}
+
+/*
+    NOTE(Axel): The table, kernel Octant + 8*(Format + 3*Mode). The index list is a
+      counter at compile time (0, 1, ..., LINE_KERNEL_COUNT - 1), every index is
+      split back in its three fields to instantiate its kernel.
+*/
+struct line_kernel_table
+{
+    line_kernel *Kernels[LINE_KERNEL_COUNT];
+};
+
+template<uint32_t... Indices> struct index_list {};
+
+template<uint32_t Count, uint32_t... Indices>
+struct make_index_list : make_index_list<Count - 1, Count - 1, Indices...> {};
+
+template<uint32_t... Indices>
+struct make_index_list<0, Indices...>
+{
+    typedef index_list<Indices...> list;
+};
+
+inline constexpr uint32_t GetLineKernelIndex(uint32_t Octant, uint32_t Format, uint32_t Mode)
+{
+    return Octant + LINE_OCTANT_COUNT*(Format + PixelFormat_Count*Mode);
+}
+
+template<uint32_t... Indices>
+constexpr line_kernel_table MakeLineKernelTable(index_list<Indices...>)
+{
+    return {{&DrawLineKernel<(Indices % LINE_OCTANT_COUNT),
+                             ((Indices / LINE_OCTANT_COUNT) % PixelFormat_Count),
+                             (Indices / (LINE_OCTANT_COUNT*PixelFormat_Count))>...}};
+}
+
+static constexpr line_kernel_table LineKernelTable = MakeLineKernelTable(make_index_list<LINE_KERNEL_COUNT>::list());
+
+static_assert(LineKernelTable.Kernels[GetLineKernelIndex(5, PixelFormat_RGB565, LineWrite_Add)] ==
+              &DrawLineKernel<5, PixelFormat_RGB565, LineWrite_Add>, "Line kernel table out of order");
+
+inline uint32_t GetLineOctant(int32_t dx, int32_t dy)
+{
+    uint32_t Result = 0;
+    Result |= (dx < 0) ? LINE_OCTANT_NEGATIVE_X : 0;
+    Result |= (dy < 0) ? LINE_OCTANT_NEGATIVE_Y : 0;
+    Result |= (((dy < 0) ? -dy : dy) > ((dx < 0) ? -dx : dx)) ? LINE_OCTANT_Y_MAJOR : 0;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Kernels is the slice of one format and mode (LINE_OCTANT_COUNT kernels).
+*/
+inline void DrawLineWithKernels(line_target *Target, line_kernel * const *Kernels,
+                                int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, line_paint *Paint)
+{
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    uint32_t Octant = GetLineOctant(dx, dy);
+
+    int32_t AbsX = (dx < 0) ? -dx : dx;
+    int32_t AbsY = (dy < 0) ? -dy : dy;
+    int32_t Major = (Octant & LINE_OCTANT_Y_MAJOR) ? AbsY : AbsX;
+    int32_t Minor = (Octant & LINE_OCTANT_Y_MAJOR) ? AbsX : AbsY;
+
+    uint8_t *Start = Target->Memory + (intptr_t)Y0*Target->Pitch + (intptr_t)X0*PixelFormatBytes[Target->Format];
+    Kernels[Octant](Start, Target->Pitch, Major, Minor, Paint);
+}
+
+static void DrawLineWith(line_target *Target, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1,
+                         line_write_mode Mode, line_paint Paint)
+{
+    line_kernel * const *Kernels = LineKernelTable.Kernels + GetLineKernelIndex(0, Target->Format, Mode);
+    DrawLineWithKernels(Target, Kernels, X0, Y0, X1, Y1, &Paint);
+}
+
+static void DrawLineBatchWith(line_target *Target, line_segment_batch *Batch, line_write_mode Mode, line_paint Paint)
+{
+    line_kernel * const *Kernels = LineKernelTable.Kernels + GetLineKernelIndex(0, Target->Format, Mode);
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawLineWithKernels(Target, Kernels, Batch->X0[Index], Batch->Y0[Index],
+                            Batch->X1[Index], Batch->Y1[Index], &Paint);
+    }
+}
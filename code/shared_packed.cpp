@@ -0,0 +1,555 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): Smaller segments, for scenes that don't fit in the cache: drawing a short
+      line costs less than bringing its 16 bytes of end points from memory.
+        - packed_segment_batch: the line_segment_batch with int16 coordinates, 8 bytes
+          a segment. Screen space fits (+-32767), an end point outside does not
+          encode (EncodeSegments returns false), clip or cull first.
+        - packed_polyline: the points as deltas in int8, about 2 bytes a point. A
+          chunk is an absolute start point (int16 X, Y), a delta count (0 to
+          PACKED_CHUNK_DELTAS) then the X deltas then the Y deltas. A delta that
+          doesn't fit in an int8 starts a new chunk, so does every 16th point.
+      The decoders are exact, the pixels are the ones of the int32 versions.
+
+      Decoding: int16 to int32 is free in a scalar loop (the load sign extends), so
+      DrawPackedSegmentBatch reads the int16 arrays directly. DecodeSegments is for
+      whoever wants a line_segment_batch back (16 lanes per step). The polyline is
+      decoded a chunk at a time (a prefix sum of the deltas, 16 lanes) into a few
+      points that stay in registers/L1 and drawn right away: the stream is read
+      once and nothing of its size is ever written.
+
+      File: "DSEG", the segment count, then the four int16 arrays. Read straight in
+      a packed_segment_batch, no conversion, once the size of the file says the
+      count is true.
+
+      The decoders trust the stream (a chunk is at most PACKED_CHUNK_DELTAS deltas,
+      all of it before the end). A stream that comes from outside goes through
+      IsPackedPolylineValid first.
+*/
+#define PACKED_CHUNK_DELTAS 16
+#define PACKED_CHUNK_HEADER_SIZE 5
+#define PACKED_STREAM_PADDING 32
+#define PACKED_FILE_MAGIC 0x47455344 /* NOTE: "DSEG" */
+
+struct packed_segment_batch
+{
+    int16_t *X0;
+    int16_t *Y0;
+    int16_t *X1;
+    int16_t *Y1;
+
+    uint32_t Count;
+    uint32_t Capacity;
+
+    buffer Memory;
+};
+
+static b32 AllocatePackedSegmentBatch(packed_segment_batch *Batch, uint32_t Capacity)
+{
+    *Batch = {};
+
+    /* NOTE: Same layout as line_segment_batch, 64 bytes aligned, multiple of 16 lanes */
+    size_t LaneCount = ((size_t)Capacity + 15) & ~(size_t)15;
+    buffer Memory = AllocateBuffer(4*LaneCount*sizeof(int16_t) + 64);
+    if(Memory.Data)
+    {
+        int16_t *Base = (int16_t *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Batch->X0 = Base;
+        Batch->Y0 = Base + LaneCount;
+        Batch->X1 = Base + 2*LaneCount;
+        Batch->Y1 = Base + 3*LaneCount;
+        Batch->Capacity = Capacity;
+        Batch->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreePackedSegmentBatch(packed_segment_batch *Batch)
+{
+    FreeBuffer(&Batch->Memory);
+    *Batch = {};
+}
+
+inline b32 FitsInt16(int32_t Value)
+{
+    b32 Result = ((Value >= INT16_MIN) && (Value <= INT16_MAX));
+    return Result;
+}
+
+static b32 EncodeSegmentsScalar(line_segment_batch *Source, packed_segment_batch *Dest)
+{
+    b32 Result = (Source->Count <= Dest->Capacity);
+    for(uint32_t Index = 0; Result && (Index < Source->Count); ++Index)
+    {
+        Result = (FitsInt16(Source->X0[Index]) && FitsInt16(Source->Y0[Index]) &&
+                  FitsInt16(Source->X1[Index]) && FitsInt16(Source->Y1[Index]));
+        Dest->X0[Index] = (int16_t)Source->X0[Index];
+        Dest->Y0[Index] = (int16_t)Source->Y0[Index];
+        Dest->X1[Index] = (int16_t)Source->X1[Index];
+        Dest->Y1[Index] = (int16_t)Source->Y1[Index];
+    }
+
+    Dest->Count = Result ? Source->Count : 0;
+    return Result;
+}
+
+/*
+    NOTE(Axel): packs works inside each 128 bits half ([a0-3 b0-3 a4-7 b4-7]), the
+      permute puts the 16 values back in order. The range is checked on the int32
+      values (min/max of everything), the saturation never hides anything.
+*/
+TARGET_AVX2
+inline void EncodeLanes16(int32_t *Source, int16_t *Dest, __m256i *Min, __m256i *Max)
+{
+    __m256i A = _mm256_loadu_si256((__m256i *)Source);
+    __m256i B = _mm256_loadu_si256((__m256i *)(Source + 8));
+    *Min = _mm256_min_epi32(*Min, _mm256_min_epi32(A, B));
+    *Max = _mm256_max_epi32(*Max, _mm256_max_epi32(A, B));
+
+    __m256i Packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(A, B), 0xd8);
+    _mm256_storeu_si256((__m256i *)Dest, Packed);
+}
+
+TARGET_AVX2
+static b32 EncodeSegments(line_segment_batch *Source, packed_segment_batch *Dest)
+{
+    b32 Result = (Source->Count <= Dest->Capacity);
+    if(Result)
+    {
+        __m256i Min = _mm256_set1_epi32(INT16_MIN);
+        __m256i Max = _mm256_set1_epi32(INT16_MAX);
+
+        uint32_t Index = 0;
+        for(; Index + 16 <= Source->Count; Index += 16)
+        {
+            EncodeLanes16(Source->X0 + Index, Dest->X0 + Index, &Min, &Max);
+            EncodeLanes16(Source->Y0 + Index, Dest->Y0 + Index, &Min, &Max);
+            EncodeLanes16(Source->X1 + Index, Dest->X1 + Index, &Min, &Max);
+            EncodeLanes16(Source->Y1 + Index, Dest->Y1 + Index, &Min, &Max);
+        }
+
+        __m256i Outside = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(INT16_MIN), Min),
+                                          _mm256_cmpgt_epi32(Max, _mm256_set1_epi32(INT16_MAX)));
+        Result = _mm256_testz_si256(Outside, Outside);
+
+        for(; Result && (Index < Source->Count); ++Index)
+        {
+            Result = (FitsInt16(Source->X0[Index]) && FitsInt16(Source->Y0[Index]) &&
+                      FitsInt16(Source->X1[Index]) && FitsInt16(Source->Y1[Index]));
+            Dest->X0[Index] = (int16_t)Source->X0[Index];
+            Dest->Y0[Index] = (int16_t)Source->Y0[Index];
+            Dest->X1[Index] = (int16_t)Source->X1[Index];
+            Dest->Y1[Index] = (int16_t)Source->Y1[Index];
+        }
+    }
+
+    Dest->Count = Result ? Source->Count : 0;
+    return Result;
+}
+
+/*
+    NOTE(Axel): Segments [First, First + Count) into Dest (Count <= Dest->Capacity), First
+      a multiple of 16. The last group goes over Count, into the padding of both
+      batches.
+*/
+TARGET_AVX2
+inline void DecodeLanes16(int16_t *Source, int32_t *Dest)
+{
+    __m256i Packed = _mm256_loadu_si256((__m256i *)Source);
+    _mm256_storeu_si256((__m256i *)Dest, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(Packed)));
+    _mm256_storeu_si256((__m256i *)(Dest + 8), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(Packed, 1)));
+}
+
+TARGET_AVX2
+static void DecodeSegments(packed_segment_batch *Source, uint32_t First, uint32_t Count, line_segment_batch *Dest)
+{
+    for(uint32_t Index = 0; Index < Count; Index += 16)
+    {
+        DecodeLanes16(Source->X0 + First + Index, Dest->X0 + Index);
+        DecodeLanes16(Source->Y0 + First + Index, Dest->Y0 + Index);
+        DecodeLanes16(Source->X1 + First + Index, Dest->X1 + Index);
+        DecodeLanes16(Source->Y1 + First + Index, Dest->Y1 + Index);
+    }
+
+    Dest->Count = Count;
+}
+
+static void DrawPackedSegmentBatch(screen_buffer *Buffer, packed_segment_batch *Batch, int32_t Color)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawLineStepping(Buffer, Batch->X0[Index], Batch->Y0[Index],
+                         Batch->X1[Index], Batch->Y1[Index], Color);
+    }
+}
+
+static b32 WritePackedSegmentFile(char const *FileName, packed_segment_batch *Batch)
+{
+    b32 Result = false;
+
+    FILE *File = fopen(FileName, "wb");
+    if(File)
+    {
+        uint32_t Header[2] = {PACKED_FILE_MAGIC, Batch->Count};
+        Result = ((fwrite(Header, sizeof(Header), 1, File) == 1) &&
+                  (fwrite(Batch->X0, sizeof(int16_t), Batch->Count, File) == Batch->Count) &&
+                  (fwrite(Batch->Y0, sizeof(int16_t), Batch->Count, File) == Batch->Count) &&
+                  (fwrite(Batch->X1, sizeof(int16_t), Batch->Count, File) == Batch->Count) &&
+                  (fwrite(Batch->Y1, sizeof(int16_t), Batch->Count, File) == Batch->Count));
+        Result = (fclose(File) == 0) && Result;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): -1 if it can't be told.
+*/
+static int64_t GetOpenFileSize(FILE *File)
+{
+    int64_t Result = -1;
+#if _WIN32
+    if(_fseeki64(File, 0, SEEK_END) == 0)
+    {
+        Result = _ftelli64(File);
+    }
+    Result = (_fseeki64(File, 0, SEEK_SET) == 0) ? Result : -1;
+#else
+    if(fseeko(File, 0, SEEK_END) == 0)
+    {
+        Result = (int64_t)ftello(File);
+    }
+    Result = (fseeko(File, 0, SEEK_SET) == 0) ? Result : -1;
+#endif
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Allocates Batch for the count in the file, only when the file is exactly
+      the header and that many segments (a broken count can't ask for gigabytes).
+*/
+static b32 ReadPackedSegmentFile(char const *FileName, packed_segment_batch *Batch)
+{
+    b32 Result = false;
+
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        int64_t FileSize = GetOpenFileSize(File);
+        uint32_t Header[2] = {};
+        if((fread(Header, sizeof(Header), 1, File) == 1) && (Header[0] == PACKED_FILE_MAGIC) &&
+           (FileSize == (int64_t)sizeof(Header) + (int64_t)Header[1]*4*(int64_t)sizeof(int16_t)) &&
+           AllocatePackedSegmentBatch(Batch, Header[1]))
+        {
+            uint32_t Count = Header[1];
+            Result = ((fread(Batch->X0, sizeof(int16_t), Count, File) == Count) &&
+                      (fread(Batch->Y0, sizeof(int16_t), Count, File) == Count) &&
+                      (fread(Batch->X1, sizeof(int16_t), Count, File) == Count) &&
+                      (fread(Batch->Y1, sizeof(int16_t), Count, File) == Count));
+            Batch->Count = Result ? Count : 0;
+        }
+        fclose(File);
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Delta polylines
+*/
+struct packed_polyline
+{
+    uint8_t *Data;
+    size_t Size;
+    size_t Capacity;
+
+    uint32_t PointCount;
+
+    buffer Memory;
+};
+
+/*
+    NOTE(Axel): Room for the worst case (every point its own chunk), plus what the
+      decoder reads past the last deltas.
+*/
+static b32 AllocatePackedPolyline(packed_polyline *Packed, uint32_t PointCapacity)
+{
+    *Packed = {};
+
+    size_t Capacity = (size_t)PointCapacity*PACKED_CHUNK_HEADER_SIZE;
+    buffer Memory = AllocateBuffer(Capacity + PACKED_STREAM_PADDING);
+    if(Memory.Data)
+    {
+        Packed->Data = Memory.Data;
+        Packed->Capacity = Capacity;
+        Packed->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreePackedPolyline(packed_polyline *Packed)
+{
+    FreeBuffer(&Packed->Memory);
+    *Packed = {};
+}
+
+inline b32 FitsInt8(int32_t Value)
+{
+    b32 Result = ((Value >= INT8_MIN) && (Value <= INT8_MAX));
+    return Result;
+}
+
+inline void WriteInt16(uint8_t *Dest, int32_t Value)
+{
+    int16_t Packed = (int16_t)Value;
+    memcpy(Dest, &Packed, sizeof(Packed));
+}
+
+inline int32_t ReadInt16(uint8_t *Source)
+{
+    int16_t Packed;
+    memcpy(&Packed, Source, sizeof(Packed));
+    return Packed;
+}
+
+/*
+    NOTE(Axel): False if a point doesn't fit in an int16 (or Dest is too small), Dest is
+      empty then.
+*/
+static b32 EncodePolyline(polyline *Source, packed_polyline *Dest)
+{
+    b32 Result = true;
+    Dest->Size = 0;
+    Dest->PointCount = 0;
+
+    uint32_t Index = 0;
+    while(Result && (Index < Source->Count))
+    {
+        int32_t X = Source->X[Index];
+        int32_t Y = Source->Y[Index];
+        Result = FitsInt16(X) && FitsInt16(Y) && (Dest->Size + PACKED_CHUNK_HEADER_SIZE <= Dest->Capacity);
+        if(Result)
+        {
+            /* NOTE: Deltas as long as they fit, up to a full chunk */
+            uint32_t DeltaCount = 0;
+            while((DeltaCount < PACKED_CHUNK_DELTAS) && (Index + 1 + DeltaCount < Source->Count))
+            {
+                uint32_t Next = Index + 1 + DeltaCount;
+                int32_t DX = Source->X[Next] - Source->X[Next - 1];
+                int32_t DY = Source->Y[Next] - Source->Y[Next - 1];
+                if(!FitsInt8(DX) || !FitsInt8(DY) || !FitsInt16(Source->X[Next]) || !FitsInt16(Source->Y[Next]))
+                {
+                    break;
+                }
+                ++DeltaCount;
+            }
+
+            size_t ChunkSize = PACKED_CHUNK_HEADER_SIZE + 2*DeltaCount;
+            Result = (Dest->Size + ChunkSize <= Dest->Capacity);
+            if(Result)
+            {
+                uint8_t *Chunk = Dest->Data + Dest->Size;
+                WriteInt16(Chunk, X);
+                WriteInt16(Chunk + 2, Y);
+                Chunk[4] = (uint8_t)DeltaCount;
+
+                int8_t *DeltaX = (int8_t *)(Chunk + PACKED_CHUNK_HEADER_SIZE);
+                int8_t *DeltaY = DeltaX + DeltaCount;
+                for(uint32_t Delta = 0; Delta < DeltaCount; ++Delta)
+                {
+                    uint32_t Point = Index + 1 + Delta;
+                    DeltaX[Delta] = (int8_t)(Source->X[Point] - Source->X[Point - 1]);
+                    DeltaY[Delta] = (int8_t)(Source->Y[Point] - Source->Y[Point - 1]);
+                }
+
+                Dest->Size += ChunkSize;
+                Dest->PointCount += 1 + DeltaCount;
+                Index += 1 + DeltaCount;
+            }
+        }
+    }
+
+    if(!Result)
+    {
+        Dest->Size = 0;
+        Dest->PointCount = 0;
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Every chunk has at most PACKED_CHUNK_DELTAS deltas and ends before Size,
+      the points add up to PointCount, and the buffer has the padding the AVX2
+      decoder reads past the end.
+*/
+static b32 IsPackedPolylineValid(packed_polyline *Packed)
+{
+    b32 Result = (Packed->Size <= Packed->Capacity);
+    uint64_t PointCount = 0;
+    size_t At = 0;
+    while(Result && (At < Packed->Size))
+    {
+        Result = (Packed->Size - At >= PACKED_CHUNK_HEADER_SIZE);
+        if(Result)
+        {
+            uint32_t DeltaCount = Packed->Data[At + 4];
+            size_t ChunkSize = PACKED_CHUNK_HEADER_SIZE + 2*(size_t)DeltaCount;
+            Result = ((DeltaCount <= PACKED_CHUNK_DELTAS) && (Packed->Size - At >= ChunkSize));
+            PointCount += 1 + DeltaCount;
+            At += ChunkSize;
+        }
+    }
+
+    Result = Result && (PointCount == Packed->PointCount);
+    return Result;
+}
+
+/*
+    NOTE(Axel): One chunk into X/Y (room for PACKED_CHUNK_DELTAS + 1 points), returns the
+      point count and moves Chunk to the next one.
+*/
+static uint32_t DecodePolylineChunkScalar(uint8_t **Chunk, int32_t *X, int32_t *Y)
+{
+    uint8_t *At = *Chunk;
+    uint32_t DeltaCount = At[4];
+    int8_t *DeltaX = (int8_t *)(At + PACKED_CHUNK_HEADER_SIZE);
+    int8_t *DeltaY = DeltaX + DeltaCount;
+
+    X[0] = ReadInt16(At);
+    Y[0] = ReadInt16(At + 2);
+    for(uint32_t Delta = 0; Delta < DeltaCount; ++Delta)
+    {
+        X[Delta + 1] = X[Delta] + DeltaX[Delta];
+        Y[Delta + 1] = Y[Delta] + DeltaY[Delta];
+    }
+
+    *Chunk = At + PACKED_CHUNK_HEADER_SIZE + 2*DeltaCount;
+    return DeltaCount + 1;
+}
+
+/*
+    NOTE(Axel): Prefix sum of 16 deltas in int16: three shifted adds inside each 128 bits
+      half, then the total of the low half added to the high half. The lanes after
+      DeltaCount are garbage, no lane before them depends on them. Every sum is a
+      point minus the start, both in int16, exact even when it wraps.
+*/
+TARGET_AVX2
+inline void DecodeDeltas16(int8_t *Deltas, int32_t Start, int32_t *Dest)
+{
+    __m256i Sum = _mm256_cvtepi8_epi16(_mm_loadu_si128((__m128i *)Deltas));
+    Sum = _mm256_add_epi16(Sum, _mm256_slli_si256(Sum, 2));
+    Sum = _mm256_add_epi16(Sum, _mm256_slli_si256(Sum, 4));
+    Sum = _mm256_add_epi16(Sum, _mm256_slli_si256(Sum, 8));
+
+    __m256i LastOfHalf = _mm256_shuffle_epi8(Sum, _mm256_set1_epi16(0x0f0e));
+    Sum = _mm256_add_epi16(Sum, _mm256_permute2x128_si256(LastOfHalf, LastOfHalf, 0x08));
+    Sum = _mm256_add_epi16(Sum, _mm256_set1_epi16((short)Start));
+
+    _mm256_storeu_si256((__m256i *)Dest, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(Sum)));
+    _mm256_storeu_si256((__m256i *)(Dest + 8), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(Sum, 1)));
+}
+
+TARGET_AVX2
+static uint32_t DecodePolylineChunk(uint8_t **Chunk, int32_t *X, int32_t *Y)
+{
+    uint8_t *At = *Chunk;
+    uint32_t DeltaCount = At[4];
+    int8_t *DeltaX = (int8_t *)(At + PACKED_CHUNK_HEADER_SIZE);
+
+    X[0] = ReadInt16(At);
+    Y[0] = ReadInt16(At + 2);
+    DecodeDeltas16(DeltaX, X[0], X + 1);
+    DecodeDeltas16(DeltaX + DeltaCount, Y[0], Y + 1);
+
+    *Chunk = At + PACKED_CHUNK_HEADER_SIZE + 2*DeltaCount;
+    return DeltaCount + 1;
+}
+
+/*
+    NOTE(Axel): The whole stream back in a polyline. Every chunk writes 17 points
+      whatever its count, Dest needs PACKED_CHUNK_DELTAS points more than the
+      stream has (it stops at the last chunk that fits otherwise).
+*/
+TARGET_AVX2
+static void DecodePolyline(packed_polyline *Packed, polyline *Dest)
+{
+    Dest->Count = 0;
+
+    uint8_t *Chunk = Packed->Data;
+    uint8_t *End = Packed->Data + Packed->Size;
+    while((Chunk < End) && (Dest->Count + PACKED_CHUNK_DELTAS + 1 <= Dest->Capacity))
+    {
+        Dest->Count += DecodePolylineChunk(&Chunk, Dest->X + Dest->Count, Dest->Y + Dest->Count);
+    }
+}
+
+/*
+    NOTE(Axel): Streaming: a chunk at a time, the last point of a chunk goes to the first
+      of the next one.
+*/
+TARGET_AVX2
+static void DrawPackedPolyline(screen_buffer *Buffer, packed_polyline *Packed, int32_t Color)
+{
+    int32_t X[PACKED_CHUNK_DELTAS + 1];
+    int32_t Y[PACKED_CHUNK_DELTAS + 1];
+    int32_t LastX = 0;
+    int32_t LastY = 0;
+    b32 HasLast = false;
+
+    uint8_t *Chunk = Packed->Data;
+    uint8_t *End = Packed->Data + Packed->Size;
+    while(Chunk < End)
+    {
+        uint32_t Count = DecodePolylineChunk(&Chunk, X, Y);
+        if(HasLast)
+        {
+            DrawLineStepping(Buffer, LastX, LastY, X[0], Y[0], Color);
+        }
+
+        for(uint32_t Index = 1; Index < Count; ++Index)
+        {
+            DrawLineStepping(Buffer, X[Index - 1], Y[Index - 1], X[Index], Y[Index], Color);
+        }
+
+        LastX = X[Count - 1];
+        LastY = Y[Count - 1];
+        HasLast = true;
+    }
+}
+
+static void DrawPackedPolylineScalar(screen_buffer *Buffer, packed_polyline *Packed, int32_t Color)
+{
+    int32_t X[PACKED_CHUNK_DELTAS + 1];
+    int32_t Y[PACKED_CHUNK_DELTAS + 1];
+    int32_t LastX = 0;
+    int32_t LastY = 0;
+    b32 HasLast = false;
+
+    uint8_t *Chunk = Packed->Data;
+    uint8_t *End = Packed->Data + Packed->Size;
+    while(Chunk < End)
+    {
+        uint32_t Count = DecodePolylineChunkScalar(&Chunk, X, Y);
+        if(HasLast)
+        {
+            DrawLineStepping(Buffer, LastX, LastY, X[0], Y[0], Color);
+        }
+
+        for(uint32_t Index = 1; Index < Count; ++Index)
+        {
+            DrawLineStepping(Buffer, X[Index - 1], Y[Index - 1], X[Index], Y[Index], Color);
+        }
+
+        LastX = X[Count - 1];
+        LastY = Y[Count - 1];
+        HasLast = true;
+    }
+}
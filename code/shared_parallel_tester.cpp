@@ -0,0 +1,326 @@
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+    NOTE(Axel): Multi-threaded flavour of the repetition_tester. The same work is
+      started on N threads pinned to N cores, every wave is lined up with a barrier
+      so all threads start together, and a wave only ends when the slowest thread
+      is done. We keep:
+        - per thread results (what each core saw on its own chunk)
+        - the aggregate wave results (last end - first begin, what the user sees)
+      A wave is exactly one call of the work function on every thread.
+
+      This relies on the TSC being synchronized across cores, which is the case on
+      any machine with an invariant TSC (see shared_platform_metrics.cpp).
+*/
+
+/*
+    NOTE(Axel): Returns the number of bytes the thread touched for this wave, the sum
+      over all threads must match TargetProcessedByteCount like CountBytes does
+      in the single threaded tester.
+*/
+typedef uint64_t parallel_test_work(void *UserData, uint32_t ThreadIndex, uint32_t ThreadCount);
+
+struct alignas(CACHE_LINE_SIZE) parallel_test_thread
+{
+    uint64_t WaveBeginTime;
+    uint64_t WaveEndTime;
+    uint64_t BytesThisWave;
+
+    repetition_test_results Results;
+};
+
+struct parallel_tester
+{
+    uint64_t TargetProcessedByteCount;
+    uint64_t CPUTimerFreq;
+    uint64_t TryForTime;
+    uint64_t TestsStartedAt;
+
+    test_mode Mode;
+    b32 PrintNewMinimums;
+    uint32_t ThreadCount;
+
+    parallel_test_work *Work;
+    void *UserData;
+    thread_barrier Barrier;
+    uint32_t volatile Running;
+
+    repetition_test_results Results;
+    parallel_test_thread Threads[MAX_THREAD_COUNT];
+};
+
+struct parallel_thread_param
+{
+    parallel_tester *Tester;
+    uint32_t ThreadIndex;
+};
+
+static void ParallelError(parallel_tester *Tester, char const *Message)
+{
+    Tester->Mode = TestMode_Error;
+    fprintf(stderr, "ERROR: %s\n", Message);
+}
+
+/*
+    NOTE(Axel): Only called by thread 0, while every other thread waits on the barrier.
+*/
+static void EndParallelWave(parallel_tester *Tester)
+{
+    uint64_t CurrentTime = ReadCPUTimer();
+
+    uint64_t FirstBegin = (uint64_t)-1;
+    uint64_t LastEnd = 0;
+    uint64_t ByteCount = 0;
+    for(uint32_t ThreadIndex = 0; ThreadIndex < Tester->ThreadCount; ++ThreadIndex)
+    {
+        parallel_test_thread *Thread = &Tester->Threads[ThreadIndex];
+        if(FirstBegin > Thread->WaveBeginTime)
+        {
+            FirstBegin = Thread->WaveBeginTime;
+        }
+
+        if(LastEnd < Thread->WaveEndTime)
+        {
+            LastEnd = Thread->WaveEndTime;
+        }
+
+        ByteCount += Thread->BytesThisWave;
+        AccumulateResult(&Thread->Results, Thread->WaveEndTime - Thread->WaveBeginTime);
+    }
+
+    if(ByteCount != Tester->TargetProcessedByteCount)
+    {
+        ParallelError(Tester, "Processed byte count mismatch");
+    }
+
+    if(Tester->Mode == TestMode_Testing)
+    {
+        repetition_test_results *Results = &Tester->Results;
+        uint64_t PreviousMin = Results->MinTime;
+        AccumulateResult(Results, LastEnd - FirstBegin);
+
+        if(Results->MinTime < PreviousMin)
+        {
+            Tester->TestsStartedAt = CurrentTime;
+
+            if(Tester->PrintNewMinimums)
+            {
+                PrintTime("Min", Results->MinTime, Tester->CPUTimerFreq, ByteCount);
+                printf("               \r");
+            }
+        }
+
+        if((CurrentTime - Tester->TestsStartedAt) > Tester->TryForTime)
+        {
+            Tester->Mode = TestMode_Completed;
+        }
+    }
+
+    if(Tester->Mode != TestMode_Testing)
+    {
+        Tester->Running = false;
+    }
+}
+
+static void RunParallelWaves(parallel_tester *Tester, uint32_t ThreadIndex)
+{
+    parallel_test_thread *Thread = &Tester->Threads[ThreadIndex];
+
+    for(;;)
+    {
+        WaitOnBarrier(&Tester->Barrier);
+        if(!AtomicLoadU32(&Tester->Running))
+        {
+            break;
+        }
+
+        Thread->WaveBeginTime = ReadCPUTimer();
+        Thread->BytesThisWave = Tester->Work(Tester->UserData, ThreadIndex, Tester->ThreadCount);
+        Thread->WaveEndTime = ReadCPUTimer();
+
+        WaitOnBarrier(&Tester->Barrier);
+        if(ThreadIndex == 0)
+        {
+            EndParallelWave(Tester);
+        }
+    }
+}
+
+static void ParallelTesterThreadProc(void *Param)
+{
+    parallel_thread_param *ThreadParam = (parallel_thread_param *)Param;
+    PinCurrentThreadToCore(ThreadParam->ThreadIndex);
+    RunParallelWaves(ThreadParam->Tester, ThreadParam->ThreadIndex);
+}
+
+/*
+    NOTE(Axel): The calling thread is used as thread 0 and is pinned to core 0.
+      Returns once no new minimum wave time was found for SecondsToTry.
+*/
+static void RunParallelTest(parallel_tester *Tester, uint32_t ThreadCount,
+                            parallel_test_work *Work, void *UserData,
+                            uint64_t TargetProcessedByteCount, uint64_t CPUTimerFreq,
+                            uint32_t SecondsToTry = 10)
+{
+    if(ThreadCount < 1)
+    {
+        ThreadCount = 1;
+    }
+
+    if(ThreadCount > MAX_THREAD_COUNT)
+    {
+        ThreadCount = MAX_THREAD_COUNT;
+    }
+
+    *Tester = {};
+    Tester->Mode = TestMode_Testing;
+    Tester->TargetProcessedByteCount = TargetProcessedByteCount;
+    Tester->CPUTimerFreq = CPUTimerFreq;
+    Tester->PrintNewMinimums = true;
+    Tester->ThreadCount = ThreadCount;
+    Tester->Work = Work;
+    Tester->UserData = UserData;
+    Tester->Running = true;
+    Tester->Results.MinTime = (uint64_t)-1;
+    for(uint32_t ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Tester->Threads[ThreadIndex].Results.MinTime = (uint64_t)-1;
+    }
+
+    InitBarrier(&Tester->Barrier, ThreadCount);
+
+    os_thread Threads[MAX_THREAD_COUNT] = {};
+    parallel_thread_param Params[MAX_THREAD_COUNT] = {};
+    uint32_t StartedCount = 1;
+    for(uint32_t ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Params[ThreadIndex].Tester = Tester;
+        Params[ThreadIndex].ThreadIndex = ThreadIndex;
+        if(!CreateOSThread(&Threads[ThreadIndex], ParallelTesterThreadProc, &Params[ThreadIndex]))
+        {
+            break;
+        }
+        ++StartedCount;
+    }
+
+    if(StartedCount == ThreadCount)
+    {
+        PinCurrentThreadToCore(0);
+        Tester->TryForTime = SecondsToTry*CPUTimerFreq;
+        Tester->TestsStartedAt = ReadCPUTimer();
+        RunParallelWaves(Tester, 0);
+
+        printf("                                                          \r");
+    }
+    else
+    {
+        /* NOTE: Release the threads that did start, they are waiting on a barrier
+           sized for ThreadCount so we have to fill it for them */
+        ParallelError(Tester, "Could not start every thread");
+        Tester->Running = false;
+        Tester->Barrier.ThreadCount = StartedCount;
+        WaitOnBarrier(&Tester->Barrier);
+    }
+
+    for(uint32_t ThreadIndex = 1; ThreadIndex < StartedCount; ++ThreadIndex)
+    {
+        JoinOSThread(&Threads[ThreadIndex]);
+    }
+}
+
+static void PrintParallelResults(parallel_tester *Tester)
+{
+    printf("Wave (%u threads):\n", Tester->ThreadCount);
+    PrintResults(Tester->Results, Tester->CPUTimerFreq, Tester->TargetProcessedByteCount);
+
+    uint64_t SlowestMin = 0;
+    uint64_t FastestMin = (uint64_t)-1;
+    for(uint32_t ThreadIndex = 0; ThreadIndex < Tester->ThreadCount; ++ThreadIndex)
+    {
+        parallel_test_thread *Thread = &Tester->Threads[ThreadIndex];
+        char Label[32];
+        snprintf(Label, sizeof(Label), "  Thread %2u min", ThreadIndex);
+        PrintTime(Label, Thread->Results.MinTime, Tester->CPUTimerFreq, Thread->BytesThisWave);
+        printf("\n");
+
+        if(SlowestMin < Thread->Results.MinTime)
+        {
+            SlowestMin = Thread->Results.MinTime;
+        }
+
+        if(FastestMin > Thread->Results.MinTime)
+        {
+            FastestMin = Thread->Results.MinTime;
+        }
+    }
+
+    if(FastestMin)
+    {
+        printf("  Imbalance (slowest/fastest thread): %.2fx\n", (double)SlowestMin / (double)FastestMin);
+    }
+}
+
+enum scaling_mode : uint32_t
+{
+    Scaling_Strong, /* Same total work split across threads */
+    Scaling_Weak,   /* Same work per thread, total grows with threads */
+};
+
+struct scaling_point
+{
+    uint32_t ThreadCount;
+    uint64_t MinWaveTime;
+    uint64_t ByteCount;
+};
+
+/*
+    NOTE(Axel): Efficiency is computed against the 1 thread point (which must be Points[0]):
+        strong: E(N) = T(1) / (N * T(N))  -> 1.0 means a perfect N times speed-up
+        weak:   E(N) = T(1) / T(N)        -> 1.0 means N times the work in the same time
+      A curve that falls off while the bandwidth column stays flat is a memory
+      bound workload, a curve that falls off with a low bandwidth is contention
+      (false sharing, synchronization).
+*/
+static void PrintScalingTable(char const *Label, scaling_mode Mode,
+                              scaling_point *Points, uint32_t PointCount,
+                              uint64_t CPUTimerFreq)
+{
+    printf("======= Scaling (%s, %s) =======\n", Label,
+           (Mode == Scaling_Strong) ? "strong" : "weak");
+    printf("Threads  Min wave (ms)   Speed-up  Efficiency  Bandwidth (gb/s)\n");
+
+    if(PointCount && CPUTimerFreq)
+    {
+        double BaseTime = (double)Points[0].MinWaveTime;
+        for(uint32_t PointIndex = 0; PointIndex < PointCount; ++PointIndex)
+        {
+            scaling_point *Point = &Points[PointIndex];
+            double Time = (double)Point->MinWaveTime;
+            double Seconds = SecondsFromCPUTime(Time, CPUTimerFreq);
+            double Gigabyte = (1024.0f * 1024.0f * 1024.0f);
+
+            double Speedup = 0.0;
+            double Efficiency = 0.0;
+            if(Time > 0.0)
+            {
+                if(Mode == Scaling_Strong)
+                {
+                    Speedup = BaseTime / Time;
+                    Efficiency = Speedup / (double)Point->ThreadCount;
+                }
+                else
+                {
+                    Efficiency = BaseTime / Time;
+                    Speedup = Efficiency * (double)Point->ThreadCount;
+                }
+            }
+
+            double Bandwidth = (Seconds > 0.0) ? (Point->ByteCount / (Gigabyte * Seconds)) : 0.0;
+            printf("%7u  %13f  %8.2fx  %9.1f%%  %16f\n", Point->ThreadCount,
+                   1000.0*Seconds, Speedup, 100.0*Efficiency, Bandwidth);
+        }
+    }
+
+    printf("\n");
+}
@@ -1,6 +1,12 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if _WIN32
 
+#include <intrin.h>
 #include <windows.h>
-#include <stdint.h>
 
 static uint64_t GetOSTimerFreq(void)
 {
@@ -16,17 +22,140 @@ static uint64_t ReadOSTimer(void)
 	return Value.QuadPart;
 }
 
+static void ReadCPUID(uint32_t Leaf, uint32_t SubLeaf, uint32_t *Registers)
+{
+	int Values[4];
+	__cpuidex(Values, (int)Leaf, (int)SubLeaf);
+	for(uint32_t Index = 0; Index < 4; ++Index)
+	{
+		Registers[Index] = (uint32_t)Values[Index];
+	}
+}
+
+#else
+
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static uint64_t GetOSTimerFreq(void)
+{
+	return 1000000000;
+}
+
+static uint64_t ReadOSTimer(void)
+{
+	struct timespec Value;
+	clock_gettime(CLOCK_MONOTONIC, &Value);
+	return (uint64_t)Value.tv_sec*GetOSTimerFreq() + (uint64_t)Value.tv_nsec;
+}
+
+static void ReadCPUID(uint32_t Leaf, uint32_t SubLeaf, uint32_t *Registers)
+{
+	__cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+}
+
+#endif
+
+/*
+	NOTE(Axel): Sleeps until ReadOSTimer() reaches OSTime, used to pace frames.
+	  Windows can only sleep in milliseconds (and only that precisely after
+	  timeBeginPeriod(1)), so the last 2ms are spent spinning.
+*/
+static void SleepUntilOSTime(uint64_t OSTime)
+{
+#if _WIN32
+	uint64_t OSFreq = GetOSTimerFreq();
+	for(;;)
+	{
+		uint64_t Now = ReadOSTimer();
+		if(Now >= OSTime)
+		{
+			break;
+		}
+
+		uint64_t MillisecondsLeft = (OSTime - Now)*1000 / OSFreq;
+		if(MillisecondsLeft > 2)
+		{
+			Sleep((DWORD)(MillisecondsLeft - 2));
+		}
+		else
+		{
+			_mm_pause();
+		}
+	}
+#else
+	struct timespec Target;
+	Target.tv_sec = (time_t)(OSTime / GetOSTimerFreq());
+	Target.tv_nsec = (long)(OSTime % GetOSTimerFreq());
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Target, 0) == EINTR)
+	{
+		/* NOTE: Interrupted by a signal, sleep again */
+	}
+#endif
+}
+
+/*
+	NOTE(Axel): The "CPU timer" is the TSC whenever we can trust it: it has to tick at a
+	  constant rate whatever the core frequency is (invariant TSC) and be the same on
+	  every core. When it isn't, ReadCPUTimer falls back on the OS timer, which is
+	  slower to read but always correct, and every tool keeps working with the
+	  frequency returned by EstimateCPUTimerFreq.
+*/
+enum cpu_timer_source : uint32_t
+{
+	CPUTimerSource_TSC,
+	CPUTimerSource_OSTimer,
+};
+
+enum cpu_timer_freq_origin : uint32_t
+{
+	CPUTimerFreqOrigin_Unknown,
+	CPUTimerFreqOrigin_CPUID15,
+	CPUTimerFreqOrigin_CPUID15And16,
+	CPUTimerFreqOrigin_Hypervisor,
+	CPUTimerFreqOrigin_LinuxTSCKHz,
+	CPUTimerFreqOrigin_Cache,
+	CPUTimerFreqOrigin_Measured,
+	CPUTimerFreqOrigin_OSTimer,
+};
+
+struct cpu_timer
+{
+	b32 Initialized;
+	cpu_timer_source Source;
+	cpu_timer_freq_origin Origin;
+	uint64_t Frequency;
+};
+
+static cpu_timer GlobalCPUTimer;
+
 inline uint64_t ReadCPUTimer(void)
 {
-	return __rdtsc();
+	uint64_t Result = 0;
+	if(GlobalCPUTimer.Source == CPUTimerSource_TSC)
+	{
+		Result = __rdtsc();
+	}
+	else
+	{
+		Result = ReadOSTimer();
+	}
+
+	return Result;
 }
 
-static uint64_t EstimateCPUTimerFreq(void)
+/*
+	NOTE(Axel): Last resort, busy-wait against the OS timer. This is what every tool used
+	  to do at startup, it now only runs once per machine and the result is cached.
+*/
+static uint64_t MeasureCPUTimerFreq(uint64_t MillisecondsToWait)
 {
-	uint64_t MillisecondsToWait = 100;
 	uint64_t OSFreq = GetOSTimerFreq();
 
-	uint64_t CPUStart = ReadCPUTimer();
+	uint64_t CPUStart = __rdtsc();
 	uint64_t OSStart = ReadOSTimer();
 	uint64_t OSEnd = 0;
 	uint64_t OSElapsed = 0;
@@ -37,15 +166,369 @@ static uint64_t EstimateCPUTimerFreq(void)
 		OSEnd = ReadOSTimer();
 		OSElapsed = OSEnd - OSStart;
 	}
-	
-	uint64_t CPUEnd = ReadCPUTimer();
+
+	uint64_t CPUEnd = __rdtsc();
 	uint64_t CPUElapsed = CPUEnd - CPUStart;
-	
+
 	uint64_t CPUFreq = 0;
 	if(OSElapsed)
 	{
 		CPUFreq = OSFreq * CPUElapsed / OSElapsed;
 	}
-	
+
 	return CPUFreq;
 }
+
+static b32 ReadTextFile(char const *FileName, char *Dest, size_t DestSize)
+{
+	b32 Result = false;
+
+	FILE *File = fopen(FileName, "rb");
+	if(File)
+	{
+		size_t Count = fread(Dest, 1, DestSize - 1, File);
+		Dest[Count] = 0;
+		fclose(File);
+		Result = (Count > 0);
+	}
+
+	return Result;
+}
+
+/*
+	NOTE(Axel): Invariant TSC is CPUID 0x80000007 EDX bit 8. On Linux the kernel also
+	  checks that the TSC is synchronized between cores (and keeps checking it against
+	  other clocks) and removes it from the available clocksources when it isn't,
+	  so we trust its judgement over the CPUID bit alone. This also catches most VMs
+	  where the TSC is emulated badly.
+*/
+static b32 IsTSCReliable(void)
+{
+	uint32_t Registers[4];
+	ReadCPUID(0x80000000, 0, Registers);
+	uint32_t MaxExtendedLeaf = Registers[0];
+
+	b32 Result = false;
+	if(MaxExtendedLeaf >= 0x80000007)
+	{
+		ReadCPUID(0x80000007, 0, Registers);
+		Result = ((Registers[3] >> 8) & 1);
+	}
+
+#if !_WIN32
+	char Clocksources[256];
+	if(Result && ReadTextFile("/sys/devices/system/clocksource/clocksource0/available_clocksource",
+							  Clocksources, sizeof(Clocksources)))
+	{
+		/* NOTE: Whole words, "hyperv_clocksource_tsc_page" is not the TSC */
+		Result = false;
+		char const *Separators = " \t\r\n";
+		for(char *Word = Clocksources + strspn(Clocksources, Separators); *Word;
+			Word += strspn(Word, Separators))
+		{
+			size_t Length = strcspn(Word, Separators);
+			Result = Result || ((Length == 3) && (strncmp(Word, "tsc", 3) == 0));
+			Word += Length;
+		}
+	}
+#endif
+
+	return Result;
+}
+
+static uint64_t GetTSCFreqFromCPUID(cpu_timer_freq_origin *Origin)
+{
+	uint64_t Result = 0;
+
+	uint32_t Registers[4];
+	ReadCPUID(0, 0, Registers);
+	uint32_t MaxLeaf = Registers[0];
+
+	/*
+		NOTE(Axel): Leaf 0x15 gives the TSC/crystal ratio (EBX/EAX) and the crystal
+		  frequency in ECX. Some parts leave ECX at 0, the ratio still tells us the TSC
+		  is derived from the crystal and it runs at the base frequency of leaf 0x16 (MHz).
+	*/
+	if(MaxLeaf >= 0x15)
+	{
+		ReadCPUID(0x15, 0, Registers);
+		uint64_t Denominator = Registers[0];
+		uint64_t Numerator = Registers[1];
+		uint64_t CrystalHz = Registers[2];
+
+		if(Denominator && Numerator)
+		{
+			if(CrystalHz)
+			{
+				Result = CrystalHz*Numerator / Denominator;
+				*Origin = CPUTimerFreqOrigin_CPUID15;
+			}
+			else if(MaxLeaf >= 0x16)
+			{
+				ReadCPUID(0x16, 0, Registers);
+				uint64_t BaseMHz = Registers[0] & 0xFFFF;
+				if(BaseMHz)
+				{
+					Result = BaseMHz*1000000;
+					*Origin = CPUTimerFreqOrigin_CPUID15And16;
+				}
+			}
+		}
+	}
+
+	/*
+		NOTE(Axel): Under a hypervisor (CPUID 1 ECX bit 31) the host may publish the TSC
+		  frequency in kHz at leaf 0x40000010 (VMware, KVM, ...). The leaves above are
+		  often hidden there, and measuring against an emulated OS timer is how we used
+		  to get wrong numbers.
+	*/
+	if(!Result)
+	{
+		ReadCPUID(1, 0, Registers);
+		b32 IsHypervisor = ((Registers[2] >> 31) & 1);
+		if(IsHypervisor)
+		{
+			ReadCPUID(0x40000000, 0, Registers);
+			if(Registers[0] >= 0x40000010)
+			{
+				ReadCPUID(0x40000010, 0, Registers);
+				if(Registers[0])
+				{
+					Result = (uint64_t)Registers[0]*1000;
+					*Origin = CPUTimerFreqOrigin_Hypervisor;
+				}
+			}
+		}
+	}
+
+	return Result;
+}
+
+static uint64_t GetTSCFreqFromOS(cpu_timer_freq_origin *Origin)
+{
+	uint64_t Result = 0;
+
+#if !_WIN32
+	/* NOTE: Only exported by some kernels, this is the kernel's own calibration */
+	char Text[64];
+	if(ReadTextFile("/sys/devices/system/cpu/cpu0/tsc_freq_khz", Text, sizeof(Text)))
+	{
+		Result = strtoull(Text, 0, 10)*1000;
+		if(Result)
+		{
+			*Origin = CPUTimerFreqOrigin_LinuxTSCKHz;
+		}
+	}
+#endif
+
+	return Result;
+}
+
+/*
+	NOTE(Axel): The cache is keyed by the CPU signature and brand string, an invariant
+	  TSC frequency is a property of the part. Delete the file to force a new
+	  measurement.
+*/
+static void GetCPUTimerCacheKey(char *Key, size_t KeySize)
+{
+	uint32_t Registers[4];
+	ReadCPUID(1, 0, Registers);
+	uint32_t Signature = Registers[0];
+
+	char Brand[49] = {};
+	ReadCPUID(0x80000000, 0, Registers);
+	if(Registers[0] >= 0x80000004)
+	{
+		for(uint32_t Leaf = 0; Leaf < 3; ++Leaf)
+		{
+			ReadCPUID(0x80000002 + Leaf, 0, Registers);
+			memcpy(Brand + Leaf*16, Registers, 16);
+		}
+	}
+
+	snprintf(Key, KeySize, "%08x %s", Signature, Brand);
+}
+
+#if !_WIN32
+#define CPU_TIMER_CACHE_FALLBACK "/tmp/draw_me_a_line_cpu_timer.txt"
+#endif
+
+static void GetCPUTimerCachePath(char *Path, size_t PathSize)
+{
+#if _WIN32
+	char Directory[MAX_PATH];
+	DWORD Count = GetTempPathA(sizeof(Directory), Directory);
+	if(!Count || (Count >= sizeof(Directory)))
+	{
+		Directory[0] = 0;
+	}
+	snprintf(Path, PathSize, "%sdraw_me_a_line_cpu_timer.txt", Directory);
+#else
+	char const *CacheHome = getenv("XDG_CACHE_HOME");
+	char const *Home = getenv("HOME");
+	if(CacheHome && CacheHome[0])
+	{
+		snprintf(Path, PathSize, "%s/draw_me_a_line_cpu_timer.txt", CacheHome);
+	}
+	else if(Home && Home[0])
+	{
+		snprintf(Path, PathSize, "%s/.cache/draw_me_a_line_cpu_timer.txt", Home);
+	}
+	else
+	{
+		snprintf(Path, PathSize, "%s", CPU_TIMER_CACHE_FALLBACK);
+	}
+#endif
+}
+
+static uint64_t ReadCachedCPUTimerFreq(void)
+{
+	uint64_t Result = 0;
+
+	char Path[512];
+	char Key[128];
+	char Text[256];
+	GetCPUTimerCachePath(Path, sizeof(Path));
+	GetCPUTimerCacheKey(Key, sizeof(Key));
+
+	b32 Found = ReadTextFile(Path, Text, sizeof(Text));
+#if !_WIN32
+	/* NOTE: Where WriteCachedCPUTimerFreq goes when the cache directory can't be made */
+	Found = Found || ReadTextFile(CPU_TIMER_CACHE_FALLBACK, Text, sizeof(Text));
+#endif
+	if(Found)
+	{
+		/* NOTE: "<frequency>\n<key>\n" */
+		char *KeyStart = strchr(Text, '\n');
+		if(KeyStart)
+		{
+			*KeyStart++ = 0;
+			char *KeyEnd = strchr(KeyStart, '\n');
+			if(KeyEnd)
+			{
+				*KeyEnd = 0;
+			}
+
+			if(strcmp(KeyStart, Key) == 0)
+			{
+				Result = strtoull(Text, 0, 10);
+			}
+		}
+	}
+
+	return Result;
+}
+
+static void WriteCachedCPUTimerFreq(uint64_t Frequency)
+{
+	char Path[512];
+	char Key[128];
+	GetCPUTimerCachePath(Path, sizeof(Path));
+	GetCPUTimerCacheKey(Key, sizeof(Key));
+
+	FILE *File = fopen(Path, "wb");
+#if !_WIN32
+	if(!File)
+	{
+		/* NOTE: $HOME/.cache may not exist yet, create it once, else the temp directory */
+		char *Slash = strrchr(Path, '/');
+		if(Slash && (Slash != Path))
+		{
+			*Slash = 0;
+			b32 Created = (mkdir(Path, 0755) == 0) || (errno == EEXIST);
+			*Slash = '/';
+			if(Created)
+			{
+				File = fopen(Path, "wb");
+			}
+		}
+
+		if(!File)
+		{
+			File = fopen(CPU_TIMER_CACHE_FALLBACK, "wb");
+		}
+	}
+#endif
+	if(File)
+	{
+		fprintf(File, "%llu\n%s\n", (unsigned long long)Frequency, Key);
+		fclose(File);
+	}
+}
+
+static char const *GetCPUTimerFreqOriginName(cpu_timer_freq_origin Origin)
+{
+	char const *Result = "unknown";
+	switch(Origin)
+	{
+		case CPUTimerFreqOrigin_CPUID15: Result = "CPUID 0x15"; break;
+		case CPUTimerFreqOrigin_CPUID15And16: Result = "CPUID 0x15 + 0x16"; break;
+		case CPUTimerFreqOrigin_Hypervisor: Result = "hypervisor CPUID 0x40000010"; break;
+		case CPUTimerFreqOrigin_LinuxTSCKHz: Result = "Linux tsc_freq_khz"; break;
+		case CPUTimerFreqOrigin_Cache: Result = "cached measurement"; break;
+		case CPUTimerFreqOrigin_Measured: Result = "measured against OS timer"; break;
+		case CPUTimerFreqOrigin_OSTimer: Result = "OS timer"; break;
+		default: break;
+	}
+
+	return Result;
+}
+
+static void InitCPUTimer(void)
+{
+	cpu_timer *Timer = &GlobalCPUTimer;
+	*Timer = {};
+
+	if(IsTSCReliable())
+	{
+		Timer->Source = CPUTimerSource_TSC;
+		Timer->Frequency = GetTSCFreqFromCPUID(&Timer->Origin);
+
+		if(!Timer->Frequency)
+		{
+			Timer->Frequency = GetTSCFreqFromOS(&Timer->Origin);
+		}
+
+		if(!Timer->Frequency)
+		{
+			Timer->Frequency = ReadCachedCPUTimerFreq();
+			Timer->Origin = CPUTimerFreqOrigin_Cache;
+		}
+
+		if(!Timer->Frequency)
+		{
+			Timer->Frequency = MeasureCPUTimerFreq(100);
+			Timer->Origin = CPUTimerFreqOrigin_Measured;
+			WriteCachedCPUTimerFreq(Timer->Frequency);
+		}
+	}
+
+	if(!Timer->Frequency)
+	{
+		fprintf(stderr, "WARNING: TSC is not invariant or not synchronized across cores, "
+				"using the OS timer (lower resolution, higher read cost).\n");
+
+		Timer->Source = CPUTimerSource_OSTimer;
+		Timer->Frequency = GetOSTimerFreq();
+		Timer->Origin = CPUTimerFreqOrigin_OSTimer;
+	}
+
+	printf("CPU timer: %s, %.3f MHz from %s\n",
+		   (Timer->Source == CPUTimerSource_TSC) ? "TSC" : "OS timer",
+		   (double)Timer->Frequency / 1000000.0, GetCPUTimerFreqOriginName(Timer->Origin));
+
+	Timer->Initialized = true;
+}
+
+/*
+	NOTE(Axel): Kept the old name, every listing calls it once at startup.
+*/
+static uint64_t EstimateCPUTimerFreq(void)
+{
+	if(!GlobalCPUTimer.Initialized)
+	{
+		InitCPUTimer();
+	}
+
+	return GlobalCPUTimer.Frequency;
+}
@@ -0,0 +1,296 @@
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+    NOTE(Axel): Scoped zone profiler to see where the time goes inside a whole frame,
+      the repetition_tester only compares one thing against another.
+
+      #define PROFILER 1 before including this file to turn it on. When it is off every
+      TimeBlock/TimeBandwidth/CountWork compiles to nothing and only the total time
+      between BeginProfile and EndAndPrintProfile is kept.
+
+      Each zone keeps:
+        - exclusive time: time spent in the zone minus the time of the zones it opened
+        - inclusive time: time spent in the zone with its children, recursion is only
+          counted once (the outermost call wins)
+        - hit count, bytes (for the bandwidth) and a work counter (pixels, lines...)
+
+      Zones are stored in a static array indexed by __COUNTER__ so opening a zone is
+      one rdtsc and a few adds. It is NOT thread safe, profile one thread.
+*/
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#define NameConcat2(A, B) A##B
+#define NameConcat(A, B) NameConcat2(A, B)
+
+struct profiler
+{
+    uint64_t StartTSC;
+    uint64_t EndTSC;
+};
+
+static profiler GlobalProfiler;
+
+#if PROFILER
+
+#define MAX_PROFILE_ANCHOR_COUNT 1024
+#define MAX_PROFILE_TRACE_EVENT_COUNT (64*1024)
+
+struct profile_anchor
+{
+    uint64_t TSCElapsedExclusive;
+    uint64_t TSCElapsedInclusive;
+    uint64_t HitCount;
+    uint64_t ProcessedByteCount;
+    uint64_t WorkCount;
+    char const *Label;
+};
+
+struct profile_trace_event
+{
+    uint32_t AnchorIndex;
+    uint32_t Depth;
+    uint64_t StartTSC;
+    uint64_t EndTSC;
+};
+
+/*
+    NOTE(Axel): Only recorded between BeginProfileTrace/EndProfileTrace, usually one
+      frame. When the buffer is full the events are dropped (and counted).
+*/
+struct profile_trace
+{
+    b32 Recording;
+    uint32_t Depth;
+    uint32_t EventCount;
+    uint32_t DroppedCount;
+    uint64_t StartTSC;
+    profile_trace_event Events[MAX_PROFILE_TRACE_EVENT_COUNT];
+};
+
+static profile_anchor GlobalProfilerAnchors[MAX_PROFILE_ANCHOR_COUNT];
+static uint32_t GlobalProfilerParent;
+static profile_trace GlobalProfileTrace;
+
+struct profile_block
+{
+    profile_block(char const *Label_, uint32_t AnchorIndex_, uint64_t ByteCount)
+    {
+        ParentIndex = GlobalProfilerParent;
+
+        AnchorIndex = AnchorIndex_;
+        Label = Label_;
+
+        profile_anchor *Anchor = GlobalProfilerAnchors + AnchorIndex;
+        OldTSCElapsedInclusive = Anchor->TSCElapsedInclusive;
+        Anchor->ProcessedByteCount += ByteCount;
+
+        GlobalProfilerParent = AnchorIndex;
+        ++GlobalProfileTrace.Depth;
+        StartTSC = ReadCPUTimer();
+    }
+
+    ~profile_block()
+    {
+        uint64_t EndTSC = ReadCPUTimer();
+        uint64_t Elapsed = EndTSC - StartTSC;
+        GlobalProfilerParent = ParentIndex;
+        --GlobalProfileTrace.Depth;
+
+        profile_anchor *Parent = GlobalProfilerAnchors + ParentIndex;
+        profile_anchor *Anchor = GlobalProfilerAnchors + AnchorIndex;
+
+        Parent->TSCElapsedExclusive -= Elapsed;
+        Anchor->TSCElapsedExclusive += Elapsed;
+        Anchor->TSCElapsedInclusive = OldTSCElapsedInclusive + Elapsed;
+        ++Anchor->HitCount;
+
+        /* NOTE: Labels are string literals, storing the pointer every time is cheaper
+           than testing if it was already set */
+        Anchor->Label = Label;
+
+        profile_trace *Trace = &GlobalProfileTrace;
+        if(Trace->Recording)
+        {
+            if(Trace->EventCount < MAX_PROFILE_TRACE_EVENT_COUNT)
+            {
+                profile_trace_event *Event = Trace->Events + Trace->EventCount++;
+                Event->AnchorIndex = AnchorIndex;
+                Event->Depth = Trace->Depth;
+                Event->StartTSC = StartTSC;
+                Event->EndTSC = EndTSC;
+            }
+            else
+            {
+                ++Trace->DroppedCount;
+            }
+        }
+    }
+
+    char const *Label;
+    uint64_t OldTSCElapsedInclusive;
+    uint64_t StartTSC;
+    uint32_t ParentIndex;
+    uint32_t AnchorIndex;
+};
+
+/* NOTE: Anchor 0 is the root, it is never printed */
+#define TimeBandwidth(Name, ByteCount) profile_block NameConcat(Block, __LINE__)(Name, __COUNTER__ + 1, ByteCount)
+#define TimeBlock(Name) TimeBandwidth(Name, 0)
+#define TimeFunction TimeBlock(__func__)
+
+/* NOTE: Adds to the work counter of the innermost open zone */
+#define CountWork(Count) (GlobalProfilerAnchors[GlobalProfilerParent].WorkCount += (Count))
+
+#define ProfilerEndOfCompilationUnit static_assert(__COUNTER__ < MAX_PROFILE_ANCHOR_COUNT, "Number of profile points exceeds MAX_PROFILE_ANCHOR_COUNT")
+
+static void PrintTimeElapsed(uint64_t TotalTSCElapsed, uint64_t CPUTimerFreq, profile_anchor *Anchor)
+{
+    double Percent = 100.0 * ((double)Anchor->TSCElapsedExclusive / (double)TotalTSCElapsed);
+    printf("  ");
+    PrintTime(Anchor->Label, Anchor->TSCElapsedExclusive, CPUTimerFreq, Anchor->ProcessedByteCount);
+    printf(" %.2f%%", Percent);
+
+    if(Anchor->TSCElapsedInclusive != Anchor->TSCElapsedExclusive)
+    {
+        double PercentWithChildren = 100.0 * ((double)Anchor->TSCElapsedInclusive / (double)TotalTSCElapsed);
+        printf(", %.2f%% w/children", PercentWithChildren);
+    }
+
+    printf(" [%llu hits]", (unsigned long long)Anchor->HitCount);
+
+    if(Anchor->WorkCount)
+    {
+        double CyclesPerWork = (double)Anchor->TSCElapsedExclusive / (double)Anchor->WorkCount;
+        printf(" %llu work (%.2f cycles/work)", (unsigned long long)Anchor->WorkCount, CyclesPerWork);
+    }
+
+    printf("\n");
+}
+
+static void PrintAnchorData(uint64_t TotalCPUElapsed, uint64_t CPUTimerFreq)
+{
+    for(uint32_t AnchorIndex = 0; AnchorIndex < MAX_PROFILE_ANCHOR_COUNT; ++AnchorIndex)
+    {
+        profile_anchor *Anchor = GlobalProfilerAnchors + AnchorIndex;
+        if(Anchor->HitCount)
+        {
+            PrintTimeElapsed(TotalCPUElapsed, CPUTimerFreq, Anchor);
+        }
+    }
+}
+
+static void ResetProfileAnchors(void)
+{
+    for(uint32_t AnchorIndex = 0; AnchorIndex < MAX_PROFILE_ANCHOR_COUNT; ++AnchorIndex)
+    {
+        GlobalProfilerAnchors[AnchorIndex] = {};
+    }
+}
+
+static void BeginProfileTrace(void)
+{
+    profile_trace *Trace = &GlobalProfileTrace;
+    Trace->Recording = true;
+    Trace->EventCount = 0;
+    Trace->DroppedCount = 0;
+    Trace->StartTSC = ReadCPUTimer();
+}
+
+static void EndProfileTrace(void)
+{
+    GlobalProfileTrace.Recording = false;
+}
+
+/*
+    NOTE(Axel): Chrome trace event format ("X" complete events, times in microseconds),
+      open it in chrome://tracing or https://ui.perfetto.dev
+*/
+static b32 WriteProfileTrace(char const *FileName, uint64_t CPUTimerFreq)
+{
+    b32 Result = false;
+
+    profile_trace *Trace = &GlobalProfileTrace;
+    FILE *File = fopen(FileName, "wb");
+    if(File && CPUTimerFreq)
+    {
+        double MicrosecondsPerTick = 1000000.0 / (double)CPUTimerFreq;
+
+        fprintf(File, "{\"traceEvents\":[\n");
+        for(uint32_t EventIndex = 0; EventIndex < Trace->EventCount; ++EventIndex)
+        {
+            profile_trace_event *Event = Trace->Events + EventIndex;
+            profile_anchor *Anchor = GlobalProfilerAnchors + Event->AnchorIndex;
+
+            double Start = (double)(Event->StartTSC - Trace->StartTSC)*MicrosecondsPerTick;
+            double Duration = (double)(Event->EndTSC - Event->StartTSC)*MicrosecondsPerTick;
+            fprintf(File, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}\n",
+                    EventIndex ? "," : "", Anchor->Label, Start, Duration, Event->Depth);
+        }
+        fprintf(File, "],\"displayTimeUnit\":\"ns\"}\n");
+        fclose(File);
+
+        if(Trace->DroppedCount)
+        {
+            fprintf(stderr, "WARNING: %u trace events dropped, MAX_PROFILE_TRACE_EVENT_COUNT is too small.\n",
+                    Trace->DroppedCount);
+        }
+
+        Result = true;
+    }
+    else
+    {
+        if(File)
+        {
+            fclose(File);
+        }
+        fprintf(stderr, "ERROR: Unable to write trace %s.\n", FileName);
+    }
+
+    return Result;
+}
+
+#else
+
+#define TimeBandwidth(...)
+#define TimeBlock(...)
+#define TimeFunction
+#define CountWork(...)
+#define ProfilerEndOfCompilationUnit
+
+#define PrintAnchorData(...)
+#define ResetProfileAnchors(...)
+#define BeginProfileTrace(...)
+#define EndProfileTrace(...)
+
+static b32 WriteProfileTrace(char const *FileName, uint64_t CPUTimerFreq)
+{
+    fprintf(stderr, "WARNING: Profiler is compiled out, no trace written to %s.\n", FileName);
+    return false;
+}
+
+#endif
+
+static void BeginProfile(void)
+{
+    ResetProfileAnchors();
+    GlobalProfiler.StartTSC = ReadCPUTimer();
+}
+
+static void EndAndPrintProfile(uint64_t CPUTimerFreq)
+{
+    GlobalProfiler.EndTSC = ReadCPUTimer();
+
+    uint64_t TotalCPUElapsed = GlobalProfiler.EndTSC - GlobalProfiler.StartTSC;
+
+    PrintTime("Total time", TotalCPUElapsed, CPUTimerFreq, 0);
+    printf("\n");
+
+    if(TotalCPUElapsed)
+    {
+        PrintAnchorData(TotalCPUElapsed, CPUTimerFreq);
+    }
+}
@@ -0,0 +1,22 @@
+#include <stdint.h>
+
+/*
+    NOTE(Axel): The test data of the listings. Not a good generator, a cheap and
+      reproducible one, the same seed draws the same scene on every machine.
+*/
+static uint32_t RandomU32(uint32_t *State)
+{
+    /* NOTE: xorshift32 */
+    uint32_t X = *State;
+    X ^= X << 13;
+    X ^= X >> 17;
+    X ^= X << 5;
+    *State = X;
+    return X;
+}
+
+inline int32_t ClampToRange(int32_t Value, int32_t Max)
+{
+    int32_t Result = (Value < 0) ? 0 : ((Value > Max) ? Max : Value);
+    return Result;
+}
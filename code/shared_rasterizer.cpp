@@ -0,0 +1,624 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+struct screen_buffer
+{
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t BytesPerPixel;
+  uint32_t Pitch;
+
+  uint8_t *Memory;
+  size_t MemoryCount;
+};
+
+enum draw_line_method
+{
+    Line_Draw_By_Rounding,
+    Line_Draw_By_Bresenham,
+    Line_Draw_By_Bresenham_Stepping,
+
+    Line_Draw_Count,
+};
+
+struct buffer
+{
+    size_t Count;
+    uint8_t *Data;
+};
+
+static buffer AllocateBuffer(size_t Count)
+{
+    buffer Result = {};
+    Result.Data = (uint8_t *)malloc(Count);
+    if(Result.Data)
+    {
+        Result.Count = Count;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %llu bytes.\n", (unsigned long long)Count);
+    }
+
+    return Result;
+}
+
+static void FreeBuffer(buffer *Buffer)
+{
+    free(Buffer->Data);
+    *Buffer = {};
+}
+
+inline int32_t RoundReal32Toint32_t(real32 Real32)
+{
+    int32_t Result = (int32_t)roundf(Real32); /* Round to the nearest integer */
+    return(Result);
+}
+
+static b32 InitScreenBuffer(screen_buffer *Screen, uint32_t Width, uint32_t Height)
+{
+  b32 Result = false;
+
+  Screen->Width = Width;
+  Screen->Height = Height;
+  Screen->BytesPerPixel = 4;
+  Screen->Pitch = Screen->Width*Screen->BytesPerPixel;
+
+  buffer Buffer = AllocateBuffer((size_t)Screen->Height*Screen->Width*Screen->BytesPerPixel);
+  Screen->Memory = Buffer.Data;
+  Screen->MemoryCount = Buffer.Count;
+
+  if(Screen->Memory)
+  {
+    Result = true;
+  }
+
+  return Result;
+}
+
+static void FreeScreenBuffer(screen_buffer *Screen)
+{
+  free(Screen->Memory);
+  *Screen = {};
+}
+
+inline void DrawPixel(screen_buffer *Buffer,
+                      int32_t X0, int32_t Y0, int32_t Color)
+{
+    int32_t Y = Y0 * Buffer->Pitch;
+    int32_t X = X0 * Buffer->BytesPerPixel;
+    uint8_t *Row = (uint8_t*)Buffer->Memory + X + Y;
+
+    int32_t *Pixel = (int32_t*)Row;
+    *Pixel = Color;
+}
+
+/*
+    NOTE(Axel): Bresenham for every octant, walking a pixel pointer instead of (X,Y).
+      Exactly the same decisions as Line_Draw_By_Bresenham, only the octant changes
+      which way we move:
+        - the major dimension is the one with the biggest delta (x when dx == dy)
+        - a major step is +-1 pixel (x major) or +-Pitch/4 (y major), the minor step
+          is the other one
+        - the decision only works with the absolute deltas, so the 7 other octants
+          are the first one mirrored and/or transposed.
+      The address is computed once, the loop is a compare, one or two adds and a store.
+      Like the one octant version the first pixel is written after the first decision
+      and the end point is not written.
+*/
+static void DrawLineStepping(screen_buffer *Buffer,
+                             int32_t X0, int32_t Y0,
+                             int32_t X1, int32_t Y1, int32_t Color)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+
+    int32_t dx = (X1 - X0);
+    int32_t dy = (Y1 - Y0);
+    intptr_t StepX = 1;
+    intptr_t StepY = PitchInPixels;
+    if(dx < 0)
+    {
+        dx = -dx;
+        StepX = -1;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        StepY = -PitchInPixels;
+    }
+
+    int32_t Major = dx;
+    int32_t Minor = dy;
+    intptr_t MajorStep = StepX;
+    intptr_t MinorStep = StepY;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = StepY;
+        MinorStep = StepX;
+    }
+
+    int32_t decision    = (2 * Minor) - Major;
+    int32_t IncrementNE = (2 * (Minor - Major));
+    int32_t IncrementE  = (2 * Minor);
+
+    uint32_t *Pixel = (uint32_t *)Buffer->Memory + Y0*PitchInPixels + X0;
+    for(int32_t Count = Major; Count > 0; --Count)
+    {
+        if(decision <= 0)
+        {
+            decision += IncrementE;
+        }
+        else
+        {
+            Pixel += MinorStep;
+            decision += IncrementNE;
+        }
+
+        *Pixel = (uint32_t)Color;
+        Pixel += MajorStep;
+    }
+}
+
+/*
+    NOTE(Axel): Same algorithms as listing_3, pulled out so several listings can share
+      the exact same workload. See listing_2/listing_3 for the derivation of the
+      decision variable. Rounding and Bresenham only handle one octant (0 <= dy <= dx).
+*/
+inline void DrawLine(screen_buffer *Buffer,
+                      int32_t X0, int32_t Y0,
+                      int32_t X1, int32_t Y1, int32_t Color,
+                      draw_line_method Method)
+{
+    switch(Method)
+    {
+        case Line_Draw_By_Rounding:
+        {
+            int32_t dx          = (X1 - X0);
+            int32_t dy          = (Y1 - Y0);
+            float m             = (float)dy / (float)dx;
+            float YOnTheLine    = (float)Y0;
+            int32_t Y           = 0;
+
+            for(int32_t X = X0; X < X1; ++X)
+            {
+                YOnTheLine += m;
+                Y = RoundReal32Toint32_t(YOnTheLine);
+
+                DrawPixel(Buffer, X, Y, Color);
+            }
+        } break;
+
+        case Line_Draw_By_Bresenham:
+        {
+            int32_t dx          = (X1 - X0);
+            int32_t dy          = (Y1 - Y0);
+            int32_t decision    = (2 * dy) - dx;   // 0 + dy - (0.5 * dx)
+            int32_t IncrementNE = (2 * (dy - dx)); // dy - dx
+            int32_t IncrementE  = (2 * dy);        // dy
+            int32_t Y           = Y0;
+
+            for(int32_t X = X0; X < (X0+dx); ++X)
+            {
+                if(decision <= 0)
+                {
+                    decision += IncrementE;
+                }
+                else
+                {
+                    ++Y;
+                    decision += IncrementNE;
+                }
+
+                DrawPixel(Buffer, X, Y, Color);
+            }
+        } break;
+
+        case Line_Draw_By_Bresenham_Stepping:
+        {
+            DrawLineStepping(Buffer, X0, Y0, X1, Y1, Color);
+        } break;
+
+        default:
+        {
+            printf("Line drawing algorithm not implemented yet\n");
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Default fast path, every octant.
+*/
+inline void DrawLine(screen_buffer *Buffer,
+                     int32_t X0, int32_t Y0,
+                     int32_t X1, int32_t Y1, int32_t Color)
+{
+    DrawLineStepping(Buffer, X0, Y0, X1, Y1, Color);
+}
+
+/*
+    NOTE(Axel): Many segments, one array per coordinate (SoA): whatever produces segments
+      in bulk (spatial queries, transforms, curves, decoders) writes here, and the
+      arrays can be loaded 8 lanes at a time.
+*/
+struct line_segment_batch
+{
+    int32_t *X0;
+    int32_t *Y0;
+    int32_t *X1;
+    int32_t *Y1;
+
+    uint32_t Count;
+    uint32_t Capacity;
+
+    buffer Memory;
+};
+
+static b32 AllocateSegmentBatch(line_segment_batch *Batch, uint32_t Capacity)
+{
+    *Batch = {};
+
+    /* NOTE: One block, each array 64 bytes aligned and padded to a multiple of 16 lanes */
+    size_t LaneCount = ((size_t)Capacity + 15) & ~(size_t)15;
+    buffer Memory = AllocateBuffer(4*LaneCount*sizeof(int32_t) + 64);
+    if(Memory.Data)
+    {
+        int32_t *Base = (int32_t *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Batch->X0 = Base;
+        Batch->Y0 = Base + LaneCount;
+        Batch->X1 = Base + 2*LaneCount;
+        Batch->Y1 = Base + 3*LaneCount;
+        Batch->Capacity = Capacity;
+        Batch->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreeSegmentBatch(line_segment_batch *Batch)
+{
+    FreeBuffer(&Batch->Memory);
+    *Batch = {};
+}
+
+inline void PushSegment(line_segment_batch *Batch, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    if(Batch->Count < Batch->Capacity)
+    {
+        uint32_t Index = Batch->Count++;
+        Batch->X0[Index] = X0;
+        Batch->Y0[Index] = Y0;
+        Batch->X1[Index] = X1;
+        Batch->Y1[Index] = Y1;
+    }
+}
+
+static void DrawLineBatch(screen_buffer *Buffer, line_segment_batch *Batch, int32_t Color)
+{
+    for(uint32_t Index = 0; Index < Batch->Count; ++Index)
+    {
+        DrawLineStepping(Buffer, Batch->X0[Index], Batch->Y0[Index],
+                         Batch->X1[Index], Batch->Y1[Index], Color);
+    }
+}
+
+/*
+    NOTE(Axel): Connected segments, point I to point I + 1. Same layout as the batch, one
+      array per coordinate.
+*/
+struct polyline
+{
+    int32_t *X;
+    int32_t *Y;
+
+    uint32_t Count;
+    uint32_t Capacity;
+
+    buffer Memory;
+};
+
+static b32 AllocatePolyline(polyline *Polyline, uint32_t Capacity)
+{
+    *Polyline = {};
+
+    size_t LaneCount = ((size_t)Capacity + 15) & ~(size_t)15;
+    buffer Memory = AllocateBuffer(2*LaneCount*sizeof(int32_t) + 64);
+    if(Memory.Data)
+    {
+        int32_t *Base = (int32_t *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Polyline->X = Base;
+        Polyline->Y = Base + LaneCount;
+        Polyline->Capacity = Capacity;
+        Polyline->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreePolyline(polyline *Polyline)
+{
+    FreeBuffer(&Polyline->Memory);
+    *Polyline = {};
+}
+
+inline void PushPoint(polyline *Polyline, int32_t X, int32_t Y)
+{
+    if(Polyline->Count < Polyline->Capacity)
+    {
+        uint32_t Index = Polyline->Count++;
+        Polyline->X[Index] = X;
+        Polyline->Y[Index] = Y;
+    }
+}
+
+static void DrawPolyline(screen_buffer *Buffer, polyline *Polyline, int32_t Color)
+{
+    for(uint32_t Index = 1; Index < Polyline->Count; ++Index)
+    {
+        DrawLineStepping(Buffer, Polyline->X[Index - 1], Polyline->Y[Index - 1],
+                         Polyline->X[Index], Polyline->Y[Index], Color);
+    }
+}
+
+/*
+    NOTE(Axel): Cohen-Sutherland. Both ends get an outcode telling on which side(s) of
+      the rectangle they are, if they share a side the line is completely outside,
+      if both are 0 it is completely inside, otherwise we move the outside end onto
+      the edge and try again. The rectangle is inclusive.
+*/
+struct clip_rect
+{
+    int32_t MinX;
+    int32_t MinY;
+    int32_t MaxX;
+    int32_t MaxY;
+};
+
+enum clip_outcode : uint32_t
+{
+    ClipOutcode_Left   = 0x1,
+    ClipOutcode_Right  = 0x2,
+    ClipOutcode_Top    = 0x4,
+    ClipOutcode_Bottom = 0x8,
+};
+
+inline clip_rect GetScreenClipRect(screen_buffer *Buffer)
+{
+    clip_rect Result = {0, 0, (int32_t)Buffer->Width - 1, (int32_t)Buffer->Height - 1};
+    return Result;
+}
+
+inline uint32_t ComputeOutcode(clip_rect Rect, int32_t X, int32_t Y)
+{
+    uint32_t Result = 0;
+    if(X < Rect.MinX) Result |= ClipOutcode_Left;
+    if(X > Rect.MaxX) Result |= ClipOutcode_Right;
+    if(Y < Rect.MinY) Result |= ClipOutcode_Top;
+    if(Y > Rect.MaxY) Result |= ClipOutcode_Bottom;
+    return Result;
+}
+
+static b32 ClipLine(clip_rect Rect, int32_t *X0, int32_t *Y0, int32_t *X1, int32_t *Y1)
+{
+    uint32_t Outcode0 = ComputeOutcode(Rect, *X0, *Y0);
+    uint32_t Outcode1 = ComputeOutcode(Rect, *X1, *Y1);
+
+    b32 Result = false;
+    for(;;)
+    {
+        if(!(Outcode0 | Outcode1))
+        {
+            Result = true;
+            break;
+        }
+
+        if(Outcode0 & Outcode1)
+        {
+            break;
+        }
+
+        uint32_t Outcode = Outcode0 ? Outcode0 : Outcode1;
+        int64_t Dx = (int64_t)*X1 - *X0;
+        int64_t Dy = (int64_t)*Y1 - *Y0;
+        int32_t X = 0;
+        int32_t Y = 0;
+
+        if(Outcode & ClipOutcode_Bottom)
+        {
+            X = (int32_t)(*X0 + Dx*(Rect.MaxY - *Y0) / Dy);
+            Y = Rect.MaxY;
+        }
+        else if(Outcode & ClipOutcode_Top)
+        {
+            X = (int32_t)(*X0 + Dx*(Rect.MinY - *Y0) / Dy);
+            Y = Rect.MinY;
+        }
+        else if(Outcode & ClipOutcode_Right)
+        {
+            Y = (int32_t)(*Y0 + Dy*(Rect.MaxX - *X0) / Dx);
+            X = Rect.MaxX;
+        }
+        else
+        {
+            Y = (int32_t)(*Y0 + Dy*(Rect.MinX - *X0) / Dx);
+            X = Rect.MinX;
+        }
+
+        if(Outcode == Outcode0)
+        {
+            *X0 = X;
+            *Y0 = Y;
+            Outcode0 = ComputeOutcode(Rect, X, Y);
+        }
+        else
+        {
+            *X1 = X;
+            *Y1 = Y;
+            Outcode1 = ComputeOutcode(Rect, X, Y);
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Where DrawLineStepping puts its pixels, in the octant frame: pixel I
+      (0 <= I < Major) is at I on the major axis, and on the minor axis at the
+      number of decisions that were > 0 up to it:
+        M(I) = max(0, ceil((2*Minor*(I + 1) - Major) / (2*Major)))
+      FirstStepAtMinor is the inverse, the first I with M(I) >= V (Major if none).
+*/
+inline int64_t MinorAtStep(int64_t I, int64_t Major, int64_t Minor)
+{
+    int64_t Numerator = 2*Minor*(I + 1) - Major;
+    int64_t Result = (Numerator > 0) ? ((Numerator + 2*Major - 1) / (2*Major)) : 0;
+    return Result;
+}
+
+inline int64_t FirstStepAtMinor(int64_t V, int64_t Major, int64_t Minor)
+{
+    int64_t Result = 0;
+    if(V > 0)
+    {
+        Result = Major;
+        if(Minor > 0)
+        {
+            Result = (2*Major*(V - 1) + Major) / (2*Minor);
+            if(Result > Major)
+            {
+                Result = Major;
+            }
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Exactly the pixels of DrawLineStepping that are inside Rect (inclusive),
+      without walking the ones outside: the first and last steps inside are solved
+      for, the decision variable is rebuilt for the first one, then it is the usual
+      loop. Drawing a line tile by tile with this gives the same pixels as drawing
+      it at once, and the end points can be anywhere, even far off screen.
+*/
+static void DrawLineScissored(screen_buffer *Buffer,
+                              int32_t X0, int32_t Y0,
+                              int32_t X1, int32_t Y1, int32_t Color,
+                              clip_rect Rect)
+{
+    intptr_t PitchInPixels = Buffer->Pitch / Buffer->BytesPerPixel;
+
+    int64_t dx = ((int64_t)X1 - X0);
+    int64_t dy = ((int64_t)Y1 - Y0);
+    int64_t SignX = 1;
+    int64_t SignY = 1;
+    if(dx < 0)
+    {
+        dx = -dx;
+        SignX = -1;
+    }
+
+    if(dy < 0)
+    {
+        dy = -dy;
+        SignY = -1;
+    }
+
+    /* NOTE: The rectangle in offsets from (X0, Y0) along the line directions */
+    int64_t MinU = (SignX > 0) ? ((int64_t)Rect.MinX - X0) : ((int64_t)X0 - Rect.MaxX);
+    int64_t MaxU = (SignX > 0) ? ((int64_t)Rect.MaxX - X0) : ((int64_t)X0 - Rect.MinX);
+    int64_t MinV = (SignY > 0) ? ((int64_t)Rect.MinY - Y0) : ((int64_t)Y0 - Rect.MaxY);
+    int64_t MaxV = (SignY > 0) ? ((int64_t)Rect.MaxY - Y0) : ((int64_t)Y0 - Rect.MinY);
+
+    int64_t Major = dx;
+    int64_t Minor = dy;
+    intptr_t MajorStep = (intptr_t)SignX;
+    intptr_t MinorStep = (intptr_t)SignY*PitchInPixels;
+    if(dy > dx)
+    {
+        Major = dy;
+        Minor = dx;
+        MajorStep = (intptr_t)SignY*PitchInPixels;
+        MinorStep = (intptr_t)SignX;
+
+        int64_t Swap = MinU; MinU = MinV; MinV = Swap;
+        Swap = MaxU; MaxU = MaxV; MaxV = Swap;
+    }
+
+    int64_t First = (MinU > 0) ? MinU : 0;
+    int64_t Last = (MaxU < Major - 1) ? MaxU : (Major - 1);
+
+    int64_t FirstInV = FirstStepAtMinor(MinV, Major, Minor);
+    int64_t LastInV = FirstStepAtMinor(MaxV + 1, Major, Minor) - 1;
+    if(First < FirstInV)
+    {
+        First = FirstInV;
+    }
+
+    if(Last > LastInV)
+    {
+        Last = LastInV;
+    }
+
+    if(First <= Last)
+    {
+        int64_t MinorBefore = (First > 0) ? MinorAtStep(First - 1, Major, Minor) : 0;
+        int64_t decision    = 2*Minor - Major + 2*Minor*First - 2*Major*MinorBefore;
+        int64_t IncrementNE = 2*(Minor - Major);
+        int64_t IncrementE  = 2*Minor;
+
+        /* NOTE: (X0, Y0) may be off the buffer, only the sum has to be in it */
+        intptr_t Offset = ((intptr_t)Y0*PitchInPixels + X0 +
+                           (intptr_t)First*MajorStep + (intptr_t)MinorBefore*MinorStep);
+        uint32_t *Pixel = (uint32_t *)Buffer->Memory + Offset;
+        for(int64_t Count = Last - First + 1; Count > 0; --Count)
+        {
+            if(decision <= 0)
+            {
+                decision += IncrementE;
+            }
+            else
+            {
+                Pixel += MinorStep;
+                decision += IncrementNE;
+            }
+
+            *Pixel = (uint32_t)Color;
+            Pixel += MajorStep;
+        }
+    }
+}
+
+inline void PrintLineDrawingMethod(draw_line_method Method)
+{
+    printf("======= Line Drawing: ");
+
+    switch(Method)
+    {
+        case Line_Draw_By_Rounding:
+        {
+            printf("By Rounding");
+        } break;
+
+        case Line_Draw_By_Bresenham:
+        {
+            printf("With Bresenham");
+        } break;
+
+        case Line_Draw_By_Bresenham_Stepping:
+        {
+            printf("With Bresenham, pixel stepping");
+        } break;
+
+        default:
+        {
+            printf("Not implemented");
+        }
+    }
+
+    printf("======= \n");
+}
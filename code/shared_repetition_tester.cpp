@@ -87,6 +87,25 @@ static void PrintResults(repetition_test_results Results, uint64_t CPUTimerFreq,
     }
 }
 
+/*
+    NOTE(Axel): For timings that are not driven by a repetition_tester (frame times,
+      parallel waves...), the results must start with MinTime = (uint64_t)-1.
+*/
+static void AccumulateResult(repetition_test_results *Results, uint64_t ElapsedTime)
+{
+    Results->TestCount += 1;
+    Results->TotalTime += ElapsedTime;
+    if(Results->MaxTime < ElapsedTime)
+    {
+        Results->MaxTime = ElapsedTime;
+    }
+
+    if(Results->MinTime > ElapsedTime)
+    {
+        Results->MinTime = ElapsedTime;
+    }
+}
+
 static void Error(repetition_tester *Tester, char const *Message)
 {
     Tester->Mode = TestMode_Error;
@@ -0,0 +1,323 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    NOTE(Axel): Retained lines. The scene owns the segments, the caller keeps handles,
+      and for every 64x64 tile (the tiles of shared_dirty_region.cpp) the scene
+      knows which segments go through it. Adding, removing or moving a segment
+      only marks the tiles of its old and new position dirty. UpdateScene then
+      redraws those tiles alone, from scratch: clear, and every segment of the
+      tile drawn scissored to it (DrawLineScissored gives the pixels DrawLine
+      would have put in the tile, wherever the end points are).
+      A frame costs the tiles that changed, not the size of the scene.
+
+      Overlapping segments: a tile draws its segments in slot order, so the result
+      is the one of drawing every live segment in slot order. Tile lists are kept
+      sorted to get that.
+
+      A handle is the slot + 1 (0 is never a valid handle) in the low 24 bits and a
+      generation in the high 8, so the handle of a removed segment stops working
+      even after its slot is reused (well, until 256 reuses).
+*/
+
+#define SCENE_HANDLE_INDEX_BITS 24
+#define SCENE_HANDLE_INDEX_MASK ((1u << SCENE_HANDLE_INDEX_BITS) - 1)
+
+struct scene_handle
+{
+    uint32_t Value;
+};
+
+struct scene_segment
+{
+    int32_t X0;
+    int32_t Y0;
+    int32_t X1;
+    int32_t Y1;
+    int32_t Color;
+    uint32_t Generation;
+    b32 Alive;
+};
+
+struct scene_tile
+{
+    uint32_t *Segments;
+    uint32_t Count;
+    uint32_t Capacity;
+};
+
+struct line_scene
+{
+    uint32_t ClearColor;
+
+    scene_segment *Segments;
+    uint32_t SegmentCapacity;
+    uint32_t SegmentCount; /* NOTE: Slots ever used, live or not */
+    uint32_t *FreeSlots;
+    uint32_t FreeSlotCount;
+
+    scene_tile *Tiles;
+    dirty_region Dirty;
+    dirty_region Scratch;
+
+    /* NOTE: Of the last UpdateScene */
+    uint32_t UpdatedTileCount;
+    uint64_t UpdatedSegmentCount;
+};
+
+static b32 InitLineScene(line_scene *Scene, uint32_t Width, uint32_t Height,
+                         uint32_t MaxSegmentCount, uint32_t ClearColor)
+{
+    b32 Result = false;
+
+    *Scene = {};
+    Scene->ClearColor = ClearColor;
+    if((MaxSegmentCount <= SCENE_HANDLE_INDEX_MASK) &&
+       InitDirtyRegion(&Scene->Dirty, Width, Height) &&
+       InitDirtyRegion(&Scene->Scratch, Width, Height))
+    {
+        uint32_t TileCount = Scene->Dirty.TileCountX*Scene->Dirty.TileCountY;
+        Scene->Segments = (scene_segment *)calloc(MaxSegmentCount, sizeof(scene_segment));
+        Scene->FreeSlots = (uint32_t *)malloc(MaxSegmentCount*sizeof(uint32_t));
+        Scene->Tiles = (scene_tile *)calloc(TileCount, sizeof(scene_tile));
+        Scene->SegmentCapacity = MaxSegmentCount;
+
+        /* NOTE: The screen buffer has whatever was there, first update redraws it all */
+        MarkAllDirty(&Scene->Dirty);
+
+        Result = (Scene->Segments && Scene->FreeSlots && Scene->Tiles);
+    }
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to create a scene of %u segments.\n", MaxSegmentCount);
+    }
+
+    return Result;
+}
+
+static void FreeLineScene(line_scene *Scene)
+{
+    if(Scene->Tiles)
+    {
+        uint32_t TileCount = Scene->Dirty.TileCountX*Scene->Dirty.TileCountY;
+        for(uint32_t TileIndex = 0; TileIndex < TileCount; ++TileIndex)
+        {
+            free(Scene->Tiles[TileIndex].Segments);
+        }
+    }
+
+    free(Scene->Tiles);
+    free(Scene->Segments);
+    free(Scene->FreeSlots);
+    FreeDirtyRegion(&Scene->Dirty);
+    FreeDirtyRegion(&Scene->Scratch);
+    *Scene = {};
+}
+
+static void InsertInTile(scene_tile *Tile, uint32_t SegmentIndex)
+{
+    if(Tile->Count == Tile->Capacity)
+    {
+        uint32_t NewCapacity = Tile->Capacity ? 2*Tile->Capacity : 16;
+        uint32_t *NewSegments = (uint32_t *)realloc(Tile->Segments, NewCapacity*sizeof(uint32_t));
+        if(!NewSegments)
+        {
+            fprintf(stderr, "ERROR: Out of memory for the scene tiles.\n");
+            return;
+        }
+
+        Tile->Segments = NewSegments;
+        Tile->Capacity = NewCapacity;
+    }
+
+    /* NOTE: Slots are mostly added in increasing order, look from the end */
+    uint32_t Position = Tile->Count;
+    while(Position && (Tile->Segments[Position - 1] > SegmentIndex))
+    {
+        Tile->Segments[Position] = Tile->Segments[Position - 1];
+        --Position;
+    }
+
+    Tile->Segments[Position] = SegmentIndex;
+    ++Tile->Count;
+}
+
+static void RemoveFromTile(scene_tile *Tile, uint32_t SegmentIndex)
+{
+    for(uint32_t Position = 0; Position < Tile->Count; ++Position)
+    {
+        if(Tile->Segments[Position] == SegmentIndex)
+        {
+            memmove(Tile->Segments + Position, Tile->Segments + Position + 1,
+                    (Tile->Count - Position - 1)*sizeof(uint32_t));
+            --Tile->Count;
+            break;
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Inserts the segment in (or removes it from) the lists of the tiles it
+      crosses, those tiles become dirty either way.
+*/
+static void LinkSegment(line_scene *Scene, uint32_t SegmentIndex, b32 Insert)
+{
+    scene_segment *Segment = Scene->Segments + SegmentIndex;
+
+    uint32_t TileMinY = 0;
+    uint32_t TileMaxY = 0;
+    MarkLineTilesOnly(&Scene->Scratch, Segment->X0, Segment->Y0, Segment->X1, Segment->Y1,
+                      &TileMinY, &TileMaxY);
+
+    for(uint32_t TileY = TileMinY; TileY <= TileMaxY; ++TileY)
+    {
+        uint64_t Row = Scene->Scratch.Rows[TileY];
+        Scene->Dirty.Rows[TileY] |= Row;
+        while(Row)
+        {
+            uint32_t TileX = FindLowestSetBit(Row);
+            Row &= Row - 1;
+
+            scene_tile *Tile = Scene->Tiles + TileY*Scene->Dirty.TileCountX + TileX;
+            if(Insert)
+            {
+                InsertInTile(Tile, SegmentIndex);
+            }
+            else
+            {
+                RemoveFromTile(Tile, SegmentIndex);
+            }
+        }
+    }
+}
+
+static scene_segment *GetSceneSegment(line_scene *Scene, scene_handle Handle)
+{
+    scene_segment *Result = 0;
+
+    uint32_t Slot = Handle.Value & SCENE_HANDLE_INDEX_MASK;
+    if(Slot && (Slot <= Scene->SegmentCount))
+    {
+        scene_segment *Segment = Scene->Segments + Slot - 1;
+        if(Segment->Alive && ((Segment->Generation & 0xFF) == (Handle.Value >> SCENE_HANDLE_INDEX_BITS)))
+        {
+            Result = Segment;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Returns a handle with a Value of 0 when the scene is full.
+*/
+static scene_handle AddSegment(line_scene *Scene, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1,
+                               int32_t Color)
+{
+    scene_handle Result = {};
+
+    uint32_t SegmentIndex = Scene->SegmentCapacity;
+    if(Scene->FreeSlotCount)
+    {
+        SegmentIndex = Scene->FreeSlots[--Scene->FreeSlotCount];
+    }
+    else if(Scene->SegmentCount < Scene->SegmentCapacity)
+    {
+        SegmentIndex = Scene->SegmentCount++;
+    }
+
+    if(SegmentIndex < Scene->SegmentCapacity)
+    {
+        scene_segment *Segment = Scene->Segments + SegmentIndex;
+        Segment->X0 = X0;
+        Segment->Y0 = Y0;
+        Segment->X1 = X1;
+        Segment->Y1 = Y1;
+        Segment->Color = Color;
+        Segment->Alive = true;
+        LinkSegment(Scene, SegmentIndex, true);
+
+        Result.Value = (SegmentIndex + 1) | ((Segment->Generation & 0xFF) << SCENE_HANDLE_INDEX_BITS);
+    }
+
+    return Result;
+}
+
+static b32 RemoveSegment(line_scene *Scene, scene_handle Handle)
+{
+    scene_segment *Segment = GetSceneSegment(Scene, Handle);
+    if(Segment)
+    {
+        uint32_t SegmentIndex = (uint32_t)(Segment - Scene->Segments);
+        LinkSegment(Scene, SegmentIndex, false);
+        Segment->Alive = false;
+        ++Segment->Generation;
+        Scene->FreeSlots[Scene->FreeSlotCount++] = SegmentIndex;
+    }
+
+    return (Segment != 0);
+}
+
+static b32 MoveSegment(line_scene *Scene, scene_handle Handle, int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+{
+    scene_segment *Segment = GetSceneSegment(Scene, Handle);
+    if(Segment)
+    {
+        uint32_t SegmentIndex = (uint32_t)(Segment - Scene->Segments);
+        LinkSegment(Scene, SegmentIndex, false);
+        Segment->X0 = X0;
+        Segment->Y0 = Y0;
+        Segment->X1 = X1;
+        Segment->Y1 = Y1;
+        LinkSegment(Scene, SegmentIndex, true);
+    }
+
+    return (Segment != 0);
+}
+
+/*
+    NOTE(Axel): Redraws the dirty tiles in Buffer (which must be the size the scene was
+      created with). When Updated isn't null the redrawn tiles are added to it, to
+      present them.
+*/
+static void UpdateScene(line_scene *Scene, screen_buffer *Buffer, dirty_region *Updated = 0)
+{
+    dirty_region *Dirty = &Scene->Dirty;
+    Scene->UpdatedTileCount = 0;
+    Scene->UpdatedSegmentCount = 0;
+
+    for(uint32_t TileY = 0; TileY < Dirty->TileCountY; ++TileY)
+    {
+        uint64_t Row = Dirty->Rows[TileY];
+        while(Row)
+        {
+            uint32_t TileX = FindLowestSetBit(Row);
+            Row &= Row - 1;
+
+            dirty_rect Rect = GetTileRect(Dirty, TileX, TileY);
+            ClearRect(Buffer, Rect, Scene->ClearColor);
+
+            clip_rect Scissor = {(int32_t)Rect.X, (int32_t)Rect.Y,
+                                 (int32_t)(Rect.X + Rect.Width) - 1, (int32_t)(Rect.Y + Rect.Height) - 1};
+            scene_tile *Tile = Scene->Tiles + TileY*Dirty->TileCountX + TileX;
+            for(uint32_t Position = 0; Position < Tile->Count; ++Position)
+            {
+                scene_segment *Segment = Scene->Segments + Tile->Segments[Position];
+                DrawLineScissored(Buffer, Segment->X0, Segment->Y0, Segment->X1, Segment->Y1,
+                                  Segment->Color, Scissor);
+            }
+
+            ++Scene->UpdatedTileCount;
+            Scene->UpdatedSegmentCount += Tile->Count;
+        }
+    }
+
+    if(Updated)
+    {
+        UnionDirtyRegion(Updated, Dirty);
+    }
+
+    ResetDirtyRegion(Dirty);
+}
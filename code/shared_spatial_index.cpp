@@ -0,0 +1,351 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    NOTE(Axel): Uniform grid over a big static set of segments, to only send what is in
+      the viewport to the clipper and the rasterizer.
+
+      The cells are squares of a power of two size, every segment is referenced
+      in all the cells its bounding box overlaps. The references are stored cell
+      after cell in one flat array (CellStart[Cell] .. CellStart[Cell + 1]), built
+      with a counting sort in two passes: no pointers, no per cell allocation, a
+      query walks contiguous memory.
+
+      A segment overlapping several cells of the query must be reported once. No
+      "already seen" array to clear: a segment is only reported by the first of
+      its cells that is inside the query (its min cell, clamped to the query).
+      Each reference keeps 2 bits telling if its cell is the first column / row of
+      the segment, so that test doesn't need the segment, and cells completely
+      inside the query don't read the segments at all, the sequential walk of the
+      references is all there is.
+
+      A grid is the right tool for segments of similar, small size (maps, meshes,
+      plots), a few very long segments would be referenced in a lot of cells, a
+      BVH would handle those better.
+*/
+
+#define MAX_GRID_CELL_COUNT (1u << 24)
+#define GRID_FIRST_COLUMN_BIT 0x80000000u
+#define GRID_FIRST_ROW_BIT 0x40000000u
+#define GRID_INDEX_MASK 0x3FFFFFFFu
+
+struct segment_grid
+{
+    int32_t MinX;
+    int32_t MinY;
+    uint32_t CellShift;
+    uint32_t CellCountX;
+    uint32_t CellCountY;
+
+    uint32_t *CellStart;
+    uint32_t *References;
+    uint64_t ReferenceCount;
+};
+
+inline uint32_t GridCellX(segment_grid *Grid, int32_t X)
+{
+    int64_t Cell = ((int64_t)X - Grid->MinX) >> Grid->CellShift;
+    if(Cell < 0)
+    {
+        Cell = 0;
+    }
+
+    if(Cell >= Grid->CellCountX)
+    {
+        Cell = Grid->CellCountX - 1;
+    }
+
+    return (uint32_t)Cell;
+}
+
+inline uint32_t GridCellY(segment_grid *Grid, int32_t Y)
+{
+    int64_t Cell = ((int64_t)Y - Grid->MinY) >> Grid->CellShift;
+    if(Cell < 0)
+    {
+        Cell = 0;
+    }
+
+    if(Cell >= Grid->CellCountY)
+    {
+        Cell = Grid->CellCountY - 1;
+    }
+
+    return (uint32_t)Cell;
+}
+
+/*
+    NOTE(Axel): Cells of about 4 segments, but never smaller than the average segment,
+      otherwise every segment ends up in a lot of cells.
+*/
+static uint32_t ChooseGridCellShift(uint64_t Width, uint64_t Height, uint32_t SegmentCount,
+                                    uint64_t AverageExtent)
+{
+    uint64_t Area = Width*Height;
+    uint64_t TargetCellCount = (SegmentCount / 4) ? (SegmentCount / 4) : 1;
+    uint64_t CellArea = Area / TargetCellCount;
+
+    uint32_t Result = 0;
+    while(((1ull << (2*Result)) < CellArea) || ((1ull << Result) < AverageExtent))
+    {
+        ++Result;
+    }
+
+    while(((Width >> Result) + 1)*((Height >> Result) + 1) > MAX_GRID_CELL_COUNT)
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+static b32 BuildSegmentGrid(segment_grid *Grid, line_segment_batch *Segments)
+{
+    b32 Result = false;
+    *Grid = {};
+
+    if(Segments->Count && (Segments->Count <= GRID_INDEX_MASK))
+    {
+        int32_t MinX = INT32_MAX;
+        int32_t MinY = INT32_MAX;
+        int32_t MaxX = INT32_MIN;
+        int32_t MaxY = INT32_MIN;
+        uint64_t ExtentSum = 0;
+        for(uint32_t Index = 0; Index < Segments->Count; ++Index)
+        {
+            int32_t X0 = Segments->X0[Index];
+            int32_t Y0 = Segments->Y0[Index];
+            int32_t X1 = Segments->X1[Index];
+            int32_t Y1 = Segments->Y1[Index];
+            int32_t SegmentMinX = (X0 < X1) ? X0 : X1;
+            int32_t SegmentMaxX = (X0 < X1) ? X1 : X0;
+            int32_t SegmentMinY = (Y0 < Y1) ? Y0 : Y1;
+            int32_t SegmentMaxY = (Y0 < Y1) ? Y1 : Y0;
+
+            MinX = (SegmentMinX < MinX) ? SegmentMinX : MinX;
+            MinY = (SegmentMinY < MinY) ? SegmentMinY : MinY;
+            MaxX = (SegmentMaxX > MaxX) ? SegmentMaxX : MaxX;
+            MaxY = (SegmentMaxY > MaxY) ? SegmentMaxY : MaxY;
+            ExtentSum += (uint64_t)((int64_t)SegmentMaxX - SegmentMinX) + (uint64_t)((int64_t)SegmentMaxY - SegmentMinY);
+        }
+
+        uint64_t Width = (uint64_t)((int64_t)MaxX - MinX) + 1;
+        uint64_t Height = (uint64_t)((int64_t)MaxY - MinY) + 1;
+        Grid->MinX = MinX;
+        Grid->MinY = MinY;
+        Grid->CellShift = ChooseGridCellShift(Width, Height, Segments->Count, ExtentSum / (2*(uint64_t)Segments->Count));
+        Grid->CellCountX = (uint32_t)(((Width - 1) >> Grid->CellShift) + 1);
+        Grid->CellCountY = (uint32_t)(((Height - 1) >> Grid->CellShift) + 1);
+
+        uint32_t CellCount = Grid->CellCountX*Grid->CellCountY;
+        Grid->CellStart = (uint32_t *)calloc((size_t)CellCount + 1, sizeof(uint32_t));
+        if(Grid->CellStart)
+        {
+            /* NOTE: Pass 1, how many references per cell (counted one cell ahead, so
+               the prefix sum leaves the start of each cell in place) */
+            uint64_t ReferenceCount = 0;
+            for(uint32_t Index = 0; Index < Segments->Count; ++Index)
+            {
+                uint32_t CellX0 = GridCellX(Grid, Segments->X0[Index]);
+                uint32_t CellX1 = GridCellX(Grid, Segments->X1[Index]);
+                uint32_t CellY0 = GridCellY(Grid, Segments->Y0[Index]);
+                uint32_t CellY1 = GridCellY(Grid, Segments->Y1[Index]);
+                uint32_t CellMinX = (CellX0 < CellX1) ? CellX0 : CellX1;
+                uint32_t CellMaxX = (CellX0 < CellX1) ? CellX1 : CellX0;
+                uint32_t CellMinY = (CellY0 < CellY1) ? CellY0 : CellY1;
+                uint32_t CellMaxY = (CellY0 < CellY1) ? CellY1 : CellY0;
+
+                for(uint32_t CellY = CellMinY; CellY <= CellMaxY; ++CellY)
+                {
+                    for(uint32_t CellX = CellMinX; CellX <= CellMaxX; ++CellX)
+                    {
+                        ++Grid->CellStart[CellY*Grid->CellCountX + CellX + 1];
+                    }
+                }
+
+                ReferenceCount += (uint64_t)(CellMaxX - CellMinX + 1)*(CellMaxY - CellMinY + 1);
+            }
+
+            if(ReferenceCount <= UINT32_MAX)
+            {
+                for(uint32_t Cell = 0; Cell < CellCount; ++Cell)
+                {
+                    Grid->CellStart[Cell + 1] += Grid->CellStart[Cell];
+                }
+
+                Grid->ReferenceCount = ReferenceCount;
+                Grid->References = (uint32_t *)malloc(ReferenceCount*sizeof(uint32_t));
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: Too many grid references (%llu).\n", (unsigned long long)ReferenceCount);
+            }
+        }
+
+        if(Grid->References)
+        {
+            /* NOTE: Pass 2, CellStart is used as a write cursor, which moves every
+               cell start to the end of the cell, that is the start of the next one */
+            for(uint32_t Index = 0; Index < Segments->Count; ++Index)
+            {
+                uint32_t CellX0 = GridCellX(Grid, Segments->X0[Index]);
+                uint32_t CellX1 = GridCellX(Grid, Segments->X1[Index]);
+                uint32_t CellY0 = GridCellY(Grid, Segments->Y0[Index]);
+                uint32_t CellY1 = GridCellY(Grid, Segments->Y1[Index]);
+                uint32_t CellMinX = (CellX0 < CellX1) ? CellX0 : CellX1;
+                uint32_t CellMaxX = (CellX0 < CellX1) ? CellX1 : CellX0;
+                uint32_t CellMinY = (CellY0 < CellY1) ? CellY0 : CellY1;
+                uint32_t CellMaxY = (CellY0 < CellY1) ? CellY1 : CellY0;
+
+                for(uint32_t CellY = CellMinY; CellY <= CellMaxY; ++CellY)
+                {
+                    for(uint32_t CellX = CellMinX; CellX <= CellMaxX; ++CellX)
+                    {
+                        uint32_t Reference = Index;
+                        Reference |= (CellX == CellMinX) ? GRID_FIRST_COLUMN_BIT : 0;
+                        Reference |= (CellY == CellMinY) ? GRID_FIRST_ROW_BIT : 0;
+                        Grid->References[Grid->CellStart[CellY*Grid->CellCountX + CellX]++] = Reference;
+                    }
+                }
+            }
+
+            memmove(Grid->CellStart + 1, Grid->CellStart, (size_t)CellCount*sizeof(uint32_t));
+            Grid->CellStart[0] = 0;
+
+            Result = true;
+        }
+    }
+    else if(Segments->Count)
+    {
+        fprintf(stderr, "ERROR: Too many segments for the grid (%u).\n", Segments->Count);
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): Optional, for a set that never changes: moves the segments around so the
+      ones of a cell are next to each other in memory (in the order of the cells),
+      and fixes the references. A query then reads (and the caller draws) the
+      segments almost in order instead of jumping all over a 160MB batch. The
+      segment indices change, so anything indexed by segment must follow.
+*/
+static b32 SortSegmentsByGridCell(segment_grid *Grid, line_segment_batch *Segments)
+{
+    b32 Result = false;
+
+    line_segment_batch Sorted = {};
+    uint32_t *NewIndices = (uint32_t *)malloc((size_t)Segments->Count*sizeof(uint32_t));
+    if(Grid->References && NewIndices && AllocateSegmentBatch(&Sorted, Segments->Capacity))
+    {
+        /* NOTE: Every segment has exactly one reference with both bits, in its first cell */
+        uint32_t const FirstCellBits = GRID_FIRST_COLUMN_BIT | GRID_FIRST_ROW_BIT;
+        for(uint64_t Reference = 0; Reference < Grid->ReferenceCount; ++Reference)
+        {
+            uint32_t Value = Grid->References[Reference];
+            if((Value & FirstCellBits) == FirstCellBits)
+            {
+                uint32_t Index = Value & GRID_INDEX_MASK;
+                NewIndices[Index] = Sorted.Count;
+                PushSegment(&Sorted, Segments->X0[Index], Segments->Y0[Index],
+                            Segments->X1[Index], Segments->Y1[Index]);
+            }
+        }
+
+        for(uint64_t Reference = 0; Reference < Grid->ReferenceCount; ++Reference)
+        {
+            uint32_t Value = Grid->References[Reference];
+            Grid->References[Reference] = (Value & ~GRID_INDEX_MASK) | NewIndices[Value & GRID_INDEX_MASK];
+        }
+
+        FreeSegmentBatch(Segments);
+        *Segments = Sorted;
+        Result = true;
+    }
+
+    free(NewIndices);
+    return Result;
+}
+
+static void FreeSegmentGrid(segment_grid *Grid)
+{
+    free(Grid->CellStart);
+    free(Grid->References);
+    *Grid = {};
+}
+
+/*
+    NOTE(Axel): The grid itself, the segments are not counted.
+*/
+static uint64_t GetSegmentGridMemory(segment_grid *Grid)
+{
+    uint64_t Result = (((uint64_t)Grid->CellCountX*Grid->CellCountY + 1)*sizeof(uint32_t) +
+                       Grid->ReferenceCount*sizeof(uint32_t));
+    return Result;
+}
+
+/*
+    NOTE(Axel): Writes the index of every segment whose bounding box overlaps View
+      (inclusive) in Result, each one once. Returns how many, stops at MaxCount.
+*/
+static uint32_t QuerySegmentGrid(segment_grid *Grid, line_segment_batch *Segments, clip_rect View,
+                                 uint32_t *Result, uint32_t MaxCount)
+{
+    uint32_t Count = 0;
+
+    if(Grid->CellStart && (View.MinX <= View.MaxX) && (View.MinY <= View.MaxY))
+    {
+        uint32_t QueryMinX = GridCellX(Grid, View.MinX);
+        uint32_t QueryMaxX = GridCellX(Grid, View.MaxX);
+        uint32_t QueryMinY = GridCellY(Grid, View.MinY);
+        uint32_t QueryMaxY = GridCellY(Grid, View.MaxY);
+
+        for(uint32_t CellY = QueryMinY; CellY <= QueryMaxY; ++CellY)
+        {
+            int64_t CellMinY = (int64_t)Grid->MinY + ((int64_t)CellY << Grid->CellShift);
+            int64_t CellMaxY = CellMinY + ((int64_t)1 << Grid->CellShift) - 1;
+            b32 InsideY = (CellMinY >= View.MinY) && (CellMaxY <= View.MaxY);
+
+            /* NOTE: On the first row of the query every segment is on its first row
+               of the query, elsewhere it has to be the first row of the segment */
+            uint32_t Required = (CellY == QueryMinY) ? 0 : GRID_FIRST_ROW_BIT;
+
+            for(uint32_t CellX = QueryMinX; CellX <= QueryMaxX; ++CellX)
+            {
+                int64_t CellMinX = (int64_t)Grid->MinX + ((int64_t)CellX << Grid->CellShift);
+                int64_t CellMaxX = CellMinX + ((int64_t)1 << Grid->CellShift) - 1;
+                b32 Inside = InsideY && (CellMinX >= View.MinX) && (CellMaxX <= View.MaxX);
+                uint32_t RequiredBits = Required | ((CellX == QueryMinX) ? 0 : GRID_FIRST_COLUMN_BIT);
+
+                uint32_t Cell = CellY*Grid->CellCountX + CellX;
+                uint32_t End = Grid->CellStart[Cell + 1];
+                for(uint32_t Reference = Grid->CellStart[Cell]; Reference < End; ++Reference)
+                {
+                    uint32_t Value = Grid->References[Reference];
+                    if((Value & RequiredBits) == RequiredBits)
+                    {
+                        uint32_t Index = Value & GRID_INDEX_MASK;
+                        b32 Overlaps = Inside;
+                        if(!Overlaps)
+                        {
+                            int32_t X0 = Segments->X0[Index];
+                            int32_t Y0 = Segments->Y0[Index];
+                            int32_t X1 = Segments->X1[Index];
+                            int32_t Y1 = Segments->Y1[Index];
+                            Overlaps = ((((X0 < X1) ? X1 : X0) >= View.MinX) && (((X0 < X1) ? X0 : X1) <= View.MaxX) &&
+                                        (((Y0 < Y1) ? Y1 : Y0) >= View.MinY) && (((Y0 < Y1) ? Y0 : Y1) <= View.MaxY));
+                        }
+
+                        if(Overlaps && (Count < MaxCount))
+                        {
+                            Result[Count++] = Index;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return Count;
+}
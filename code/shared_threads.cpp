@@ -0,0 +1,283 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#if _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#endif
+
+#define MAX_THREAD_COUNT 64
+#define CACHE_LINE_SIZE 64
+
+typedef void thread_proc(void *Param);
+
+struct os_thread
+{
+#if _WIN32
+    HANDLE Handle;
+#else
+    pthread_t Handle;
+#endif
+    thread_proc *Proc;
+    void *Param;
+};
+
+/*
+    NOTE(Axel): Atomics are only ever used on naturally aligned 32 bits values.
+      Every operation is a full barrier, which is what x86 gives us anyway with
+      the lock prefix.
+*/
+#if _WIN32
+inline uint32_t AtomicAddU32(uint32_t volatile *Value, uint32_t Addend)
+{
+    // NOTE: Returns the value after the addition
+    uint32_t Result = (uint32_t)_InterlockedExchangeAdd((long volatile *)Value, (long)Addend) + Addend;
+    return Result;
+}
+
+inline uint32_t AtomicExchangeU32(uint32_t volatile *Value, uint32_t New)
+{
+    uint32_t Result = (uint32_t)_InterlockedExchange((long volatile *)Value, (long)New);
+    return Result;
+}
+
+inline uint32_t AtomicCompareExchangeU32(uint32_t volatile *Value, uint32_t Expected, uint32_t New)
+{
+    // NOTE: Returns the value that was in memory, the exchange happened if it is Expected
+    uint32_t Result = (uint32_t)_InterlockedCompareExchange((long volatile *)Value, (long)New, (long)Expected);
+    return Result;
+}
+
+inline uint32_t AtomicLoadU32(uint32_t volatile *Value)
+{
+    uint32_t Result = *Value;
+    _ReadWriteBarrier();
+    return Result;
+}
+#else
+inline uint32_t AtomicAddU32(uint32_t volatile *Value, uint32_t Addend)
+{
+    uint32_t Result = __atomic_add_fetch(Value, Addend, __ATOMIC_SEQ_CST);
+    return Result;
+}
+
+inline uint32_t AtomicExchangeU32(uint32_t volatile *Value, uint32_t New)
+{
+    uint32_t Result = __atomic_exchange_n(Value, New, __ATOMIC_SEQ_CST);
+    return Result;
+}
+
+inline uint32_t AtomicCompareExchangeU32(uint32_t volatile *Value, uint32_t Expected, uint32_t New)
+{
+    __atomic_compare_exchange_n(Value, &Expected, New, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Expected;
+}
+
+inline uint32_t AtomicLoadU32(uint32_t volatile *Value)
+{
+    uint32_t Result = __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+    return Result;
+}
+#endif
+
+static uint32_t GetLogicalCoreCount(void)
+{
+    uint32_t Result = 1;
+
+#if _WIN32
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    Result = Info.dwNumberOfProcessors;
+#else
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+    if(Count > 0)
+    {
+        Result = (uint32_t)Count;
+    }
+#endif
+
+    if(Result > MAX_THREAD_COUNT)
+    {
+        Result = MAX_THREAD_COUNT;
+    }
+
+    return Result;
+}
+
+static b32 PinCurrentThreadToCore(uint32_t CoreIndex)
+{
+    b32 Result = false;
+
+#if _WIN32
+    DWORD_PTR Mask = (DWORD_PTR)1 << CoreIndex;
+    Result = (SetThreadAffinityMask(GetCurrentThread(), Mask) != 0);
+#else
+    cpu_set_t Set;
+    CPU_ZERO(&Set);
+    CPU_SET(CoreIndex, &Set);
+    Result = (pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set) == 0);
+#endif
+
+    return Result;
+}
+
+#if _WIN32
+static DWORD WINAPI OSThreadEntry(LPVOID Param)
+{
+    os_thread *Thread = (os_thread *)Param;
+    Thread->Proc(Thread->Param);
+    return 0;
+}
+#else
+static void *OSThreadEntry(void *Param)
+{
+    os_thread *Thread = (os_thread *)Param;
+    Thread->Proc(Thread->Param);
+    return 0;
+}
+#endif
+
+/*
+    NOTE(Axel): The os_thread has to stay alive (and at the same address) until
+      JoinOSThread returns, the new thread reads Proc/Param from it.
+*/
+static b32 CreateOSThread(os_thread *Thread, thread_proc *Proc, void *Param)
+{
+    b32 Result = false;
+
+    Thread->Proc = Proc;
+    Thread->Param = Param;
+
+#if _WIN32
+    Thread->Handle = CreateThread(0, 0, OSThreadEntry, Thread, 0, 0);
+    Result = (Thread->Handle != 0);
+#else
+    Result = (pthread_create(&Thread->Handle, 0, OSThreadEntry, Thread) == 0);
+#endif
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to create thread.\n");
+    }
+
+    return Result;
+}
+
+static void JoinOSThread(os_thread *Thread)
+{
+#if _WIN32
+    WaitForSingleObject(Thread->Handle, INFINITE);
+    CloseHandle(Thread->Handle);
+#else
+    pthread_join(Thread->Handle, 0);
+#endif
+}
+
+/*
+    NOTE(Axel): Spinning barrier. We only use it to line up waves of work on threads
+      pinned to distinct cores, where going through the OS scheduler to wake up
+      would add more latency than the work we are trying to measure.
+      Do not use it with more threads than cores.
+*/
+struct thread_barrier
+{
+    uint32_t ThreadCount;
+    uint32_t volatile ArrivedCount;
+    uint32_t volatile Generation;
+};
+
+static void InitBarrier(thread_barrier *Barrier, uint32_t ThreadCount)
+{
+    Barrier->ThreadCount = ThreadCount;
+    Barrier->ArrivedCount = 0;
+    Barrier->Generation = 0;
+}
+
+static void WaitOnBarrier(thread_barrier *Barrier)
+{
+    uint32_t Generation = AtomicLoadU32(&Barrier->Generation);
+
+    if(AtomicAddU32(&Barrier->ArrivedCount, 1) == Barrier->ThreadCount)
+    {
+        AtomicExchangeU32(&Barrier->ArrivedCount, 0);
+        AtomicAddU32(&Barrier->Generation, 1);
+    }
+    else
+    {
+        while(AtomicLoadU32(&Barrier->Generation) == Generation)
+        {
+            _mm_pause();
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Sleeping wait, for threads that share the cores with other work (an
+      encoder running behind the renderer) and can't spin on a barrier.
+*/
+struct os_semaphore
+{
+#if _WIN32
+    HANDLE Handle;
+#else
+    sem_t Handle;
+#endif
+};
+
+static b32 InitSemaphore(os_semaphore *Semaphore, uint32_t InitialCount)
+{
+    b32 Result = false;
+
+#if _WIN32
+    Semaphore->Handle = CreateSemaphoreA(0, (LONG)InitialCount, 0x7fffffff, 0);
+    Result = (Semaphore->Handle != 0);
+#else
+    Result = (sem_init(&Semaphore->Handle, 0, InitialCount) == 0);
+#endif
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to create semaphore.\n");
+    }
+
+    return Result;
+}
+
+static void SignalSemaphore(os_semaphore *Semaphore, uint32_t Count)
+{
+#if _WIN32
+    ReleaseSemaphore(Semaphore->Handle, (LONG)Count, 0);
+#else
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        sem_post(&Semaphore->Handle);
+    }
+#endif
+}
+
+static void WaitSemaphore(os_semaphore *Semaphore)
+{
+#if _WIN32
+    WaitForSingleObject(Semaphore->Handle, INFINITE);
+#else
+    while(sem_wait(&Semaphore->Handle) != 0)
+    {
+        /* NOTE: Interrupted by a signal, wait again */
+    }
+#endif
+}
+
+static void FreeSemaphore(os_semaphore *Semaphore)
+{
+#if _WIN32
+    CloseHandle(Semaphore->Handle);
+#else
+    sem_destroy(&Semaphore->Handle);
+#endif
+}
@@ -0,0 +1,555 @@
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+/*
+    NOTE(Axel): Vertex stage. The segments are kept in world space (floats, SoA), and
+      every pan/zoom transforms all the end points to the screen, straight into a
+      line_segment_batch:
+        - 3x3: 2D homogeneous, affine (pan, zoom, rotation) when the last row is
+          0 0 1, projective otherwise (a tilted map)
+        - 4x4: 3D points, the usual camera * projection
+      The snap to the grid of the rasterizer happens in the same pass: the result
+      is rounded to the nearest integer (nearest even on a tie, the SIMD default),
+      after a scale by 2^SubpixelBits for a fixed point grid (folded into the
+      matrix, it costs nothing).
+
+      Every segment is clipped in homogeneous space before the divide, so that what
+      is left of it stays on the same line:
+        - near W: a point with W < TRANSFORM_NEAR_W is behind the eye, dividing by
+          it flips it
+        - guard band: |X| <= 2^30*W and |Y| <= 2^30*W, past it the integers would
+          overflow (the screen is tiny next to it, ClipLine does the rest)
+      The affine transforms have W = 1. A segment with nothing left becomes
+      (0, 0)-(0, 0) which draws nothing. The AVX2 kernels let the scalar code redo
+      the lanes that need a clip (rare, a few per frame), so both give the same
+      integers, bit for bit (same operations, same order, no FMA).
+*/
+
+#define TRANSFORM_NEAR_W 1e-3f
+#define TRANSFORM_MAX_COORDINATE 1073741824.0f
+
+struct transform_3x3
+{
+    real32 E[3][3];
+};
+
+struct transform_4x4
+{
+    real32 E[4][4];
+};
+
+struct world_segment_batch
+{
+    real32 *X0;
+    real32 *Y0;
+    real32 *Z0;
+    real32 *X1;
+    real32 *Y1;
+    real32 *Z1;
+
+    uint32_t Count;
+    uint32_t Capacity;
+
+    buffer Memory;
+};
+
+static b32 AllocateWorldSegmentBatch(world_segment_batch *Batch, uint32_t Capacity)
+{
+    *Batch = {};
+
+    /* NOTE: Same layout as line_segment_batch, the kernels read whole groups of 8 */
+    size_t LaneCount = ((size_t)Capacity + 15) & ~(size_t)15;
+    buffer Memory = AllocateBuffer(6*LaneCount*sizeof(real32) + 64);
+    if(Memory.Data)
+    {
+        memset(Memory.Data, 0, Memory.Count);
+        real32 *Base = (real32 *)(((uintptr_t)Memory.Data + 63) & ~(uintptr_t)63);
+        Batch->X0 = Base;
+        Batch->Y0 = Base + LaneCount;
+        Batch->Z0 = Base + 2*LaneCount;
+        Batch->X1 = Base + 3*LaneCount;
+        Batch->Y1 = Base + 4*LaneCount;
+        Batch->Z1 = Base + 5*LaneCount;
+        Batch->Capacity = Capacity;
+        Batch->Memory = Memory;
+    }
+
+    return (Memory.Data != 0);
+}
+
+static void FreeWorldSegmentBatch(world_segment_batch *Batch)
+{
+    FreeBuffer(&Batch->Memory);
+    *Batch = {};
+}
+
+inline void PushWorldSegment(world_segment_batch *Batch, real32 X0, real32 Y0, real32 Z0,
+                             real32 X1, real32 Y1, real32 Z1)
+{
+    if(Batch->Count < Batch->Capacity)
+    {
+        uint32_t Index = Batch->Count++;
+        Batch->X0[Index] = X0;
+        Batch->Y0[Index] = Y0;
+        Batch->Z0[Index] = Z0;
+        Batch->X1[Index] = X1;
+        Batch->Y1[Index] = Y1;
+        Batch->Z1[Index] = Z1;
+    }
+}
+
+static transform_3x3 Multiply(transform_3x3 A, transform_3x3 B)
+{
+    transform_3x3 Result = {};
+    for(uint32_t Row = 0; Row < 3; ++Row)
+    {
+        for(uint32_t Column = 0; Column < 3; ++Column)
+        {
+            Result.E[Row][Column] = (A.E[Row][0]*B.E[0][Column] + A.E[Row][1]*B.E[1][Column] +
+                                     A.E[Row][2]*B.E[2][Column]);
+        }
+    }
+
+    return Result;
+}
+
+static transform_4x4 Multiply(transform_4x4 A, transform_4x4 B)
+{
+    transform_4x4 Result = {};
+    for(uint32_t Row = 0; Row < 4; ++Row)
+    {
+        for(uint32_t Column = 0; Column < 4; ++Column)
+        {
+            Result.E[Row][Column] = (A.E[Row][0]*B.E[0][Column] + A.E[Row][1]*B.E[1][Column] +
+                                     A.E[Row][2]*B.E[2][Column] + A.E[Row][3]*B.E[3][Column]);
+        }
+    }
+
+    return Result;
+}
+
+/*
+    NOTE(Axel): World point (CenterX, CenterY) in the middle of the screen, PixelsPerUnit
+      zoom, turned by Angle (radians).
+*/
+static transform_3x3 GetViewTransform2D(real32 CenterX, real32 CenterY, real32 PixelsPerUnit, real32 Angle,
+                                        uint32_t ScreenWidth, uint32_t ScreenHeight)
+{
+    real32 Cos = cosf(Angle)*PixelsPerUnit;
+    real32 Sin = sinf(Angle)*PixelsPerUnit;
+
+    transform_3x3 Result =
+    {{
+        {Cos, -Sin, 0.5f*(real32)ScreenWidth - (Cos*CenterX - Sin*CenterY)},
+        {Sin,  Cos, 0.5f*(real32)ScreenHeight - (Sin*CenterX + Cos*CenterY)},
+        {0.0f, 0.0f, 1.0f},
+    }};
+    return Result;
+}
+
+inline b32 IsAffine(transform_3x3 *Transform)
+{
+    b32 Result = ((Transform->E[2][0] == 0.0f) && (Transform->E[2][1] == 0.0f) && (Transform->E[2][2] == 1.0f));
+    return Result;
+}
+
+static transform_3x3 ScaleToSubpixels(transform_3x3 Transform, uint32_t SubpixelBits)
+{
+    real32 Scale = (real32)(1u << SubpixelBits);
+    for(uint32_t Column = 0; Column < 3; ++Column)
+    {
+        Transform.E[0][Column] *= Scale;
+        Transform.E[1][Column] *= Scale;
+    }
+
+    return Transform;
+}
+
+static transform_4x4 ScaleToSubpixels(transform_4x4 Transform, uint32_t SubpixelBits)
+{
+    real32 Scale = (real32)(1u << SubpixelBits);
+    for(uint32_t Column = 0; Column < 4; ++Column)
+    {
+        Transform.E[0][Column] *= Scale;
+        Transform.E[1][Column] *= Scale;
+    }
+
+    return Transform;
+}
+
+/*
+    NOTE(Axel): In front of the eye and inside the guard band, nothing to clip. 2^30*W is
+      exact (a power of two), and X/W rounds to at most 2^30 when |X| <= 2^30*W, so
+      the divide of a point that passes never overflows the int32. A NaN fails.
+*/
+inline b32 IsInsideGuardBand(real32 X, real32 Y, real32 W)
+{
+    real32 Limit = TRANSFORM_MAX_COORDINATE*W;
+    b32 Result = ((W >= TRANSFORM_NEAR_W) &&
+                  (X <= Limit) && (X >= -Limit) && (Y <= Limit) && (Y >= -Limit));
+    return Result;
+}
+
+TARGET_AVX2
+inline __m256 IsInsideGuardBand(__m256 X, __m256 Y, __m256 W)
+{
+    __m256 Limit = _mm256_mul_ps(_mm256_set1_ps(TRANSFORM_MAX_COORDINATE), W);
+    __m256 NegativeLimit = _mm256_sub_ps(_mm256_setzero_ps(), Limit);
+    __m256 Result = _mm256_and_ps(_mm256_cmp_ps(W, _mm256_set1_ps(TRANSFORM_NEAR_W), _CMP_GE_OQ),
+                                  _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(X, Limit, _CMP_LE_OQ),
+                                                              _mm256_cmp_ps(X, NegativeLimit, _CMP_GE_OQ)),
+                                                _mm256_and_ps(_mm256_cmp_ps(Y, Limit, _CMP_LE_OQ),
+                                                              _mm256_cmp_ps(Y, NegativeLimit, _CMP_GE_OQ))));
+    return Result;
+}
+
+inline int32_t SnapToGrid(real32 Value)
+{
+    int32_t Result = _mm_cvtss_si32(_mm_set_ss(Value));
+    return Result;
+}
+
+/*
+    NOTE(Axel): A clipped end point is on the guard band give or take the rounding, the
+      clamp only takes that back.
+*/
+inline int32_t SnapToGrid(real64 Value)
+{
+    Value = (Value > -TRANSFORM_MAX_COORDINATE) ? Value : -TRANSFORM_MAX_COORDINATE;
+    Value = (Value < TRANSFORM_MAX_COORDINATE) ? Value : TRANSFORM_MAX_COORDINATE;
+
+    int32_t Result = _mm_cvtsd_si32(_mm_set_sd(Value));
+    return Result;
+}
+
+TARGET_AVX2
+inline __m256i SnapToGrid(__m256 Value)
+{
+    __m256i Result = _mm256_cvtps_epi32(Value);
+    return Result;
+}
+
+/*
+    NOTE(Axel): Both ends already transformed (X, Y, W). Clips against the near W and the
+      guard band, divides, snaps, writes segment Index of Out.
+      The clip is Liang-Barsky on the five planes, each one a distance that is >= 0
+      inside: W - NEAR_W, 2^30*W - X, 2^30*W + X, 2^30*W - Y, 2^30*W + Y. It is in
+      real64 and moves the clipped end along the segment, in X, Y and W at once, so
+      the slope stays. An end that was not clipped is divided exactly like the
+      kernels do it, in real32.
+*/
+static void ProjectSegment(line_segment_batch *Out, uint32_t Index,
+                           real32 X0, real32 Y0, real32 W0, real32 X1, real32 Y1, real32 W1)
+{
+    int32_t Snapped[4] = {};
+
+    if(IsInsideGuardBand(X0, Y0, W0) && IsInsideGuardBand(X1, Y1, W1))
+    {
+        Snapped[0] = SnapToGrid(X0 / W0);
+        Snapped[1] = SnapToGrid(Y0 / W0);
+        Snapped[2] = SnapToGrid(X1 / W1);
+        Snapped[3] = SnapToGrid(Y1 / W1);
+    }
+    else
+    {
+        real64 Max = TRANSFORM_MAX_COORDINATE;
+        real64 Near = TRANSFORM_NEAR_W;
+        real64 Distance[5][2] =
+        {
+            {(real64)W0 - Near, (real64)W1 - Near},
+            {Max*W0 - X0, Max*W1 - X1},
+            {Max*W0 + X0, Max*W1 + X1},
+            {Max*W0 - Y0, Max*W1 - Y1},
+            {Max*W0 + Y0, Max*W1 + Y1},
+        };
+
+        b32 Visible = true;
+        b32 Clipped0 = false;
+        b32 Clipped1 = false;
+        real64 T0 = 0.0;
+        real64 T1 = 1.0;
+        for(uint32_t Plane = 0; Plane < 5; ++Plane)
+        {
+            real64 D0 = Distance[Plane][0];
+            real64 D1 = Distance[Plane][1];
+
+            /* NOTE: Written so that a NaN is outside */
+            b32 Outside0 = !(D0 >= 0.0);
+            b32 Outside1 = !(D1 >= 0.0);
+            if(Outside0 && Outside1)
+            {
+                Visible = false;
+            }
+            else if(Outside0)
+            {
+                real64 T = D0 / (D0 - D1);
+                T0 = (T > T0) ? T : T0;
+                Clipped0 = true;
+            }
+            else if(Outside1)
+            {
+                real64 T = D0 / (D0 - D1);
+                T1 = (T < T1) ? T : T1;
+                Clipped1 = true;
+            }
+        }
+
+        if(Visible && (T0 <= T1))
+        {
+            real64 Dx = (real64)X1 - X0;
+            real64 Dy = (real64)Y1 - Y0;
+            real64 Dw = (real64)W1 - W0;
+            if(!Clipped0)
+            {
+                Snapped[0] = SnapToGrid(X0 / W0);
+                Snapped[1] = SnapToGrid(Y0 / W0);
+            }
+            else
+            {
+                real64 W = W0 + T0*Dw;
+                Snapped[0] = SnapToGrid((X0 + T0*Dx) / W);
+                Snapped[1] = SnapToGrid((Y0 + T0*Dy) / W);
+            }
+
+            if(!Clipped1)
+            {
+                Snapped[2] = SnapToGrid(X1 / W1);
+                Snapped[3] = SnapToGrid(Y1 / W1);
+            }
+            else
+            {
+                real64 W = W0 + T1*Dw;
+                Snapped[2] = SnapToGrid((X0 + T1*Dx) / W);
+                Snapped[3] = SnapToGrid((Y0 + T1*Dy) / W);
+            }
+        }
+    }
+
+    Out->X0[Index] = Snapped[0];
+    Out->Y0[Index] = Snapped[1];
+    Out->X1[Index] = Snapped[2];
+    Out->Y1[Index] = Snapped[3];
+}
+
+static void TransformSegmentsScalar(transform_3x3 Transform, uint32_t SubpixelBits,
+                                    world_segment_batch *World, line_segment_batch *Out)
+{
+    b32 Affine = IsAffine(&Transform);
+    transform_3x3 M = ScaleToSubpixels(Transform, SubpixelBits);
+
+    uint32_t Count = (World->Count < Out->Capacity) ? World->Count : Out->Capacity;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        real32 X0 = World->X0[Index];
+        real32 Y0 = World->Y0[Index];
+        real32 X1 = World->X1[Index];
+        real32 Y1 = World->Y1[Index];
+
+        real32 OutX0 = (M.E[0][0]*X0 + M.E[0][1]*Y0) + M.E[0][2];
+        real32 OutY0 = (M.E[1][0]*X0 + M.E[1][1]*Y0) + M.E[1][2];
+        real32 OutX1 = (M.E[0][0]*X1 + M.E[0][1]*Y1) + M.E[0][2];
+        real32 OutY1 = (M.E[1][0]*X1 + M.E[1][1]*Y1) + M.E[1][2];
+        if(Affine)
+        {
+            if(IsInsideGuardBand(OutX0, OutY0, 1.0f) && IsInsideGuardBand(OutX1, OutY1, 1.0f))
+            {
+                Out->X0[Index] = SnapToGrid(OutX0);
+                Out->Y0[Index] = SnapToGrid(OutY0);
+                Out->X1[Index] = SnapToGrid(OutX1);
+                Out->Y1[Index] = SnapToGrid(OutY1);
+            }
+            else
+            {
+                ProjectSegment(Out, Index, OutX0, OutY0, 1.0f, OutX1, OutY1, 1.0f);
+            }
+        }
+        else
+        {
+            real32 W0 = (M.E[2][0]*X0 + M.E[2][1]*Y0) + M.E[2][2];
+            real32 W1 = (M.E[2][0]*X1 + M.E[2][1]*Y1) + M.E[2][2];
+            ProjectSegment(Out, Index, OutX0, OutY0, W0, OutX1, OutY1, W1);
+        }
+    }
+
+    Out->Count = Count;
+}
+
+static void TransformSegmentsScalar(transform_4x4 Transform, uint32_t SubpixelBits,
+                                    world_segment_batch *World, line_segment_batch *Out)
+{
+    transform_4x4 M = ScaleToSubpixels(Transform, SubpixelBits);
+
+    uint32_t Count = (World->Count < Out->Capacity) ? World->Count : Out->Capacity;
+    for(uint32_t Index = 0; Index < Count; ++Index)
+    {
+        real32 P[2][3] =
+        {
+            {World->X0[Index], World->Y0[Index], World->Z0[Index]},
+            {World->X1[Index], World->Y1[Index], World->Z1[Index]},
+        };
+
+        real32 R[2][4];
+        for(uint32_t End = 0; End < 2; ++End)
+        {
+            for(uint32_t Row = 0; Row < 4; ++Row)
+            {
+                R[End][Row] = ((M.E[Row][0]*P[End][0] + M.E[Row][1]*P[End][1]) + M.E[Row][2]*P[End][2]) + M.E[Row][3];
+            }
+        }
+
+        ProjectSegment(Out, Index, R[0][0], R[0][1], R[0][3], R[1][0], R[1][1], R[1][3]);
+    }
+
+    Out->Count = Count;
+}
+
+/*
+    NOTE(Axel): Row of the matrix times 8 points: (E0*X + E1*Y) + E2.
+*/
+TARGET_AVX2
+inline __m256 TransformRow(real32 *Row, __m256 X, __m256 Y)
+{
+    __m256 Result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(Row[0]), X),
+                                                _mm256_mul_ps(_mm256_set1_ps(Row[1]), Y)),
+                                  _mm256_set1_ps(Row[2]));
+    return Result;
+}
+
+TARGET_AVX2
+inline __m256 TransformRow(real32 *Row, __m256 X, __m256 Y, __m256 Z)
+{
+    __m256 Result = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(Row[0]), X),
+                                                              _mm256_mul_ps(_mm256_set1_ps(Row[1]), Y)),
+                                                _mm256_mul_ps(_mm256_set1_ps(Row[2]), Z)),
+                                  _mm256_set1_ps(Row[3]));
+    return Result;
+}
+
+/*
+    NOTE(Axel): The lanes of Clip (a movemask) are redone by ProjectSegment.
+*/
+TARGET_AVX2
+static void ClipSegments8(line_segment_batch *Out, uint32_t Index, uint32_t Count, uint32_t Clip,
+                          __m256 X0, __m256 Y0, __m256 W0, __m256 X1, __m256 Y1, __m256 W1)
+{
+    real32 Values[6][8];
+    _mm256_storeu_ps(Values[0], X0);
+    _mm256_storeu_ps(Values[1], Y0);
+    _mm256_storeu_ps(Values[2], W0);
+    _mm256_storeu_ps(Values[3], X1);
+    _mm256_storeu_ps(Values[4], Y1);
+    _mm256_storeu_ps(Values[5], W1);
+    for(uint32_t Lane = 0; (Lane < 8) && ((Index + Lane) < Count); ++Lane)
+    {
+        if(Clip & (1u << Lane))
+        {
+            ProjectSegment(Out, Index + Lane, Values[0][Lane], Values[1][Lane], Values[2][Lane],
+                           Values[3][Lane], Values[4][Lane], Values[5][Lane]);
+        }
+    }
+}
+
+/*
+    NOTE(Axel): 8 segments, already transformed. Every lane is divided and stored, the
+      lanes all behind the eye are zeroed on the way (like ProjectSegment does), and
+      only the lanes with an end outside the guard band or behind the eye (rare, a
+      few per frame) are redone by ProjectSegment.
+*/
+TARGET_AVX2
+static void ProjectSegments8(line_segment_batch *Out, uint32_t Index, uint32_t Count,
+                             __m256 X0, __m256 Y0, __m256 W0, __m256 X1, __m256 Y1, __m256 W1)
+{
+    __m256 Near = _mm256_set1_ps(TRANSFORM_NEAR_W);
+    __m256 Behind0 = _mm256_cmp_ps(W0, Near, _CMP_NGE_UQ);
+    __m256 Behind1 = _mm256_cmp_ps(W1, Near, _CMP_NGE_UQ);
+    __m256 Hidden = _mm256_and_ps(Behind0, Behind1);
+    __m256i HiddenMask = _mm256_castps_si256(Hidden);
+
+    _mm256_store_si256((__m256i *)(Out->X0 + Index), _mm256_andnot_si256(HiddenMask, SnapToGrid(_mm256_div_ps(X0, W0))));
+    _mm256_store_si256((__m256i *)(Out->Y0 + Index), _mm256_andnot_si256(HiddenMask, SnapToGrid(_mm256_div_ps(Y0, W0))));
+    _mm256_store_si256((__m256i *)(Out->X1 + Index), _mm256_andnot_si256(HiddenMask, SnapToGrid(_mm256_div_ps(X1, W1))));
+    _mm256_store_si256((__m256i *)(Out->Y1 + Index), _mm256_andnot_si256(HiddenMask, SnapToGrid(_mm256_div_ps(Y1, W1))));
+
+    __m256 Inside = _mm256_and_ps(IsInsideGuardBand(X0, Y0, W0), IsInsideGuardBand(X1, Y1, W1));
+    uint32_t Clip = ~(uint32_t)_mm256_movemask_ps(_mm256_or_ps(Inside, Hidden)) & 0xFF;
+    if(Clip)
+    {
+        ClipSegments8(Out, Index, Count, Clip, X0, Y0, W0, X1, Y1, W1);
+    }
+}
+
+
+/*
+    NOTE(Axel): Groups of 8 segments, the last group reads and writes the padding lanes of
+      both batches (they are allocated for it).
+*/
+TARGET_AVX2
+static void TransformSegments(transform_3x3 Transform, uint32_t SubpixelBits,
+                              world_segment_batch *World, line_segment_batch *Out)
+{
+    b32 Affine = IsAffine(&Transform);
+    transform_3x3 M = ScaleToSubpixels(Transform, SubpixelBits);
+
+    uint32_t Count = (World->Count < Out->Capacity) ? World->Count : Out->Capacity;
+    for(uint32_t Index = 0; Index < Count; Index += 8)
+    {
+        __m256 X0 = _mm256_load_ps(World->X0 + Index);
+        __m256 Y0 = _mm256_load_ps(World->Y0 + Index);
+        __m256 X1 = _mm256_load_ps(World->X1 + Index);
+        __m256 Y1 = _mm256_load_ps(World->Y1 + Index);
+
+        __m256 OutX0 = TransformRow(M.E[0], X0, Y0);
+        __m256 OutY0 = TransformRow(M.E[1], X0, Y0);
+        __m256 OutX1 = TransformRow(M.E[0], X1, Y1);
+        __m256 OutY1 = TransformRow(M.E[1], X1, Y1);
+        if(Affine)
+        {
+            _mm256_store_si256((__m256i *)(Out->X0 + Index), SnapToGrid(OutX0));
+            _mm256_store_si256((__m256i *)(Out->Y0 + Index), SnapToGrid(OutY0));
+            _mm256_store_si256((__m256i *)(Out->X1 + Index), SnapToGrid(OutX1));
+            _mm256_store_si256((__m256i *)(Out->Y1 + Index), SnapToGrid(OutY1));
+
+            __m256 One = _mm256_set1_ps(1.0f);
+            uint32_t Inside = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(IsInsideGuardBand(OutX0, OutY0, One),
+                                                                         IsInsideGuardBand(OutX1, OutY1, One)));
+            if(Inside != 0xFF)
+            {
+                ClipSegments8(Out, Index, Count, ~Inside & 0xFF, OutX0, OutY0, One, OutX1, OutY1, One);
+            }
+        }
+        else
+        {
+            ProjectSegments8(Out, Index, Count, OutX0, OutY0, TransformRow(M.E[2], X0, Y0),
+                             OutX1, OutY1, TransformRow(M.E[2], X1, Y1));
+        }
+    }
+
+    Out->Count = Count;
+}
+
+TARGET_AVX2
+static void TransformSegments(transform_4x4 Transform, uint32_t SubpixelBits,
+                              world_segment_batch *World, line_segment_batch *Out)
+{
+    transform_4x4 M = ScaleToSubpixels(Transform, SubpixelBits);
+
+    uint32_t Count = (World->Count < Out->Capacity) ? World->Count : Out->Capacity;
+    for(uint32_t Index = 0; Index < Count; Index += 8)
+    {
+        __m256 X0 = _mm256_load_ps(World->X0 + Index);
+        __m256 Y0 = _mm256_load_ps(World->Y0 + Index);
+        __m256 Z0 = _mm256_load_ps(World->Z0 + Index);
+        __m256 X1 = _mm256_load_ps(World->X1 + Index);
+        __m256 Y1 = _mm256_load_ps(World->Y1 + Index);
+        __m256 Z1 = _mm256_load_ps(World->Z1 + Index);
+
+        ProjectSegments8(Out, Index, Count,
+                         TransformRow(M.E[0], X0, Y0, Z0), TransformRow(M.E[1], X0, Y0, Z0),
+                         TransformRow(M.E[3], X0, Y0, Z0),
+                         TransformRow(M.E[0], X1, Y1, Z1), TransformRow(M.E[1], X1, Y1, Z1),
+                         TransformRow(M.E[3], X1, Y1, Z1));
+    }
+
+    Out->Count = Count;
+}
@@ -0,0 +1,436 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+/*
+    NOTE(Axel): Linux presentation through X11. The screen_buffer we rasterize in IS the
+      XImage memory, and with MIT-SHM that memory is a shared memory segment the X
+      server reads directly: presenting is a request telling the server which
+      rectangle to read, no copy of the frame on our side (StretchDIBits copies the
+      whole buffer every time).
+
+      The server tells us when it is done reading with a ShmCompletion event, until
+      then the image is "in flight" and must not be drawn into.
+
+      When MIT-SHM isn't there (remote display) we fall back to XPutImage, which
+      copies the frame through the socket.
+
+      Works under Xvfb, so it can run on a headless machine:
+        xvfb-run -s "-screen 0 1920x1080x24" ./build/listing_8_main_rc
+*/
+
+#define MAX_X11_IMAGE_COUNT 8
+
+struct x11_image
+{
+    XImage *Image;
+    XShmSegmentInfo ShmInfo;
+    b32 Shared;
+
+    /* NOTE: One per XShmPutImage not completed yet, presenting dirty rectangles
+       puts the same image several times */
+    uint32_t InFlightCount;
+    uint64_t PresentStartTime;
+    uint64_t LastPresentLatency;
+
+    screen_buffer Buffer;
+};
+
+struct x11_window
+{
+    Display *XDisplay;
+    Window XWindow;
+    GC XGC;
+    Visual *XVisual;
+    int Depth;
+    Atom WMDeleteWindow;
+
+    b32 Running;
+    b32 HasShm;
+    int ShmCompletionEvent;
+    uint32_t Width;
+    uint32_t Height;
+
+    x11_image *Images[MAX_X11_IMAGE_COUNT];
+    uint32_t ImageCount;
+
+    /* NOTE: XShmPutImage -> ShmCompletion, in CPU timer ticks */
+    repetition_test_results PresentLatency;
+};
+
+static b32 GlobalX11ErrorOccured;
+
+static int X11TrapError(Display *, XErrorEvent *)
+{
+    GlobalX11ErrorOccured = true;
+    return 0;
+}
+
+static b32 X11OpenWindow(x11_window *Window, uint32_t Width, uint32_t Height, char const *Title)
+{
+    b32 Result = false;
+
+    *Window = {};
+    Window->PresentLatency.MinTime = (uint64_t)-1;
+    Window->XDisplay = XOpenDisplay(0);
+    if(Window->XDisplay)
+    {
+        Display *XDisplay = Window->XDisplay;
+        int Screen = DefaultScreen(XDisplay);
+
+        XVisualInfo VisualInfo = {};
+        if(XMatchVisualInfo(XDisplay, Screen, 24, TrueColor, &VisualInfo))
+        {
+            Window->XVisual = VisualInfo.visual;
+            Window->Depth = VisualInfo.depth;
+            Window->Width = Width;
+            Window->Height = Height;
+
+            XSetWindowAttributes Attributes = {};
+            Attributes.background_pixel = 0;
+            Attributes.border_pixel = 0;
+            Attributes.colormap = XCreateColormap(XDisplay, RootWindow(XDisplay, Screen),
+                                                  Window->XVisual, AllocNone);
+            Attributes.event_mask = StructureNotifyMask|KeyPressMask|ExposureMask;
+
+            Window->XWindow = XCreateWindow(XDisplay, RootWindow(XDisplay, Screen),
+                                           0, 0, Width, Height, 0,
+                                           Window->Depth, InputOutput, Window->XVisual,
+                                           CWBackPixel|CWBorderPixel|CWColormap|CWEventMask,
+                                           &Attributes);
+
+            XStoreName(XDisplay, Window->XWindow, Title);
+            Window->WMDeleteWindow = XInternAtom(XDisplay, "WM_DELETE_WINDOW", False);
+            XSetWMProtocols(XDisplay, Window->XWindow, &Window->WMDeleteWindow, 1);
+
+            Window->XGC = XCreateGC(XDisplay, Window->XWindow, 0, 0);
+            XMapWindow(XDisplay, Window->XWindow);
+
+            int Major = 0;
+            int Minor = 0;
+            Bool SharedPixmaps = False;
+            Window->HasShm = XShmQueryVersion(XDisplay, &Major, &Minor, &SharedPixmaps);
+            if(Window->HasShm)
+            {
+                Window->ShmCompletionEvent = XShmGetEventBase(XDisplay) + ShmCompletion;
+            }
+            else
+            {
+                fprintf(stderr, "WARNING: MIT-SHM not available, presenting with XPutImage (copies the frame).\n");
+            }
+
+            XSync(XDisplay, False);
+            Window->Running = true;
+            Result = true;
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: No 24 bits TrueColor visual.\n");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open X display (is DISPLAY set?).\n");
+    }
+
+    return Result;
+}
+
+static void FillScreenBufferFromImage(x11_image *Image)
+{
+    XImage *XImg = Image->Image;
+    Image->Buffer.Width = XImg->width;
+    Image->Buffer.Height = XImg->height;
+    Image->Buffer.BytesPerPixel = XImg->bits_per_pixel / 8;
+    Image->Buffer.Pitch = XImg->bytes_per_line;
+    Image->Buffer.Memory = (uint8_t *)XImg->data;
+    Image->Buffer.MemoryCount = (size_t)XImg->bytes_per_line*XImg->height;
+}
+
+static b32 X11CreateSharedImage(x11_window *Window, x11_image *Image, uint32_t Width, uint32_t Height)
+{
+    b32 Result = false;
+
+    Display *XDisplay = Window->XDisplay;
+    Image->Image = XShmCreateImage(XDisplay, Window->XVisual, Window->Depth, ZPixmap, 0,
+                                   &Image->ShmInfo, Width, Height);
+    if(Image->Image)
+    {
+        size_t Size = (size_t)Image->Image->bytes_per_line*Image->Image->height;
+        Image->ShmInfo.shmid = shmget(IPC_PRIVATE, Size, IPC_CREAT|0600);
+        if(Image->ShmInfo.shmid >= 0)
+        {
+            Image->ShmInfo.shmaddr = (char *)shmat(Image->ShmInfo.shmid, 0, 0);
+            if(Image->ShmInfo.shmaddr != (char *)-1)
+            {
+                Image->Image->data = Image->ShmInfo.shmaddr;
+                Image->ShmInfo.readOnly = False;
+
+                /* NOTE: Attaching fails with an X error (not a return value) when the
+                   server can't see our memory, trap it */
+                GlobalX11ErrorOccured = false;
+                int (*OldHandler)(Display *, XErrorEvent *) = XSetErrorHandler(X11TrapError);
+                XShmAttach(XDisplay, &Image->ShmInfo);
+                XSync(XDisplay, False);
+                XSetErrorHandler(OldHandler);
+
+                Result = !GlobalX11ErrorOccured;
+                if(!Result)
+                {
+                    shmdt(Image->ShmInfo.shmaddr);
+                }
+            }
+
+            /* NOTE: The segment goes away once both sides detached */
+            shmctl(Image->ShmInfo.shmid, IPC_RMID, 0);
+        }
+
+        if(!Result)
+        {
+            Image->Image->data = 0;
+            XDestroyImage(Image->Image);
+            Image->Image = 0;
+        }
+    }
+
+    return Result;
+}
+
+static void X11DestroyImage(x11_window *Window, x11_image *Image)
+{
+    if(Image->Image)
+    {
+        if(Image->Shared)
+        {
+            XShmDetach(Window->XDisplay, &Image->ShmInfo);
+            XSync(Window->XDisplay, False);
+            shmdt(Image->ShmInfo.shmaddr);
+            Image->Image->data = 0;
+        }
+
+        XDestroyImage(Image->Image);
+    }
+
+    for(uint32_t ImageIndex = 0; ImageIndex < Window->ImageCount; ++ImageIndex)
+    {
+        if(Window->Images[ImageIndex] == Image)
+        {
+            Window->Images[ImageIndex] = Window->Images[--Window->ImageCount];
+            break;
+        }
+    }
+
+    *Image = {};
+}
+
+static b32 X11CreateImage(x11_window *Window, x11_image *Image, uint32_t Width, uint32_t Height)
+{
+    b32 Result = false;
+    *Image = {};
+
+    if(Window->HasShm)
+    {
+        Image->Shared = X11CreateSharedImage(Window, Image, Width, Height);
+        if(!Image->Shared)
+        {
+            fprintf(stderr, "WARNING: XShmAttach failed, presenting with XPutImage (copies the frame).\n");
+            Window->HasShm = false;
+        }
+    }
+
+    if(!Image->Shared)
+    {
+        /* NOTE: 32 bits per pixel, XDestroyImage frees the data with free() */
+        char *Data = (char *)malloc((size_t)Width*Height*4);
+        if(Data)
+        {
+            Image->Image = XCreateImage(Window->XDisplay, Window->XVisual, Window->Depth, ZPixmap, 0,
+                                        Data, Width, Height, 32, 0);
+            if(!Image->Image)
+            {
+                free(Data);
+            }
+        }
+    }
+
+    if(Image->Image)
+    {
+        if(Image->Image->bits_per_pixel == 32)
+        {
+            /* NOTE: An image the completion events can't find would never stop being in flight */
+            if(Window->ImageCount < MAX_X11_IMAGE_COUNT)
+            {
+                FillScreenBufferFromImage(Image);
+                Window->Images[Window->ImageCount++] = Image;
+                Result = true;
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: More than %d images on one window.\n", MAX_X11_IMAGE_COUNT);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: The X server wants %d bits per pixel, we only do 32.\n",
+                    Image->Image->bits_per_pixel);
+        }
+    }
+
+    if(!Result)
+    {
+        X11DestroyImage(Window, Image);
+    }
+
+    return Result;
+}
+
+static void X11CloseWindow(x11_window *Window)
+{
+    if(Window->XDisplay)
+    {
+        if(Window->XWindow)
+        {
+            XFreeGC(Window->XDisplay, Window->XGC);
+            XDestroyWindow(Window->XDisplay, Window->XWindow);
+        }
+        XCloseDisplay(Window->XDisplay);
+    }
+
+    *Window = {};
+}
+
+static void X11HandleEvent(x11_window *Window, XEvent *Event)
+{
+    if(Window->HasShm && (Event->type == Window->ShmCompletionEvent))
+    {
+        uint64_t Now = ReadCPUTimer();
+        XShmCompletionEvent *Completion = (XShmCompletionEvent *)Event;
+        for(uint32_t ImageIndex = 0; ImageIndex < Window->ImageCount; ++ImageIndex)
+        {
+            x11_image *Image = Window->Images[ImageIndex];
+            if(Image->InFlightCount && (Image->ShmInfo.shmseg == Completion->shmseg))
+            {
+                --Image->InFlightCount;
+                if(!Image->InFlightCount)
+                {
+                    Image->LastPresentLatency = Now - Image->PresentStartTime;
+                    AccumulateResult(&Window->PresentLatency, Image->LastPresentLatency);
+                }
+            }
+        }
+    }
+    else
+    {
+        switch(Event->type)
+        {
+            case ClientMessage:
+            {
+                if((Atom)Event->xclient.data.l[0] == Window->WMDeleteWindow)
+                {
+                    Window->Running = false;
+                }
+            } break;
+
+            case DestroyNotify:
+            {
+                Window->Running = false;
+            } break;
+
+            case KeyPress:
+            {
+                if(XLookupKeysym(&Event->xkey, 0) == XK_Escape)
+                {
+                    Window->Running = false;
+                }
+            } break;
+
+            default: break;
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Never blocks. Returns false once the window was closed.
+*/
+static b32 X11ProcessPendingEvents(x11_window *Window)
+{
+    while(XPending(Window->XDisplay))
+    {
+        XEvent Event;
+        XNextEvent(Window->XDisplay, &Event);
+        X11HandleEvent(Window, &Event);
+    }
+
+    return Window->Running;
+}
+
+/*
+    NOTE(Axel): Blocks until the server is done reading the image, after that it is safe
+      to draw into it again (or to destroy it). Once the window is closed a put may end
+      in an error instead of a completion, so the wait is an XSync: when it returns the
+      server has executed every put, whatever their outcome.
+*/
+static void X11WaitForPresent(x11_window *Window, x11_image *Image)
+{
+    while(Image->InFlightCount)
+    {
+        if(Window->Running)
+        {
+            XEvent Event;
+            XNextEvent(Window->XDisplay, &Event);
+            X11HandleEvent(Window, &Event);
+        }
+        else
+        {
+            XSync(Window->XDisplay, False);
+            while(XPending(Window->XDisplay))
+            {
+                XEvent Event;
+                XNextEvent(Window->XDisplay, &Event);
+                X11HandleEvent(Window, &Event);
+            }
+            Image->InFlightCount = 0;
+        }
+    }
+}
+
+/*
+    NOTE(Axel): Several rectangles of the same image can be presented in a row, the
+      latency is then measured from the first put to the last completion.
+*/
+static void X11PresentRect(x11_window *Window, x11_image *Image,
+                           int32_t X, int32_t Y, uint32_t Width, uint32_t Height)
+{
+    if(!Image->InFlightCount)
+    {
+        Image->PresentStartTime = ReadCPUTimer();
+    }
+
+    if(Image->Shared)
+    {
+        XShmPutImage(Window->XDisplay, Window->XWindow, Window->XGC, Image->Image,
+                     X, Y, X, Y, Width, Height, True);
+        ++Image->InFlightCount;
+        XFlush(Window->XDisplay);
+    }
+    else
+    {
+        XPutImage(Window->XDisplay, Window->XWindow, Window->XGC, Image->Image,
+                  X, Y, X, Y, Width, Height);
+        XFlush(Window->XDisplay);
+
+        Image->LastPresentLatency = ReadCPUTimer() - Image->PresentStartTime;
+        AccumulateResult(&Window->PresentLatency, Image->LastPresentLatency);
+    }
+}
+
+static void X11Present(x11_window *Window, x11_image *Image)
+{
+    X11PresentRect(Window, Image, 0, 0, Image->Buffer.Width, Image->Buffer.Height);
+}